@@ -0,0 +1,637 @@
+// parabola_accuracy.cpp
+// Accuracy regression harness: every fast path against its reference path
+//
+// usage: parabola_accuracy [-n cases] [-s seed] [-p ephe path] [-t table] [-v]
+// Runs a seeded set of positions, houses, eclipses, crossings and fixed
+// stars through the reference functions and through each optimized path:
+// SEFLG_FAST, precomputed tables (swe_set_table), interpolated nutation,
+// explicit contexts, compute_batch and the parallel eclipse and crossing
+// generators. For each pair it reports the maximum and the 50/99/99.9th
+// percentile of the differences, in arc seconds or seconds of time, and
+// exits with 1 if a maximum exceeds the bound of the path. It also checks
+// the executor's edge cases.
+// Without -t, a table over 1995 - 2005 is built in a temporary file.
+
+#include "parabola_cross.h"
+#include "parabola_eclipse.h"
+#include "parabola_pheno.h"
+#include "parabola_table.h"
+#include "parabola_wrapper.h"
+#include "swephexp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const double J2000 = 2451545.0;
+static const double YEARS = 2999;           // around J2000, inside the files
+static const double TABLE_YEARS = 5;        // around J2000, built table
+
+// Differences of one optimized path against the reference
+struct Check {
+    std::string group;
+    std::string path;
+    const char* unit;       // "\"", "\"/d" or "s"
+    double bound;
+    std::vector<double> diff = {};
+    int mismatches = 0;     // cases where only one side succeeded
+    int failures = 0;       // both sides failed, or the reference is not
+                            // from the Swiss Ephemeris files
+    double worst = -1;
+    double worst_tjd = 0;
+
+    void add(double d, double tjd) {
+        if (d > worst) {
+            worst = d;
+            worst_tjd = tjd;
+        }
+        diff.push_back(d);
+    }
+};
+
+struct Options {
+    int n = 2000;
+    unsigned seed = 20240101;
+    std::string ephe = "ephe";
+    std::string table;
+    bool verbose = false;
+};
+
+// angular distance of two polar positions in arcsec
+static double separation(const double* a, const double* b) {
+    double c = std::sin(a[1] * DEGTORAD) * std::sin(b[1] * DEGTORAD)
+             + std::cos(a[1] * DEGTORAD) * std::cos(b[1] * DEGTORAD)
+             * std::cos((a[0] - b[0]) * DEGTORAD);
+    double dlon = swe_difdeg2n(a[0], b[0]) * std::cos(a[1] * DEGTORAD);
+    double dlat = a[1] - b[1];
+    // the small-angle form is more precise below a few arcmin
+    if (c > 0.9999999)
+        return std::sqrt(dlon * dlon + dlat * dlat) * 3600;
+    return std::acos(c) * RADTODEG * 3600;
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t) std::ceil(p / 100 * sorted.size());
+    return sorted[std::min(sorted.size() - 1, i > 0 ? i - 1 : 0)];
+}
+
+static const std::vector<int> calc_bodies = {
+    SE_SUN, SE_MOON, SE_MERCURY, SE_VENUS, SE_MARS, SE_JUPITER, SE_SATURN,
+    SE_URANUS, SE_NEPTUNE, SE_PLUTO, SE_MEAN_NODE, SE_TRUE_NODE,
+    SE_MEAN_APOG, SE_OSCU_APOG, SE_CHIRON, SE_CERES,
+};
+
+struct FlagSet {
+    const char* name;
+    int32 iflag;
+};
+
+static const std::vector<FlagSet> calc_flags = {
+    {"speed", SEFLG_SWIEPH | SEFLG_SPEED},
+    {"equatorial", SEFLG_SWIEPH | SEFLG_SPEED | SEFLG_EQUATORIAL},
+    {"topocentric", SEFLG_SWIEPH | SEFLG_TOPOCTR},
+    {"j2000", SEFLG_SWIEPH | SEFLG_J2000},
+    {"sidereal", SEFLG_SWIEPH | SEFLG_SIDEREAL},
+};
+
+struct CalcCase {
+    double tjd_ut;
+    int ipl;
+    int32 iflag;
+};
+
+// Part of +-years around J2000 within the files of body ipl; Chiron's
+// ephemeris is restricted to JD 1967601.5 - 3419437.5
+static double span(int ipl, double years) {
+    return ipl == SE_CHIRON ? std::min(years, 1300.0) / years : 1.0;
+}
+
+static std::vector<CalcCase> make_calc_cases(const Options& opt, double years) {
+    std::mt19937_64 rng(opt.seed);
+    std::uniform_real_distribution<double> dist(-years * 365.25, years * 365.25);
+    std::vector<CalcCase> cases;
+    for (const auto& fs : calc_flags)
+        for (int ipl : calc_bodies)
+            for (int i = 0; i < opt.n / 10; ++i)
+                cases.push_back({J2000 + dist(rng) * span(ipl, years), ipl, fs.iflag});
+    return cases;
+}
+
+static void add_calc(Check& pos, Check* spd, const CalcCase& c, int32 r1, const double* xref, int32 r2,
+                     const double* xalt) {
+    // all cases are within the files: a reference computed otherwise
+    // does not test the path
+    if ((r1 < 0 && r2 < 0) || (r1 >= 0 && !(r1 & SEFLG_SWIEPH))) {
+        ++pos.failures;
+        return;
+    }
+    if ((r1 < 0) != (r2 < 0)) {
+        ++pos.mismatches;
+        return;
+    }
+    pos.add(separation(xref, xalt), c.tjd_ut);
+    if (spd != nullptr && (c.iflag & SEFLG_SPEED))
+        spd->add(std::max(std::fabs(xref[3] - xalt[3]), std::fabs(xref[4] - xalt[4])) * 3600, c.tjd_ut);
+}
+
+// Positions of the reference and of a variant called by `alt`, which
+// returns the flag of swe_calc_ut(). Both calls alternate in order, so
+// that neither profits from positions saved by the other one.
+template <typename Alt>
+static void compare_calc(Check& pos, Check* spd, const std::vector<CalcCase>& cases, Alt alt) {
+    char serr[AS_MAXCH];
+    for (size_t k = 0; k < cases.size(); ++k) {
+        const CalcCase& c = cases[k];
+        double xref[6], xalt[6];
+        int32 r1, r2;
+        if (k & 1) {
+            r2 = alt(c, xalt);
+            r1 = swe_calc_ut(c.tjd_ut, c.ipl, c.iflag, xref, serr);
+        } else {
+            r1 = swe_calc_ut(c.tjd_ut, c.ipl, c.iflag, xref, serr);
+            r2 = alt(c, xalt);
+        }
+        add_calc(pos, spd, c, r1, xref, r2, xalt);
+    }
+}
+
+// Interpolated nutation only differs for dates within a day of each other,
+// so it runs over series, all of them first without and then with it.
+// swe_set_interpolate_nut() keeps the saved positions; resetting the path
+// drops them between the passes.
+static std::vector<CalcCase> make_series_cases(const Options& opt) {
+    std::mt19937_64 rng(opt.seed + 4);
+    std::uniform_real_distribution<double> dist(-YEARS * 365.25, YEARS * 365.25);
+    std::vector<CalcCase> cases;
+    for (int i = 0; i < opt.n / 10; ++i) {
+        const FlagSet& fs = calc_flags[i % calc_flags.size()];
+        int ipl = calc_bodies[i % calc_bodies.size()];
+        double t0 = J2000 + dist(rng) * span(ipl, YEARS);
+        for (int k = 0; k < 40; ++k)
+            cases.push_back({t0 + k * 0.1, ipl, fs.iflag});
+    }
+    return cases;
+}
+
+static void compare_interpolated_nut(Check& pos, const Options& opt, const std::vector<CalcCase>& cases) {
+    char serr[AS_MAXCH];
+    std::vector<double> xref(6 * cases.size()), xalt(6 * cases.size());
+    std::vector<int32> rref(cases.size()), ralt(cases.size());
+    for (int pass = 0; pass < 2; ++pass) {
+        swe_set_ephe_path(opt.ephe.c_str());
+        swe_set_interpolate_nut(pass == 1);
+        double* x = pass ? xalt.data() : xref.data();
+        int32* r = pass ? ralt.data() : rref.data();
+        for (size_t k = 0; k < cases.size(); ++k)
+            r[k] = swe_calc_ut(cases[k].tjd_ut, cases[k].ipl, cases[k].iflag, x + 6 * k, serr);
+    }
+    swe_set_interpolate_nut(FALSE);
+    swe_set_ephe_path(opt.ephe.c_str());
+    for (size_t k = 0; k < cases.size(); ++k)
+        add_calc(pos, nullptr, cases[k], rref[k], &xref[6 * k], ralt[k], &xalt[6 * k]);
+}
+
+static void check_calc(std::vector<Check>& checks, const Options& opt, swe_ctx* ctx) {
+    std::vector<CalcCase> cases = make_calc_cases(opt, YEARS);
+
+    Check fast{"calc", "SEFLG_FAST", "\"", 1.0};
+    Check fast_speed{"calc", "SEFLG_FAST speed", "\"/d", 1.0};
+    compare_calc(fast, &fast_speed, cases, [](const CalcCase& c, double* x) {
+        char serr[AS_MAXCH];
+        return swe_calc_ut(c.tjd_ut, c.ipl, c.iflag | SEFLG_FAST, x, serr);
+    });
+    checks.push_back(fast);
+    checks.push_back(fast_speed);
+
+    // speeds go into the same check, they must be the same as well
+    Check ctxc{"calc", "swe_ctx_calc_ut", "\"", 1e-6};
+    compare_calc(ctxc, &ctxc, cases, [ctx](const CalcCase& c, double* x) {
+        char serr[AS_MAXCH];
+        return swe_ctx_calc_ut(ctx, c.tjd_ut, c.ipl, c.iflag, x, serr);
+    });
+    checks.push_back(ctxc);
+
+    // documented to be good to about 3 mas in nutation
+    Check nut{"calc", "interpolated nutation", "\"", 0.005};
+    compare_interpolated_nut(nut, opt, make_series_cases(opt));
+    checks.push_back(nut);
+
+    // compute_batch asks for SEFLG_SPEED with the default ephemeris
+    std::vector<CalcCase> bcases;
+    PlanetBatchRequest batch;
+    for (const auto& c : cases) {
+        if (c.iflag == (SEFLG_SWIEPH | SEFLG_SPEED)) {
+            bcases.push_back(c);
+            batch.requests.push_back({c.tjd_ut, c.ipl});
+        }
+    }
+    ParabolaTuning tuning;
+    tuning.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    tuning.chunk = 256;
+    tuning.ephe_path = opt.ephe;
+    PlanetBatchResult br = compute_batch(batch, tuning);
+    swe_set_ephe_path(opt.ephe.c_str());
+    Check bc{"calc", "compute_batch", "\"", 1e-6};
+    size_t next = 0;
+    compare_calc(bc, &bc, bcases, [&](const CalcCase&, double* x) {
+        const PlanetResult& r = br.results[next++];
+        std::memcpy(x, r.xx, sizeof(r.xx));
+        return (int32) r.errcode;
+    });
+    checks.push_back(bc);
+}
+
+static void check_table(std::vector<Check>& checks, const Options& opt) {
+    std::string fname = opt.table;
+    double maxerr = 0.01;
+    if (fname.empty()) {
+        fname = (std::filesystem::temp_directory_path()
+                 / ("parabola_accuracy." + std::to_string(std::random_device()()) + ".tab")).string();
+        EphemerisTableRequest req;
+        req.fname = fname;
+        req.iflag = SEFLG_SWIEPH;
+        req.tjd_start = J2000 - TABLE_YEARS * 365.25;
+        req.tjd_end = J2000 + TABLE_YEARS * 365.25;
+        for (int ipl = SE_SUN; ipl <= SE_PLUTO; ++ipl)
+            req.bodies.push_back(ipl);
+        req.prec = maxerr;
+        req.ephe_path = opt.ephe;
+        EphemerisTableResult res = build_ephemeris_table(req);
+        swe_set_ephe_path(opt.ephe.c_str());
+        if (res.errcode != OK) {
+            std::printf("table: not built: %s\n", res.serr);
+            return;
+        }
+    }
+    char serr[AS_MAXCH];
+    std::vector<char> name(fname.begin(), fname.end());
+    name.push_back('\0');
+    struct swe_table* ptab = swe_tab_open(name.data(), serr);
+    if (ptab == nullptr) {
+        std::printf("table: %s\n", serr);
+        return;
+    }
+    std::vector<CalcCase> cases;
+    for (const auto& c : make_calc_cases(opt, TABLE_YEARS * 0.99))
+        if (c.ipl <= SE_PLUTO && (c.iflag & ~SEFLG_SPEED) == SEFLG_SWIEPH)
+            cases.push_back(c);
+    // the table bounds longitude and latitude each, the check their
+    // angular distance
+    Check tc{"calc", "swe_set_table", "\"", std::sqrt(2.0) * maxerr};
+    Check ts{"calc", "swe_set_table speed", "\"/d", 1.0};
+    compare_calc(tc, &ts, cases, [ptab, maxerr](const CalcCase& c, double* x) {
+        char serr[AS_MAXCH];
+        swe_set_table(ptab, maxerr);
+        int32 r = swe_calc_ut(c.tjd_ut, c.ipl, c.iflag, x, serr);
+        swe_set_table(nullptr, 0);
+        return r;
+    });
+    checks.push_back(tc);
+    checks.push_back(ts);
+    swe_tab_close(ptab);
+    if (opt.table.empty())
+        std::remove(fname.c_str());
+}
+
+struct HouseCase {
+    double tjd_ut, lat, lon;
+    int hsys;
+};
+
+// largest difference of the 12 cusps, ascendant, MC, ARMC and vertex
+static double cusp_difference(const double* cref, const double* aref, const double* calt, const double* aalt) {
+    double d = 0;
+    for (int k = 1; k <= 12; ++k)
+        d = std::max(d, std::fabs(swe_difdeg2n(cref[k], calt[k])) * 3600);
+    for (int k = 0; k < 4; ++k)
+        d = std::max(d, std::fabs(swe_difdeg2n(aref[k], aalt[k])) * 3600);
+    return d;
+}
+
+static void check_houses(std::vector<Check>& checks, const Options& opt, swe_ctx* ctx) {
+    static const char hsys_list[] = "PKORCAEWBMTX";
+    std::mt19937_64 rng(opt.seed + 1);
+    std::uniform_real_distribution<double> dt(-YEARS * 365.25, YEARS * 365.25);
+    std::uniform_real_distribution<double> dlat(-66, 66), dlon(-180, 180);
+    // series of 20 charts, 2.4 hours apart, for interpolated nutation
+    std::vector<HouseCase> cases;
+    for (int i = 0; i < opt.n / 20; ++i) {
+        double tjd = J2000 + dt(rng), lat = dlat(rng), lon = dlon(rng);
+        for (int k = 0; k < 20; ++k)
+            cases.push_back({tjd + k * 0.1, lat, lon, hsys_list[i % (sizeof(hsys_list) - 1)]});
+    }
+    Check cc{"houses", "swe_ctx_houses_ex2", "\"", 1e-6};
+    // intermediate cusps near the polar circles magnify the error of the
+    // obliquity many times
+    Check nc{"houses", "interpolated nutation", "\"", 0.1};
+    char serr[AS_MAXCH];
+    std::vector<double> cref(13 * cases.size()), aref(10 * cases.size());
+    std::vector<int> rref(cases.size());
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const HouseCase& h = cases[i];
+        double calt[13], aalt[10];
+        rref[i] = swe_houses_ex2(h.tjd_ut, 0, h.lat, h.lon, h.hsys, &cref[13 * i], &aref[10 * i], nullptr, nullptr, serr);
+        int r2 = swe_ctx_houses_ex2(ctx, h.tjd_ut, 0, h.lat, h.lon, h.hsys, calt, aalt, nullptr, nullptr, serr);
+        if (rref[i] != r2)
+            ++cc.mismatches;
+        else
+            cc.add(cusp_difference(&cref[13 * i], &aref[10 * i], calt, aalt), h.tjd_ut);
+    }
+    swe_set_ephe_path(opt.ephe.c_str());
+    swe_set_interpolate_nut(TRUE);
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const HouseCase& h = cases[i];
+        double calt[13], aalt[10];
+        int r2 = swe_houses_ex2(h.tjd_ut, 0, h.lat, h.lon, h.hsys, calt, aalt, nullptr, nullptr, serr);
+        if (rref[i] != r2)
+            ++nc.mismatches;
+        else
+            nc.add(cusp_difference(&cref[13 * i], &aref[10 * i], calt, aalt), h.tjd_ut);
+    }
+    swe_set_interpolate_nut(FALSE);
+    swe_set_ephe_path(opt.ephe.c_str());
+    checks.push_back(cc);
+    checks.push_back(nc);
+}
+
+static void check_fixstars(std::vector<Check>& checks, const Options& opt, swe_ctx* ctx) {
+    static const char* stars[] = {"Aldebaran", "Spica", "Regulus", "Sirius", "Algol", "Polaris", ",alCen", "Antares"};
+    std::mt19937_64 rng(opt.seed + 2);
+    std::uniform_real_distribution<double> dt(-YEARS * 365.25, YEARS * 365.25);
+    Check oc{"fixstar", "swe_fixstar_ut", "\"", 1e-6};
+    Check cc{"fixstar", "swe_ctx_fixstar2_ut", "\"", 1e-6};
+    Check fc{"fixstar", "SEFLG_FAST", "\"", 1.0};
+    char star[AS_MAXCH], serr[AS_MAXCH];
+    for (int i = 0; i < opt.n / 2; ++i) {
+        const char* st = stars[i % (sizeof(stars) / sizeof(stars[0]))];
+        double tjd = J2000 + dt(rng);
+        int32 iflag = SEFLG_SWIEPH | (i % 3 == 0 ? SEFLG_EQUATORIAL : 0) | SEFLG_SPEED;
+        double xref[6], xalt[6];
+        std::strcpy(star, st);
+        int32 r1 = swe_fixstar2_ut(star, tjd, iflag, xref, serr);
+        for (int pass = 0; pass < 3; ++pass) {
+            Check& ck = pass == 0 ? oc : pass == 1 ? cc : fc;
+            std::strcpy(star, st);
+            int32 r2 = pass == 0 ? swe_fixstar_ut(star, tjd, iflag, xalt, serr)
+                     : pass == 1 ? swe_ctx_fixstar2_ut(ctx, star, tjd, iflag, xalt, serr)
+                                 : swe_fixstar2_ut(star, tjd, iflag | SEFLG_FAST, xalt, serr);
+            if ((r1 < 0 && r2 < 0) || (r1 >= 0 && !(r1 & SEFLG_SWIEPH))) {
+                ++ck.failures;
+                continue;
+            }
+            if ((r1 < 0) != (r2 < 0)) {
+                ++ck.mismatches;
+                continue;
+            }
+            ck.add(separation(xref, xalt), tjd);
+        }
+    }
+    checks.push_back(oc);
+    checks.push_back(cc);
+    checks.push_back(fc);
+}
+
+// The parallel catalog against one serial search over the same span
+static void check_eclipses(std::vector<Check>& checks, const Options& opt) {
+    double years = std::max(10, opt.n / 20);
+    for (EclipseKind kind : {EclipseKind::Solar, EclipseKind::Lunar}) {
+        bool solar = kind == EclipseKind::Solar;
+        Check ck{"eclipse", solar ? "compute_eclipse_catalog/solar" : "compute_eclipse_catalog/lunar", "s", 1.0};
+        EclipseCatalogRequest req;
+        req.kind = kind;
+        req.tjd_start = J2000 - years / 2 * 365.25;
+        req.tjd_end = J2000 + years / 2 * 365.25;
+        req.ephe_path = opt.ephe;
+        EclipseCatalog cat = compute_eclipse_catalog(req);
+        swe_set_ephe_path(opt.ephe.c_str());
+        if (cat.errcode != OK) {
+            std::printf("%s: %s\n", ck.path.c_str(), cat.serr);
+            ++ck.mismatches;
+            checks.push_back(ck);
+            continue;
+        }
+        char serr[AS_MAXCH];
+        double t = req.tjd_start, tret[10];
+        size_t k = 0;
+        while (true) {
+            int32 r = solar ? swe_sol_eclipse_when_glob(t, req.ifl, 0, tret, 0, serr)
+                            : swe_lun_eclipse_when(t, req.ifl, 0, tret, 0, serr);
+            if (r < 0 || tret[0] >= req.tjd_end)
+                break;
+            if (k >= cat.eclipses.size() || cat.eclipses[k].retflag != r) {
+                ++ck.mismatches;
+            } else {
+                double d = 0;
+                for (int j = 0; j < 8; ++j) {
+                    // contacts an eclipse does not have are 0 on both sides
+                    if (tret[j] != 0 || cat.eclipses[k].tret[j] != 0)
+                        d = std::max(d, std::fabs(tret[j] - cat.eclipses[k].tret[j]) * 86400);
+                }
+                ck.add(d, tret[0]);
+            }
+            ++k;
+            t = tret[0] + 1;
+        }
+        if (k != cat.eclipses.size())
+            ck.mismatches += (int) (k > cat.eclipses.size() ? k - cat.eclipses.size() : cat.eclipses.size() - k);
+        checks.push_back(ck);
+    }
+}
+
+// Batched crossings against the scalar functions
+static void check_crossings(std::vector<Check>& checks, const Options& opt) {
+    std::mt19937_64 rng(opt.seed + 3);
+    std::uniform_real_distribution<double> dt(-YEARS * 365.25, YEARS * 365.25), dx(0, 360);
+    for (CrossKind kind : {CrossKind::Sun, CrossKind::Moon, CrossKind::MoonNode}) {
+        const char* name = kind == CrossKind::Sun ? "compute_crossing_batch/sun"
+                         : kind == CrossKind::Moon ? "compute_crossing_batch/moon" : "compute_crossing_batch/node";
+        CrossingBatchRequest req;
+        req.kind = kind;
+        req.ephe_path = opt.ephe;
+        for (int i = 0; i < opt.n / 4; ++i) {
+            req.jd.push_back(J2000 + dt(rng));
+            req.x2cross.push_back(dx(rng));
+        }
+        CrossingBatchResult res = compute_crossing_batch(req);
+        swe_set_ephe_path(opt.ephe.c_str());
+        // both sides stop within 1 mas of the target, which is about 0.1 s
+        // of the Sun, 0.01 s of the Moon's longitude and 0.02 s of its latitude
+        double bound = kind == CrossKind::Sun ? 0.2 : kind == CrossKind::Moon ? 0.02 : 0.05;
+        Check ck{"crossing", name, "s", bound};
+        char serr[AS_MAXCH];
+        for (size_t i = 0; i < req.jd.size(); ++i) {
+            double xlon, xlat, ref;
+            if (kind == CrossKind::Sun)
+                ref = swe_solcross_ut(req.x2cross[i], req.jd[i], req.iflag, serr);
+            else if (kind == CrossKind::Moon)
+                ref = swe_mooncross_ut(req.x2cross[i], req.jd[i], req.iflag, serr);
+            else
+                ref = swe_mooncross_node_ut(req.jd[i], req.iflag, &xlon, &xlat, serr);
+            if ((ref < req.jd[i]) != (res.jd_cross[i] < req.jd[i])) {
+                ++ck.mismatches;
+                continue;
+            }
+            if (ref >= req.jd[i])
+                ck.add(std::fabs(ref - res.jd_cross[i]) * 86400, req.jd[i]);
+        }
+        checks.push_back(ck);
+    }
+    // Heliocentric crossings of the planets Mercury - Pluto, both ways
+    // (helio+ forward, helio- backward).
+    // Searching backward, swe_helio_cross_ut() can skip a crossing of an
+    // eccentric orbit (see cross_lon_multi in sweph.c), so backward
+    // crossings are checked against their definition: the longitude at
+    // the crossing, and no crossing between it and the start, which the
+    // forward search from just after the crossing tells.
+    for (int32 dir : {1, -1}) {
+        Check ck{"crossing", dir > 0 ? "compute_crossing_batch/helio+" : "compute_crossing_batch/helio-", "s", 1.0};
+        for (int32 ipl = SE_MERCURY; ipl <= SE_PLUTO; ++ipl) {
+            CrossingBatchRequest req;
+            req.kind = CrossKind::Helio;
+            req.ipl = ipl;
+            req.dir = dir;
+            req.ephe_path = opt.ephe;
+            // neighbouring start times, so that the batch predicts from
+            // its cache instead of calling the scalar function
+            double jd0 = J2000 + dt(rng) / 4;
+            for (int i = 0; i < opt.n / 40; ++i) {
+                req.jd.push_back(jd0 + 2.0 * i);
+                req.x2cross.push_back(dx(rng));
+            }
+            CrossingBatchResult res = compute_crossing_batch(req);
+            swe_set_ephe_path(opt.ephe.c_str());
+            char serr[AS_MAXCH];
+            for (size_t i = 0; i < req.jd.size(); ++i) {
+                double ref, next, x[6];
+                int32 rc = swe_helio_cross_ut(ipl, req.x2cross[i], req.jd[i], req.iflag, dir, &ref, serr);
+                double got = res.jd_cross[i];
+                if ((rc < 0) != (got == 0)) {
+                    ++ck.mismatches;
+                    continue;
+                }
+                if (rc < 0)
+                    continue;
+                if (dir > 0) {
+                    ck.add(std::fabs(ref - got) * 86400, req.jd[i]);
+                    continue;
+                }
+                if (got >= req.jd[i]
+                    || swe_calc_ut(got, ipl, req.iflag | SEFLG_HELCTR | SEFLG_SPEED, x, serr) < 0
+                    || swe_helio_cross_ut(ipl, req.x2cross[i], got + 1, req.iflag, 1, &next, serr) < 0
+                    || next < req.jd[i]) {
+                    ++ck.mismatches;
+                    continue;
+                }
+                ck.add(std::fabs(swe_difdeg2n(x[0], req.x2cross[i])) / std::fabs(x[3]) * 86400, req.jd[i]);
+            }
+        }
+        checks.push_back(ck);
+    }
+}
+
+// Executor edge cases: empty ranges, and the caller's ephemeris state,
+// which the bodies must not change. Each test adds 1 if it fails, else 0.
+static void check_parallel(std::vector<Check>& checks, const Options& opt) {
+    Check ec{"parallel", "empty range", "", 0};
+    std::vector<int> none;
+    ec.add(!parabola_for(0, [](size_t) {}), 0);
+    ec.add(!parabola_map(none, [](int i) { return i; }).empty(), 0);
+    ec.add(parabola_reduce(none, 7, [](int i) { return i; }, [](int a, int b) { return a + b; }) != 7, 0);
+    ec.add(!compute_batch(PlanetBatchRequest()).results.empty(), 0);
+    checks.push_back(ec);
+
+    Check sc{"parallel", "caller ephemeris path", "", 0};
+    char before[AS_MAXCH], after[AS_MAXCH], serr[AS_MAXCH];
+    double xx[6];
+    swe_get_ephe_path(before);
+    int32 rf = swe_calc_ut(J2000, SE_SUN, SEFLG_SWIEPH, xx, serr);
+    ParabolaParallelOptions po;
+    po.threads = 2;
+    po.chunk = 1;
+    parabola_for(16, [](size_t) { parabola_bind_ephe_path("/nonexistent"); }, po);
+    PhenoBatchRequest preq;
+    preq.jd.assign(16, J2000);
+    preq.bodies = {SE_MARS};
+    preq.ephe_path = "/nonexistent";
+    preq.threads = 2;
+    compute_pheno_batch(preq);
+    sc.add(std::strcmp(before, swe_get_ephe_path(after)) != 0, 0);
+    sc.add(swe_calc_ut(J2000, SE_SUN, SEFLG_SWIEPH, xx, serr) != rf, 0);
+    checks.push_back(sc);
+    swe_set_ephe_path(opt.ephe.c_str());
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-n" && i + 1 < argc) {
+            opt.n = std::max(20, std::atoi(argv[++i]));
+        } else if (a == "-s" && i + 1 < argc) {
+            opt.seed = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (a == "-p" && i + 1 < argc) {
+            opt.ephe = argv[++i];
+        } else if (a == "-t" && i + 1 < argc) {
+            opt.table = argv[++i];
+        } else if (a == "-v") {
+            opt.verbose = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [-n cases] [-s seed] [-p ephe path] [-t table] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    swe_set_ephe_path(opt.ephe.c_str());
+    swe_set_topo(8.55, 47.37, 400);
+    swe_set_sid_mode(SE_SIDM_LAHIRI, 0, 0);
+    swe_ctx* ctx = swe_ctx_new();
+    swe_ctx_set_ephe_path(ctx, opt.ephe.c_str());
+    swe_ctx_set_topo(ctx, 8.55, 47.37, 400);
+    swe_ctx_set_sid_mode(ctx, SE_SIDM_LAHIRI, 0, 0);
+
+    std::vector<Check> checks;
+    check_calc(checks, opt, ctx);
+    check_table(checks, opt);
+    check_houses(checks, opt, ctx);
+    check_fixstars(checks, opt, ctx);
+    check_eclipses(checks, opt);
+    check_crossings(checks, opt);
+    check_parallel(checks, opt);
+
+    int failed = 0;
+    std::printf("%-9s %-32s %7s %12s %12s %12s %12s %12s\n", "group", "path", "n", "p50", "p99", "p99.9", "max",
+                "bound");
+    for (auto& ck : checks) {
+        std::vector<double> d = ck.diff;
+        std::sort(d.begin(), d.end());
+        double mx = d.empty() ? 0 : d.back();
+        // a check without cases has tested nothing
+        bool ok = mx <= ck.bound && ck.mismatches == 0 && ck.failures == 0 && !d.empty();
+        failed += !ok;
+        std::printf("%-9s %-32s %7zu", ck.group.c_str(), ck.path.c_str(), d.size());
+        for (double v : {percentile(d, 50), percentile(d, 99), percentile(d, 99.9), mx, ck.bound}) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.4g%s", v, ck.unit);
+            std::printf(" %12s", buf);
+        }
+        std::printf("  %s", ok ? "ok" : "FAILED");
+        if (ck.mismatches > 0)
+            std::printf(" (%d cases failed on one side only)", ck.mismatches);
+        if (ck.failures > 0)
+            std::printf(" (%d cases failed on both sides or without SEFLG_SWIEPH)", ck.failures);
+        if (opt.verbose && ck.worst > 0)
+            std::printf(" (max at jd %.5f)", ck.worst_tjd);
+        std::printf("\n");
+    }
+    std::printf("%d of %zu checks failed\n", failed, checks.size());
+    swe_ctx_free(ctx);
+    swe_close();
+    return failed > 0 ? 1 : 0;
+}
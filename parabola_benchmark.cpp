@@ -0,0 +1,541 @@
+// parabola_benchmark.cpp
+// Micro- and macrobenchmarks of the public hot paths, with JSON output
+//
+// usage: parabola_benchmark [-o results.json] [-p ephe path] [-f filter] [-r reps] [--quick]
+//                           [--trace trace.json]
+// Every case runs once to warm up and then `reps` times on fixed inputs;
+// the JSON file holds the median and the spread in ns per operation, so
+// that runs of two releases on the same machine can be compared case by
+// case. Cases whose ephemeris is not available are written as "skipped".
+// --trace records the compute_batch cases with parabola_trace, per request
+// phases included, into a Chrome trace file.
+
+#include "parabola_wrapper.h"
+#include "parabola_trace.h"
+#include "swephexp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static const double J2000 = 2451545.0;
+static const int32 EPHMASK = SEFLG_JPLEPH | SEFLG_SWIEPH | SEFLG_MOSEPH;
+
+// One timed unit of work; returns the number of operations it did, or
+// -1 with `note` set if the case cannot run here.
+using BenchBody = std::function<long(std::string& note)>;
+
+struct BenchCase {
+    std::string group;
+    std::string name;
+    BenchBody body;
+    std::shared_ptr<size_t> threads;    // set by compute_batch cases
+};
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    std::string status = "ok";
+    std::string note;
+    long ops = 0;
+    int reps = 0;
+    double ns_median = 0;
+    double ns_min = 0;
+    double ns_max = 0;
+    size_t threads = 0;     // compute_batch: the count it picked
+};
+
+struct BenchOptions {
+    std::string json = "parabola_benchmark.json";
+    std::string ephe = "ephe";
+    std::string filter;
+    std::string trace;
+    int reps = 5;
+    bool quick = false;
+};
+
+static std::string json_escape(const std::string& s) {
+    std::string r;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if ((unsigned char) c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            r += buf;
+        } else {
+            r += c;
+        }
+    }
+    return r;
+}
+
+static BenchResult run_case(const BenchCase& bc, int reps) {
+    BenchResult res;
+    res.group = bc.group;
+    res.name = bc.name;
+    std::string note;
+    // warm-up: opens the files and fills the caches a real run would have
+    if (bc.body(note) < 0) {
+        res.status = "skipped";
+        res.note = note;
+        return res;
+    }
+    std::vector<double> ns;
+    for (int i = 0; i < reps; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        long ops = bc.body(note);
+        std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (ops <= 0)
+            continue;
+        res.ops = ops;
+        ns.push_back(dt.count() / ops);
+    }
+    if (ns.empty()) {
+        res.status = "skipped";
+        res.note = note;
+        return res;
+    }
+    std::sort(ns.begin(), ns.end());
+    res.reps = (int) ns.size();
+    res.ns_median = ns[ns.size() / 2];
+    res.ns_min = ns.front();
+    res.ns_max = ns.back();
+    res.note = note;
+    return res;
+}
+
+// Positions along a time-ordered run, as a chart series or a scan would
+// request them; JPL and Swiss Ephemeris are limited to their file range.
+static std::vector<double> scan_dates(int n, double step) {
+    std::vector<double> d(n);
+    for (int i = 0; i < n; ++i)
+        d[i] = J2000 - n / 2 * step + i * step;
+    return d;
+}
+
+struct EpheKind {
+    const char* name;
+    int32 iflag;
+};
+
+static void add_calc_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    static const EpheKind ephes[] = {
+        {"swieph", SEFLG_SWIEPH}, {"jpl", SEFLG_JPLEPH}, {"moseph", SEFLG_MOSEPH},
+    };
+    static const int bodies[] = {
+        SE_SUN, SE_MOON, SE_MERCURY, SE_VENUS, SE_MARS, SE_JUPITER, SE_SATURN,
+        SE_URANUS, SE_NEPTUNE, SE_PLUTO, SE_MEAN_NODE, SE_TRUE_NODE,
+        SE_MEAN_APOG, SE_OSCU_APOG, SE_CHIRON, SE_CERES,
+    };
+    auto dates = std::make_shared<std::vector<double>>(scan_dates(opt.quick ? 500 : 2000, 1.37));
+    for (const auto& e : ephes) {
+        for (int ipl : bodies) {
+            // the analytical lunar points and the asteroids only exist in one form
+            if (e.iflag == SEFLG_MOSEPH && (ipl == SE_CHIRON || ipl == SE_CERES))
+                continue;
+            char pname[AS_MAXCH];
+            swe_get_planet_name(ipl, pname);
+            for (int ut = 0; ut <= 1; ++ut) {
+                std::string name = std::string(ut ? "swe_calc_ut/" : "swe_calc/") + e.name + "/" + pname;
+                int32 iflag = e.iflag | SEFLG_SPEED;
+                cases.push_back({"calc", name, [=](std::string& note) -> long {
+                    double xx[6];
+                    char serr[AS_MAXCH];
+                    long ops = 0;
+                    for (double t : *dates) {
+                        *serr = '\0';
+                        int32 ret = ut ? swe_calc_ut(t, ipl, iflag, xx, serr)
+                                       : swe_calc(t, ipl, iflag, xx, serr);
+                        // a missing file makes the library fall back silently
+                        if (ret < 0 || (ret & EPHMASK) != (iflag & EPHMASK)) {
+                            note = *serr ? serr : "ephemeris not available";
+                            return -1;
+                        }
+                        ++ops;
+                    }
+                    return ops;
+                }, nullptr});
+            }
+        }
+    }
+}
+
+static void add_house_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    static const char hsys_list[] = "PKORCAEVXHTBMGUWYNFLQIiJDS";
+    int n = opt.quick ? 500 : 2000;
+    for (const char* hp = hsys_list; *hp != '\0'; ++hp) {
+        int hsys = *hp;
+        std::string name = std::string("swe_houses_ex2/") + (char) hsys + "/" + swe_house_name(hsys);
+        cases.push_back({"houses", name, [=](std::string& note) -> long {
+            double cusps[37], ascmc[10], cusp_speed[37], ascmc_speed[10];
+            char serr[AS_MAXCH];
+            long ops = 0;
+            for (int i = 0; i < n; ++i) {
+                double tjd_ut = J2000 + i * 0.731;
+                double geolat = -60 + (i % 121);    // polar latitudes fail for some systems
+                if (swe_houses_ex2(tjd_ut, SEFLG_SPEED, geolat, 8.55, hsys, cusps, ascmc,
+                                   cusp_speed, ascmc_speed, serr) < 0 && i == 0) {
+                    note = serr;
+                    return -1;
+                }
+                ++ops;
+            }
+            return ops;
+        }, nullptr});
+    }
+}
+
+static void add_fixstar_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    static const char* stars[] = {"Aldebaran", "Spica", "Regulus", "Sirius", ",alCMa", "Algol"};
+    int n = opt.quick ? 100 : 500;
+    for (const char* st : stars) {
+        cases.push_back({"fixstar", std::string("swe_fixstar2_ut/") + st, [=](std::string& note) -> long {
+            char star[AS_MAXCH], serr[AS_MAXCH];
+            double xx[6];
+            long ops = 0;
+            for (int i = 0; i < n; ++i) {
+                // swe_fixstar2() writes the full name back into star
+                std::strcpy(star, st);
+                if (swe_fixstar2_ut(star, J2000 + i * 36.5, SEFLG_SWIEPH | SEFLG_SPEED, xx, serr) < 0) {
+                    note = serr;
+                    return -1;
+                }
+                ++ops;
+            }
+            return ops;
+        }, nullptr});
+    }
+}
+
+static void add_eclipse_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    int n = opt.quick ? 5 : 20;
+    double geopos[3] = {8.55, 47.37, 400};
+    cases.push_back({"eclipse", "swe_sol_eclipse_when_glob", [=](std::string& note) -> long {
+        double tret[10];
+        char serr[AS_MAXCH];
+        double t = J2000;
+        for (int i = 0; i < n; ++i) {
+            if (swe_sol_eclipse_when_glob(t, SEFLG_SWIEPH, 0, tret, 0, serr) < 0) {
+                note = serr;
+                return -1;
+            }
+            t = tret[0] + 1;
+        }
+        return n;
+    }, nullptr});
+    cases.push_back({"eclipse", "swe_sol_eclipse_when_loc", [=](std::string& note) -> long {
+        double tret[10], attr[20], gp[3] = {geopos[0], geopos[1], geopos[2]};
+        char serr[AS_MAXCH];
+        double t = J2000;
+        for (int i = 0; i < n; ++i) {
+            if (swe_sol_eclipse_when_loc(t, SEFLG_SWIEPH, gp, tret, attr, 0, serr) < 0) {
+                note = serr;
+                return -1;
+            }
+            t = tret[0] + 1;
+        }
+        return n;
+    }, nullptr});
+    cases.push_back({"eclipse", "swe_lun_eclipse_when", [=](std::string& note) -> long {
+        double tret[10];
+        char serr[AS_MAXCH];
+        double t = J2000;
+        for (int i = 0; i < n; ++i) {
+            if (swe_lun_eclipse_when(t, SEFLG_SWIEPH, 0, tret, 0, serr) < 0) {
+                note = serr;
+                return -1;
+            }
+            t = tret[0] + 1;
+        }
+        return n;
+    }, nullptr});
+}
+
+static void add_rise_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    static const int bodies[] = {SE_SUN, SE_MOON, SE_VENUS};
+    int n = opt.quick ? 50 : 200;
+    for (int ipl : bodies) {
+        char pname[AS_MAXCH];
+        swe_get_planet_name(ipl, pname);
+        for (int32 rsmi : {SE_CALC_RISE, SE_CALC_SET}) {
+            std::string name = std::string("swe_rise_trans/") + (rsmi == SE_CALC_RISE ? "rise/" : "set/") + pname;
+            cases.push_back({"rise", name, [=](std::string& note) -> long {
+                double geopos[3] = {8.55, 47.37, 400}, tret;
+                char serr[AS_MAXCH];
+                double t = J2000;
+                long ops = 0;
+                for (int i = 0; i < n; ++i) {
+                    int32 ret = swe_rise_trans(t, ipl, NULL, SEFLG_SWIEPH, rsmi, geopos, 1013.25, 10, &tret, serr);
+                    if (ret < 0) {
+                        note = serr;
+                        return -1;
+                    }
+                    t = (ret == 0 ? tret : t + 1) + 0.1;
+                    ++ops;
+                }
+                return ops;
+            }, nullptr});
+        }
+    }
+}
+
+static void add_heliacal_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    int n = opt.quick ? 1 : 3;
+    cases.push_back({"heliacal", "swe_heliacal_ut/Venus/rising", [=](std::string& note) -> long {
+        double geopos[3] = {8.55, 47.37, 400};
+        double datm[4] = {1013.25, 15, 40, 0};
+        double dobs[6] = {36, 1, 0, 0, 0, 0};
+        double dret[50];
+        char object[] = "Venus", serr[AS_MAXCH];
+        double t = J2000;
+        for (int i = 0; i < n; ++i) {
+            if (swe_heliacal_ut(t, geopos, datm, dobs, object, SE_HELIACAL_RISING,
+                                SEFLG_SWIEPH, dret, serr) < 0) {
+                note = serr;
+                return -1;
+            }
+            t = dret[0] + 30;
+        }
+        return n;
+    }, nullptr});
+}
+
+static void add_time_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    int n = opt.quick ? 20000 : 100000;
+    cases.push_back({"time", "swe_deltat_ex", [=](std::string&) -> long {
+        char serr[AS_MAXCH];
+        volatile double sum = 0;
+        for (int i = 0; i < n; ++i)
+            sum = sum + swe_deltat_ex(J2000 - 200 * 365.25 + i * 1.461, SEFLG_SWIEPH, serr);
+        return n;
+    }, nullptr});
+    // obliquity and nutation, as every apparent position needs them
+    cases.push_back({"time", "nutation/SE_ECL_NUT", [=](std::string& note) -> long {
+        double xx[6];
+        char serr[AS_MAXCH];
+        for (int i = 0; i < n / 5; ++i) {
+            if (swe_calc(J2000 + i * 0.37, SE_ECL_NUT, 0, xx, serr) < 0) {
+                note = serr;
+                return -1;
+            }
+        }
+        return n / 5;
+    }, nullptr});
+}
+
+// Request lists of the three shapes found in practice: charts (all planets
+// of one date after the other), series (one planet over a date range) and
+// unrelated requests arriving in random order.
+static std::vector<PlanetRequest> make_requests(const std::string& pattern, size_t n) {
+    std::vector<PlanetRequest> req;
+    req.reserve(n);
+    if (pattern == "time_major") {
+        for (size_t i = 0; i < n; ++i)
+            req.push_back({J2000 + (double) (i / 10) * 0.5, (int) (i % 10)});
+    } else if (pattern == "body_major") {
+        size_t per_body = std::max<size_t>(1, n / 10);
+        for (size_t i = 0; i < n; ++i)
+            req.push_back({J2000 + (double) (i % per_body) * 0.5, (int) std::min<size_t>(9, i / per_body)});
+    } else {
+        std::mt19937_64 rng(20240101);
+        std::uniform_real_distribution<double> dist(-200 * 365.25, 200 * 365.25);
+        for (size_t i = 0; i < n; ++i)
+            req.push_back({J2000 + dist(rng), (int) (rng() % 10)});
+    }
+    return req;
+}
+
+static void add_batch_cases(std::vector<BenchCase>& cases, const BenchOptions& opt) {
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    if (opt.quick)
+        sizes = {1000, 10000};
+    static const char* patterns[] = {"time_major", "body_major", "random"};
+    for (const char* pat : patterns) {
+        for (size_t n : sizes) {
+            auto batch = std::make_shared<PlanetBatchRequest>();
+            batch->requests = make_requests(pat, n);
+            auto threads = std::make_shared<size_t>(0);
+            cases.push_back({"batch", std::string("compute_batch/") + pat + "/" + std::to_string(n),
+                             [=](std::string& note) -> long {
+                PlanetBatchResult r = compute_batch(*batch);
+                size_t tuned = parabola_default_tuning().threads;
+                *threads = tuned > 0 ? tuned : g_parabola_thread_count;
+                if (r.results.size() != batch->requests.size())
+                    return -1;
+                // compute_batch does not bind an ephemeris path in its workers
+                if (!r.results.empty() && r.results[0].errcode >= 0)
+                    note = (r.results[0].errcode & SEFLG_SWIEPH) ? "swieph" : "moseph";
+                return (long) n;
+            }, threads});
+        }
+    }
+
+    // the same slicing with a fixed thread count, bound to the ephemeris path
+    size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < hw; t *= 2)
+        counts.push_back(t);
+    counts.push_back(hw);
+    if (hw == 1)
+        counts.push_back(2);
+    size_t n = sizes.back();
+    std::string ephe = opt.ephe;
+    // one pool per thread count, started by the untimed warm-up run
+    std::vector<std::shared_ptr<std::unique_ptr<ParabolaThreadPool>>> pools;
+    for (size_t i = 0; i < counts.size(); ++i)
+        pools.push_back(std::make_shared<std::unique_ptr<ParabolaThreadPool>>());
+    for (const char* pat : patterns) {
+        auto reqs = std::make_shared<std::vector<PlanetRequest>>(make_requests(pat, n));
+        for (size_t c = 0; c < counts.size(); ++c) {
+            size_t nt = counts[c];
+            auto pool = pools[c];
+            cases.push_back({"batch", std::string("pool/") + pat + "/" + std::to_string(n) + "/"
+                                      + std::to_string(nt) + "threads",
+                             [=](std::string&) -> long {
+                if (!*pool)
+                    pool->reset(new ParabolaThreadPool(nt));
+                std::vector<std::future<void>> futures;
+                size_t slice = std::max<size_t>(1, reqs->size() / nt);
+                for (size_t i = 0; i < reqs->size(); i += slice) {
+                    size_t end = std::min(reqs->size(), i + slice);
+                    futures.push_back((*pool)->submit([&, i, end]() {
+                        parabola_bind_ephe_path(ephe);
+                        double xx[6];
+                        char serr[AS_MAXCH];
+                        for (size_t k = i; k < end; ++k)
+                            swe_calc_ut((*reqs)[k].jd, (*reqs)[k].ipl, SEFLG_SPEED, xx, serr);
+                    }));
+                }
+                for (auto& f : futures)
+                    f.get();
+                return (long) reqs->size();
+            }, nullptr});
+        }
+    }
+}
+
+static void write_json(const std::string& path, const BenchOptions& opt,
+                       const std::vector<BenchResult>& results) {
+    FILE* fp = std::fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return;
+    }
+    char vers[AS_MAXCH], stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    std::fprintf(fp, "{\n");
+    std::fprintf(fp, "  \"schema\": 1,\n");
+    std::fprintf(fp, "  \"swisseph_version\": \"%s\",\n", json_escape(swe_version(vers)).c_str());
+#ifdef __VERSION__
+    std::fprintf(fp, "  \"compiler\": \"%s\",\n", json_escape(__VERSION__).c_str());
+#endif
+#ifdef NDEBUG
+    std::fprintf(fp, "  \"assertions\": false,\n");
+#else
+    std::fprintf(fp, "  \"assertions\": true,\n");
+#endif
+    std::fprintf(fp, "  \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(fp, "  \"ephe_path\": \"%s\",\n", json_escape(opt.ephe).c_str());
+    std::fprintf(fp, "  \"quick\": %s,\n", opt.quick ? "true" : "false");
+    std::fprintf(fp, "  \"timestamp\": \"%s\",\n", stamp);
+    std::fprintf(fp, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::fprintf(fp, "%s\n    {\"group\": \"%s\", \"name\": \"%s\", \"status\": \"%s\"",
+                     i ? "," : "", json_escape(r.group).c_str(), json_escape(r.name).c_str(),
+                     r.status.c_str());
+        if (r.status == "ok") {
+            std::fprintf(fp, ", \"ops\": %ld, \"reps\": %d, \"ns_per_op\": %.1f, \"ns_per_op_min\": %.1f, "
+                             "\"ns_per_op_max\": %.1f, \"ops_per_sec\": %.1f",
+                         r.ops, r.reps, r.ns_median, r.ns_min, r.ns_max, 1e9 / r.ns_median);
+            if (r.threads > 0)
+                std::fprintf(fp, ", \"threads\": %zu", r.threads);
+        }
+        if (!r.note.empty())
+            std::fprintf(fp, ", \"note\": \"%s\"", json_escape(r.note).c_str());
+        std::fprintf(fp, "}");
+    }
+    std::fprintf(fp, "\n  ]\n}\n");
+    std::fclose(fp);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-o" && i + 1 < argc) {
+            opt.json = argv[++i];
+        } else if (a == "-p" && i + 1 < argc) {
+            opt.ephe = argv[++i];
+        } else if (a == "-f" && i + 1 < argc) {
+            opt.filter = argv[++i];
+        } else if (a == "-r" && i + 1 < argc) {
+            opt.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--trace" && i + 1 < argc) {
+            opt.trace = argv[++i];
+        } else if (a == "--quick") {
+            opt.quick = true;
+            opt.reps = std::min(opt.reps, 3);
+        } else {
+            std::fprintf(stderr, "usage: %s [-o results.json] [-p ephe path] [-f filter] [-r reps] [--quick] "
+                                 "[--trace trace.json]\n", argv[0]);
+            return 2;
+        }
+    }
+    parabola_bind_ephe_path(opt.ephe);
+
+    std::vector<BenchCase> cases;
+    add_calc_cases(cases, opt);
+    add_house_cases(cases, opt);
+    add_fixstar_cases(cases, opt);
+    add_eclipse_cases(cases, opt);
+    add_rise_cases(cases, opt);
+    add_heliacal_cases(cases, opt);
+    add_time_cases(cases, opt);
+    add_batch_cases(cases, opt);
+
+    std::vector<BenchResult> results;
+    for (const auto& bc : cases) {
+        std::string full = bc.group + "/" + bc.name;
+        if (!opt.filter.empty() && full.find(opt.filter) == std::string::npos)
+            continue;
+        bool traced = !opt.trace.empty() && bc.threads;
+        if (traced) {
+            ParabolaTraceOptions topt;
+            topt.request_phases = true;
+            topt.events_per_thread = 1 << 20;
+            parabola_trace_start(topt);
+        }
+        BenchResult r = run_case(bc, bc.group == "batch" ? std::min(opt.reps, 3) : opt.reps);
+        if (traced)
+            parabola_trace_stop();
+        if (bc.threads)
+            r.threads = *bc.threads;
+        if (r.status == "ok")
+            std::printf("%-56s %14.1f ns/op %14.0f ops/s\n", full.c_str(), r.ns_median, 1e9 / r.ns_median);
+        else
+            std::printf("%-56s skipped: %s\n", full.c_str(), r.note.c_str());
+        // compute_batch closes the ephemeris on the calling thread
+        if (bc.threads)
+            swe_set_ephe_path(opt.ephe.c_str());
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+    // the rings hold the last compute_batch case traced
+    if (!opt.trace.empty() && !parabola_trace_write(opt.trace))
+        std::fprintf(stderr, "cannot write %s\n", opt.trace.c_str());
+    write_json(opt.json, opt, results);
+    std::printf("%zu cases written to %s\n", results.size(), opt.json.c_str());
+    swe_close();
+    return 0;
+}
@@ -0,0 +1,262 @@
+// parabola_capi.cpp
+// C interface of the batch engine, see parabola_capi.h
+
+#include "parabola_capi.h"
+#include "parabola_trace.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct parabola_job {
+    struct parabola_batch batch;
+    std::string ephe_path;          // batch.ephe_path points here
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> done{false};
+    int32 retc = OK;
+    char serr[AS_MAXCH] = {0};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+template <typename T>
+static T& at(T* base, ptrdiff_t stride, size_t i) {
+    return *reinterpret_cast<T*>(reinterpret_cast<char*>(base) + stride * (ptrdiff_t) i);
+}
+
+template <typename T>
+static const T& at(const T* base, ptrdiff_t stride, size_t i) {
+    return *reinterpret_cast<const T*>(reinterpret_cast<const char*>(base) + stride * (ptrdiff_t) i);
+}
+
+static void set_serr(char* serr, const char* msg) {
+    if (serr != nullptr)
+        std::snprintf(serr, AS_MAXCH, "%s", msg);
+}
+
+// The caller's struct, with the fields it does not know zeroed
+static int32 read_batch(const struct parabola_batch* in, struct parabola_batch* b, char* serr) {
+    if (in == nullptr || in->size < (int32) offsetof(struct parabola_batch, ephe_path)) {
+        set_serr(serr, "parabola_batch: missing or too old, see parabola_batch_init()");
+        return ERR;
+    }
+    std::memset(b, 0, sizeof(*b));
+    std::memcpy(b, in, std::min<size_t>((size_t) in->size, sizeof(*b)));
+    b->size = (int32) sizeof(*b);
+    if (b->n < 0 || (b->n > 0 && (b->tjd_ut == nullptr || b->ipl == nullptr || b->xx == nullptr))) {
+        set_serr(serr, "parabola_batch: n < 0, or tjd_ut, ipl or xx is NULL");
+        return ERR;
+    }
+    return OK;
+}
+
+// No C++ exception may cross the C interface; they end up in serr
+static void set_serr_exception(char* serr) {
+    try {
+        throw;
+    } catch (const std::exception& e) {
+        set_serr(serr, e.what());
+    } catch (...) {
+        set_serr(serr, "unknown exception");
+    }
+}
+
+static int32 run_batch(const struct parabola_batch& b, const std::atomic<bool>* cancel, char* serr) try {
+    if (b.n == 0)
+        return OK;
+    ParabolaTraceScope span("parabola_calc_batch", "batch", (int64_t) b.n);
+    ParabolaTuning tuning = parabola_default_tuning();
+    if (b.ephe_path != nullptr)
+        tuning.ephe_path = b.ephe_path;
+    ParabolaParallelOptions opt;
+    opt.threads = b.threads > 0 ? (size_t) b.threads : tuning.threads;
+    opt.chunk = tuning.chunk;
+    opt.cancel = cancel;
+    std::atomic<bool> failed{false};
+    char first_serr[AS_MAXCH] = {0};
+    bool complete = parabola_for_range((size_t) b.n, [&](size_t begin, size_t end) {
+        parabola_bind_tuning(tuning);
+        for (size_t i = begin; i < end; ++i) {
+            double x[6];
+            char s[AS_MAXCH];
+            *s = '\0';
+            int32 iflag = b.iflag != nullptr ? at(b.iflag, b.iflag_stride, i) : SEFLG_SPEED;
+            int32 rf = swe_calc_ut(at(b.tjd_ut, b.tjd_stride, i), at(b.ipl, b.ipl_stride, i), iflag, x, s);
+            double* xx = &at(b.xx, b.xx_stride, i);
+            for (int k = 0; k < 6; ++k)
+                at(xx, b.xx_col_stride, k) = x[k];
+            if (b.retflag != nullptr)
+                at(b.retflag, b.retflag_stride, i) = rf;
+            if (b.serr != nullptr)
+                std::memcpy(&at(b.serr, b.serr_stride, i), s, AS_MAXCH);
+            if (rf < 0 && !failed.exchange(true))
+                std::memcpy(first_serr, s, AS_MAXCH);
+        }
+    }, opt);
+    if (!complete) {
+        set_serr(serr, "batch cancelled");
+        return ERR;
+    }
+    if (failed.load()) {
+        set_serr(serr, first_serr);
+        return ERR;
+    }
+    return OK;
+} catch (...) {
+    set_serr_exception(serr);
+    return ERR;
+}
+
+// Runs submitted jobs one after the other; each one is parallel in itself
+class JobQueue {
+public:
+    static JobQueue& instance() {
+        static JobQueue queue;
+        return queue;
+    }
+
+    void push(parabola_job* job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!thread.joinable())
+                thread = std::thread([this] { work(); });
+            jobs.push_back(job);
+        }
+        wake.notify_one();
+    }
+
+    ~JobQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_one();
+        if (thread.joinable())
+            thread.join();
+    }
+
+private:
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            parabola_job* job = jobs.front();
+            jobs.pop_front();
+            lock.unlock();
+            char serr[AS_MAXCH] = {0};
+            int32 retc = run_batch(job->batch, &job->cancel, serr);
+            {
+                // a waiter may free the job as soon as the lock is released
+                std::lock_guard<std::mutex> jl(job->mutex);
+                job->retc = retc;
+                std::memcpy(job->serr, serr, AS_MAXCH);
+                job->done.store(true, std::memory_order_release);
+                job->cv.notify_all();
+            }
+            lock.lock();
+        }
+    }
+
+    std::thread thread;
+    std::deque<parabola_job*> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop = false;
+};
+
+extern "C" {
+
+int32 parabola_abi_version(void) {
+    return PARABOLA_ABI_VERSION;
+}
+
+void parabola_batch_init(struct parabola_batch* b, int32 n, const double* tjd_ut, const int32* ipl,
+                         const int32* iflag, double* xx, int32* retflag) {
+    std::memset(b, 0, sizeof(*b));
+    b->size = (int32) sizeof(*b);
+    b->n = n;
+    b->tjd_ut = tjd_ut;
+    b->tjd_stride = sizeof(double);
+    b->ipl = ipl;
+    b->ipl_stride = sizeof(int32);
+    b->iflag = iflag;
+    b->iflag_stride = sizeof(int32);
+    b->xx = xx;
+    b->xx_stride = 6 * sizeof(double);
+    b->xx_col_stride = sizeof(double);
+    b->retflag = retflag;
+    b->retflag_stride = sizeof(int32);
+    b->serr_stride = AS_MAXCH;
+}
+
+int32 parabola_calc_batch(const struct parabola_batch* b, char* serr) {
+    struct parabola_batch batch;
+    if (read_batch(b, &batch, serr) != OK)
+        return ERR;
+    return run_batch(batch, nullptr, serr);
+}
+
+parabola_job* parabola_calc_submit(const struct parabola_batch* b, char* serr) {
+    parabola_job* job = nullptr;
+    try {
+        job = new parabola_job;
+        if (read_batch(b, &job->batch, serr) != OK) {
+            delete job;
+            return nullptr;
+        }
+        if (job->batch.ephe_path != nullptr) {
+            job->ephe_path = job->batch.ephe_path;
+            job->batch.ephe_path = job->ephe_path.c_str();
+        }
+        JobQueue::instance().push(job);
+        return job;
+    } catch (...) {
+        delete job;
+        set_serr_exception(serr);
+        return nullptr;
+    }
+}
+
+int32 parabola_job_poll(parabola_job* job) {
+    return job->done.load(std::memory_order_acquire) ? 1 : 0;
+}
+
+int32 parabola_job_wait(parabola_job* job, double timeout, char* serr) {
+    try {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        auto finished = [job] { return job->done.load(std::memory_order_acquire); };
+        if (timeout < 0)
+            job->cv.wait(lock, finished);
+        else if (!job->cv.wait_for(lock, std::chrono::duration<double>(timeout), finished))
+            return PARABOLA_BUSY;
+        if (job->retc != OK)
+            set_serr(serr, job->serr);
+        return job->retc;
+    } catch (...) {
+        set_serr_exception(serr);
+        return ERR;
+    }
+}
+
+void parabola_job_cancel(parabola_job* job) {
+    job->cancel.store(true, std::memory_order_relaxed);
+}
+
+void parabola_job_free(parabola_job* job) {
+    if (job == nullptr)
+        return;
+    parabola_job_wait(job, -1, nullptr);
+    delete job;
+}
+
+} // extern "C"
@@ -0,0 +1,86 @@
+/* parabola_capi.h
+ * C interface of the batch engine, for FFI callers (Python, Go, JNI)
+ *
+ * Inputs and outputs are arrays owned by the caller, addressed by a base
+ * pointer and a stride in bytes between elements, as numpy describes its
+ * arrays (a stride of 0 repeats one element for all). The engine writes
+ * the results straight into them and allocates nothing per element.
+ * The functions are thread-safe; all return OK or ERR, with the reason
+ * in serr (AS_MAXCH bytes) if serr is not NULL.
+ */
+#ifndef PARABOLA_CAPI_H
+#define PARABOLA_CAPI_H
+
+#include <stddef.h>
+#include "swephexp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PARABOLA_ABI_VERSION 1
+
+/* parabola_job_wait() timed out */
+#define PARABOLA_BUSY 1
+
+/* n calls of swe_calc_ut(tjd_ut[i], ipl[i], iflag[i], xx[i], serr[i]).
+ * Set it up with parabola_batch_init(), which fills in `size` and packed
+ * strides, and change what differs; fields added in later versions go to
+ * the end, so that `size` tells which ones the caller knows. */
+struct parabola_batch {
+  int32 size;                   /* sizeof(struct parabola_batch) */
+  int32 n;
+  const double *tjd_ut;         /* UT */
+  ptrdiff_t tjd_stride;
+  const int32 *ipl;
+  ptrdiff_t ipl_stride;
+  const int32 *iflag;           /* NULL = SEFLG_SPEED, as compute_batch() */
+  ptrdiff_t iflag_stride;
+  double *xx;                   /* 6 doubles per element */
+  ptrdiff_t xx_stride;          /* between elements */
+  ptrdiff_t xx_col_stride;      /* between the 6 doubles of an element */
+  int32 *retflag;               /* may be NULL */
+  ptrdiff_t retflag_stride;
+  char *serr;                   /* AS_MAXCH bytes per element; may be NULL */
+  ptrdiff_t serr_stride;
+  const char *ephe_path;        /* NULL = the profile's or the default */
+  int32 threads;                /* 0 = the profile's */
+};
+
+int32 parabola_abi_version(void);
+
+/* Packed arrays and no serr array. For one flag for all elements, set
+ * iflag_stride to 0 afterwards. */
+void parabola_batch_init(struct parabola_batch *b, int32 n, const double *tjd_ut, const int32 *ipl,
+                         const int32 *iflag, double *xx, int32 *retflag);
+
+/* Returns ERR if the batch is malformed, an element failed or the engine
+ * ran out of resources; retflag tells which elements failed, serr holds
+ * the first message. An empty batch (n == 0) returns OK. */
+int32 parabola_calc_batch(const struct parabola_batch *b, char *serr);
+
+/* Runs the batch in the background; batches submitted from anywhere run
+ * one after the other. The arrays must stay valid until the job is
+ * waited for or freed. Returns NULL if the batch is malformed. */
+typedef struct parabola_job parabola_job;
+parabola_job *parabola_calc_submit(const struct parabola_batch *b, char *serr);
+
+/* 1 if the job has finished, else 0 */
+int32 parabola_job_poll(parabola_job *job);
+
+/* Waits up to timeout seconds, for ever if timeout < 0. Returns
+ * PARABOLA_BUSY on timeout, else what parabola_calc_batch() would. */
+int32 parabola_job_wait(parabola_job *job, double timeout, char *serr);
+
+/* Skips the elements not computed yet; the job then ends with ERR and
+ * their outputs are undefined */
+void parabola_job_cancel(parabola_job *job);
+
+/* Waits for the job and releases it */
+void parabola_job_free(parabola_job *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARABOLA_CAPI_H */
@@ -0,0 +1,90 @@
+// parabola_cross.cpp
+// Batch longitude and node crossings (swe_solcross, swe_mooncross, swe_helio_cross)
+
+#include "parabola_cross.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+CrossingBatchResult compute_crossing_batch(const CrossingBatchRequest& req) {
+    CrossingBatchResult res;
+    size_t n = req.jd.size();
+    bool node = req.kind == CrossKind::MoonNode;
+    if (!node && req.x2cross.size() != n) {
+        res.errcode = ERR;
+        std::strcpy(res.serr, "compute_crossing_batch: x2cross and jd differ in size");
+        return res;
+    }
+    res.jd_cross.resize(n);
+    if (node) {
+        res.xlon.resize(n);
+        res.xlat.resize(n);
+    }
+    if (n == 0)
+        return res;
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&req](size_t a, size_t b) {
+        return req.jd[a] < req.jd[b];
+    });
+
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, std::min(nthreads, n));
+    size_t chunk = (n + nthreads - 1) / nthreads;
+
+    struct ChunkStatus {
+        int errcode = OK;
+        char serr[256] = {0};
+    };
+    ParabolaThreadPool pool(nthreads);
+    std::vector<std::future<ChunkStatus>> futures;
+    for (size_t k0 = 0; k0 < n; k0 += chunk) {
+        size_t k1 = std::min(n, k0 + chunk);
+        futures.emplace_back(pool.submit([&req, &res, &order, node, k0, k1]() {
+            ChunkStatus st;
+            parabola_bind_ephe_path(req.ephe_path);
+            size_t m = k1 - k0;
+            std::vector<double> x(m), jd(m), jc(m), lon(m), lat(m);
+            for (size_t k = 0; k < m; ++k) {
+                jd[k] = req.jd[order[k0 + k]];
+                if (!node)
+                    x[k] = req.x2cross[order[k0 + k]];
+            }
+            int32 retc = OK;
+            switch (req.kind) {
+            case CrossKind::Sun:
+                retc = swe_solcross_multi_ut(x.data(), jd.data(), (int32) m, req.iflag, jc.data(), st.serr);
+                break;
+            case CrossKind::Moon:
+                retc = swe_mooncross_multi_ut(x.data(), jd.data(), (int32) m, req.iflag, jc.data(), st.serr);
+                break;
+            case CrossKind::MoonNode:
+                retc = swe_mooncross_node_multi_ut(jd.data(), (int32) m, req.iflag, jc.data(), lon.data(), lat.data(), st.serr);
+                break;
+            case CrossKind::Helio:
+                retc = swe_helio_cross_multi_ut(req.ipl, x.data(), jd.data(), (int32) m, req.iflag, req.dir, jc.data(), st.serr);
+                break;
+            }
+            st.errcode = retc;
+            for (size_t k = 0; k < m; ++k) {
+                size_t i = order[k0 + k];
+                res.jd_cross[i] = jc[k];
+                if (node) {
+                    res.xlon[i] = lon[k];
+                    res.xlat[i] = lat[k];
+                }
+            }
+            return st;
+        }));
+    }
+    for (auto& fut : futures) {
+        ChunkStatus st = fut.get();
+        if (st.errcode == ERR && res.errcode == OK) {
+            res.errcode = ERR;
+            std::strcpy(res.serr, st.serr);
+        }
+    }
+    return res;
+}
@@ -0,0 +1,39 @@
+// parabola_cross.h
+// Batch longitude and node crossings (swe_solcross, swe_mooncross, swe_helio_cross)
+#pragma once
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+enum class CrossKind {
+    Sun,        // swe_solcross_ut()
+    Moon,       // swe_mooncross_ut()
+    MoonNode,   // swe_mooncross_node_ut(), x2cross is ignored
+    Helio       // swe_helio_cross_ut() of body `ipl`
+};
+
+struct CrossingBatchRequest {
+    CrossKind kind = CrossKind::Sun;
+    int32 ipl = SE_SUN;             // CrossKind::Helio only
+    int32 dir = 1;                  // CrossKind::Helio only; < 0 searches backward
+    std::vector<double> x2cross;    // target longitudes, one per start time
+    std::vector<double> jd;         // start times, UT
+    int32 iflag = SEFLG_SWIEPH;
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+// Element i belongs to x2cross[i] and jd[i]. Failed elements hold what the
+// scalar function returns on error.
+struct CrossingBatchResult {
+    std::vector<double> jd_cross;   // UT
+    std::vector<double> xlon;       // CrossKind::MoonNode only
+    std::vector<double> xlat;       // CrossKind::MoonNode only
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Sorts the elements by start time and hands each worker one contiguous run
+// of neighbouring start times, so that the swe_*cross_multi_ut() functions
+// can reuse ephemeris evaluations between neighbouring crossings.
+CrossingBatchResult compute_crossing_batch(const CrossingBatchRequest& req);
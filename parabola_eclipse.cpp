@@ -0,0 +1,405 @@
+// parabola_eclipse.cpp
+// Parallel eclipse catalog generator and Besselian-element eclipse geometry
+
+#include "parabola_eclipse.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Mean new moon of 2000 Jan 6 (Meeus, Astronomical Algorithms, ch. 49)
+// and the mean synodic month. Only used to place window borders, so the
+// mean values are more than accurate enough.
+static const double MEAN_NEW_MOON_J2000 = 2451550.09766;
+static const double SYNODIC_MONTH = 29.530588861;
+
+struct EclipseWindow {
+    double tjd_start;
+    double tjd_end;
+};
+
+struct EclipseWindowResult {
+    std::vector<EclipseRecord> eclipses;
+    int32 errcode = OK;
+    char serr[256] = {0};
+};
+
+// Window borders lie on full moons for solar and on new moons for lunar
+// catalogs, i.e. as far as possible from any eclipse of the requested kind,
+// so no eclipse can be found by two neighbouring windows.
+static std::vector<EclipseWindow> make_windows(const EclipseCatalogRequest& req) {
+    std::vector<EclipseWindow> windows;
+    double phase = (req.kind == EclipseKind::Solar) ? 0.5 : 0.0;
+    double span = SYNODIC_MONTH * std::max<size_t>(1, req.lunations_per_window);
+    double k = std::floor((req.tjd_start - MEAN_NEW_MOON_J2000) / SYNODIC_MONTH - phase);
+    double border = MEAN_NEW_MOON_J2000 + (k + phase) * SYNODIC_MONTH + span;
+    double t = req.tjd_start;
+    while (t < req.tjd_end) {
+        double te = std::min(border, req.tjd_end);
+        if (te > t)
+            windows.push_back({t, te});
+        t = te;
+        border += span;
+    }
+    return windows;
+}
+
+static EclipseWindowResult search_window(const EclipseCatalogRequest& req, const EclipseWindow& w) {
+    EclipseWindowResult res;
+    parabola_bind_ephe_path(req.ephe_path);
+    double t = w.tjd_start;
+    while (true) {
+        EclipseRecord rec;
+        std::memset(&rec, 0, sizeof(rec));
+        int32 retflag;
+        if (req.kind == EclipseKind::Solar)
+            retflag = swe_sol_eclipse_when_glob(t, req.ifl, req.ifltype, rec.tret, 0, res.serr);
+        else
+            retflag = swe_lun_eclipse_when(t, req.ifl, req.ifltype, rec.tret, 0, res.serr);
+        if (retflag == ERR) {
+            res.errcode = ERR;
+            return res;
+        }
+        if (rec.tret[0] >= w.tjd_end)
+            break;
+        rec.retflag = retflag;
+        if (req.kind == EclipseKind::Solar) {
+            if (swe_sol_eclipse_where(rec.tret[0], req.ifl, rec.geopos, rec.attr, res.serr) == ERR) {
+                res.errcode = ERR;
+                return res;
+            }
+        } else {
+            double geopos[3] = {0, 0, 0};
+            if (swe_lun_eclipse_how(rec.tret[0], req.ifl, geopos, rec.attr, res.serr) == ERR) {
+                res.errcode = ERR;
+                return res;
+            }
+        }
+        res.eclipses.push_back(rec);
+        // eclipses of one kind are at least a lunation apart
+        t = rec.tret[0] + SYNODIC_MONTH / 2;
+    }
+    return res;
+}
+
+int32 stream_eclipse_catalog(const EclipseCatalogRequest& req, const EclipseSink& sink, char* serr) {
+    if (serr) *serr = '\0';
+    std::vector<EclipseWindow> windows = make_windows(req);
+    if (windows.empty())
+        return OK;
+
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, std::min(nthreads, windows.size()));
+    ParabolaThreadPool pool(nthreads);
+    std::vector<std::future<EclipseWindowResult>> futures;
+    futures.reserve(windows.size());
+    for (const auto& w : windows)
+        futures.emplace_back(pool.submit([&req, w]() { return search_window(req, w); }));
+
+    // merge in window order; later windows keep running while we stream
+    int32 retc = OK;
+    for (auto& fut : futures) {
+        EclipseWindowResult r = fut.get();
+        if (retc == ERR)
+            continue;
+        if (r.errcode == ERR) {
+            retc = ERR;
+            if (serr) std::strcpy(serr, r.serr);
+            continue;
+        }
+        for (const auto& rec : r.eclipses)
+            sink(rec);
+    }
+    return retc;
+}
+
+EclipseCatalog compute_eclipse_catalog(const EclipseCatalogRequest& req) {
+    EclipseCatalog cat;
+    cat.errcode = stream_eclipse_catalog(req, [&cat](const EclipseRecord& rec) {
+        cat.eclipses.push_back(rec);
+    }, cat.serr);
+    return cat;
+}
+
+// ---------------------------------------------------------------------------
+// Eclipse geometry
+// ---------------------------------------------------------------------------
+
+// Same Earth, Sun and Moon dimensions as swecl.c, in equatorial Earth radii.
+static const double EARTH_RADIUS_M = 6378140.0;
+static const double AUNIT_M = 1.49597870700e+11;
+static const double SUN_RADIUS_ER = 1392000000.0 / 2 / EARTH_RADIUS_M;
+static const double MOON_RADIUS_ER = 3476300.0 / 2 / EARTH_RADIUS_M;
+static const double EARTH_FLATTENING = 1.0 / 298.25642;
+
+static double cheb_eval(const ChebSeries& s, double u) {
+    // Clenshaw recurrence, u in [-1, 1]
+    double b1 = 0, b2 = 0;
+    for (int j = ECLIPSE_MODEL_NCOEF - 1; j >= 1; --j) {
+        double b0 = 2 * u * b1 - b2 + s.c[j];
+        b2 = b1;
+        b1 = b0;
+    }
+    return u * b1 - b2 + s.c[0] / 2;
+}
+
+static void cheb_fit(const double* f, ChebSeries* s) {
+    const int n = ECLIPSE_MODEL_NCOEF;
+    for (int j = 0; j < n; ++j) {
+        double sum = 0;
+        for (int k = 0; k < n; ++k)
+            sum += f[k] * std::cos(M_PI * j * (k + 0.5) / n);
+        s->c[j] = 2.0 * sum / n;
+    }
+}
+
+static int32 sample_elements(double tjd_ut, int32 ifl, BesselianElements* be, char* serr) {
+    double xs[6], xm[6];
+    int32 iflag = (ifl & (SEFLG_JPLEPH | SEFLG_SWIEPH | SEFLG_MOSEPH)) | SEFLG_EQUATORIAL | SEFLG_XYZ;
+    double tjd = tjd_ut + swe_deltat_ex(tjd_ut, ifl, serr);
+    if (swe_calc(tjd, SE_SUN, iflag, xs, serr) == ERR)
+        return ERR;
+    if (swe_calc(tjd, SE_MOON, iflag, xm, serr) == ERR)
+        return ERR;
+    double scale = AUNIT_M / EARTH_RADIUS_M;
+    double g[3];
+    for (int i = 0; i < 3; ++i) {
+        xs[i] *= scale;
+        xm[i] *= scale;
+        g[i] = xs[i] - xm[i];
+    }
+    double gd = std::sqrt(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+    double a = std::atan2(g[1], g[0]);
+    double d = std::asin(g[2] / gd);
+    double sa = std::sin(a), ca = std::cos(a), sd = std::sin(d), cd = std::cos(d);
+    be->x = -xm[0] * sa + xm[1] * ca;
+    be->y = -xm[0] * sd * ca - xm[1] * sd * sa + xm[2] * cd;
+    double z = xm[0] * cd * ca + xm[1] * cd * sa + xm[2] * sd;
+    double sinf1 = (SUN_RADIUS_ER + MOON_RADIUS_ER) / gd;
+    double sinf2 = (SUN_RADIUS_ER - MOON_RADIUS_ER) / gd;
+    be->tan_f1 = sinf1 / std::sqrt(1 - sinf1 * sinf1);
+    be->tan_f2 = sinf2 / std::sqrt(1 - sinf2 * sinf2);
+    be->l1 = (z + MOON_RADIUS_ER / sinf1) * be->tan_f1;
+    be->l2 = (z - MOON_RADIUS_ER / sinf2) * be->tan_f2;
+    be->d = d;
+    be->mu = swe_sidtime(tjd_ut) * 15 * DEGTORAD - a;
+    return OK;
+}
+
+int32 build_eclipse_model(double tjd_start, double tjd_end, int32 ifl, EclipseModel* model, char* serr) {
+    const int n = ECLIPSE_MODEL_NCOEF;
+    double fx[n], fy[n], fd[n], fmu[n], fl1[n], fl2[n], ftf1[n], ftf2[n];
+    double mid = (tjd_start + tjd_end) / 2, half = (tjd_end - tjd_start) / 2;
+    model->tjd_start = tjd_start;
+    model->tjd_end = tjd_end;
+    for (int k = 0; k < n; ++k) {
+        BesselianElements be;
+        double t = mid + half * std::cos(M_PI * (k + 0.5) / n);
+        if (sample_elements(t, ifl, &be, serr) == ERR)
+            return ERR;
+        fx[k] = be.x;
+        fy[k] = be.y;
+        fd[k] = be.d;
+        fl1[k] = be.l1;
+        fl2[k] = be.l2;
+        ftf1[k] = be.tan_f1;
+        ftf2[k] = be.tan_f2;
+        // unwrap the hour angle against the previous node
+        fmu[k] = be.mu;
+        if (k > 0)
+            fmu[k] -= 2 * M_PI * std::round((fmu[k] - fmu[k - 1]) / (2 * M_PI));
+    }
+    cheb_fit(fx, &model->x);
+    cheb_fit(fy, &model->y);
+    cheb_fit(fd, &model->d);
+    cheb_fit(fmu, &model->mu);
+    cheb_fit(fl1, &model->l1);
+    cheb_fit(fl2, &model->l2);
+    cheb_fit(ftf1, &model->tan_f1);
+    cheb_fit(ftf2, &model->tan_f2);
+    return OK;
+}
+
+int32 build_eclipse_model(const EclipseRecord& rec, int32 ifl, EclipseModel* model, char* serr) {
+    // tret[2]/tret[3]: first and last contact of the penumbra with the Earth
+    double t0 = rec.tret[2] != 0 ? rec.tret[2] : rec.tret[0] - 0.2;
+    double t1 = rec.tret[3] != 0 ? rec.tret[3] : rec.tret[0] + 0.2;
+    return build_eclipse_model(t0 - 0.01, t1 + 0.01, ifl, model, serr);
+}
+
+BesselianElements eclipse_model_elements(const EclipseModel& model, double tjd_ut) {
+    double half = (model.tjd_end - model.tjd_start) / 2;
+    double u = (tjd_ut - model.tjd_start - half) / half;
+    BesselianElements be;
+    be.x = cheb_eval(model.x, u);
+    be.y = cheb_eval(model.y, u);
+    be.d = cheb_eval(model.d, u);
+    be.mu = cheb_eval(model.mu, u);
+    be.l1 = cheb_eval(model.l1, u);
+    be.l2 = cheb_eval(model.l2, u);
+    be.tan_f1 = cheb_eval(model.tan_f1, u);
+    be.tan_f2 = cheb_eval(model.tan_f2, u);
+    return be;
+}
+
+// The fundamental frame is rotated so that the shadow axis has right
+// ascension 0; geographic longitude is then the point's right ascension
+// minus mu. The Earth is the ellipsoid X^2 + Y^2 + (Z / (1 - f))^2 = 1.
+
+// Solves for the Moon-facing surface point with fundamental coordinates
+// (xi, eta); returns false if (xi, eta) lies outside the Earth's disk.
+static bool surface_zeta(const BesselianElements& be, double xi, double eta, double* zeta) {
+    double sd = std::sin(be.d), cd = std::cos(be.d);
+    double b = 1 / ((1 - EARTH_FLATTENING) * (1 - EARTH_FLATTENING));
+    double A = cd * cd + b * sd * sd;
+    double B = 2 * eta * sd * cd * (b - 1);
+    double C = eta * eta * (sd * sd + b * cd * cd) + xi * xi - 1;
+    double disc = B * B - 4 * A * C;
+    if (disc < 0)
+        return false;
+    *zeta = (-B + std::sqrt(disc)) / (2 * A);
+    return true;
+}
+
+static EclipseGeoPoint fundamental_to_geo(const BesselianElements& be, double xi, double eta, double zeta) {
+    double sd = std::sin(be.d), cd = std::cos(be.d);
+    double X = zeta * cd - eta * sd;
+    double Y = xi;
+    double Z = zeta * sd + eta * cd;
+    double f1 = (1 - EARTH_FLATTENING) * (1 - EARTH_FLATTENING);
+    EclipseGeoPoint p;
+    p.lat = std::atan2(Z, f1 * std::sqrt(X * X + Y * Y)) * RADTODEG;
+    p.lon = swe_degnorm((std::atan2(Y, X) - be.mu) * RADTODEG);
+    if (p.lon > 180) p.lon -= 360;
+    p.valid = true;
+    return p;
+}
+
+static void geo_to_fundamental(const BesselianElements& be, const EclipseGeoPoint& p, double* xi, double* eta) {
+    double f1 = (1 - EARTH_FLATTENING) * (1 - EARTH_FLATTENING);
+    double lat = p.lat * DEGTORAD;
+    // geocentric latitude and radius on the ellipsoid
+    double latc = std::atan(f1 * std::tan(lat));
+    double r = (1 - EARTH_FLATTENING) / std::sqrt(1 - (2 * EARTH_FLATTENING - EARTH_FLATTENING * EARTH_FLATTENING) * std::cos(latc) * std::cos(latc));
+    double ra = p.lon * DEGTORAD + be.mu;
+    double X = r * std::cos(latc) * std::cos(ra);
+    double Y = r * std::cos(latc) * std::sin(ra);
+    double Z = r * std::sin(latc);
+    double sd = std::sin(be.d), cd = std::cos(be.d);
+    *xi = Y;
+    *eta = -X * sd + Z * cd;
+}
+
+// Point of the shadow edge in direction q (from north through east);
+// umbra uses l2/tan f2, penumbra l1/tan f1.
+static EclipseGeoPoint edge_point(const BesselianElements& be, double q, bool umbra, double* zeta_out) {
+    double l = umbra ? be.l2 : be.l1;
+    double tf = umbra ? be.tan_f2 : be.tan_f1;
+    double zeta = 0;
+    EclipseGeoPoint p = {0, 0, false};
+    for (int iter = 0; iter < 4; ++iter) {
+        double L = std::fabs(l - zeta * tf);
+        double xi = be.x + L * std::sin(q);
+        double eta = be.y + L * std::cos(q);
+        if (!surface_zeta(be, xi, eta, &zeta))
+            return p;
+        if (iter == 3)
+            p = fundamental_to_geo(be, xi, eta, zeta);
+    }
+    if (zeta_out) *zeta_out = zeta;
+    return p;
+}
+
+// Northern and southern limit at one instant: the edge points where the
+// shadow moves tangentially to its own edge relative to the rotating Earth.
+static void limit_points(const EclipseModel& model, double t, bool umbra, EclipseGeoPoint* north, EclipseGeoPoint* south) {
+    const double h = 1.0 / 1440;  // one minute
+    BesselianElements be = eclipse_model_elements(model, t);
+    BesselianElements be2 = eclipse_model_elements(model, t + h);
+    EclipseGeoPoint lim[2];
+    for (int side = 0; side < 2; ++side) {
+        // start perpendicular to the motion of the shadow axis
+        double q = std::atan2(-(be2.y - be.y), be2.x - be.x) + side * M_PI;
+        EclipseGeoPoint p = {0, 0, false};
+        for (int iter = 0; iter < 4; ++iter) {
+            p = edge_point(be, q, umbra, NULL);
+            if (!p.valid)
+                break;
+            double xi, eta, xi2, eta2;
+            geo_to_fundamental(be, p, &xi, &eta);
+            geo_to_fundamental(be2, p, &xi2, &eta2);
+            double vx = (be2.x - be.x) - (xi2 - xi);
+            double vy = (be2.y - be.y) - (eta2 - eta);
+            double qn = std::atan2(-vy, vx);
+            // keep the side we started on
+            if (std::cos(qn - q) < 0) qn += M_PI;
+            q = qn;
+        }
+        lim[side] = p;
+    }
+    // side 0 is north of an eastward shadow axis; a single valid limit
+    // keeps its side
+    if (lim[0].valid && lim[1].valid && lim[1].lat > lim[0].lat)
+        std::swap(lim[0], lim[1]);
+    *north = lim[0];
+    *south = lim[1];
+}
+
+static EclipsePathSample path_sample(const EclipseModel& model, double t) {
+    EclipsePathSample s;
+    s.tjd_ut = t;
+    BesselianElements be = eclipse_model_elements(model, t);
+    double zeta;
+    if (surface_zeta(be, be.x, be.y, &zeta))
+        s.central = fundamental_to_geo(be, be.x, be.y, zeta);
+    else
+        s.central = {0, 0, false};
+    limit_points(model, t, true, &s.umbra_north, &s.umbra_south);
+    limit_points(model, t, false, &s.penumbra_north, &s.penumbra_south);
+    return s;
+}
+
+// Splits [0, n) into one contiguous chunk per worker and runs fn(i) on it.
+template <typename Fn>
+static void parallel_chunks(size_t n, size_t threads, Fn fn) {
+    size_t nthreads = threads ? threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, std::min(nthreads, n));
+    ParabolaThreadPool pool(nthreads);
+    std::vector<std::future<void>> futures;
+    size_t chunk = (n + nthreads - 1) / nthreads;
+    for (size_t i0 = 0; i0 < n; i0 += chunk) {
+        size_t i1 = std::min(n, i0 + chunk);
+        futures.emplace_back(pool.submit([&fn, i0, i1]() {
+            for (size_t i = i0; i < i1; ++i) fn(i);
+        }));
+    }
+    for (auto& f : futures) f.get();
+}
+
+std::vector<EclipsePathSample> compute_eclipse_path(const EclipseModel& model, double step, size_t threads) {
+    std::vector<EclipsePathSample> path;
+    if (step <= 0 || model.tjd_end <= model.tjd_start)
+        return path;
+    size_t n = (size_t) ((model.tjd_end - model.tjd_start) / step) + 1;
+    path.resize(n);
+    parallel_chunks(n, threads, [&](size_t i) {
+        path[i] = path_sample(model, model.tjd_start + i * step);
+    });
+    return path;
+}
+
+std::vector<EclipseGeoPoint> compute_shadow_outline(const EclipseModel& model, double tjd_ut, bool umbra, size_t npoints) {
+    std::vector<EclipseGeoPoint> outline(npoints);
+    BesselianElements be = eclipse_model_elements(model, tjd_ut);
+    for (size_t i = 0; i < npoints; ++i)
+        outline[i] = edge_point(be, 2 * M_PI * i / npoints, umbra, NULL);
+    return outline;
+}
+
+std::vector<std::vector<EclipseGeoPoint>> compute_shadow_outlines(const EclipseModel& model, const std::vector<double>& times, bool umbra, size_t npoints, size_t threads) {
+    std::vector<std::vector<EclipseGeoPoint>> outlines(times.size());
+    parallel_chunks(times.size(), threads, [&](size_t i) {
+        outlines[i] = compute_shadow_outline(model, times[i], umbra, npoints);
+    });
+    return outlines;
+}
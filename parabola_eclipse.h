@@ -0,0 +1,116 @@
+// parabola_eclipse.h
+// Parallel eclipse catalog generator and Besselian-element eclipse geometry
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+enum class EclipseKind {
+    Solar,
+    Lunar
+};
+
+// One catalog entry: exactly what swe_sol_eclipse_when_glob() /
+// swe_lun_eclipse_when() return in tret, plus the attributes of the
+// eclipse at maximum (swe_sol_eclipse_where() / swe_lun_eclipse_how()).
+struct EclipseRecord {
+    int32 retflag;      // SE_ECL_* type bits of the eclipse
+    double tret[10];    // contact times (UT), see swe_*_eclipse_when()
+    double attr[20];    // attributes at maximum eclipse
+    double geopos[10];  // solar only: central line / greatest eclipse position
+};
+
+struct EclipseCatalogRequest {
+    EclipseKind kind = EclipseKind::Solar;
+    double tjd_start = 0;           // UT, inclusive
+    double tjd_end = 0;             // UT, exclusive (time of maximum)
+    int32 ifl = SEFLG_SWIEPH;       // ephemeris flag
+    int32 ifltype = 0;              // SE_ECL_* filter, 0 = all types
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t lunations_per_window = 24;
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+struct EclipseCatalog {
+    std::vector<EclipseRecord> eclipses;
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Receives each eclipse on the calling thread, strictly in time order.
+using EclipseSink = std::function<void(const EclipseRecord&)>;
+
+// Splits [tjd_start, tjd_end) into lunation-aligned windows whose borders
+// fall half a lunation away from the syzygies that can produce an eclipse
+// of the requested kind, searches the windows concurrently and hands the
+// merged result to `sink` in order, window by window as they complete.
+// Returns OK or ERR; on ERR `serr` holds the first failing window's message
+// and every eclipse before that window has already been delivered.
+int32 stream_eclipse_catalog(const EclipseCatalogRequest& req, const EclipseSink& sink, char* serr);
+
+// Convenience wrapper collecting the whole catalog in memory.
+EclipseCatalog compute_eclipse_catalog(const EclipseCatalogRequest& req);
+
+// ---------------------------------------------------------------------------
+// Eclipse geometry: Besselian elements and shadow footprints
+//
+// build_eclipse_model() samples the apparent Sun and Moon once at Chebyshev
+// nodes over the eclipse and fits the Besselian elements; every path point
+// and outline is then evaluated from the fit, without further ephemeris
+// calls, so any resolution costs only arithmetic.
+// ---------------------------------------------------------------------------
+
+#define ECLIPSE_MODEL_NCOEF 13
+
+struct ChebSeries {
+    double c[ECLIPSE_MODEL_NCOEF];
+};
+
+struct EclipseModel {
+    double tjd_start;   // UT
+    double tjd_end;     // UT
+    ChebSeries x, y;    // shadow axis on the fundamental plane, Earth radii
+    ChebSeries d;       // declination of the shadow axis, radians
+    ChebSeries mu;      // Greenwich hour angle of the shadow axis, radians
+    ChebSeries l1, l2;  // penumbra / umbra radius on the fundamental plane
+    ChebSeries tan_f1, tan_f2;
+};
+
+// Besselian elements evaluated at one instant.
+struct BesselianElements {
+    double x, y, d, mu, l1, l2, tan_f1, tan_f2;
+};
+
+struct EclipseGeoPoint {
+    double lon;     // degrees, east positive
+    double lat;     // geodetic degrees
+    bool valid;     // false if the point falls off the Earth
+};
+
+struct EclipsePathSample {
+    double tjd_ut;
+    EclipseGeoPoint central;
+    EclipseGeoPoint umbra_north, umbra_south;
+    EclipseGeoPoint penumbra_north, penumbra_south;
+};
+
+// Fits the model over [tjd_start, tjd_end] (UT). ifl is the ephemeris flag.
+int32 build_eclipse_model(double tjd_start, double tjd_end, int32 ifl, EclipseModel* model, char* serr);
+
+// Same, spanning the global begin/end times of a solar catalog record.
+int32 build_eclipse_model(const EclipseRecord& rec, int32 ifl, EclipseModel* model, char* serr);
+
+BesselianElements eclipse_model_elements(const EclipseModel& model, double tjd_ut);
+
+// Central line and northern/southern umbral and penumbral limits at
+// `step` day resolution across the model span, evaluated in parallel.
+std::vector<EclipsePathSample> compute_eclipse_path(const EclipseModel& model, double step, size_t threads = 0);
+
+// Umbra (or penumbra) outline on the ground at one instant, `npoints`
+// points around the shadow axis; points beyond the limb are invalid.
+std::vector<EclipseGeoPoint> compute_shadow_outline(const EclipseModel& model, double tjd_ut, bool umbra, size_t npoints);
+
+// Outlines for many instants in parallel, in the order of `times`.
+std::vector<std::vector<EclipseGeoPoint>> compute_shadow_outlines(const EclipseModel& model, const std::vector<double>& times, bool umbra, size_t npoints, size_t threads = 0);
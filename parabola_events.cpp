@@ -0,0 +1,113 @@
+// parabola_events.cpp
+// Parallel time-slab scans for mundane aspects, transits and ingresses
+
+#include "parabola_events.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cstring>
+
+struct EventSlab {
+    double tjd_start;
+    double tjd_end;
+};
+
+struct EventSlabResult {
+    std::vector<EVENT> events;
+    int32 errcode = OK;
+    char serr[256] = {0};
+};
+
+// The iterator advances with t += tstep, so the slab borders are taken
+// from the very same sum rather than from tjd_start + k * tstep: a slab
+// then steps through exactly the doubles the serial run would, and the
+// last window of a slab is never shortened.
+static std::vector<EventSlab> make_slabs(const EventScanRequest& req, size_t nthreads) {
+    std::vector<EventSlab> slabs;
+    double tstep = req.tstep;
+    if (tstep <= 0)
+        tstep = (req.itype & SWEV_PROXY) ? SWEV_PROXY_WINDOW : SWEV_TSTEP;
+    size_t nsteps = 0;
+    for (double t = req.tjd_start; t < req.tjd_end; t += tstep)
+        ++nsteps;
+    if (nsteps == 0)
+        return slabs;
+    size_t per_slab = req.steps_per_slab;
+    if (per_slab == 0)
+        per_slab = std::max<size_t>(1, (nsteps + 4 * nthreads - 1) / (4 * nthreads));
+    size_t k = 0;
+    for (double t = req.tjd_start; t < req.tjd_end; t += tstep, ++k) {
+        if (k % per_slab != 0)
+            continue;
+        if (!slabs.empty())
+            slabs.back().tjd_end = t;
+        slabs.push_back({t, req.tjd_end});
+    }
+    return slabs;
+}
+
+static EventSlabResult scan_slab(const EventScanRequest& req, const EventSlab& s) {
+    EventSlabResult res;
+    parabola_bind_ephe_path(req.ephe_path);
+    // the C interface takes non-const strings
+    std::vector<char> splan(req.splan.begin(), req.splan.end());
+    std::vector<char> sasp(req.sasp.begin(), req.sasp.end());
+    std::vector<double> dpos(req.dpos);
+    splan.push_back('\0');
+    sasp.push_back('\0');
+    EVITER* pit = swev_iter_open(req.iflag, req.itype, s.tjd_start, s.tjd_end, req.tstep,
+                                 splan.data(), sasp.data(), (int32) dpos.size(), dpos.data(), res.serr);
+    if (pit == NULL) {
+        res.errcode = ERR;
+        return res;
+    }
+    EVENT ev;
+    int32 retc;
+    while ((retc = swev_iter_next(pit, &ev, res.serr)) == 1)
+        res.events.push_back(ev);
+    swev_iter_close(pit);
+    if (retc == ERR)
+        res.errcode = ERR;
+    return res;
+}
+
+int32 stream_event_scan(const EventScanRequest& req, const EventSink& sink, char* serr) {
+    if (serr) *serr = '\0';
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, nthreads);
+    std::vector<EventSlab> slabs = make_slabs(req, nthreads);
+    if (slabs.empty())
+        return OK;
+
+    nthreads = std::min(nthreads, slabs.size());
+    ParabolaThreadPool pool(nthreads);
+    std::vector<std::future<EventSlabResult>> futures;
+    futures.reserve(slabs.size());
+    for (const auto& s : slabs)
+        futures.emplace_back(pool.submit([&req, s]() { return scan_slab(req, s); }));
+
+    // Each slab's events are in time order and the slabs do not overlap,
+    // so merging them is concatenation in slab order; later slabs keep
+    // running while we stream.
+    int32 retc = OK;
+    for (auto& fut : futures) {
+        EventSlabResult r = fut.get();
+        if (retc == ERR)
+            continue;
+        if (r.errcode == ERR) {
+            retc = ERR;
+            if (serr) std::strcpy(serr, r.serr);
+            continue;
+        }
+        for (const auto& ev : r.events)
+            sink(ev);
+    }
+    return retc;
+}
+
+EventScan compute_event_scan(const EventScanRequest& req) {
+    EventScan scan;
+    scan.errcode = stream_event_scan(req, [&scan](const EVENT& ev) {
+        scan.events.push_back(ev);
+    }, scan.serr);
+    return scan;
+}
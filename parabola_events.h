@@ -0,0 +1,46 @@
+// parabola_events.h
+// Parallel time-slab scans for mundane aspects, transits and ingresses
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "swephexp.h"
+extern "C" {
+#include "swevents.h"
+}
+
+struct EventScanRequest {
+    int32 iflag = SEFLG_SWIEPH;     // ephemeris and position flags
+    int32 itype = CTYP_MASPECTS;    // CTYP_MASPECTS / TRANSITS / INGRESSES, may include SWEV_PROXY
+    double tjd_start = 0;           // TT, inclusive
+    double tjd_end = 0;             // TT, exclusive
+    double tstep = 0;               // search step (window with SWEV_PROXY); 0 = iterator default
+    std::string splan = SPLAN_ASPECTS;
+    std::string sasp = SASP_ASPECTS;
+    std::vector<double> dpos;       // positions for transits, ignored otherwise
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t steps_per_slab = 0;      // 0 = about four slabs per thread
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+struct EventScan {
+    std::vector<EVENT> events;
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Receives each event on the calling thread, strictly in time order.
+using EventSink = std::function<void(const EVENT&)>;
+
+// Cuts [tjd_start, tjd_end) into slabs of whole search steps, runs one
+// event iterator per slab concurrently and hands the merged events to
+// `sink` slab by slab as they complete. Slab borders are points of the
+// serial step grid, so every step is searched by exactly one slab and the
+// events are identical to those of a single swev_iter_open() over the whole
+// range, in the same order. Returns OK or ERR; on ERR `serr` holds the
+// first failing slab's message and every event before that slab has
+// already been delivered.
+int32 stream_event_scan(const EventScanRequest& req, const EventSink& sink, char* serr);
+
+// Convenience wrapper collecting all events in memory.
+EventScan compute_event_scan(const EventScanRequest& req);
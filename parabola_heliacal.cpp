@@ -0,0 +1,96 @@
+// parabola_heliacal.cpp
+// Visibility maps: limiting magnitude over latitude x longitude x date grids
+
+#include "parabola_heliacal.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+VisibilityGridResult compute_visibility_grid(const VisibilityGridRequest& req) {
+    VisibilityGridResult res;
+    res.ntimes = req.jd.size();
+    res.nlat = req.lat.size();
+    res.nlon = req.lon.size();
+    size_t nplane = res.nlat * res.nlon;
+    size_t n = res.ntimes * nplane;
+    res.limiting_magnitude.resize(n);
+    res.object_alt.resize(n);
+    res.object_azi.resize(n);
+    res.sun_alt.resize(n);
+    res.sun_azi.resize(n);
+    res.moon_alt.resize(n);
+    res.moon_azi.resize(n);
+    res.object_magnitude.resize(n);
+    res.retflag.resize(n);
+    if (n == 0)
+        return res;
+    if (req.object.size() >= AS_MAXCH) {
+        res.errcode = ERR;
+        std::strcpy(res.serr, "object name too long");
+        return res;
+    }
+
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, nthreads);
+    // every task handles one epoch; split the rows when epochs are scarce
+    size_t bands = std::min(res.nlat, (nthreads + res.ntimes - 1) / res.ntimes);
+    size_t rows = (res.nlat + bands - 1) / bands;
+
+    struct TaskStatus {
+        int errcode = OK;
+        char serr[256] = {0};
+    };
+    ParabolaThreadPool pool(std::min(nthreads, res.ntimes * bands));
+    std::vector<std::future<TaskStatus>> futures;
+    for (size_t it = 0; it < res.ntimes; ++it) {
+        for (size_t r0 = 0; r0 < res.nlat; r0 += rows) {
+            size_t r1 = std::min(res.nlat, r0 + rows);
+            futures.emplace_back(pool.submit([&req, &res, nplane, it, r0, r1]() {
+                TaskStatus st;
+                parabola_bind_ephe_path(req.ephe_path);
+                size_t ngeo = (r1 - r0) * res.nlon;
+                std::vector<double> dgeo(3 * ngeo), dret(8 * ngeo);
+                for (size_t ilat = r0, k = 0; ilat < r1; ++ilat) {
+                    for (size_t ilon = 0; ilon < res.nlon; ++ilon, ++k) {
+                        dgeo[3 * k] = req.lon[ilon];
+                        dgeo[3 * k + 1] = req.lat[ilat];
+                        dgeo[3 * k + 2] = req.height;
+                    }
+                }
+                double datm[4], dobs[6];
+                std::copy(req.datm, req.datm + 4, datm);
+                std::copy(req.dobs, req.dobs + 6, dobs);
+                char object[AS_MAXCH];
+                std::snprintf(object, sizeof(object), "%s", req.object.c_str());
+                size_t base = it * nplane + r0 * res.nlon;
+                char serr[AS_MAXCH];
+                if (swe_vis_limit_mag_grid(req.jd[it], dgeo.data(), (int32) ngeo, datm, dobs, object,
+                                           req.helflag, dret.data(), &res.retflag[base], serr) == ERR) {
+                    st.errcode = ERR;
+                    std::snprintf(st.serr, sizeof(st.serr), "%s", serr);
+                }
+                for (size_t k = 0; k < ngeo; ++k) {
+                    const double* d = &dret[8 * k];
+                    res.limiting_magnitude[base + k] = d[0];
+                    res.object_alt[base + k] = d[1];
+                    res.object_azi[base + k] = d[2];
+                    res.sun_alt[base + k] = d[3];
+                    res.sun_azi[base + k] = d[4];
+                    res.moon_alt[base + k] = d[5];
+                    res.moon_azi[base + k] = d[6];
+                    res.object_magnitude[base + k] = d[7];
+                }
+                return st;
+            }));
+        }
+    }
+    for (auto& fut : futures) {
+        TaskStatus st = fut.get();
+        if (st.errcode == ERR && res.errcode == OK) {
+            res.errcode = ERR;
+            std::strcpy(res.serr, st.serr);
+        }
+    }
+    return res;
+}
@@ -0,0 +1,44 @@
+// parabola_heliacal.h
+// Visibility maps: limiting magnitude over latitude x longitude x date grids
+#pragma once
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+struct VisibilityGridRequest {
+    std::vector<double> jd;             // UT
+    std::vector<double> lat;            // geographic latitude, degrees
+    std::vector<double> lon;            // geographic longitude, degrees east
+    double height = 0;                  // eye height above sea level, m
+    double datm[4] = {0, 0, 0, 0};      // pressure, temperature, humidity, extinction; see swe_vis_limit_mag()
+    double dobs[6] = {0, 0, 0, 0, 0, 0}; // observer age, Snellen ratio, optics; see swe_vis_limit_mag()
+    std::string object;                 // "venus", "moon", a star name, ...
+    int32 helflag = SEFLG_SWIEPH;       // SE_HELFLAG_* | ephemeris flag
+    std::string ephe_path;              // bound in every worker; empty = default
+    size_t threads = 0;                 // 0 = std::thread::hardware_concurrency()
+};
+
+// One column per swe_vis_limit_mag() output. Element
+// [(it * nlat + ilat) * nlon + ilon] belongs to jd[it], lat[ilat], lon[ilon].
+struct VisibilityGridResult {
+    size_t ntimes = 0;
+    size_t nlat = 0;
+    size_t nlon = 0;
+    std::vector<double> limiting_magnitude; // dret[0], -100 if the object is below the horizon
+    std::vector<double> object_alt;         // dret[1]
+    std::vector<double> object_azi;         // dret[2]
+    std::vector<double> sun_alt;            // dret[3]
+    std::vector<double> sun_azi;            // dret[4]
+    std::vector<double> moon_alt;           // dret[5]
+    std::vector<double> moon_azi;           // dret[6]
+    std::vector<double> object_magnitude;   // dret[7]
+    std::vector<int32> retflag;             // swe_vis_limit_mag() return value
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Evaluates the visibility model at every grid point with
+// swe_vis_limit_mag_grid(), which computes the ephemeris once per epoch and
+// runs the sky brightness model over blocks of locations. Epochs, and bands
+// of latitude rows when there are fewer epochs than threads, run in parallel.
+VisibilityGridResult compute_visibility_grid(const VisibilityGridRequest& req);
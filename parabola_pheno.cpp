@@ -0,0 +1,55 @@
+// parabola_pheno.cpp
+// Batch planetary phenomena (swe_pheno) over bodies x times, columnar output
+
+#include "parabola_pheno.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+PhenoBatchResult compute_pheno_batch(const PhenoBatchRequest& req) {
+    PhenoBatchResult res;
+    res.ntimes = req.jd.size();
+    res.nbodies = req.bodies.size();
+    size_t n = res.ntimes * res.nbodies;
+    res.phase_angle.resize(n);
+    res.phase.resize(n);
+    res.elongation.resize(n);
+    res.diameter.resize(n);
+    res.magnitude.resize(n);
+    res.parallax.resize(n);
+    res.retflag.resize(n);
+    if (n == 0)
+        return res;
+
+    ParabolaParallelOptions opt;
+    opt.threads = std::min(req.threads ? req.threads : std::thread::hardware_concurrency(), res.ntimes);
+    std::mutex err_mutex;
+    parabola_for_range(res.ntimes, [&req, &res, &err_mutex](size_t t0, size_t t1) {
+        parabola_bind_ephe_path(req.ephe_path);
+        std::vector<int32> bodies(req.bodies);
+        std::vector<double> attr(20 * bodies.size());
+        char serr[256];
+        for (size_t it = t0; it < t1; ++it) {
+            int32* rf = &res.retflag[it * res.nbodies];
+            if (swe_pheno_multi_ut(req.jd[it], bodies.data(), (int32) bodies.size(), req.iflag, attr.data(), rf, serr) == ERR) {
+                std::lock_guard<std::mutex> lock(err_mutex);
+                if (res.errcode == OK) {
+                    res.errcode = ERR;
+                    std::strcpy(res.serr, serr);
+                }
+            }
+            for (size_t ib = 0; ib < res.nbodies; ++ib) {
+                const double* a = &attr[20 * ib];
+                size_t k = it * res.nbodies + ib;
+                res.phase_angle[k] = a[0];
+                res.phase[k] = a[1];
+                res.elongation[k] = a[2];
+                res.diameter[k] = a[3];
+                res.magnitude[k] = a[4];
+                res.parallax[k] = a[5];
+            }
+        }
+    }, opt);
+    return res;
+}
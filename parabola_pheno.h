@@ -0,0 +1,35 @@
+// parabola_pheno.h
+// Batch planetary phenomena (swe_pheno) over bodies x times, columnar output
+#pragma once
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+struct PhenoBatchRequest {
+    std::vector<double> jd;         // UT
+    std::vector<int32> bodies;
+    int32 iflag = SEFLG_SWIEPH;
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+// One column per swe_pheno() attribute. Element [it * nbodies + ib] belongs
+// to jd[it] and bodies[ib].
+struct PhenoBatchResult {
+    size_t ntimes = 0;
+    size_t nbodies = 0;
+    std::vector<double> phase_angle;    // attr[0]
+    std::vector<double> phase;          // attr[1]
+    std::vector<double> elongation;     // attr[2]
+    std::vector<double> diameter;       // attr[3]
+    std::vector<double> magnitude;      // attr[4]
+    std::vector<double> parallax;       // attr[5], Moon only
+    std::vector<int32> retflag;
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Evaluates every body at every time with swe_pheno_multi_ut(), which
+// shares delta T and the geocentric Sun per epoch. Time chunks run in
+// parallel and write straight into the preallocated columns.
+PhenoBatchResult compute_pheno_batch(const PhenoBatchRequest& req);
@@ -0,0 +1,512 @@
+// parabola_server.cpp
+// Local batch calculation server, see parabola_server.h
+
+#include "parabola_server.h"
+#include "parabola_trace.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32)
+
+static bool read_full(int fd, void* buf, size_t len) {
+    char* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t r = ::recv(fd, p, len, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= (size_t) r;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void* buf, size_t len) {
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t r = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= (size_t) r;
+    }
+    return true;
+}
+
+struct Pending;
+
+// A reader thread takes request frames off the socket and a writer thread
+// sends the answers, so that a client that does not read stalls only its
+// own connection. `backlog` counts the bytes of the frames read and not
+// yet answered; the reader waits while it exceeds the cap, which stops
+// reading from the socket and so holds the client back.
+struct Connection {
+    int fd;
+    std::thread reader;
+    std::thread writer;
+    std::mutex mutex;                   // guards the members below
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Pending>> answers;   // to be written
+    size_t backlog = 0;
+    bool reading = true;                // the reader has not returned
+    bool broken = false;                // a write failed, or stop()
+    std::atomic<int> running{2};        // threads that have not returned
+    ~Connection() {
+        ::close(fd);
+    }
+    void close_now() {
+        std::lock_guard<std::mutex> lock(mutex);
+        broken = true;
+        answers.clear();
+        ::shutdown(fd, SHUT_RDWR);
+        cv.notify_all();
+    }
+};
+
+// One request frame on its way through the batches
+struct Pending {
+    std::shared_ptr<Connection> conn;
+    uint64_t id;
+    std::vector<ParabolaWireRequest> req;
+    std::vector<ParabolaWireResult> res;
+    size_t taken = 0;                   // elements handed to batches
+    size_t left;                        // elements not computed yet
+    std::chrono::steady_clock::time_point arrival;
+};
+
+// bytes a frame of n requests holds until its answer is written
+static size_t frame_bytes(size_t n) {
+    return sizeof(ParabolaWireHeader) + n * (sizeof(ParabolaWireRequest) + sizeof(ParabolaWireResult));
+}
+
+struct ParabolaServer::Impl {
+    ParabolaServerOptions opt;
+    ParabolaTuning tuning;
+    int listen_fd = -1;
+    std::thread acceptor;
+    std::thread dispatcher;
+
+    std::mutex mutex;                   // guards the rest
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Pending>> queue;
+    size_t queued = 0;                  // elements in queue not taken yet
+    std::vector<std::shared_ptr<Connection>> conns;
+    ParabolaServerStats stats;
+    bool stopping = false;
+
+    void accept_loop();
+    void read_loop(std::shared_ptr<Connection> conn);
+    void write_loop(std::shared_ptr<Connection> conn);
+    void dispatch_loop();
+    void run_batch(std::vector<std::pair<Pending*, size_t>>& items);
+    void add_connection(int fd);
+};
+
+void ParabolaServer::Impl::add_connection(int fd) {
+    auto conn = std::make_shared<Connection>();
+    conn->fd = fd;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping)
+        return;
+    // reap the connections that have ended
+    for (auto it = conns.begin(); it != conns.end();) {
+        if ((*it)->running.load() == 0) {
+            (*it)->reader.join();
+            (*it)->writer.join();
+            it = conns.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    ++stats.connections;
+    conn->reader = std::thread([this, conn] { read_loop(conn); });
+    conn->writer = std::thread([this, conn] { write_loop(conn); });
+    conns.push_back(conn);
+}
+
+void ParabolaServer::Impl::accept_loop() {
+    while (true) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;     // the socket was shut down by stop()
+        }
+        add_connection(fd);
+    }
+}
+
+void ParabolaServer::Impl::read_loop(std::shared_ptr<Connection> conn) {
+    while (true) {
+        {
+            // a single frame above the cap is still served on its own
+            std::unique_lock<std::mutex> cl(conn->mutex);
+            conn->cv.wait(cl, [&] { return conn->broken || conn->backlog == 0 || conn->backlog < opt.max_backlog; });
+            if (conn->broken)
+                break;
+        }
+        ParabolaWireHeader h;
+        if (!read_full(conn->fd, &h, sizeof(h)) || h.magic != PARABOLA_WIRE_REQUEST || h.n > PARABOLA_WIRE_MAX_N)
+            break;
+        auto p = std::make_shared<Pending>();
+        p->conn = conn;
+        p->id = h.id;
+        p->req.resize(h.n);
+        if (h.n > 0 && !read_full(conn->fd, p->req.data(), h.n * sizeof(ParabolaWireRequest)))
+            break;
+        p->res.resize(h.n);
+        p->left = h.n;
+        p->arrival = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> cl(conn->mutex);
+            conn->backlog += frame_bytes(h.n);
+            if (h.n == 0) {
+                conn->answers.push_back(p);
+                conn->cv.notify_all();
+                continue;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(p);
+            queued += h.n;
+            ++stats.requests;
+        }
+        wake.notify_one();
+    }
+    // the answers still due go out; the writer closes after the last one
+    ::shutdown(conn->fd, SHUT_RD);
+    {
+        std::lock_guard<std::mutex> cl(conn->mutex);
+        conn->reading = false;
+        conn->cv.notify_all();
+    }
+    --conn->running;
+}
+
+void ParabolaServer::Impl::write_loop(std::shared_ptr<Connection> conn) {
+    std::unique_lock<std::mutex> cl(conn->mutex);
+    while (true) {
+        conn->cv.wait(cl, [&] {
+            return conn->broken || !conn->answers.empty() || (!conn->reading && conn->backlog == 0);
+        });
+        if (conn->broken || conn->answers.empty())
+            break;
+        std::shared_ptr<Pending> p = std::move(conn->answers.front());
+        conn->answers.pop_front();
+        cl.unlock();
+        ParabolaWireHeader rh = {PARABOLA_WIRE_RESULT, (uint32_t) p->res.size(), p->id};
+        bool ok = write_full(conn->fd, &rh, sizeof(rh))
+               && write_full(conn->fd, p->res.data(), p->res.size() * sizeof(ParabolaWireResult));
+        size_t bytes = frame_bytes(p->res.size());
+        p.reset();
+        cl.lock();
+        conn->backlog -= bytes;
+        if (!ok) {
+            conn->broken = true;
+            conn->answers.clear();
+            ::shutdown(conn->fd, SHUT_RDWR);
+        }
+        conn->cv.notify_all();
+    }
+    cl.unlock();
+    --conn->running;
+}
+
+void ParabolaServer::Impl::dispatch_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping)
+            return;
+        // a small request waits a little for others to join it
+        auto deadline = queue.front()->arrival + std::chrono::microseconds(opt.max_delay_us);
+        wake.wait_until(lock, deadline, [this] { return stopping || queued >= opt.max_batch; });
+        if (stopping)
+            return;
+        std::vector<std::pair<Pending*, size_t>> items;
+        std::vector<std::pair<std::shared_ptr<Pending>, size_t>> held;
+        while (!queue.empty() && items.size() < opt.max_batch) {
+            std::shared_ptr<Pending> p = queue.front();
+            size_t n = std::min(p->req.size() - p->taken, opt.max_batch - items.size());
+            for (size_t i = p->taken; i < p->taken + n; ++i)
+                items.emplace_back(p.get(), i);
+            p->taken += n;
+            queued -= n;
+            held.emplace_back(p, n);
+            if (p->taken == p->req.size())
+                queue.pop_front();
+        }
+        ++stats.batches;
+        stats.elements += items.size();
+        lock.unlock();
+
+        run_batch(items);
+        // only this thread counts down, so `left` needs no lock; the
+        // connection's writer sends the answer
+        for (auto& h : held) {
+            Pending* p = h.first.get();
+            p->left -= h.second;
+            if (p->left == 0) {
+                Connection& c = *p->conn;
+                std::lock_guard<std::mutex> cl(c.mutex);
+                if (!c.broken) {
+                    c.answers.push_back(h.first);
+                    c.cv.notify_all();
+                }
+            }
+        }
+        held.clear();
+        lock.lock();
+    }
+}
+
+void ParabolaServer::Impl::run_batch(std::vector<std::pair<Pending*, size_t>>& items) {
+    ParabolaTraceScope span("server batch", "batch", (int64_t) items.size());
+    std::sort(items.begin(), items.end(), [](const std::pair<Pending*, size_t>& a, const std::pair<Pending*, size_t>& b) {
+        const ParabolaWireRequest& x = a.first->req[a.second];
+        const ParabolaWireRequest& y = b.first->req[b.second];
+        if (x.ipl != y.ipl)
+            return x.ipl < y.ipl;
+        if (x.iflag != y.iflag)
+            return x.iflag < y.iflag;
+        return x.tjd_ut < y.tjd_ut;
+    });
+    ParabolaParallelOptions popt;
+    popt.threads = opt.threads;
+    popt.chunk = tuning.chunk;
+    parabola_for_range(items.size(), [this, &items](size_t begin, size_t end) {
+        parabola_bind_tuning(tuning);
+        char serr[AS_MAXCH];
+        for (size_t i = begin; i < end; ++i) {
+            const ParabolaWireRequest& rq = items[i].first->req[items[i].second];
+            ParabolaWireResult& rs = items[i].first->res[items[i].second];
+            rs.retflag = swe_calc_ut(rq.tjd_ut, rq.ipl, rq.iflag, rs.xx, serr);
+            rs.reserved = 0;
+        }
+    }, popt);
+}
+
+ParabolaServer::ParabolaServer(const ParabolaServerOptions& opt) : impl_(new Impl) {
+    impl_->opt = opt;
+    impl_->opt.max_batch = std::max<size_t>(1, opt.max_batch);
+    impl_->tuning = parabola_default_tuning();
+    if (!opt.ephe_path.empty())
+        impl_->tuning.ephe_path = opt.ephe_path;
+    if (impl_->opt.threads == 0)
+        impl_->opt.threads = impl_->tuning.threads;
+}
+
+ParabolaServer::~ParabolaServer() {
+    stop();
+}
+
+bool ParabolaServer::start(std::string& err) {
+    Impl& s = *impl_;
+    // open the files and read the constants in every worker once
+    std::vector<ParabolaWireRequest> warm;
+    for (size_t i = 0; i < 64 * std::max<size_t>(1, std::thread::hardware_concurrency()); ++i)
+        warm.push_back({2451545.0 + (double) i, (int32) (i % 10), SEFLG_SPEED});
+    auto p = std::make_shared<Pending>();
+    p->req = warm;
+    p->res.resize(warm.size());
+    std::vector<std::pair<Pending*, size_t>> items;
+    for (size_t i = 0; i < warm.size(); ++i)
+        items.emplace_back(p.get(), i);
+    s.run_batch(items);
+
+    if (!s.opt.socket_path.empty()) {
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (s.opt.socket_path.size() >= sizeof(addr.sun_path)) {
+            err = "socket path too long: " + s.opt.socket_path;
+            return false;
+        }
+        std::strcpy(addr.sun_path, s.opt.socket_path.c_str());
+        s.listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s.listen_fd < 0) {
+            err = std::string("socket: ") + std::strerror(errno);
+            return false;
+        }
+        // a socket file left behind by a server that did not stop cleanly
+        struct stat st;
+        if (::stat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode))
+            ::unlink(addr.sun_path);
+        if (::bind(s.listen_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || ::listen(s.listen_fd, 64) != 0) {
+            err = s.opt.socket_path + ": " + std::strerror(errno);
+            ::close(s.listen_fd);
+            s.listen_fd = -1;
+            return false;
+        }
+        s.acceptor = std::thread([&s] { s.accept_loop(); });
+    }
+    s.dispatcher = std::thread([&s] { s.dispatch_loop(); });
+    return true;
+}
+
+void ParabolaServer::stop() {
+    Impl& s = *impl_;
+    std::vector<std::shared_ptr<Connection>> conns;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.stopping)
+            return;
+        s.stopping = true;
+        conns.swap(s.conns);
+    }
+    s.wake.notify_all();
+    if (s.listen_fd >= 0) {
+        ::shutdown(s.listen_fd, SHUT_RDWR);
+        if (s.acceptor.joinable())
+            s.acceptor.join();
+        ::close(s.listen_fd);
+        ::unlink(s.opt.socket_path.c_str());
+        s.listen_fd = -1;
+    }
+    if (s.dispatcher.joinable())
+        s.dispatcher.join();
+    for (auto& c : conns) {
+        c->close_now();
+        c->reader.join();
+        c->writer.join();
+    }
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.queue.clear();
+}
+
+void ParabolaServer::attach(int fd) {
+    impl_->add_connection(fd);
+}
+
+ParabolaServerStats ParabolaServer::stats() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->stats;
+}
+
+ParabolaServerClient::~ParabolaServerClient() {
+    close();
+}
+
+bool ParabolaServerClient::connect(const std::string& socket_path, std::string& err) {
+    close();
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        err = "socket path too long: " + socket_path;
+        return false;
+    }
+    std::strcpy(addr.sun_path, socket_path.c_str());
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0 || ::connect(fd_, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        err = socket_path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ParabolaServerClient::connect(ParabolaServer& server, std::string& err) {
+    close();
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        err = std::string("socketpair: ") + std::strerror(errno);
+        return false;
+    }
+    fd_ = sv[0];
+    server.attach(sv[1]);
+    return true;
+}
+
+void ParabolaServerClient::close() {
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+bool ParabolaServerClient::calc(const std::vector<ParabolaWireRequest>& req, std::vector<ParabolaWireResult>& res,
+                                std::string& err) {
+    if (fd_ < 0) {
+        err = "not connected";
+        return false;
+    }
+    if (req.size() > PARABOLA_WIRE_MAX_N) {
+        err = "more than PARABOLA_WIRE_MAX_N requests";
+        return false;
+    }
+    ParabolaWireHeader h = {PARABOLA_WIRE_REQUEST, (uint32_t) req.size(), next_id_++};
+    if (!write_full(fd_, &h, sizeof(h)) || !write_full(fd_, req.data(), req.size() * sizeof(ParabolaWireRequest))) {
+        err = "connection lost";
+        return false;
+    }
+    ParabolaWireHeader rh;
+    if (!read_full(fd_, &rh, sizeof(rh)) || rh.magic != PARABOLA_WIRE_RESULT || rh.id != h.id || rh.n != h.n) {
+        err = "connection lost or bad answer";
+        return false;
+    }
+    res.resize(rh.n);
+    if (rh.n > 0 && !read_full(fd_, res.data(), rh.n * sizeof(ParabolaWireResult))) {
+        err = "connection lost";
+        return false;
+    }
+    return true;
+}
+
+#else // _WIN32
+
+struct ParabolaServer::Impl {};
+
+ParabolaServer::ParabolaServer(const ParabolaServerOptions&) : impl_(new Impl) {}
+ParabolaServer::~ParabolaServer() {}
+
+bool ParabolaServer::start(std::string& err) {
+    err = "parabola server: Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+void ParabolaServer::stop() {}
+void ParabolaServer::attach(int) {}
+
+ParabolaServerStats ParabolaServer::stats() const {
+    return ParabolaServerStats();
+}
+
+ParabolaServerClient::~ParabolaServerClient() {}
+
+bool ParabolaServerClient::connect(const std::string&, std::string& err) {
+    err = "parabola server: Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+bool ParabolaServerClient::connect(ParabolaServer&, std::string& err) {
+    err = "parabola server: Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+void ParabolaServerClient::close() {}
+
+bool ParabolaServerClient::calc(const std::vector<ParabolaWireRequest>&, std::vector<ParabolaWireResult>&,
+                                std::string& err) {
+    err = "not connected";
+    return false;
+}
+
+#endif // _WIN32
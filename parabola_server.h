@@ -0,0 +1,103 @@
+// parabola_server.h
+// Local batch calculation server: Unix socket, binary frames, coalescing
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+// Wire format, in host byte order (the socket is local). A request frame
+// is a header with magic PARABOLA_WIRE_REQUEST and n request records, the
+// answer a header with PARABOLA_WIRE_RESULT, the same id and n results.
+// Requests may be pipelined; answers come back as their batches finish.
+// A malformed frame ends the connection.
+#define PARABOLA_WIRE_REQUEST 0x31514250u   // "PBQ1"
+#define PARABOLA_WIRE_RESULT 0x31524250u    // "PBR1"
+#define PARABOLA_WIRE_MAX_N (1u << 22)
+
+struct ParabolaWireHeader {
+    uint32_t magic;
+    uint32_t n;
+    uint64_t id;
+};
+
+struct ParabolaWireRequest {
+    double tjd_ut;
+    int32 ipl;
+    int32 iflag;
+};
+
+// retflag < 0: swe_calc_ut() failed
+struct ParabolaWireResult {
+    double xx[6];
+    int32 retflag;
+    int32 reserved;
+};
+
+struct ParabolaServerOptions {
+    std::string socket_path;        // empty = in-process clients only
+    std::string ephe_path;          // else the profile's
+    size_t threads = 0;             // 0 = the profile's, else hardware_concurrency()
+    size_t max_batch = 8192;        // elements per coalesced batch
+    int max_delay_us = 200;         // how long a small request waits for more
+    size_t max_backlog = 64u << 20; // bytes of unanswered frames per connection
+};
+
+struct ParabolaServerStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t elements = 0;
+    uint64_t batches = 0;
+};
+
+// Keeps the worker pool warm and feeds it with the requests of all
+// connections. Requests that arrive together are merged into one batch,
+// sorted by body, flags and time, so that consecutive calls reuse the
+// ephemeris segments and saved positions. Every connection has its own
+// writer: a client that does not read its answers holds back only its own
+// requests, once max_backlog bytes of them are unanswered.
+class ParabolaServer {
+public:
+    explicit ParabolaServer(const ParabolaServerOptions& opt);
+    ~ParabolaServer();
+    ParabolaServer(const ParabolaServer&) = delete;
+    ParabolaServer& operator=(const ParabolaServer&) = delete;
+
+    // Warms up the workers and, with a socket_path, listens there.
+    // Returns false, with the reason in err, if the socket cannot be set up.
+    bool start(std::string& err);
+    // Closes the socket and all connections; waits for the threads
+    void stop();
+
+    // Serves an already connected stream socket; the server closes it
+    void attach(int fd);
+
+    ParabolaServerStats stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Synchronous client, over the server's socket or in-process over a
+// socketpair attached to the server
+class ParabolaServerClient {
+public:
+    ParabolaServerClient() = default;
+    ~ParabolaServerClient();
+    ParabolaServerClient(const ParabolaServerClient&) = delete;
+    ParabolaServerClient& operator=(const ParabolaServerClient&) = delete;
+
+    bool connect(const std::string& socket_path, std::string& err);
+    bool connect(ParabolaServer& server, std::string& err);
+    void close();
+
+    // Returns false, with the reason in err, if the connection fails
+    bool calc(const std::vector<ParabolaWireRequest>& req, std::vector<ParabolaWireResult>& res, std::string& err);
+
+private:
+    int fd_ = -1;
+    uint64_t next_id_ = 1;
+};
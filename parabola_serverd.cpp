@@ -0,0 +1,67 @@
+// parabola_serverd.cpp
+// Runs a ParabolaServer on a Unix socket until SIGINT or SIGTERM
+//
+// usage: parabola_serverd [-s socket] [-p ephe path] [-t threads] [-b max batch] [-d max delay us]
+// Short-lived processes send their calculations here instead of opening
+// the ephemeris files and reading their constants themselves; see
+// parabola_server.h for the frame format and ParabolaServerClient.
+
+#include "parabola_server.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+int main(int argc, char** argv) {
+    ParabolaServerOptions opt;
+    opt.socket_path = "/tmp/parabola.sock";
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-s" && i + 1 < argc) {
+            opt.socket_path = argv[++i];
+        } else if (a == "-p" && i + 1 < argc) {
+            opt.ephe_path = argv[++i];
+        } else if (a == "-t" && i + 1 < argc) {
+            opt.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (a == "-b" && i + 1 < argc) {
+            opt.max_batch = std::strtoul(argv[++i], nullptr, 10);
+        } else if (a == "-d" && i + 1 < argc) {
+            opt.max_delay_us = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [-s socket] [-p ephe path] [-t threads] [-b max batch] [-d max delay us]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+#if defined(_WIN32)
+    std::fprintf(stderr, "%s: Unix domain sockets are not supported on this platform\n", argv[0]);
+    return 1;
+#else
+    // the signals go to sigwait() below, not to the server's threads
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+    ParabolaServer server(opt);
+    std::string err;
+    if (!server.start(err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::printf("listening on %s\n", opt.socket_path.c_str());
+    std::fflush(stdout);
+    int sig;
+    sigwait(&sigs, &sig);
+    server.stop();
+    ParabolaServerStats st = server.stats();
+    std::printf("%llu connections, %llu requests, %llu elements in %llu batches\n",
+                (unsigned long long) st.connections, (unsigned long long) st.requests,
+                (unsigned long long) st.elements, (unsigned long long) st.batches);
+    return 0;
+#endif
+}
@@ -0,0 +1,170 @@
+// parabola_shm.cpp
+// Shared-memory ring of batch records, see parabola_shm.h
+
+#include "parabola_shm.h"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define PARABOLA_SHM_MAGIC 0x48535250u     // "PRSH"
+#define PARABOLA_SHM_VERSION 1
+
+ParabolaShmRing::~ParabolaShmRing() {
+    detach();
+}
+
+#if !defined(_WIN32)
+
+bool ParabolaShmRing::map(int fd, size_t size, std::string& err) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        err = name_ + ": mmap: " + std::strerror(errno);
+        return false;
+    }
+    fd_ = fd;
+    size_ = size;
+    hdr_ = static_cast<ParabolaShmHeader*>(p);
+    cells_ = reinterpret_cast<ParabolaShmCell*>(static_cast<char*>(p) + sizeof(ParabolaShmHeader));
+    return true;
+}
+
+bool ParabolaShmRing::create(const std::string& name, size_t capacity, std::string& err) {
+    detach();
+    size_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+    size_t size = sizeof(ParabolaShmHeader) + cap * sizeof(ParabolaShmCell);
+    name_ = name;
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        err = name + ": " + std::strerror(errno);
+        return false;
+    }
+    if (::ftruncate(fd, (off_t) size) != 0 || !map(fd, size, err)) {
+        if (err.empty())
+            err = name + ": ftruncate: " + std::strerror(errno);
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+    new (hdr_) ParabolaShmHeader();
+    hdr_->record_size = (uint32_t) sizeof(PlanetShmRecord);
+    hdr_->capacity = (uint32_t) cap;
+    hdr_->enqueue_pos.store(0, std::memory_order_relaxed);
+    hdr_->dequeue_pos.store(0, std::memory_order_relaxed);
+    hdr_->closed.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < cap; ++i) {
+        new (&cells_[i]) ParabolaShmCell();
+        cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    mask_ = cap - 1;
+    hdr_->version = PARABOLA_SHM_VERSION;
+    // openers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    reinterpret_cast<std::atomic<uint32_t>*>(&hdr_->magic)->store(PARABOLA_SHM_MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool ParabolaShmRing::open(const std::string& name, std::string& err) {
+    detach();
+    name_ = name;
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        err = name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ParabolaShmHeader)) {
+        err = name + ": not a parabola ring (yet)";
+        ::close(fd);
+        return false;
+    }
+    if (!map(fd, (size_t) st.st_size, err)) {
+        ::close(fd);
+        return false;
+    }
+    uint32_t magic = reinterpret_cast<std::atomic<uint32_t>*>(&hdr_->magic)->load(std::memory_order_acquire);
+    if (magic != PARABOLA_SHM_MAGIC || hdr_->version != PARABOLA_SHM_VERSION
+        || hdr_->record_size != sizeof(PlanetShmRecord)) {
+        err = name + ": not a parabola ring of this version, or not formatted yet";
+        detach();
+        return false;
+    }
+    // the cell index is pos & mask_, so a bad capacity would address
+    // memory outside the segment
+    uint32_t cap = hdr_->capacity;
+    if (cap == 0 || (cap & (cap - 1)) != 0
+        || sizeof(ParabolaShmHeader) + (size_t) cap * sizeof(ParabolaShmCell) > size_) {
+        err = name + ": damaged parabola ring, capacity " + std::to_string(cap);
+        detach();
+        return false;
+    }
+    mask_ = cap - 1;
+    return true;
+}
+
+void ParabolaShmRing::unlink() {
+    if (!name_.empty())
+        ::shm_unlink(name_.c_str());
+}
+
+void ParabolaShmRing::detach() {
+    if (hdr_ != nullptr)
+        ::munmap(hdr_, size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    hdr_ = nullptr;
+    cells_ = nullptr;
+    mask_ = 0;
+    size_ = 0;
+    fd_ = -1;
+}
+
+#else // _WIN32
+
+bool ParabolaShmRing::map(int, size_t, std::string& err) {
+    err = "parabola shm: POSIX shared memory is not supported on this platform";
+    return false;
+}
+
+bool ParabolaShmRing::create(const std::string&, size_t, std::string& err) {
+    return map(-1, 0, err);
+}
+
+bool ParabolaShmRing::open(const std::string&, std::string& err) {
+    return map(-1, 0, err);
+}
+
+void ParabolaShmRing::unlink() {}
+void ParabolaShmRing::detach() {}
+
+#endif // _WIN32
+
+size_t parabola_shm_publish(ParabolaShmRing& ring, uint64_t batch_id, const PlanetBatchRequest& batch,
+                            const PlanetBatchResult& result, int timeout_ms) {
+    size_t n = std::min(batch.requests.size(), result.results.size());
+    for (size_t i = 0; i < n; ++i) {
+        bool ok = ring.produce([&](PlanetShmRecord& r) {
+            const PlanetRequest& rq = batch.requests[i];
+            const PlanetResult& rs = result.results[i];
+            r.batch = batch_id;
+            r.index = (uint32_t) i;
+            r.count = (uint32_t) n;
+            r.jd = rq.jd;
+            r.ipl = rq.ipl;
+            r.iflag = SEFLG_SPEED;      // as compute_batch() calls swe_calc_ut()
+            r.errcode = rs.errcode;
+            r.reserved = 0;
+            std::memcpy(r.xx, rs.xx, sizeof(r.xx));
+        }, timeout_ms);
+        if (!ok)
+            return i;
+    }
+    return n;
+}
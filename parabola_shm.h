@@ -0,0 +1,178 @@
+// parabola_shm.h
+// Shared-memory ring of batch records for producer/consumer processes
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "parabola_wrapper.h"
+
+// One request or result; a producer running compute_batch() publishes
+// its results, consumers read them in place. seq is the record's position
+// in the stream, numbered from 0 by the ring.
+struct PlanetShmRecord {
+    uint64_t seq;
+    uint64_t batch;         // the producer's batch id
+    uint32_t index;         // in the batch
+    uint32_t count;         // records of the batch
+    double jd;
+    int32 ipl;
+    int32 iflag;
+    int32 errcode;          // swe_calc_ut() return; requests: 0
+    int32 reserved;
+    double xx[6];
+};
+
+// The segment: a header, then a power of two of cells. Positions grow
+// without wrapping; a cell is free for position p when its seq is p and
+// holds the record of p when it is p + 1 (D. Vyukov's bounded queue), so
+// any number of producers and consumers work without locks.
+struct alignas(64) ParabolaShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) std::atomic<uint64_t> dequeue_pos;
+    alignas(64) std::atomic<uint32_t> closed;
+};
+
+struct alignas(64) ParabolaShmCell {
+    std::atomic<uint64_t> seq;
+    PlanetShmRecord rec;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the ring needs address-free atomics in shared memory");
+
+// A ring in a POSIX shared memory object. The creator sizes and formats
+// it; other processes open it by name. A process that dies while it holds
+// a cell leaves the ring stuck at that position.
+class ParabolaShmRing {
+public:
+    ParabolaShmRing() = default;
+    ~ParabolaShmRing();
+    ParabolaShmRing(const ParabolaShmRing&) = delete;
+    ParabolaShmRing& operator=(const ParabolaShmRing&) = delete;
+
+    // name as for shm_open(), e.g. "/parabola-charts"; capacity is rounded
+    // up to a power of two. Both return false, with the reason in err.
+    bool create(const std::string& name, size_t capacity, std::string& err);
+    bool open(const std::string& name, std::string& err);
+    // Removes the name; attached processes keep the segment until they unmap
+    void unlink();
+    void detach();
+
+    // Writes a record in place with fill(PlanetShmRecord&); false if full
+    template <typename F>
+    bool try_produce(F&& fill) {
+        uint64_t pos = hdr_->enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            ParabolaShmCell& c = cells_[pos & mask_];
+            int64_t dif = (int64_t) (c.seq.load(std::memory_order_acquire) - pos);
+            if (dif == 0) {
+                if (hdr_->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(c.rec);
+                    c.rec.seq = pos;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = hdr_->enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Reads a record in place with read(const PlanetShmRecord&); the cell
+    // is handed back to the producers afterwards. False if empty.
+    template <typename F>
+    bool try_consume(F&& read) {
+        uint64_t pos = hdr_->dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            ParabolaShmCell& c = cells_[pos & mask_];
+            int64_t dif = (int64_t) (c.seq.load(std::memory_order_acquire) - (pos + 1));
+            if (dif == 0) {
+                if (hdr_->dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    read(static_cast<const PlanetShmRecord&>(c.rec));
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = hdr_->dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocking forms: wait while the ring is full (back-pressure) or empty,
+    // up to timeout_ms (< 0: no limit). consume() also gives up once the
+    // ring is closed and drained.
+    template <typename F>
+    bool produce(F&& fill, int timeout_ms = -1) {
+        return wait_for([&] { return try_produce(fill); }, timeout_ms, false);
+    }
+
+    template <typename F>
+    bool consume(F&& read, int timeout_ms = -1) {
+        return wait_for([&] { return try_consume(read); }, timeout_ms, true);
+    }
+
+    bool push(const PlanetShmRecord& r, int timeout_ms = -1) {
+        return produce([&r](PlanetShmRecord& dst) { dst = r; }, timeout_ms);
+    }
+
+    bool pop(PlanetShmRecord& r, int timeout_ms = -1) {
+        return consume([&r](const PlanetShmRecord& src) { r = src; }, timeout_ms);
+    }
+
+    // End of the stream, for consumers that wait on an empty ring
+    void close() { hdr_->closed.store(1, std::memory_order_release); }
+    bool closed() const { return hdr_->closed.load(std::memory_order_acquire) != 0; }
+
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t produced() const { return hdr_->enqueue_pos.load(std::memory_order_relaxed); }
+    uint64_t consumed() const { return hdr_->dequeue_pos.load(std::memory_order_relaxed); }
+    // the segment's descriptor, e.g. to hand to a child process
+    int fd() const { return fd_; }
+
+private:
+    bool map(int fd, size_t size, std::string& err);
+
+    // Spins briefly, then sleeps in growing steps up to 100 us, so that a
+    // waiting process costs little without a futex shared across processes
+    template <typename Try>
+    bool wait_for(Try&& attempt, int timeout_ms, bool stop_when_closed) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        for (unsigned spin = 0;; ++spin) {
+            if (attempt())
+                return true;
+            if (stop_when_closed && closed() && !attempt())
+                return false;
+            if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline)
+                return false;
+            if (spin < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min(100u, spin - 63)));
+        }
+    }
+
+    ParabolaShmHeader* hdr_ = nullptr;
+    ParabolaShmCell* cells_ = nullptr;
+    uint64_t mask_ = 0;
+    size_t size_ = 0;
+    int fd_ = -1;
+    std::string name_;
+};
+
+// Publishes the results of `batch` as records batch_id/0..n-1, waiting
+// while consumers fall behind. Returns the number published, fewer than
+// the results if timeout_ms ran out.
+size_t parabola_shm_publish(ParabolaShmRing& ring, uint64_t batch_id, const PlanetBatchRequest& batch,
+                            const PlanetBatchResult& result, int timeout_ms = -1);
@@ -0,0 +1,112 @@
+// parabola_table.cpp
+// Parallel generator for dense precomputed ephemeris tables (swetab.c)
+
+#include "parabola_table.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+struct TableChunk {
+    size_t ib;                      // body
+    int32 i0, i1;                   // points (sampling) or intervals (errors)
+};
+
+struct TableChunkStatus {
+    int32 retflag = OK;
+    double maxerr[6] = {0};
+    char serr[256] = {0};
+};
+
+EphemerisTableResult build_ephemeris_table(const EphemerisTableRequest& req) {
+    EphemerisTableResult res;
+    size_t nbody = req.bodies.size();
+    if (!req.tstep.empty() && req.tstep.size() != nbody) {
+        res.errcode = ERR;
+        std::strcpy(res.serr, "build_ephemeris_table: tstep and bodies differ in size");
+        return res;
+    }
+    std::vector<double> tstep(nbody), tfirst(nbody);
+    std::vector<int32> npt(nbody), retflag(nbody, ERR);
+    std::vector<std::vector<double>> x(nbody);
+    std::vector<std::vector<char>> bad(nbody);
+    std::vector<TableChunk> chunks;
+    for (size_t ib = 0; ib < nbody; ++ib) {
+        tstep[ib] = req.tstep.empty() ? swe_tab_default_step(req.bodies[ib]) : req.tstep[ib];
+        if (swe_tab_grid(req.tjd_start, req.tjd_end, tstep[ib], &tfirst[ib], &npt[ib]) == ERR) {
+            res.errcode = ERR;
+            std::snprintf(res.serr, sizeof(res.serr), "invalid range or step width for body %d", req.bodies[ib]);
+            return res;
+        }
+        x[ib].resize(3 * (size_t) npt[ib]);
+        bad[ib].assign(npt[ib], 0);
+        int32 per_year = std::max<int32>(1, (int32) (365.25 / tstep[ib]));
+        for (int32 i0 = 0; i0 < npt[ib]; i0 += per_year)
+            chunks.push_back({ib, i0, std::min(npt[ib], i0 + per_year)});
+    }
+    res.maxerr.assign(6 * nbody, 0);
+    if (chunks.empty())
+        return res;
+
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, std::min(nthreads, chunks.size()));
+    ParabolaThreadPool pool(nthreads);
+
+    // The error of an interval needs the points on either side of it, so
+    // all points are sampled before any error is measured.
+    auto run = [&](bool errors) {
+        std::vector<std::future<TableChunkStatus>> futures;
+        futures.reserve(chunks.size());
+        for (const auto& c : chunks) {
+            futures.emplace_back(pool.submit([&req, &tstep, &tfirst, &npt, &x, &bad, c, errors]() {
+                TableChunkStatus st;
+                parabola_bind_ephe_path(req.ephe_path);
+                int32 ipl = req.bodies[c.ib];
+                if (errors)
+                    st.retflag = swe_tab_error(ipl, req.iflag, tfirst[c.ib], tstep[c.ib], npt[c.ib], x[c.ib].data(),
+                                               c.i0, c.i1, req.prec, bad[c.ib].data(), st.maxerr, st.serr);
+                else
+                    st.retflag = swe_tab_sample(ipl, req.iflag, tfirst[c.ib], tstep[c.ib], c.i0, c.i1 - c.i0,
+                                                x[c.ib].data(), st.serr);
+                return st;
+            }));
+        }
+        for (size_t k = 0; k < futures.size(); ++k) {
+            TableChunkStatus st = futures[k].get();
+            size_t ib = chunks[k].ib;
+            if (st.retflag == ERR) {
+                if (res.errcode == OK) {
+                    res.errcode = ERR;
+                    std::strcpy(res.serr, st.serr);
+                }
+                continue;
+            }
+            if (errors) {
+                for (int m = 0; m < 6; ++m)
+                    res.maxerr[6 * ib + m] = std::max(res.maxerr[6 * ib + m], st.maxerr[m]);
+            } else if (chunks[k].i0 == 0) {
+                retflag[ib] = st.retflag;
+            }
+        }
+    };
+    run(false);
+    if (res.errcode == ERR)
+        return res;
+    run(true);
+    if (res.errcode == ERR)
+        return res;
+
+    std::vector<int32> ipl(req.bodies);
+    std::vector<double*> px(nbody);
+    std::vector<char*> pbad(nbody);
+    for (size_t ib = 0; ib < nbody; ++ib) {
+        px[ib] = x[ib].data();
+        pbad[ib] = bad[ib].data();
+    }
+    std::vector<char> fname(req.fname.begin(), req.fname.end());
+    fname.push_back('\0');
+    if (swe_tab_save(fname.data(), req.tjd_start, req.tjd_end, (int32) nbody, ipl.data(), retflag.data(), tstep.data(),
+                     px.data(), req.prec, pbad.data(), res.maxerr.data(), res.serr) == ERR)
+        res.errcode = ERR;
+    return res;
+}
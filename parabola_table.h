@@ -0,0 +1,30 @@
+// parabola_table.h
+// Parallel generator for dense precomputed ephemeris tables (swetab.c)
+#pragma once
+#include <string>
+#include <vector>
+#include "swephexp.h"
+
+struct EphemerisTableRequest {
+    std::string fname;
+    int32 iflag = SEFLG_SWIEPH;     // swe_calc() flags of the table, SEFLG_SPEED aside
+    double tjd_start = 0;           // TT
+    double tjd_end = 0;             // TT
+    std::vector<int32> bodies;
+    std::vector<double> tstep;      // per body, days; empty = swe_tab_default_step()
+    double prec = 0.01;             // arc seconds; intervals beyond it use swe_calc()
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+struct EphemerisTableResult {
+    std::vector<double> maxerr;     // 6 per body, see swe_tab_maxerr()
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Builds the same table as swe_tab_create(). Each body's points are cut
+// into one-year chunks; the chunks are sampled on ParabolaThreadPool, then
+// their interpolation errors are measured in parallel, and the table is
+// written once all chunks are done.
+EphemerisTableResult build_ephemeris_table(const EphemerisTableRequest& req);
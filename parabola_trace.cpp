@@ -0,0 +1,175 @@
+// parabola_trace.cpp
+// Opt-in span recorder for compute_batch, exported as Chrome trace JSON
+
+#include "parabola_trace.h"
+#include "swephexp.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;
+    const char* cat;
+    uint64_t t0;
+    uint64_t t1;
+    int64_t arg;
+};
+
+// Written only by its thread; head counts every span ever recorded, the
+// last events.size() of them are kept.
+struct TraceRing {
+    int tid = 0;
+    std::string name;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};
+};
+
+static std::atomic<bool> g_active{false};
+static std::atomic<bool> g_phases{false};
+static std::atomic<uint64_t> g_generation{0};
+
+static std::mutex g_mutex;      // guards the rest
+static std::vector<std::shared_ptr<TraceRing>> g_rings;
+static size_t g_ring_size = 65536;
+static uint64_t g_origin = 0;   // start of the recording
+
+// The ring of this thread in recording g_generation. The thread holds a
+// reference of its own, so a ring dropped by a restart stays valid until
+// the thread moves to a new one.
+struct ThreadTrace {
+    std::shared_ptr<TraceRing> ring;
+    uint64_t generation = 0;
+};
+static thread_local ThreadTrace t_trace;
+
+static TraceRing* thread_ring() {
+    uint64_t gen = g_generation.load(std::memory_order_acquire);
+    if (t_trace.ring && t_trace.generation == gen)
+        return t_trace.ring.get();
+    auto ring = std::make_shared<TraceRing>();
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        ring->events.resize(std::max<size_t>(1, g_ring_size));
+        ring->tid = (int) g_rings.size() + 1;
+        ring->name = "thread " + std::to_string(ring->tid);
+        g_rings.push_back(ring);
+    }
+    t_trace.ring = ring;
+    t_trace.generation = gen;
+    return ring.get();
+}
+
+// timed sections of the library, see swe_stats_set_hook()
+static void library_span(int32 istat, double t0, double t1) {
+    if (!g_active.load(std::memory_order_relaxed))
+        return;
+    const char* name;
+    switch (istat) {
+    case SE_STAT_SEG_NS: name = "segment read"; break;
+    case SE_STAT_FILE_NS: name = "fopen"; break;
+    case SE_STAT_NUT_NS: name = "nutation"; break;
+    case SE_STAT_FIXSTAR_NS: name = "fixstar load"; break;
+    case SE_STAT_DELTAT_NS: name = "deltat"; break;
+    case SE_STAT_APP_NS: name = "apparent position"; break;
+    default: return;
+    }
+    parabola_trace_span(name, "swisseph", (uint64_t) t0, (uint64_t) t1);
+}
+
+void parabola_trace_start(const ParabolaTraceOptions& opt) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_rings.clear();
+        g_ring_size = opt.events_per_thread;
+        g_origin = parabola_trace_now();
+    }
+    g_generation.fetch_add(1, std::memory_order_release);
+    g_phases.store(opt.request_phases, std::memory_order_relaxed);
+    // the library's clock is the one of std::chrono::steady_clock
+    swe_stats_set_hook(opt.library_spans ? library_span : nullptr);
+    g_active.store(true, std::memory_order_release);
+}
+
+void parabola_trace_stop() {
+    g_active.store(false, std::memory_order_release);
+    swe_stats_set_hook(nullptr);
+}
+
+bool parabola_trace_active() {
+    return g_active.load(std::memory_order_relaxed);
+}
+
+bool parabola_trace_request_phases() {
+    return g_phases.load(std::memory_order_relaxed) && parabola_trace_active();
+}
+
+void parabola_trace_span(const char* name, const char* cat, uint64_t t0, uint64_t t1, int64_t arg) {
+    if (!parabola_trace_active())
+        return;
+    TraceRing* ring = thread_ring();
+    uint64_t h = ring->head.load(std::memory_order_relaxed);
+    ring->events[h % ring->events.size()] = {name, cat, t0, t1, arg};
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+void parabola_trace_thread_name(const std::string& name) {
+    if (!parabola_trace_active())
+        return;
+    TraceRing* ring = thread_ring();
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ring->name = name;
+}
+
+static std::string json_string(const std::string& s) {
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if ((unsigned char) c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            r += buf;
+        } else {
+            r += c;
+        }
+    }
+    return r + "\"";
+}
+
+bool parabola_trace_write(const std::string& path) {
+    FILE* fp = std::fopen(path.c_str(), "w");
+    if (fp == nullptr)
+        return false;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    uint64_t dropped = 0;
+    bool first = true;
+    std::fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    for (const auto& ring : g_rings) {
+        std::fprintf(fp, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": %s}}",
+                     first ? "" : ",", ring->tid, json_string(ring->name).c_str());
+        first = false;
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t n = std::min<uint64_t>(head, ring->events.size());
+        dropped += head - n;
+        for (uint64_t i = head - n; i < head; ++i) {
+            const TraceEvent& e = ring->events[i % ring->events.size()];
+            // spans begun before the start, e.g. library sections
+            uint64_t t0 = std::max(e.t0, g_origin);
+            if (e.t1 < t0)
+                continue;
+            std::fprintf(fp, ",\n{\"name\": %s, \"cat\": %s, \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                             "\"ts\": %.3f, \"dur\": %.3f",
+                         json_string(e.name).c_str(), json_string(e.cat).c_str(), ring->tid,
+                         (t0 - g_origin) / 1000.0, (e.t1 - t0) / 1000.0);
+            if (e.arg >= 0)
+                std::fprintf(fp, ", \"args\": {\"n\": %lld}", (long long) e.arg);
+            std::fprintf(fp, "}");
+        }
+    }
+    std::fprintf(fp, "\n], \"otherData\": {\"dropped_spans\": %llu}}\n", (unsigned long long) dropped);
+    return std::fclose(fp) == 0;
+}
@@ -0,0 +1,60 @@
+// parabola_trace.h
+// Opt-in span recorder for compute_batch, exported as Chrome trace JSON
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ParabolaTraceOptions {
+    size_t events_per_thread = 65536;   // ring size; older spans are overwritten
+    bool request_phases = false;        // deltat/ephemeris span per request
+    bool library_spans = true;          // segment reads, file opens, nutation
+};
+
+// Starts recording and drops the spans of an earlier recording. Every
+// thread writes into a ring of its own without locking; the rings outlive
+// the threads, so pool workers of finished batches are still in the dump.
+// Start, stop and write must not run while a traced batch is running.
+void parabola_trace_start(const ParabolaTraceOptions& opt = ParabolaTraceOptions());
+void parabola_trace_stop();
+
+// Writes the recorded spans as Chrome trace JSON ("X" events, one track
+// per thread), to be opened in chrome://tracing or ui.perfetto.dev.
+// Returns false if the file cannot be written.
+bool parabola_trace_write(const std::string& path);
+
+bool parabola_trace_active();
+bool parabola_trace_request_phases();
+
+// ns of std::chrono::steady_clock, the clock of all spans
+inline uint64_t parabola_trace_now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Records a span of the calling thread. name and cat must be string
+// literals or otherwise live until the dump; arg is shown if >= 0.
+void parabola_trace_span(const char* name, const char* cat, uint64_t t0, uint64_t t1, int64_t arg = -1);
+
+// Names the calling thread's track, e.g. "worker 3"
+void parabola_trace_thread_name(const std::string& name);
+
+// Records a span from construction to destruction while tracing is on
+class ParabolaTraceScope {
+public:
+    ParabolaTraceScope(const char* name, const char* cat, int64_t arg = -1)
+        : name_(name), cat_(cat), arg_(arg), t0_(parabola_trace_active() ? parabola_trace_now() : 0) {}
+    ~ParabolaTraceScope() {
+        if (t0_ != 0)
+            parabola_trace_span(name_, cat_, t0_, parabola_trace_now(), arg_);
+    }
+    ParabolaTraceScope(const ParabolaTraceScope&) = delete;
+    ParabolaTraceScope& operator=(const ParabolaTraceScope&) = delete;
+
+private:
+    const char* name_;
+    const char* cat_;
+    int64_t arg_;
+    uint64_t t0_;
+};
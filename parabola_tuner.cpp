@@ -0,0 +1,232 @@
+// parabola_tuner.cpp
+// Sweeps the compute_batch knobs on representative workloads and writes
+// the host's tuning profile, which compute_batch loads on its first call
+//
+// usage: parabola_tuner [-o profile] [-p ephe path] [-t table] [-n requests] [-r reps] [--quick]
+// Every configuration (thread count x chunk size x backend) runs each
+// workload once to warm up and then `reps` times. A configuration scores
+// the sum over the workloads of its median time; among those within 2% of
+// the best, the one with the fewest threads wins, so that noise does not
+// buy a thread that does not pay. Backend "table" is tried when -t names
+// a table made by swe_tab_create() or build_ephemeris_table().
+
+#include "parabola_wrapper.h"
+#include "swephexp.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static const double J2000 = 2451545.0;
+
+struct TunerOptions {
+    std::string profile;
+    std::string ephe = "ephe";
+    std::string table;
+    size_t nreq = 20000;
+    int reps = 7;
+    bool quick = false;
+};
+
+struct Workload {
+    const char* name;
+    PlanetBatchRequest batch;
+};
+
+// Charts (all planets of one date after the other), series (one planet
+// over a date range) and unrelated requests, as in parabola_benchmark
+static std::vector<Workload> make_workloads(size_t n) {
+    std::vector<Workload> w(3);
+    w[0].name = "time_major";
+    w[1].name = "body_major";
+    w[2].name = "random";
+    size_t per_body = std::max<size_t>(1, n / 10);
+    std::mt19937_64 rng(20240101);
+    std::uniform_real_distribution<double> dist(-200 * 365.25, 200 * 365.25);
+    for (size_t i = 0; i < n; ++i) {
+        w[0].batch.requests.push_back({J2000 + (double) (i / 10) * 0.5, (int) (i % 10)});
+        w[1].batch.requests.push_back({J2000 + (double) (i % per_body) * 0.5, (int) std::min<size_t>(9, i / per_body)});
+        w[2].batch.requests.push_back({J2000 + dist(rng), (int) (rng() % 10)});
+    }
+    return w;
+}
+
+struct Trial {
+    ParabolaTuning tuning;
+    std::vector<double> median;     // seconds, per workload
+    std::vector<double> mad;        // median absolute deviation
+    double score = 0;
+    bool ok = true;
+};
+
+// Makes every directory of an ephemeris path list absolute
+static std::string absolute_paths(const std::string& list) {
+#if defined(_WIN32)
+    const char* seps = ";";
+#else
+    const char* seps = ";:";
+#endif
+    std::string out;
+    size_t b = 0;
+    while (b <= list.size()) {
+        size_t e = std::min(list.find_first_of(seps, b), list.size());
+        std::string dir = list.substr(b, e - b);
+        out += dir.empty() ? dir : std::filesystem::absolute(dir).lexically_normal().string();
+        if (e < list.size())
+            out += list[e];
+        b = e + 1;
+    }
+    return out;
+}
+
+static double median_of(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static void run_trial(Trial& tr, const std::vector<Workload>& workloads, int reps) {
+    for (const auto& w : workloads) {
+        std::vector<double> t;
+        for (int i = 0; i <= reps; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            PlanetBatchResult r = compute_batch(w.batch, tr.tuning);
+            std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+            // the backend must deliver what was asked for
+            for (const auto& pr : r.results) {
+                if (pr.errcode < 0 || !(pr.errcode & SEFLG_SWIEPH)) {
+                    tr.ok = false;
+                    return;
+                }
+            }
+            if (i > 0)
+                t.push_back(dt.count());
+        }
+        double med = median_of(t);
+        std::vector<double> dev;
+        for (double x : t)
+            dev.push_back(std::abs(x - med));
+        tr.median.push_back(med);
+        tr.mad.push_back(median_of(dev));
+        tr.score += med;
+    }
+}
+
+int main(int argc, char** argv) {
+    TunerOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-o" && i + 1 < argc) {
+            opt.profile = argv[++i];
+        } else if (a == "-p" && i + 1 < argc) {
+            opt.ephe = argv[++i];
+        } else if (a == "-t" && i + 1 < argc) {
+            opt.table = argv[++i];
+        } else if (a == "-n" && i + 1 < argc) {
+            opt.nreq = std::max<size_t>(100, std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "-r" && i + 1 < argc) {
+            opt.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--quick") {
+            opt.quick = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [-o profile] [-p ephe path] [-t table] [-n requests] [-r reps] [--quick]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (opt.quick) {
+        opt.nreq = std::min<size_t>(opt.nreq, 5000);
+        opt.reps = std::min(opt.reps, 3);
+    }
+    if (opt.profile.empty())
+        opt.profile = parabola_profile_path();
+    // the profile is read by programs started anywhere
+    opt.ephe = absolute_paths(opt.ephe);
+    if (!opt.table.empty())
+        opt.table = std::filesystem::absolute(opt.table).lexically_normal().string();
+
+    size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> threads;
+    for (size_t t = 1; t < hw; t *= 2)
+        threads.push_back(t);
+    threads.push_back(hw);
+    std::vector<size_t> chunks = {0, 256, 1024, 4096};
+    std::vector<std::string> backends = {"swieph"};
+    if (!opt.table.empty()) {
+        // compute_batch falls back to the .se1 files if the table does not
+        // open, which would pass for the table
+        char serr[AS_MAXCH] = {0};
+        std::vector<char> name(opt.table.begin(), opt.table.end());
+        name.push_back('\0');
+        struct swe_table* ptab = swe_tab_open(name.data(), serr);
+        if (ptab == nullptr) {
+            std::fprintf(stderr, "table not tried: %s\n", serr);
+        } else {
+            swe_tab_close(ptab);
+            backends.push_back("table");
+        }
+    }
+
+    std::vector<Workload> workloads = make_workloads(opt.nreq);
+    std::vector<Trial> trials;
+    for (const auto& be : backends) {
+        for (size_t nt : threads) {
+            for (size_t ch : chunks) {
+                Trial tr;
+                tr.tuning.threads = nt;
+                tr.tuning.chunk = ch;
+                tr.tuning.backend = be;
+                tr.tuning.table = be == "table" ? opt.table : "";
+                tr.tuning.ephe_path = opt.ephe;
+                run_trial(tr, workloads, opt.reps);
+                if (!tr.ok) {
+                    std::printf("%-7s %3zu threads chunk %5zu: not available\n", be.c_str(), nt, ch);
+                    continue;
+                }
+                std::printf("%-7s %3zu threads chunk %5zu:", be.c_str(), nt, ch);
+                for (size_t k = 0; k < workloads.size(); ++k)
+                    std::printf("  %s %8.0f/s (+-%.1f%%)", workloads[k].name, opt.nreq / tr.median[k],
+                                100 * tr.mad[k] / tr.median[k]);
+                std::printf("\n");
+                std::fflush(stdout);
+                trials.push_back(tr);
+            }
+        }
+    }
+    if (trials.empty()) {
+        std::fprintf(stderr, "no configuration ran; check the ephemeris path %s\n", opt.ephe.c_str());
+        return 1;
+    }
+
+    double best_score = trials[0].score;
+    for (const auto& tr : trials)
+        best_score = std::min(best_score, tr.score);
+    const Trial* pick = nullptr;
+    for (const auto& tr : trials) {
+        if (tr.score > best_score * 1.02)
+            continue;
+        if (pick == nullptr || tr.tuning.threads < pick->tuning.threads
+            || (tr.tuning.threads == pick->tuning.threads && tr.score < pick->score))
+            pick = &tr;
+    }
+
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::path(opt.profile).parent_path();
+    if (!dir.empty())
+        std::filesystem::create_directories(dir, ec);
+    std::string err;
+    if (!parabola_save_profile(opt.profile, pick->tuning, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::printf("picked %s, %zu threads, chunk %zu (%.0f requests/s over all workloads)\n",
+                pick->tuning.backend.c_str(), pick->tuning.threads, pick->tuning.chunk,
+                workloads.size() * opt.nreq / pick->score);
+    std::printf("profile written to %s\n", opt.profile.c_str());
+    return 0;
+}
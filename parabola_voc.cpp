@@ -0,0 +1,117 @@
+// parabola_voc.cpp
+// Void-of-course Moon calendars, computed month by month in parallel
+
+#include "parabola_voc.h"
+#include "parabola_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+struct VocSlab {
+    double tjd_start;
+    double tjd_end;
+    std::vector<VOC> vocs;
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+static std::vector<VocSlab> make_slabs(const VocCalendarRequest& req) {
+    std::vector<VocSlab> slabs;
+    size_t nmon = std::max<size_t>(1, req.months_per_slab);
+    int year, month, day;
+    double hour;
+    swe_revjul(req.tjd_start, SE_GREG_CAL, &year, &month, &day, &hour);
+    double t0 = req.tjd_start;
+    while (t0 < req.tjd_end) {
+        month += (int) nmon;
+        year += (month - 1) / 12;
+        month = (month - 1) % 12 + 1;
+        double t1 = std::min(req.tjd_end, swe_julday(year, month, 1, 0, SE_GREG_CAL));
+        VocSlab s;
+        s.tjd_start = t0;
+        s.tjd_end = t1;
+        slabs.push_back(std::move(s));
+        t0 = t1;
+    }
+    return slabs;
+}
+
+// Phases from tjd0 while the search start is before tjde, as swevents does.
+static int32 search_vocs(const VocCalendarRequest& req, double tjd0, double tjde, std::vector<VOC>& vocs, char* serr) {
+    VOCITER* pit = swev_voc_open(req.iflag, req.vocmethod, tjd0, tjde, serr);
+    if (pit == NULL)
+        return ERR;
+    VOC voc;
+    int32 retc;
+    while ((retc = swev_voc_next(pit, &voc, serr)) == 1)
+        vocs.push_back(voc);
+    swev_voc_close(pit);
+    return retc == ERR ? ERR : OK;
+}
+
+// First lunar ingress after the search start of a phase
+static double first_ingress(const VOC& v) {
+    return v.tingr0 != 0 ? v.tingr0 : v.tingr;
+}
+
+VocCalendar compute_voc_calendar(const VocCalendarRequest& req) {
+    VocCalendar cal;
+    std::vector<VocSlab> slabs = make_slabs(req);
+    if (slabs.empty())
+        return cal;
+
+    size_t nthreads = req.threads ? req.threads : std::thread::hardware_concurrency();
+    nthreads = std::max<size_t>(1, std::min(nthreads, slabs.size()));
+    ParabolaThreadPool pool(nthreads);
+    std::vector<std::future<void>> futures;
+    for (auto& s : slabs) {
+        futures.emplace_back(pool.submit([&req, &s]() {
+            parabola_bind_ephe_path(req.ephe_path);
+            s.errcode = search_vocs(req, s.tjd_start, s.tjd_end, s.vocs, s.serr);
+        }));
+    }
+    for (auto& fut : futures)
+        fut.get();
+
+    // Walk the serial chain of search starts t (the first is tjd_start,
+    // then the end of the last phase + 0.1). The phase searched from t is
+    // the one a slab found from a start with the same next lunar ingress.
+    // Searches not covered by a slab run on a worker, like the slabs, so
+    // that the caller's ephemeris path is left alone.
+    pool.submit([&req, &slabs, &cal]() {
+        parabola_bind_ephe_path(req.ephe_path);
+        double t = req.tjd_start;
+        size_t k = 0, j = 0;
+        while (t < req.tjd_end) {
+            while (k + 1 < slabs.size() && slabs[k + 1].tjd_start <= t) {
+                ++k;
+                j = 0;
+            }
+            const VocSlab& s = slabs[k];
+            if (s.errcode == ERR) {
+                cal.errcode = ERR;
+                std::strcpy(cal.serr, s.serr);
+                return;
+            }
+            while (j < s.vocs.size() && first_ingress(s.vocs[j]) <= t)
+                ++j;
+            if (j < s.vocs.size() && (j == 0 || s.vocs[j - 1].tingr < t)) {
+                cal.vocs.push_back(s.vocs[j]);
+            } else {
+                // t is within a phase over two ingresses of this slab's chain,
+                // or beyond its last phase
+                std::vector<VOC> one;
+                if (search_vocs(req, t, std::nextafter(t, t + 1), one, cal.serr) == ERR) {
+                    cal.errcode = ERR;
+                    return;
+                }
+                // no further phase: the serial search ends here as well
+                if (one.empty())
+                    return;
+                cal.vocs.push_back(one[0]);
+            }
+            t = cal.vocs.back().tingr + 0.1;
+        }
+    }).get();
+    return cal;
+}
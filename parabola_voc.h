@@ -0,0 +1,33 @@
+// parabola_voc.h
+// Void-of-course Moon calendars, computed month by month in parallel
+#pragma once
+#include <string>
+#include <vector>
+#include "swephexp.h"
+extern "C" {
+#include "swevents.h"
+}
+
+struct VocCalendarRequest {
+    int32 iflag = SEFLG_SWIEPH;     // ephemeris flags
+    int32 vocmethod = 1;            // 1, 2 or 3, see swevvoc.c; 0 = 3
+    double tjd_start = 0;           // TT
+    double tjd_end = 0;             // TT; the phase ending after it is included
+    std::string ephe_path;          // bound in every worker; empty = default
+    size_t months_per_slab = 1;     // calendar months searched by one task
+    size_t threads = 0;             // 0 = std::thread::hardware_concurrency()
+};
+
+struct VocCalendar {
+    std::vector<VOC> vocs;          // in time order
+    int errcode = OK;
+    char serr[256] = {0};
+};
+
+// Returns the same phases as a single swev_voc_open() over the whole range.
+// The range is cut at month borders and every slab is searched by its own
+// VOC iterator; where a slab's first phase does not continue the chain of
+// phases of the slab before it (method 1 can bridge a month border with a
+// phase over two ingresses), the missing phases are searched serially
+// during the merge.
+VocCalendar compute_voc_calendar(const VocCalendarRequest& req);
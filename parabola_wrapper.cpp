@@ -2,6 +2,7 @@
 // Thread-safe, batch-optimized Swiss Ephemeris parallel executor
 
 #include "parabola_wrapper.h"
+#include "parabola_trace.h"
 #include "swephexp.h"
 #include <vector>
 #include <string>
@@ -9,15 +10,58 @@
 #include <mutex>
 #include <thread>
 #include <queue>
+#include <deque>
 #include <condition_variable>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <iostream>
+#include <fstream>
+#include <limits>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 // Public API types for use in the rest of Parabola
 PlanetBatchResult compute_batch(const PlanetBatchRequest& batch);
 
 
 size_t g_parabola_thread_count = 1; // default fallback if no autotune is run
+ParabolaTuning g_parabola_tuning;
+
+// Per-thread record of the ephemeris path bound to this thread's swed.
+// Its destructor runs at thread exit and releases the files the thread opened.
+struct ThreadEpheBinding {
+    std::string path;
+    std::string library_path;   // swe_get_ephe_path() after binding
+    bool bound = false;
+    ~ThreadEpheBinding() {
+        if (bound) swe_close();
+    }
+};
+
+static thread_local ThreadEpheBinding t_ephe_binding;
+
+// The binding is also checked against the path the library has, which
+// changes if the thread calls swe_set_ephe_path() itself. An empty path
+// goes back to the default if another one was bound before.
+void parabola_bind_ephe_path(const std::string& ephe_path) {
+    char current[AS_MAXCH];
+    swe_get_ephe_path(current);
+    if (t_ephe_binding.bound && t_ephe_binding.path == ephe_path && t_ephe_binding.library_path == current)
+        return;
+    if (!ephe_path.empty())
+        swe_set_ephe_path(ephe_path.c_str());
+    else if (t_ephe_binding.bound && !t_ephe_binding.path.empty())
+        swe_set_ephe_path(nullptr);
+    swe_get_ephe_path(current);
+    t_ephe_binding.path = ephe_path;
+    t_ephe_binding.library_path = current;
+    t_ephe_binding.bound = true;
+}
 
 class ThreadPool {
 public:
@@ -70,68 +114,385 @@ private:
     bool stop = false;
 };
 
-size_t autotune_threads(const std::vector<PlanetRequest>& requests) {
-    size_t best = 1;
-    double best_throughput = 0;
-    size_t trial = 1;
-    std::vector<PlanetRequest> slice = requests;
-
-    while (true) {
+// Takes chunks of job until the range is used up, a body threw or the
+// caller cancelled
+static void run_chunks(ParabolaJob& job) {
+    while (!job.failed.load(std::memory_order_relaxed)
+           && (job.cancel == nullptr || !job.cancel->load(std::memory_order_relaxed))) {
+        size_t begin = job.next.fetch_add(job.chunk, std::memory_order_relaxed);
+        if (begin >= job.n)
+            return;
         try {
-            auto start = std::chrono::high_resolution_clock::now();
-            ThreadPool pool(trial);
-            std::vector<std::future<void>> futures;
-
-            size_t slice_size = std::max<size_t>(1, slice.size() / trial);
-            for (size_t i = 0; i < slice.size(); i += slice_size) {
-                size_t end = std::min(slice.size(), i + slice_size);
-                futures.push_back(pool.enqueue([batch = std::vector<PlanetRequest>(slice.begin() + i, slice.begin() + end)]() {
-                    for (const auto& req : batch) {
-                        double xx[6];
-                        char serr[256] = {0};
-                        swe_calc_ut(req.jd, req.ipl, SEFLG_SPEED, xx, serr);
-                    }
-                }));
-            }
+            job.body(job.ctx, begin, std::min(job.n, begin + job.chunk));
+        } catch (...) {
+            if (!job.failed.exchange(true))
+                job.error = std::current_exception();
+        }
+    }
+}
+
+// set in the executor's workers
+static thread_local bool t_executor_worker = false;
+
+// Workers of parabola_run_job(). They start on first use, grow to the
+// largest thread count asked for and are joined at exit. A job stays in the
+// queue until it has its helpers or its range is used up.
+class ParabolaExecutor {
+public:
+    static ParabolaExecutor& instance() {
+        static ParabolaExecutor executor;
+        return executor;
+    }
 
-            for (auto& f : futures) f.get();
-            auto end = std::chrono::high_resolution_clock::now();
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-            double throughput = (requests.size() / (double)ms) * 1000.0;
+    // Lets up to `helpers` workers join job
+    void post(ParabolaJob& job, size_t helpers) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (workers.size() < helpers)
+            workers.emplace_back([this] { work(); });
+        job.max_helpers = helpers;
+        jobs.push_back(&job);
+        lock.unlock();
+        for (size_t i = 0; i < helpers; ++i)
+            wake.notify_one();
+    }
+
+    // Waits until no worker runs a chunk of job any more
+    void retire(ParabolaJob& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        unqueue(job);
+        idle.wait(lock, [&job] { return job.active == 0; });
+    }
+
+    // Waits until the workers have used up, or given up, the range of job
+    void finish(ParabolaJob& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&job] {
+            return job.active == 0
+                && (job.next.load() >= job.n || job.failed.load()
+                    || (job.cancel != nullptr && job.cancel->load(std::memory_order_relaxed)));
+        });
+        unqueue(job);
+    }
+
+    ~ParabolaExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+private:
+    void unqueue(ParabolaJob& job) {
+        auto it = std::find(jobs.begin(), jobs.end(), &job);
+        if (it != jobs.end())
+            jobs.erase(it);
+    }
+
+    void work() {
+        t_executor_worker = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (stop)
+                return;
+            ParabolaJob& job = *jobs.front();
+            if (++job.helpers >= job.max_helpers)
+                jobs.pop_front();
+            ++job.active;
+            lock.unlock();
+            run_chunks(job);
+            lock.lock();
+            // the range is used up; later workers need not look at it
+            unqueue(job);
+            if (--job.active == 0)
+                idle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<ParabolaJob*> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stop = false;
+};
 
-            std::cout << trial << " threads: " << ms << " ms => " << throughput << " planets/sec\n";
+// A caller outside the executor only waits, so that the bodies, which bind
+// ephemeris paths and tables, never change its thread's state. A worker
+// running a nested loop takes chunks itself, as waiting could deadlock.
+bool parabola_run_job(ParabolaJob& job, size_t threads) {
+    if (job.n == 0)
+        return true;
+    if (threads == 0)
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (job.chunk == 0)
+        job.chunk = std::max<size_t>(1, job.n / (8 * threads));
+    size_t helpers = std::min(threads, (job.n + job.chunk - 1) / job.chunk);
+    ParabolaExecutor& executor = ParabolaExecutor::instance();
+    if (!t_executor_worker) {
+        executor.post(job, helpers);
+        executor.finish(job);
+    } else if (helpers > 1) {
+        executor.post(job, helpers - 1);
+        run_chunks(job);
+        executor.retire(job);
+    } else {
+        run_chunks(job);
+    }
+    if (job.error)
+        std::rethrow_exception(job.error);
+    return job.next.load() >= job.n;
+}
 
-            if (throughput > best_throughput) {
-                best_throughput = throughput;
-                best = trial;
-                ++trial;
-            } else {
-                break; // performance dropped, stop here
+// Wall time of one pass of requests over `threads` workers, in seconds
+static double time_pass(const std::vector<PlanetRequest>& requests, size_t threads) {
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    std::vector<std::future<void>> futures;
+    size_t slice_size = std::max<size_t>(1, requests.size() / threads);
+    for (size_t i = 0; i < requests.size(); i += slice_size) {
+        size_t end = std::min(requests.size(), i + slice_size);
+        futures.push_back(pool.enqueue([&requests, i, end]() {
+            for (size_t k = i; k < end; ++k) {
+                double xx[6];
+                char serr[256] = {0};
+                swe_calc_ut(requests[k].jd, requests[k].ipl, SEFLG_SPEED, xx, serr);
             }
+        }));
+    }
+    for (auto& f : futures) f.get();
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    return dt.count();
+}
+
+// Tries 1, 2, 4, ... threads and the hardware's count on the first
+// AUTOTUNE_SAMPLE requests, taking the median of three passes each, and
+// returns the fastest. A dip in between does not end the search, as it did
+// when one pass in whole milliseconds decided.
+static const size_t AUTOTUNE_SAMPLE = 4096;
+
+size_t autotune_threads(const std::vector<PlanetRequest>& requests) {
+    ParabolaTraceScope span("autotune", "batch", (int64_t) requests.size());
+    if (requests.empty())
+        return 1;
+    std::vector<PlanetRequest> sample(requests.begin(),
+                                      requests.begin() + std::min(requests.size(), AUTOTUNE_SAMPLE));
+    size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < hw; t *= 2)
+        counts.push_back(t);
+    counts.push_back(hw);
+    size_t best = 1;
+    double best_time = 0;
+    for (size_t trial : counts) {
+        ParabolaTraceScope trial_span("autotune trial", "batch", (int64_t) trial);
+        double t[3];
+        try {
+            for (double& ti : t)
+                ti = time_pass(sample, trial);
         } catch (...) {
             break; // thread creation failed, cap reached
         }
+        std::sort(t, t + 3);
+        if (best_time == 0 || t[1] < best_time) {
+            best_time = t[1];
+            best = trial;
+        }
     }
     return best;
 }
 
+static std::string host_name() {
+    char buf[256] = {0};
+#if defined(_WIN32)
+    const char* h = std::getenv("COMPUTERNAME");
+    if (h != nullptr)
+        std::snprintf(buf, sizeof(buf), "%s", h);
+#else
+    if (gethostname(buf, sizeof(buf) - 1) != 0)
+        buf[0] = '\0';
+#endif
+    return buf[0] != '\0' ? buf : "localhost";
+}
+
+std::string parabola_profile_path() {
+    const char* p = std::getenv("PARABOLA_PROFILE");
+    if (p != nullptr && *p != '\0')
+        return p;
+    const char* home = std::getenv("HOME");
+#if defined(_WIN32)
+    if (home == nullptr)
+        home = std::getenv("USERPROFILE");
+#endif
+    std::string dir = home != nullptr ? std::string(home) + "/.parabola" : ".parabola";
+    return dir + "/" + host_name() + ".profile";
+}
+
+// One "key = value" per line; '#' starts a comment
+bool parabola_load_profile(const std::string& path, ParabolaTuning& tuning, std::string& err) {
+    std::ifstream in(path);
+    if (!in) {
+        err = "cannot read " + path;
+        return false;
+    }
+    ParabolaTuning t;
+    std::string line, host;
+    auto trim = [](std::string s) {
+        size_t b = s.find_first_not_of(" \t\r");
+        size_t e = s.find_last_not_of(" \t\r");
+        return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+    };
+    // the whole value must be a number, or the profile is rejected
+    auto parse_size = [](const std::string& v, size_t& out) {
+        char* end = nullptr;
+        if (v.empty() || !std::isdigit((unsigned char) v[0]))
+            return false;
+        errno = 0;
+        unsigned long long x = std::strtoull(v.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0' || x > std::numeric_limits<size_t>::max())
+            return false;
+        out = (size_t) x;
+        return true;
+    };
+    while (std::getline(in, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            continue;
+        std::string key = trim(line.substr(0, eq)), val = trim(line.substr(eq + 1));
+        if (key == "host")
+            host = val;
+        else if (key == "threads" || key == "chunk") {
+            if (!parse_size(val, key == "threads" ? t.threads : t.chunk)) {
+                err = path + ": bad " + key + " '" + val + "'";
+                return false;
+            }
+        }
+        else if (key == "backend")
+            t.backend = val;
+        else if (key == "table")
+            t.table = val;
+        else if (key == "table_maxerr")
+            t.table_maxerr = std::atof(val.c_str());
+        else if (key == "ephe_path")
+            t.ephe_path = val;
+    }
+    if (host != host_name()) {
+        err = path + " was tuned on host '" + host + "'";
+        return false;
+    }
+    if (t.backend != "swieph" && t.backend != "table") {
+        err = path + ": unknown backend '" + t.backend + "'";
+        return false;
+    }
+    tuning = t;
+    return true;
+}
+
+bool parabola_save_profile(const std::string& path, const ParabolaTuning& tuning, std::string& err) {
+    std::ofstream out(path);
+    if (!out) {
+        err = "cannot write " + path;
+        return false;
+    }
+    out << "# compute_batch tuning profile, written by parabola_tuner\n"
+        << "host = " << host_name() << "\n"
+        << "hardware_concurrency = " << std::thread::hardware_concurrency() << "\n"
+        << "threads = " << tuning.threads << "\n"
+        << "chunk = " << tuning.chunk << "\n"
+        << "backend = " << tuning.backend << "\n"
+        << "table = " << tuning.table << "\n"
+        << "table_maxerr = " << tuning.table_maxerr << "\n"
+        << "ephe_path = " << tuning.ephe_path << "\n";
+    out.close();
+    if (!out) {
+        err = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+// Tables opened for backend "table", shared by all workers until exit
+static struct swe_table* open_table(const std::string& fname) {
+    static std::mutex mutex;
+    static std::vector<std::pair<std::string, struct swe_table*>> tables;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& t : tables)
+        if (t.first == fname)
+            return t.second;
+    char serr[AS_MAXCH] = {0};
+    std::vector<char> name(fname.begin(), fname.end());
+    name.push_back('\0');
+    struct swe_table* ptab = swe_tab_open(name.data(), serr);
+    tables.emplace_back(fname, ptab);
+    return ptab;
+}
+
+const ParabolaTuning& parabola_default_tuning() {
+    static std::once_flag profile_once;
+    std::call_once(profile_once, [] {
+        std::string err;
+        parabola_load_profile(parabola_profile_path(), g_parabola_tuning, err);
+    });
+    return g_parabola_tuning;
+}
+
+void parabola_bind_tuning(const ParabolaTuning& tuning) {
+    if (!tuning.ephe_path.empty())
+        parabola_bind_ephe_path(tuning.ephe_path);
+    swe_set_table(tuning.backend == "table" ? open_table(tuning.table) : nullptr, tuning.table_maxerr);
+}
+
 PlanetBatchResult compute_batch(const PlanetBatchRequest& batch) {
-    g_parabola_thread_count = autotune_threads(batch.requests);
-    ThreadPool pool(g_parabola_thread_count);
+    return compute_batch(batch, parabola_default_tuning());
+}
+
+PlanetBatchResult compute_batch(const PlanetBatchRequest& batch, const ParabolaTuning& tuning) {
+    ParabolaTraceScope batch_span("compute_batch", "batch", (int64_t) batch.requests.size());
+    // without a profile, the first batch measures; later ones reuse the
+    // pick. Only the pick is published, so that callers with their own
+    // tuning do not change each other's thread count.
+    static std::once_flag autotune_once;
+    static size_t autotuned = 1;
+    size_t threads = tuning.threads;
+    if (threads == 0) {
+        std::call_once(autotune_once, [&] {
+            autotuned = autotune_threads(batch.requests);
+            g_parabola_thread_count = autotuned;
+        });
+        threads = autotuned;
+    }
+    ThreadPool pool(threads);
     std::vector<std::future<PlanetBatchResult>> futures;
 
-    size_t slice_size = std::max<size_t>(1, batch.requests.size() / g_parabola_thread_count);
+    size_t slice_size = tuning.chunk > 0 ? tuning.chunk
+                                         : std::max<size_t>(1, batch.requests.size() / threads);
 
     for (size_t i = 0; i < batch.requests.size(); i += slice_size) {
         size_t end = std::min(batch.requests.size(), i + slice_size);
-        std::vector<PlanetRequest> slice(batch.requests.begin() + i, batch.requests.begin() + end);
+        uint64_t t_enqueue = parabola_trace_active() ? parabola_trace_now() : 0;
 
-        futures.emplace_back(pool.enqueue([slice]() -> PlanetBatchResult {
+        futures.emplace_back(pool.enqueue([&batch, &tuning, i, end, t_enqueue]() -> PlanetBatchResult {
+            if (t_enqueue != 0) {
+                parabola_trace_thread_name("compute_batch worker");
+                parabola_trace_span("queue wait", "batch", t_enqueue, parabola_trace_now());
+            }
+            ParabolaTraceScope slice_span("slice", "batch", (int64_t) (end - i));
+            parabola_bind_tuning(tuning);
+            bool phases = parabola_trace_request_phases();
             PlanetBatchResult result;
-            for (const auto& req : slice) {
+            result.results.reserve(end - i);
+            for (size_t k = i; k < end; ++k) {
+                const PlanetRequest& req = batch.requests[k];
                 PlanetResult r = {.ipl = req.ipl};
                 std::memset(r.serr, 0, sizeof(r.serr));
+                uint64_t t0 = phases ? parabola_trace_now() : 0;
                 int ret = swe_calc_ut(req.jd, req.ipl, SEFLG_SPEED, r.xx, r.serr);
+                if (phases)
+                    parabola_trace_span("swe_calc_ut", "request", t0, parabola_trace_now(), req.ipl);
                 r.errcode = ret;
                 result.results.push_back(r);
             }
@@ -140,8 +501,13 @@ PlanetBatchResult compute_batch(const PlanetBatchRequest& batch) {
     }
 
     PlanetBatchResult merged;
+    merged.results.reserve(batch.requests.size());
     for (auto& fut : futures) {
+        uint64_t t_wait = parabola_trace_active() ? parabola_trace_now() : 0;
         PlanetBatchResult r = fut.get();
+        if (t_wait != 0)
+            parabola_trace_span("wait for slice", "batch", t_wait, parabola_trace_now());
+        ParabolaTraceScope merge_span("merge", "batch", (int64_t) r.results.size());
         merged.results.insert(merged.results.end(), r.results.begin(), r.results.end());
     }
 
@@ -5,7 +5,13 @@
 extern size_t g_parabola_thread_count;
 
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <thread>
 #include <queue>
 #include <mutex>
@@ -63,22 +69,118 @@ private:
     bool stop = false;
 };
 
-// universal parabola<T, R>(inputs, lambda)
+// Parallel loops on one executor that lives for the whole process. A call
+// posts a single job: workers take chunks of the index range from an
+// atomic counter until it is used up, so there is no task, future or
+// std::function per item, and the callable is invoked directly. The calling
+// thread waits and runs no body, so its ephemeris state stays as it was.
+// Worker threads keep theirs between calls; bind the path with
+// parabola_bind_ephe_path() in the body. Calls may be nested; a nested call
+// also runs chunks on the worker that makes it.
+struct ParabolaParallelOptions {
+    size_t threads = 0;                         // workers; 0 = hardware_concurrency()
+    size_t chunk = 0;                           // indices per grab; 0 = about 8 grabs per thread
+    const std::atomic<bool>* cancel = nullptr;  // checked before every chunk
+};
+
+// One parallel loop, as seen by the executor
+struct ParabolaJob {
+    void (*body)(void* ctx, size_t begin, size_t end);
+    void* ctx;
+    size_t n;
+    size_t chunk;
+    size_t max_helpers;                     // workers that may join
+    const std::atomic<bool>* cancel;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;               // first exception of a body
+    size_t helpers = 0;                     // guarded by the executor
+    size_t active = 0;                      // guarded by the executor
+};
+
+// Runs `job` to completion or cancellation on the executor. Rethrows the first exception of a body; returns false if it was
+// cancelled, in which case some chunks never ran.
+bool parabola_run_job(ParabolaJob& job, size_t threads);
+
+// f(begin, end) for consecutive subranges of [0, n)
+template <typename F>
+bool parabola_for_range(size_t n, F&& f, const ParabolaParallelOptions& opt = ParabolaParallelOptions()) {
+    using Body = std::remove_reference_t<F>;
+    ParabolaJob job;
+    job.body = [](void* ctx, size_t begin, size_t end) { (*static_cast<Body*>(ctx))(begin, end); };
+    job.ctx = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+    job.n = n;
+    job.chunk = opt.chunk;
+    job.cancel = opt.cancel;
+    return parabola_run_job(job, opt.threads);
+}
+
+// f(i) for every i in [0, n)
+template <typename F>
+bool parabola_for(size_t n, F&& f, const ParabolaParallelOptions& opt = ParabolaParallelOptions()) {
+    return parabola_for_range(n, [&f](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            f(i);
+    }, opt);
+}
+
+// out[i] = f(items[i]), into storage the caller has sized
+template <typename T, typename OutIt, typename F>
+bool parabola_map(const std::vector<T>& items, OutIt out, F&& f,
+                  const ParabolaParallelOptions& opt = ParabolaParallelOptions()) {
+    return parabola_for_range(items.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            out[i] = f(items[i]);
+    }, opt);
+}
+
+template <typename T, typename F>
+auto parabola_map(const std::vector<T>& items, F&& f, const ParabolaParallelOptions& opt = ParabolaParallelOptions())
+    -> std::vector<std::decay_t<std::invoke_result_t<F&, const T&>>> {
+    std::vector<std::decay_t<std::invoke_result_t<F&, const T&>>> results(items.size());
+    parabola_map(items, results.begin(), f, opt);
+    return results;
+}
+
+// combine(... combine(combine(init, f(items[0])), f(items[1])) ...). The
+// chunks are reduced in parallel and their partial results in index order,
+// so the result does not depend on scheduling if combine is associative.
+template <typename T, typename R, typename F, typename Op>
+R parabola_reduce(const std::vector<T>& items, R init, F&& f, Op&& combine,
+                  ParabolaParallelOptions opt = ParabolaParallelOptions()) {
+    size_t n = items.size();
+    if (n == 0)
+        return init;
+    size_t nt = opt.threads ? opt.threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (opt.chunk == 0)
+        opt.chunk = std::max<size_t>(1, n / (8 * nt));
+    size_t nchunks = (n + opt.chunk - 1) / opt.chunk;
+    std::vector<std::optional<R>> partial(nchunks);
+    parabola_for_range(n, [&](size_t begin, size_t end) {
+        R acc = f(items[begin]);
+        for (size_t i = begin + 1; i < end; ++i)
+            acc = combine(std::move(acc), f(items[i]));
+        partial[begin / opt.chunk] = std::move(acc);
+    }, opt);
+    // chunks skipped by a cancellation are left out
+    for (auto& p : partial)
+        if (p)
+            init = combine(std::move(init), std::move(*p));
+    return init;
+}
+
+// universal parabola<T, R>(inputs, lambda), on g_parabola_thread_count threads
 template <typename T, typename R>
 std::vector<R> parabola(const std::vector<T>& items, std::function<R(const T&)> func) {
-    ParabolaThreadPool pool(g_parabola_thread_count);
-    std::vector<std::future<R>> futures;
-    for (const auto& item : items)
-        futures.emplace_back(pool.submit([=]() { return func(item); }));
-
-    std::vector<R> results;
-    results.reserve(items.size());
-    for (auto& f : futures)
-        results.push_back(f.get());
+    ParabolaParallelOptions opt;
+    opt.threads = std::max<size_t>(1, g_parabola_thread_count);
+    std::vector<R> results(items.size());
+    parabola_map(items, results.begin(), func, opt);
     return results;
 }
 #pragma once
 #include <vector>
+#include <string>
 
 // Public API types
 struct PlanetRequest {
@@ -101,8 +203,44 @@ struct PlanetBatchResult {
     std::vector<PlanetResult> results;
 };
 
-// Main API entrypoint
+// Knobs of compute_batch, normally from the host's tuning profile
+struct ParabolaTuning {
+    size_t threads = 0;             // 0 = autotune_threads() on the first batch
+    size_t chunk = 0;               // requests per task; 0 = one slice per thread
+    std::string backend = "swieph"; // "swieph": .se1 files; "table": see below
+    std::string table;              // swe_tab_open() file for backend "table"
+    double table_maxerr = 0.01;     // arc seconds, see swe_set_table()
+    std::string ephe_path;          // bound in every worker; empty = default
+};
+extern ParabolaTuning g_parabola_tuning;
+
+// Main API entrypoint; runs with g_parabola_tuning, which the first call
+// loads from the profile at parabola_profile_path() if there is one.
 PlanetBatchResult compute_batch(const PlanetBatchRequest& batch);
+PlanetBatchResult compute_batch(const PlanetBatchRequest& batch, const ParabolaTuning& tuning);
+
+// g_parabola_tuning, loaded from the profile on the first call
+const ParabolaTuning& parabola_default_tuning();
+
+// Sets up the calling worker for `tuning`: binds its ephemeris path and
+// selects the table of backend "table" (or none) with swe_set_table()
+void parabola_bind_tuning(const ParabolaTuning& tuning);
 
 // Configurable thread pool tuning
 extern size_t g_parabola_thread_count;
+size_t autotune_threads(const std::vector<PlanetRequest>& requests);
+
+// Tuning profiles, written by parabola_tuner. The path is $PARABOLA_PROFILE,
+// else $HOME/.parabola/<host name>.profile. A profile written on another
+// host is not loaded. Both return false, with the reason in err, if the
+// file cannot be read or written.
+std::string parabola_profile_path();
+bool parabola_load_profile(const std::string& path, ParabolaTuning& tuning, std::string& err);
+bool parabola_save_profile(const std::string& path, const ParabolaTuning& tuning, std::string& err);
+
+// Point the calling thread's ephemeris state (TLS swed) at `ephe_path`.
+// Only calls swe_set_ephe_path() when the path differs from the one this
+// thread already uses, and arranges for swe_close() when the thread exits,
+// so pool workers neither reopen files per task nor leak descriptors.
+// An empty path means the library default.
+void parabola_bind_ephe_path(const std::string& ephe_path);
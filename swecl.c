@@ -3788,10 +3788,34 @@ static const double mag_elem[NMAG_ELEM][4] = {
                 {5.33, 0.32, 0, 0},     /* Juno */
                 {3.20, 0.32, 0, 0},     /* Vesta */
                 };
-int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char *serr)
+static AS_BOOL pheno_has_phase(int32 ipl)
+{
+  return (ipl != SE_SUN && ipl != SE_EARTH &&
+    ipl != SE_MEAN_NODE && ipl != SE_TRUE_NODE &&
+    ipl != SE_MEAN_APOG && ipl != SE_OSCU_APOG);
+}
+
+/* cartesian -> polar coordinates in degrees, as swe_calc() returns them
+ * without SEFLG_XYZ */
+static void pheno_cartpol(double *x, double *l)
+{
+  swi_cartpol(x, l);
+  l[0] *= RADTODEG;
+  l[1] *= RADTODEG;
+}
+
+/* 
+ * Core of swe_pheno() and swe_pheno_multi().
+ * xs and *iflag_sun cache the geocentric sun used for the elongation:
+ * it is only recomputed if the flags of this body differ from the ones
+ * it was computed with, so that several bodies at the same tjd share it.
+ * Polar coordinates are derived from the cartesian positions instead of
+ * calling swe_calc() a second time for each of them.
+ */
+static int32 pheno_calc(double tjd, int32 ipl, int32 iflag, double *xs, int32 *iflag_sun, double *attr, char *serr)
 {
   int i;
-  double xx[6], xx2[6], xxs[6], lbr[6], lbr2[6], dt = 0, dd;
+  double xx[6], xx2[6], lbr[6], lbr2[6], dt = 0, dd;
   double fac;
   double T, in, om, sinB;
   double ph1, ph2, me[2];
@@ -3837,17 +3861,8 @@ int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char
     iflagp |= epheflag2;
     epheflag = epheflag2;
   }
-  if (swe_calc(tjd, (int) ipl, iflag, lbr, serr) == ERR)
-    /* int cast can be removed when swe_calc() gets int32 ipl definition */
-    return ERR;
-  /* if moon, we need sun as well, for magnitude */
-  if (ipl == SE_MOON) {
-    if (swe_calc(tjd, SE_SUN, iflag | SEFLG_XYZ, xxs, serr) == ERR)
-      return ERR;
-  }
-  if (ipl != SE_SUN && ipl != SE_EARTH &&
-    ipl != SE_MEAN_NODE && ipl != SE_TRUE_NODE &&
-    ipl != SE_MEAN_APOG && ipl != SE_OSCU_APOG) {
+  pheno_cartpol(xx, lbr);
+  if (pheno_has_phase(ipl)) {
     /*
      * light time planet - earth
      */
@@ -3860,9 +3875,7 @@ int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char
     if (swe_calc(tjd - dt, (int) ipl, iflagp | SEFLG_XYZ, xx2, serr) == ERR)
     /* int cast can be removed when swe_calc() gets int32 ipl definition */
       return ERR;
-    if (swe_calc(tjd - dt, (int) ipl, iflagp, lbr2, serr) == ERR)
-    /* int cast can be removed when swe_calc() gets int32 ipl definition */
-      return ERR;
+    pheno_cartpol(xx2, lbr2);
     /*
      * phase angle
      */
@@ -4059,11 +4072,12 @@ int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char
     /* 
      * elongation of planet
      */
-    if (swe_calc(tjd, SE_SUN, iflag | SEFLG_XYZ, xx2, serr) == ERR)
-      return ERR;
-    if (swe_calc(tjd, SE_SUN, iflag, lbr2, serr) == ERR)
-      return ERR;
-    attr[2] = acos(swi_dot_prod_unit(xx, xx2)) * RADTODEG;
+    if (*iflag_sun != iflag) {
+      if (swe_calc(tjd, SE_SUN, iflag | SEFLG_XYZ, xs, serr) == ERR)
+        return ERR;
+      *iflag_sun = iflag;
+    }
+    attr[2] = acos(swi_dot_prod_unit(xx, xs)) * RADTODEG;
   }
   /* horizontal parallax */
   if (ipl == SE_MOON) {
@@ -4111,6 +4125,69 @@ int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char
   return iflag;
 }
 
+int32 CALL_CONV swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char *serr)
+{
+  double xs[6];
+  int32 iflag_sun = -1;
+  return pheno_calc(tjd, ipl, iflag, xs, &iflag_sun, attr, serr);
+}
+
+/*
+ * Phenomena of several bodies at the same time tjd (ET).
+ * attr must have room for 20 * nipl doubles; attr + 20 * i receives what
+ * swe_pheno(tjd, ipl[i], iflag, attr + 20 * i, serr) would return, and
+ * retflag[i] its return value. The geocentric sun is computed once for
+ * all bodies.
+ * Returns OK, or ERR if any body failed; serr then holds the first error.
+ */
+int32 CALL_CONV swe_pheno_multi(double tjd, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr)
+{
+  int32 i, retc = OK;
+  double xs[6];
+  int32 iflag_sun = -1;
+  char serr2[AS_MAXCH];
+  if (serr != NULL)
+    *serr = '\0';
+  for (i = 0; i < nipl; i++) {
+    *serr2 = '\0';
+    retflag[i] = pheno_calc(tjd, ipl[i], iflag, xs, &iflag_sun, attr + 20 * i, serr2);
+    if (retflag[i] == ERR && retc != ERR) {
+      retc = ERR;
+      if (serr != NULL)
+        strcpy(serr, serr2);
+    }
+  }
+  return retc;
+}
+
+int32 CALL_CONV swe_pheno_multi_ut(double tjd_ut, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr)
+{
+  double deltat;
+  int32 i, retc;
+  char serr2[AS_MAXCH];
+  int32 epheflag = iflag & SEFLG_EPHMASK;
+  if (epheflag == 0) {
+    epheflag = SEFLG_SWIEPH;
+    iflag |= SEFLG_SWIEPH;
+  }
+  deltat = swe_deltat_ex(tjd_ut, iflag, serr);
+  retc = swe_pheno_multi(tjd_ut + deltat, ipl, nipl, iflag, attr, retflag, serr);
+  /* bodies for which another ephemeris was used need their own delta t,
+   * as in swe_pheno_ut() */
+  for (i = 0; i < nipl; i++) {
+    if (retflag[i] != ERR && (retflag[i] & SEFLG_EPHMASK) != epheflag) {
+      *serr2 = '\0';
+      retflag[i] = swe_pheno_ut(tjd_ut, ipl[i], iflag, attr + 20 * i, serr2);
+      if (retflag[i] < 0 && retc != ERR) {
+        retc = ERR;
+        if (serr != NULL)
+          strcpy(serr, serr2);
+      }
+    }
+  }
+  return retc;
+}
+
 int32 CALL_CONV swe_pheno_ut(double tjd_ut, int32 ipl, int32 iflag, double *attr, char *serr)
 {
   double deltat;
@@ -0,0 +1,373 @@
+/* SWISSEPH
+ * 
+ * swectx.c: explicit calculation contexts.
+ *
+ * All state of the library - ephemeris files, the JPL reader, saved
+ * positions, nutation and obliquity, topocentric and sidereal settings,
+ * the last fixed star - lives in a struct swe_data. Every thread has a
+ * default one (swi_swed_tls), which the classical functions use.
+ *
+ * A swe_ctx holds a struct swe_data of its own. The swe_ctx_...()
+ * functions run the classical function with the thread redirected to
+ * the context, so that a task-based runtime can keep one context per
+ * task and resume the task on any worker thread, with its files still
+ * open and its saved positions still valid. swe_ctx_bind() redirects
+ * the thread for any number of classical calls.
+ *
+ * A context must not be used by two threads at the same time. A NULL
+ * context stands for the default context of the calling thread.
+ *
+ * The segment buffers of a context come from an arena of a few large
+ * blocks. swe_close() and file switches reset the arena without freeing
+ * the blocks, so that a context reused for request after request with
+ * swe_ctx_close() does not allocate again. The blocks are freed by
+ * swe_ctx_free(), and for the default context of a thread by
+ * swe_close(). swe_ctx_arena_stats() returns the counters.
+ *
+ * The following is not part of a context and stays per thread: the
+ * scratch arrays of the Moshier theories, the caches of the heliacal
+ * functions (swehel.c), the lapse rate for refraction (swecl.c) and the
+ * tables of Delta T and leap seconds, which are read from the
+ * ephemeris path but are the same for all contexts using it.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+
+#define ARENA_BLOCK	16384	/* segments of all main bodies fit twice */
+#define ARENA_ALIGN	16
+
+struct swi_arena_block {
+  struct swi_arena_block *next;
+  size_t size, used;
+};
+
+/* header size rounded up, so that the space behind it is aligned */
+#define BLOCK_HDR	((sizeof(struct swi_arena_block) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+struct swe_ctx {
+  struct swe_data data;		/* first member, see swe_ctx_bind() */
+};
+
+/* Returns space of size bytes, aligned for doubles, or NULL if out of
+ * memory. The space is valid until swi_arena_reset(). */
+void *swi_arena_alloc(struct swi_arena *a, size_t size)
+{
+  struct swi_arena_block *b;
+  size_t bsize;
+  size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+  for (b = a->blocks; b != NULL; b = b->next) {
+    if (b->size - b->used >= size)
+      break;
+  }
+  if (b == NULL) {
+    bsize = (size > ARENA_BLOCK) ? size : ARENA_BLOCK;
+    if ((b = (struct swi_arena_block *) malloc(BLOCK_HDR + bsize)) == NULL)
+      return NULL;
+    b->size = bsize;
+    b->used = 0;
+    b->next = a->blocks;
+    a->blocks = b;
+    a->nmalloc++;
+    a->reserved += bsize;
+  }
+  b->used += size;
+  a->nalloc++;
+  a->used += size;
+  if (a->used > a->peak)
+    a->peak = a->used;
+  return (char *) b + BLOCK_HDR + b->used - size;
+}
+
+/* all space becomes free; the blocks are kept */
+void swi_arena_reset(struct swi_arena *a)
+{
+  struct swi_arena_block *b;
+  for (b = a->blocks; b != NULL; b = b->next)
+    b->used = 0;
+  a->used = 0;
+  a->nreset++;
+}
+
+/* frees the blocks; the counters are kept */
+void swi_arena_release(struct swi_arena *a)
+{
+  struct swi_arena_block *b;
+  while ((b = a->blocks) != NULL) {
+    a->blocks = b->next;
+    free(b);
+    a->nfree++;
+  }
+  a->used = 0;
+  a->reserved = 0;
+}
+
+/* redirects the thread to ctx, returns the context to restore */
+static struct swe_data *ctx_enter(swe_ctx *ctx)
+{
+  struct swe_data *prev = swi_swed_cur;
+  swi_swed_cur = (ctx != NULL) ? &ctx->data : NULL;
+  return prev;
+}
+
+static void ctx_leave(struct swe_data *prev)
+{
+  swi_swed_cur = prev;
+}
+
+/* Creates an empty context. It is initialised like the default context
+ * of a new thread with the first call that uses it, i.e. the ephemeris
+ * path is SE_EPHE_PATH or $SE_EPHE_PATH until swe_ctx_set_ephe_path().
+ * Returns NULL if out of memory. */
+swe_ctx *CALL_CONV swe_ctx_new(void)
+{
+  /* all zero is the state of a context before swi_init_swed_if_start() */
+  return (swe_ctx *) calloc(1, sizeof(swe_ctx));
+}
+
+/* Closes the files of the context and frees it. If the context is bound
+ * to the calling thread, the thread returns to its default context. */
+void CALL_CONV swe_ctx_free(swe_ctx *ctx)
+{
+  struct swe_data *prev;
+  if (ctx == NULL)
+    return;
+  prev = ctx_enter(ctx);
+  swe_close();
+  swi_arena_release(&ctx->data.arena);
+  ctx_leave(prev == &ctx->data ? NULL : prev);
+  free(ctx);
+}
+
+/* Makes ctx the context of all following calls of the thread, NULL the
+ * default context. Returns the context bound before, to be restored by
+ * the caller. */
+swe_ctx *CALL_CONV swe_ctx_bind(swe_ctx *ctx)
+{
+  return (swe_ctx *) ctx_enter(ctx);
+}
+
+void CALL_CONV swe_ctx_set_ephe_path(swe_ctx *ctx, const char *path)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  swe_set_ephe_path(path);
+  ctx_leave(prev);
+}
+
+void CALL_CONV swe_ctx_set_jpl_file(swe_ctx *ctx, const char *fname)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  swe_set_jpl_file(fname);
+  ctx_leave(prev);
+}
+
+void CALL_CONV swe_ctx_set_topo(swe_ctx *ctx, double geolon, double geolat, double geoalt)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  swe_set_topo(geolon, geolat, geoalt);
+  ctx_leave(prev);
+}
+
+void CALL_CONV swe_ctx_set_sid_mode(swe_ctx *ctx, int32 sid_mode, double t0, double ayan_t0)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  swe_set_sid_mode(sid_mode, t0, ayan_t0);
+  ctx_leave(prev);
+}
+
+/* Closes the files of the context and forgets all computed positions,
+ * as swe_close() does, but keeps the buffers for the next request. */
+void CALL_CONV swe_ctx_close(swe_ctx *ctx)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  swe_close();
+  ctx_leave(prev);
+}
+
+/* Counters of the segment buffer arena of the context, see 
+ * SE_ARENA_... for the index of each in stats[SE_ARENA_NSTATS] */
+void CALL_CONV swe_ctx_arena_stats(swe_ctx *ctx, double *stats)
+{
+  struct swe_data *prev = ctx_enter(ctx);
+  struct swi_arena *a = &swed.arena;
+  stats[SE_ARENA_NALLOC] = a->nalloc;
+  stats[SE_ARENA_NRESET] = a->nreset;
+  stats[SE_ARENA_NMALLOC] = a->nmalloc;
+  stats[SE_ARENA_NFREE] = a->nfree;
+  stats[SE_ARENA_USED] = (double) a->used;
+  stats[SE_ARENA_RESERVED] = (double) a->reserved;
+  stats[SE_ARENA_PEAK] = (double) a->peak;
+  ctx_leave(prev);
+}
+
+int32 CALL_CONV swe_ctx_calc(swe_ctx *ctx, double tjd, int ipl, int32 iflag, double *xx, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_calc(tjd, ipl, iflag, xx, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_calc_ut(swe_ctx *ctx, double tjd_ut, int32 ipl, int32 iflag, double *xx, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_calc_ut(tjd_ut, ipl, iflag, xx, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_fixstar2(swe_ctx *ctx, char *star, double tjd, int32 iflag, double *xx, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_fixstar2(star, tjd, iflag, xx, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_fixstar2_ut(swe_ctx *ctx, char *star, double tjd_ut, int32 iflag, double *xx, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_fixstar2_ut(star, tjd_ut, iflag, xx, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int CALL_CONV swe_ctx_houses(swe_ctx *ctx, double tjd_ut, double geolat, double geolon, int hsys, double *cusps, double *ascmc)
+{
+  int retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_houses(tjd_ut, geolat, geolon, hsys, cusps, ascmc);
+  ctx_leave(prev);
+  return retc;
+}
+
+int CALL_CONV swe_ctx_houses_ex2(swe_ctx *ctx, double tjd_ut, int32 iflag, double geolat, double geolon, int hsys, double *cusps, double *ascmc, double *cusp_speed, double *ascmc_speed, char *serr)
+{
+  int retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_houses_ex2(tjd_ut, iflag, geolat, geolon, hsys, cusps, ascmc, cusp_speed, ascmc_speed, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_sol_eclipse_when_loc(swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_sol_eclipse_when_loc(tjd_start, ifl, geopos, tret, attr, backward, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_sol_eclipse_when_glob(swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_sol_eclipse_when_glob(tjd_start, ifl, ifltype, tret, backward, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_sol_eclipse_how(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_sol_eclipse_how(tjd_ut, ifl, geopos, attr, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_sol_eclipse_where(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_sol_eclipse_where(tjd_ut, ifl, geopos, attr, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_lun_eclipse_when(swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_lun_eclipse_when(tjd_start, ifl, ifltype, tret, backward, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_lun_eclipse_when_loc(swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_lun_eclipse_when_loc(tjd_start, ifl, geopos, tret, attr, backward, serr);
+  ctx_leave(prev);
+  return retc;
+}
+
+int32 CALL_CONV swe_ctx_lun_eclipse_how(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr)
+{
+  int32 retc;
+  struct swe_data *prev = ctx_enter(ctx);
+  retc = swe_lun_eclipse_how(tjd_ut, ifl, geopos, attr, serr);
+  ctx_leave(prev);
+  return retc;
+}
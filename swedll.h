@@ -92,6 +92,7 @@ extern "C" {
 DllImport int32 CALL_CONV_IMP swe_heliacal_ut(double JDNDaysUTStart, double *geopos, double *datm, double *dobs, char *ObjectName, int32 TypeEvent, int32 iflag, double *dret, char *serr);
 DllImport int32 CALL_CONV_IMP swe_heliacal_pheno_ut(double JDNDaysUT, double *geopos, double *datm, double *dobs, char *ObjectName, int32 TypeEvent, int32 helflag, double *darr, char *serr);
 DllImport int32 CALL_CONV_IMP swe_vis_limit_mag(double tjdut, double *geopos, double *datm, double *dobs, char *ObjectName, int32 helflag, double *dret, char *serr);
+DllImport int32 CALL_CONV_IMP swe_vis_limit_mag_grid(double tjdut, double *geopos, int32 ngeo, double *datm, double *dobs, char *ObjectName, int32 helflag, double *dret, int32 *retflag, char *serr);
 /* the following are secret, for Victor Reijs' */
 DllImport int32 CALL_CONV_IMP swe_heliacal_angle(double tjdut, double *dgeo, double *datm, double *dobs, int32 helflag, double mag, double azi_obj, double azi_sun, double azi_moon, double alt_moon, double *dret, char *serr);
 DllImport int32 CALL_CONV_IMP swe_topo_arcus_visionis(double tjdut, double *dgeo, double *datm, double *dobs, int32 helflag, double mag, double azi_obj, double alt_obj, double azi_sun, double azi_moon, double alt_moon, double *dret, char *serr);
@@ -131,6 +132,79 @@ DllImport int32 CALL_CONV_IMP swe_helio_cross(
 	int ipl, double x2cross, double jd_et, int32 iflag, int32 dir, double *jd_cross, char *serr);
 DllImport int32 CALL_CONV_IMP swe_helio_cross_ut(
 	int ipl, double x2cross, double jd_ut, int32 iflag, int32 dir, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_solcross_multi(
+	double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_solcross_multi_ut(
+	double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_mooncross_multi(
+	double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_mooncross_multi_ut(
+	double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_mooncross_node_multi(
+	double *jd_et, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr);
+DllImport int32 CALL_CONV_IMP swe_mooncross_node_multi_ut(
+	double *jd_ut, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr);
+DllImport int32 CALL_CONV_IMP swe_helio_cross_multi(
+	int32 ipl, double *x2cross, double *jd_et, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr);
+DllImport int32 CALL_CONV_IMP swe_helio_cross_multi_ut(
+	int32 ipl, double *x2cross, double *jd_ut, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr);
+struct swe_table;
+DllImport double CALL_CONV_IMP swe_tab_default_step(int32 ipl);
+DllImport int32 CALL_CONV_IMP swe_tab_grid(
+	double tjd0, double tjde, double tstep, double *tfirst, int32 *npt);
+DllImport int32 CALL_CONV_IMP swe_tab_sample(
+	int32 ipl, int32 iflag, double tfirst, double tstep, int32 i0, int32 n, double *x, char *serr);
+DllImport int32 CALL_CONV_IMP swe_tab_error(
+	int32 ipl, int32 iflag, double tfirst, double tstep, int32 npt, double *x, int32 i0, int32 i1, double prec, char *bad, double *maxerr, char *serr);
+DllImport int32 CALL_CONV_IMP swe_tab_save(
+	char *fname, double tjd0, double tjde, int32 nbody, int32 *ipl, int32 *retflag, double *tstep, double **x, double prec, char **bad, double *maxerr, char *serr);
+DllImport int32 CALL_CONV_IMP swe_tab_create(
+	char *fname, int32 iflag, double tjd0, double tjde, int32 nbody, int32 *ipl, double *tstep, double prec, char *serr);
+DllImport struct swe_table * CALL_CONV_IMP swe_tab_open(char *fname, char *serr);
+DllImport void CALL_CONV_IMP swe_tab_close(struct swe_table *ptab);
+DllImport double CALL_CONV_IMP swe_tab_maxerr(
+	struct swe_table *ptab, int32 ipl, double *maxerr);
+DllImport int32 CALL_CONV_IMP swe_tab_calc(
+	struct swe_table *ptab, double tjd, int32 ipl, int32 iflag, double *xx, char *serr);
+DllImport void CALL_CONV_IMP swe_set_table(struct swe_table *ptab, double maxerr);
+typedef struct swe_ctx swe_ctx;
+DllImport swe_ctx * CALL_CONV_IMP swe_ctx_new(void);
+DllImport void CALL_CONV_IMP swe_ctx_free(swe_ctx *ctx);
+DllImport swe_ctx * CALL_CONV_IMP swe_ctx_bind(swe_ctx *ctx);
+DllImport void CALL_CONV_IMP swe_ctx_set_ephe_path(swe_ctx *ctx, const char *path);
+DllImport void CALL_CONV_IMP swe_ctx_set_jpl_file(swe_ctx *ctx, const char *fname);
+DllImport void CALL_CONV_IMP swe_ctx_set_topo(
+	swe_ctx *ctx, double geolon, double geolat, double geoalt);
+DllImport void CALL_CONV_IMP swe_ctx_set_sid_mode(
+	swe_ctx *ctx, int32 sid_mode, double t0, double ayan_t0);
+DllImport void CALL_CONV_IMP swe_ctx_close(swe_ctx *ctx);
+DllImport void CALL_CONV_IMP swe_ctx_arena_stats(swe_ctx *ctx, double *stats);
+DllImport int32 CALL_CONV_IMP swe_ctx_calc(
+	swe_ctx *ctx, double tjd, int ipl, int32 iflag, double *xx, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_calc_ut(
+	swe_ctx *ctx, double tjd_ut, int32 ipl, int32 iflag, double *xx, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_fixstar2(
+	swe_ctx *ctx, char *star, double tjd, int32 iflag, double *xx, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_fixstar2_ut(
+	swe_ctx *ctx, char *star, double tjd_ut, int32 iflag, double *xx, char *serr);
+DllImport int CALL_CONV_IMP swe_ctx_houses(
+	swe_ctx *ctx, double tjd_ut, double geolat, double geolon, int hsys, double *cusps, double *ascmc);
+DllImport int CALL_CONV_IMP swe_ctx_houses_ex2(
+	swe_ctx *ctx, double tjd_ut, int32 iflag, double geolat, double geolon, int hsys, double *cusps, double *ascmc, double *cusp_speed, double *ascmc_speed, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_sol_eclipse_when_loc(
+	swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_sol_eclipse_when_glob(
+	swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_sol_eclipse_how(
+	swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_sol_eclipse_where(
+	swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_lun_eclipse_when(
+	swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_lun_eclipse_when_loc(
+	swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr);
+DllImport int32 CALL_CONV_IMP swe_ctx_lun_eclipse_how(
+	swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
 
 DllImport int32 CALL_CONV_IMP swe_fixstar(
         char *star, double tjd, int32 iflag, 
@@ -300,6 +374,10 @@ DllImport int32  CALL_CONV_IMP swe_pheno(double tjd, int32 ipl, int32 iflag, dou
 
 DllImport int32  CALL_CONV_IMP swe_pheno_ut(double tjd_ut, int32 ipl, int32 iflag, double *attr, char *serr);
 
+DllImport int32  CALL_CONV_IMP swe_pheno_multi(double tjd, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr);
+
+DllImport int32  CALL_CONV_IMP swe_pheno_multi_ut(double tjd_ut, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr);
+
 DllImport double  CALL_CONV_IMP swe_refrac(double inalt, double atpress, double attemp, int32 calc_flag);
 DllImport double  CALL_CONV_IMP swe_refrac_extended(double inalt, double geoalt, double atpress, double attemp, double lapse_rate, int32 calc_flag, double *dret);
 DllImport void  CALL_CONV_IMP swe_set_lapse_rate(double lapse_rate);
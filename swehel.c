@@ -812,14 +812,10 @@ static double kW(double HeightEye, double TempS, double RH)
 ' lat [deg]
 ' kOZ [-]
 */
-static double kOZ(double AltS, double sunra, double Lat)
+static double kOZ_calc(double AltS, double sunra, double Lat)
 {
   double CHANGEKO, OZ, LT, kOZret;
-  static TLS double koz_last, alts_last, sunra_last;
   double altslim = 0;
-  if (AltS == alts_last && sunra == sunra_last)
-    return koz_last;
-  alts_last = AltS; sunra_last = sunra;
   OZ = 0.031;
   LT = Lat * DEGTORAD;
   /* From Schaefer , Archaeoastronomy, XV, 2000, page 128*/
@@ -836,7 +832,16 @@ if ((0)) {
     printf("bsk=%f %f\n", kOZret, AltS);
   a = 1;
 }
-  koz_last = kOZret * CHANGEKO;
+  return kOZret * CHANGEKO;
+}
+
+static double kOZ(double AltS, double sunra, double Lat)
+{
+  static TLS double koz_last, alts_last, sunra_last;
+  if (AltS == alts_last && sunra == sunra_last)
+    return koz_last;
+  alts_last = AltS; sunra_last = sunra;
+  koz_last = kOZ_calc(AltS, sunra, Lat);
   return koz_last;
 }
 
@@ -878,17 +883,13 @@ static int Sgn(double x)
 ' VR [km]
 ' ka [-]
 */
-static double ka(double AltS, double sunra, double Lat, double HeightEye, double TempS, double RH, double VR, char *serr)
+static double ka_calc(double AltS, double sunra, double Lat, double HeightEye, double TempS, double RH, double VR, char *serr)
 {
   double CHANGEKA, LAMBDA, BetaVr, Betaa, kaact;
   double SL = Sgn(Lat);
   /* depending on day/night vision (altitude of sun < start astronomical twilight),
    * lambda eye sensibility changes
    * see extinction section of Vistas in Astronomy page 343 */
-  static TLS double alts_last, sunra_last, ka_last;
-  if (AltS == alts_last && sunra == sunra_last)
-    return ka_last;
-  alts_last = AltS; sunra_last = sunra;
   CHANGEKA = (1 - 0.166667 * mymin(6, mymax(-AltS - 12, 0)));
   LAMBDA = 0.55 + (CHANGEKA - 1) * 0.04;
   if (VR != 0) {
@@ -906,7 +907,7 @@ static double ka(double AltS, double sunra, double Lat, double HeightEye, double
         /* return 0; * return "#HIGHVR"; */
       }
     } else {
-      kaact = VR - kW(HeightEye, TempS, RH) - kR(AltS, HeightEye) - kOZ(AltS, sunra, Lat);
+      kaact = VR - kW(HeightEye, TempS, RH) - kR(AltS, HeightEye) - kOZ_calc(AltS, sunra, Lat);
       if (kaact < 0) {
 	if (serr != NULL)
 	  strcpy(serr, "The provided atmosphic coeefficent (ktot) is too low, when taking into acount other atmospheric parameters"); /* is a warning */
@@ -922,10 +923,19 @@ static double ka(double AltS, double sunra, double Lat, double HeightEye, double
     kaact = 0.1 * exp(-1 * HeightEye / scaleHaerosol) * pow(1 - 0.32 / log(RH / 100.0), 1.33) * (1 + 0.33 * SL * sin(sunra * DEGTORAD));
     kaact = kaact * pow(LAMBDA / 0.55, -1.3);
   }
-  ka_last = kaact;
   return kaact;
 }
 
+static double ka(double AltS, double sunra, double Lat, double HeightEye, double TempS, double RH, double VR, char *serr)
+{
+  static TLS double alts_last, sunra_last, ka_last;
+  if (AltS == alts_last && sunra == sunra_last)
+    return ka_last;
+  alts_last = AltS; sunra_last = sunra;
+  ka_last = ka_calc(AltS, sunra, Lat, HeightEye, TempS, RH, VR, serr);
+  return ka_last;
+}
+
 /*###################################################################
 ' JDNDaysUT [-]
 ' AltS [deg]
@@ -1030,9 +1040,22 @@ static double PresEfromPresS(double TempS, double Press, double HeightEye)
 ' VR [km]
 ' Deltam [-]
 */
-static double Deltam(double AltO, double AltS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+static double Deltam_calc(double AppAltO, double Press, double kRact, double kaact, double kOZact, double kWact)
 {
   double zend, xR, XW, Xa, XOZ;
+  zend = (90 - AppAltO) * DEGTORAD;
+  if (zend > PI / 2)
+    zend = PI / 2;
+  /* From Schaefer , Archaeoastronomy, XV, 2000, page 128*/
+  xR = Xext(scaleHrayleigh, zend, Press);
+  XW = Xext(scaleHwater, zend, Press);
+  Xa = Xext(scaleHaerosol, zend, Press);
+  XOZ = Xlay(scaleHozone, zend, Press);
+  return kRact * xR + kaact * Xa + kOZact * XOZ + kWact * XW;
+}
+
+static double Deltam(double AltO, double AltS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+{
   double PresE = PresEfromPresS(datm[1], datm[0], HeightEye);
   double TempE = TempEfromTempS(datm[1], HeightEye, LapseSA);
   double AppAltO = AppAltfromTopoAlt(AltO, TempE, PresE, helflag);
@@ -1042,15 +1065,7 @@ static double Deltam(double AltO, double AltS, double sunra, double Lat, double
     return deltam_last;
   alts_last = AltS; alto_last = AltO; sunra_last = sunra;
   if (staticAirmass == 0) {
-    zend = (90 - AppAltO) * DEGTORAD;
-    if (zend > PI / 2)
-      zend = PI / 2;
-    /* From Schaefer , Archaeoastronomy, XV, 2000, page 128*/
-    xR = Xext(scaleHrayleigh, zend, datm[0]);
-    XW = Xext(scaleHwater, zend, datm[0]);
-    Xa = Xext(scaleHaerosol, zend, datm[0]);
-    XOZ = Xlay(scaleHozone, zend, datm[0]);
-    deltam = kR(AltS, HeightEye) * xR + kt(AltS, sunra, Lat, HeightEye, datm[1], datm[2], datm[3], 0, serr) * Xa + kOZ(AltS, sunra, Lat) * XOZ + kW(HeightEye, datm[1], datm[2]) * XW;
+    deltam = Deltam_calc(AppAltO, datm[0], kR(AltS, HeightEye), kt(AltS, sunra, Lat, HeightEye, datm[1], datm[2], datm[3], 0, serr), kOZ(AltS, sunra, Lat), kW(HeightEye, datm[1], datm[2]));
   } else {
     deltam = kt(AltS, sunra, Lat, HeightEye, datm[1], datm[2], datm[3], 4, serr) * Airmass(AppAltO, datm[0]);
   }
@@ -1070,31 +1085,41 @@ static double Deltam(double AltO, double AltS, double sunra, double Lat, double
 ' VR [km]
 ' Bn [nL]
 */
-static double Bn(double AltO, double JDNDayUT, double AltS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+static double BnZenith(double JDNDayUT)
 {
-  double PresE = PresEfromPresS(datm[1], datm[0], HeightEye);
-  double TempE = TempEfromTempS(datm[1], HeightEye, LapseSA);
-  double AppAltO = AppAltfromTopoAlt(AltO, TempE, PresE, helflag);
-  double zend, YearB, MonthB, DayB, Bna, kX, Bnb;
+  double YearB, MonthB, DayB;
   double B0 = 0.0000000000001, dut;
   int iyar, imon, iday;
-  /* Below altitude of 10 degrees, the Bn stays the same (see page 343 Vistas in Astronomy) */
-  if (AppAltO < 10)
-    AppAltO = 10;
-  zend = (90 - AppAltO) * DEGTORAD;
   /* From Schaefer , Archaeoastronomy, XV, 2000, page 128 and adjusted for sunspot period*/
   /*YearB = DatefromJDut(JDNDayUT, 1);
     MonthB = DatefromJDut(JDNDayUT, 2);
     DayB = DatefromJDut(JDNDayUT, 3);*/
   swe_revjul(JDNDayUT, SE_GREG_CAL, &iyar, &imon, &iday, &dut); 
   YearB = iyar; MonthB = imon; DayB = iday;
-  Bna = B0 * (1 + 0.3 * cos(6.283 * (YearB + ((DayB - 1) / 30.4 + MonthB - 1) / 12 - 1990.33) / 11.1));
-  kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+  return B0 * (1 + 0.3 * cos(6.283 * (YearB + ((DayB - 1) / 30.4 + MonthB - 1) / 12 - 1990.33) / 11.1));
+}
+
+static double Bn_calc(double Bna, double AppAltO, double kX)
+{
+  double zend, Bnb;
+  /* Below altitude of 10 degrees, the Bn stays the same (see page 343 Vistas in Astronomy) */
+  if (AppAltO < 10)
+    AppAltO = 10;
+  zend = (90 - AppAltO) * DEGTORAD;
   /* From Schaefer , Archaeoastronomy, XV, 2000, page 129 */
   Bnb = Bna * (0.4 + 0.6 / sqrt(1 - 0.96 * pow(sin(zend), 2))) * pow(10, -0.4 * kX);
   return mymax(Bnb, 0) * erg2nL;
 }
 
+static double Bn(double AltO, double JDNDayUT, double AltS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+{
+  double PresE = PresEfromPresS(datm[1], datm[0], HeightEye);
+  double TempE = TempEfromTempS(datm[1], HeightEye, LapseSA);
+  double AppAltO = AppAltfromTopoAlt(AltO, TempE, PresE, helflag);
+  double kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+  return Bn_calc(BnZenith(JDNDayUT), AppAltO, kX);
+}
+
 /*###################################################################
 ' JDNDaysUT [-]
 ' dgeo [array: longitude, latitude, eye height above sea m]
@@ -1183,12 +1208,26 @@ static double MoonPhase(double AltM, double AziM, double AltS, double AziS)
 /*###################################################################
 ' Pressure [mbar]
 */
-static double Bm(double AltO, double AziO, double AltM, double AziM, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+static double Bm_calc(double RM, double kXM, double kX, double phasemoon)
 {
   double M0 = -11.05;
-  double Bm = 0;
-  double RM, kXM, kX, C3, FM, phasemoon, MM;
+  double Bm, C3, FM, MM;
   double lunar_radius = 0.25 * DEGTORAD;
+  if (RM <= lunar_radius) // addition by Dieter for objects behind the Moon, SE2.06
+    RM = lunar_radius;
+  C3 = pow(10, -0.4 * kXM);
+  FM = (62000000.0) / RM / RM + pow(10, 6.15 - RM / 40) + pow(10, 5.36) * (1.06 + pow(cos(RM * DEGTORAD), 2));
+  Bm = FM * C3 + 440000 * (1 - C3);
+  MM = MoonsBrightness(MoonDistance, phasemoon);
+  Bm = Bm * pow(10, -0.4 * (MM - M0 + 43.27));
+  Bm = Bm * (1 - pow(10, -0.4 * kX));
+  return Bm;
+}
+
+static double Bm(double AltO, double AziO, double AltM, double AziM, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+{
+  double Bm = 0;
+  double RM, kXM, kX;
   AS_BOOL object_is_moon = FALSE;
   if (AltO == AltM && AziO == AziM)
     object_is_moon = TRUE;
@@ -1196,17 +1235,9 @@ static double Bm(double AltO, double AziO, double AltM, double AziM, double AltS
   /* moon only adds light when (partly) above horizon
    * From Schaefer , Archaeoastronomy, XV, 2000, page 129*/
     RM = DistanceAngle(AltO * DEGTORAD, AziO * DEGTORAD, AltM * DEGTORAD, AziM * DEGTORAD) / DEGTORAD;
-    if (RM <= lunar_radius) // addition by Dieter for objects behind the Moon, SE2.06
-      RM = lunar_radius;
     kXM = Deltam(AltM, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
     kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
-    C3 = pow(10, -0.4 * kXM);
-    FM = (62000000.0) / RM / RM + pow(10, 6.15 - RM / 40) + pow(10, 5.36) * (1.06 + pow(cos(RM * DEGTORAD), 2));
-    Bm = FM * C3 + 440000 * (1 - C3);
-    phasemoon = MoonPhase(AltM, AziM, AltS, AziS);
-    MM = MoonsBrightness(MoonDistance, phasemoon);
-    Bm = Bm * pow(10, -0.4 * (MM - M0 + 43.27));
-    Bm = Bm * (1 - pow(10, -0.4 * kX));
+    Bm = Bm_calc(RM, kXM, kX, MoonPhase(AltM, AziM, AltS, AziS));
   }
   Bm = mymax(Bm, 0) * erg2nL;
   return Bm;
@@ -1215,17 +1246,11 @@ static double Bm(double AltO, double AziO, double AltM, double AziM, double AltS
 /*###################################################################
 ' Pressure [mbar]
 */
-static double Btwi(double AltO, double AziO, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+static double Btwi_calc(double AltS, double AppAltO, double RS, double kX, double k)
 {
 double M0 = -11.05;
 double MS = -26.74;
-double PresE = PresEfromPresS(datm[1], datm[0], HeightEye);
-double TempE = TempEfromTempS(datm[1], HeightEye, LapseSA);
-double AppAltO = AppAltfromTopoAlt(AltO, TempE, PresE, helflag);
 double ZendO = 90 - AppAltO;
-double RS = DistanceAngle(AltO * DEGTORAD, AziO * DEGTORAD, AltS * DEGTORAD, AziS * DEGTORAD) / DEGTORAD;
-double kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
-double k = kt(AltS, sunra, Lat, HeightEye, datm[1], datm[2], datm[3], 4, serr);
 /* From Schaefer , Archaeoastronomy, XV, 2000, page 129*/
 double Btwi = pow(10, -0.4 * (MS - M0 + 32.5 - AltS - (ZendO / (360 * k))));
 Btwi = Btwi * (100 / RS) * (1 - pow(10, -0.4 * kX));
@@ -1233,6 +1258,17 @@ Btwi = mymax(Btwi, 0) * erg2nL;
 return Btwi;
 }
 
+static double Btwi(double AltO, double AziO, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+{
+double PresE = PresEfromPresS(datm[1], datm[0], HeightEye);
+double TempE = TempEfromTempS(datm[1], HeightEye, LapseSA);
+double AppAltO = AppAltfromTopoAlt(AltO, TempE, PresE, helflag);
+double RS = DistanceAngle(AltO * DEGTORAD, AziO * DEGTORAD, AltS * DEGTORAD, AziS * DEGTORAD) / DEGTORAD;
+double kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+double k = kt(AltS, sunra, Lat, HeightEye, datm[1], datm[2], datm[3], 4, serr);
+return Btwi_calc(AltS, AppAltO, RS, kX, k);
+}
+
 /*###################################################################
 ' Pressure [mbar]
 2300 REM  Daylight brightness
@@ -1243,13 +1279,10 @@ return Btwi;
 2350 BD=BD*(1-10^(-.4*K(I)*X))
 2360 BD=BD*(FS*C4+440000.0*(1-C4))
 */
-static double Bday(double AltO, double AziO, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+static double Bday_calc(double RS, double kXS, double kX)
 {
   double M0 = -11.05;
   double MS = -26.74;
-  double RS = DistanceAngle(AltO * DEGTORAD, AziO * DEGTORAD, AltS * DEGTORAD, AziS * DEGTORAD) / DEGTORAD;
-  double kXS = Deltam(AltS, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
-  double kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
   /* From Schaefer , Archaeoastronomy, XV, 2000, page 129*/
   double C4 = pow(10, -0.4 * kXS);
   double FS = (62000000.0) / RS / RS + pow(10, (6.15 - RS / 40)) + pow(10, 5.36) * (1.06 + pow(cos(RS * DEGTORAD), 2));
@@ -1260,6 +1293,14 @@ static double Bday(double AltO, double AziO, double AltS, double AziS, double su
   return Bday;
 }
 
+static double Bday(double AltO, double AziO, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, char *serr)
+{
+  double RS = DistanceAngle(AltO * DEGTORAD, AziO * DEGTORAD, AltS * DEGTORAD, AziS * DEGTORAD) / DEGTORAD;
+  double kXS = Deltam(AltS, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+  double kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+  return Bday_calc(RS, kXS, kX);
+}
+
 /*###################################################################
 ' Value [nL]
 ' PresS [mbar]
@@ -1379,22 +1420,13 @@ static void default_heliacal_parameters(double *datm, double *dgeo, double *dobs
 ' VR [km]
 ' VisLimMagn [-]
 */
-static double VisLimMagn(double *dobs, double AltO, double AziO, double AltM, double AziM, double JDNDaysUT, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, int32 *scotopic_flag, char *serr)
+static double VisLimMagn_calc(double *dobs, double Bsk, double kX, double JDNDaysUT, int32 helflag, int32 *scotopic_flag)
 {
-  double C1, C2, Th, kX, Bsk, CorrFactor1, CorrFactor2;
+  double C1, C2, Th, CorrFactor1, CorrFactor2;
   double log10 = 2.302585092994;
   AS_BOOL is_scotopic = FALSE;
   /*double Age = dobs[0];*/
   /*double SN = dobs[1];*/
-  Bsk = Bsky(AltO, AziO, AltM, AziM, JDNDaysUT, AltS, AziS, sunra, Lat, HeightEye, datm, helflag, serr);
-  /* Schaefer, Astronomy and the limits of vision, Archaeoastronomy, 1993 Verder:*/
-  kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
-if ((0)) {
-  static int a = 0;
-  if (a == 0)
-    printf("bsk=%f, kx=%f\n", Bsk, kX);
-  a = 1;
-}
   /* influence of age*/
   /*Fa = mymax(1, pow(p(23, Bsk) / p(Age, Bsk), 2)); */
   CorrFactor1 = OpticFactor(Bsk, kX, dobs, JDNDaysUT, "", 1, helflag);
@@ -1442,6 +1474,21 @@ if ((0)) {
   return -16.57 - 2.5 * (log(Th) / log10);
 }
 
+static double VisLimMagn(double *dobs, double AltO, double AziO, double AltM, double AziM, double JDNDaysUT, double AltS, double AziS, double sunra, double Lat, double HeightEye, double *datm, int32 helflag, int32 *scotopic_flag, char *serr)
+{
+  double kX, Bsk;
+  Bsk = Bsky(AltO, AziO, AltM, AziM, JDNDaysUT, AltS, AziS, sunra, Lat, HeightEye, datm, helflag, serr);
+  /* Schaefer, Astronomy and the limits of vision, Archaeoastronomy, 1993 Verder:*/
+  kX = Deltam(AltO, AltS, sunra, Lat, HeightEye, datm, helflag, serr);
+if ((0)) {
+  static int a = 0;
+  if (a == 0)
+    printf("bsk=%f, kx=%f\n", Bsk, kX);
+  a = 1;
+}
+  return VisLimMagn_calc(dobs, Bsk, kX, JDNDaysUT, helflag, scotopic_flag);
+}
+
 /* tolower star name, but not Bayer designation */
 static char *tolower_string_star(char *str)
 {
@@ -1540,6 +1587,270 @@ int32 CALL_CONV swe_vis_limit_mag(double tjdut, double *dgeo, double *datm, doub
   return retval;
 }
 
+/* Visibility grid: swe_vis_limit_mag() for many observer locations at one
+ * epoch.
+ *
+ * The ephemeris part is done once per epoch: delta t, sidereal time, the
+ * Sun's right ascension for the extinction model, the geocentric positions
+ * of the object, the Sun and the Moon, and the object's magnitude (except
+ * for the Moon, whose phase depends on the observer). Each location then
+ * only needs a parallax correction and a rotation into the horizon. With SE_HELFLAG_HIGH_PRECISION, the positions and the magnitude
+ * are computed topocentrically for every location instead, exactly as
+ * swe_vis_limit_mag() does.
+ *
+ * The brightness model runs over blocks of VISGRID_LANES locations, one
+ * stage at a time (atmosphere, extinction, sky brightness, threshold),
+ * using the cache-free cores of the scalar functions above, so that the
+ * loops carry no ephemeris calls and no TLS state.
+ */
+#define VISGRID_LANES 16
+
+static int32 vis_grid_equ(double tjd_tt, int32 ipl, char *star, int32 iflag, double *x, char *serr)
+{
+  if (ipl != -1)
+    return swe_calc(tjd_tt, ipl, iflag, x, serr);
+  return call_swe_fixstar(star, tjd_tt, iflag, x, serr);
+}
+
+/* Azimuth (from north, as ObjectLoc() returns it) and true altitude of an
+ * equatorial position x (ra, dec [deg], distance [AU]) seen from dgeo. armc
+ * is the local sidereal angle. With parallax, x is geocentric and shifted to
+ * the observer; dist returns the topocentric distance. */
+static void vis_grid_azalt(double *x, double armc, double *dgeo, AS_BOOL parallax, double *azi, double *alt, double *dist)
+{
+  double xx[6], xobs[3], xaz[3];
+  double cosfi, sinfi, cc, ss, f2;
+  xx[0] = x[0]; xx[1] = x[1]; xx[2] = x[2];
+  if (parallax) {
+    cosfi = cos(dgeo[1] * DEGTORAD);
+    sinfi = sin(dgeo[1] * DEGTORAD);
+    f2 = (1 - EARTH_OBLATENESS) * (1 - EARTH_OBLATENESS);
+    cc = 1 / sqrt(cosfi * cosfi + f2 * sinfi * sinfi);
+    ss = f2 * cc;
+    /* observer on the ellipsoid, equatorial of date; armc is its RA */
+    xobs[0] = (EARTH_RADIUS * cc + dgeo[2]) * cosfi / AUNIT * cos(armc * DEGTORAD);
+    xobs[1] = (EARTH_RADIUS * cc + dgeo[2]) * cosfi / AUNIT * sin(armc * DEGTORAD);
+    xobs[2] = (EARTH_RADIUS * ss + dgeo[2]) * sinfi / AUNIT;
+    xx[0] *= DEGTORAD;
+    xx[1] *= DEGTORAD;
+    swi_polcart(xx, xx);
+    xx[0] -= xobs[0];
+    xx[1] -= xobs[1];
+    xx[2] -= xobs[2];
+    swi_cartpol(xx, xx);
+    xx[0] *= RADTODEG;
+    xx[1] *= RADTODEG;
+  }
+  *dist = xx[2];
+  /* as swe_azalt(), without the refraction we do not need */
+  xaz[0] = swe_degnorm(swe_degnorm(xx[0] - armc) - 90);
+  xaz[1] = xx[1];
+  xaz[2] = 1;
+  swe_cotrans(xaz, xaz, 90 - dgeo[1]);
+  xaz[0] = swe_degnorm(xaz[0] + 90);
+  xaz[0] = 360 - xaz[0];
+  /* as ObjectLoc(): azimuth from north */
+  xaz[0] += 180;
+  if (xaz[0] >= 360)
+    xaz[0] -= 360;
+  *azi = xaz[0];
+  *alt = xaz[1];
+}
+
+/* dgeo     3 * ngeo doubles: longitude, latitude, eye height of each location
+ * datm     atmospheric conditions as for swe_vis_limit_mag(), applied at
+ *          every location (defaults are resolved per location; the array
+ *          itself is not modified)
+ * dobs     observer, as for swe_vis_limit_mag() (not modified)
+ * dret     8 * ngeo doubles, for each location dret[0..7] as returned by
+ *          swe_vis_limit_mag()
+ * retflag  ngeo values, for each location the return value that
+ *          swe_vis_limit_mag() would give (-2 below horizon, -1 error,
+ *          else the photopic/scotopic bits)
+ * returns  OK, or ERR if any location failed (serr has the first message)
+ */
+int32 CALL_CONV swe_vis_limit_mag_grid(double tjdut, double *dgeo, int32 ngeo, double *datm, double *dobs, char *ObjectName, int32 helflag, double *dret, int32 *retflag, char *serr)
+{
+  int32 retval = OK, ig, i, l, n, ipl, epheflag, iflag, scotopic_flag;
+  AS_BOOL exact = (helflag & SE_HELFLAG_HIGH_PRECISION) != 0;
+  AS_BOOL use_sun = !(helflag & SE_HELFLAG_VISLIM_DARK);
+  AS_BOOL use_moon;
+  double tjd_tt, sidt, sunra, bna, dmag = 0, armc, dist, b, rs, *dg, *dr;
+  double xo[6], xs[6], xm[6], x[20];
+  char star[AS_MAXCH], serr2[AS_MAXCH];
+  int32 lane_loc[VISGRID_LANES];
+  double ldatm[VISGRID_LANES][4], ldobs[VISGRID_LANES][6];
+  double alto[VISGRID_LANES], azio[VISGRID_LANES], alts[VISGRID_LANES], azis[VISGRID_LANES];
+  double altm[VISGRID_LANES], azim[VISGRID_LANES];
+  double prese[VISGRID_LANES], tempe[VISGRID_LANES];
+  double kw[VISGRID_LANES], kr[VISGRID_LANES], koz[VISGRID_LANES], ka0[VISGRID_LANES], ktot[VISGRID_LANES];
+  double appo[VISGRID_LANES], dmo[VISGRID_LANES], dms[VISGRID_LANES], dmm[VISGRID_LANES];
+  AS_BOOL moonlit[VISGRID_LANES];
+  if (serr != NULL)
+    *serr = '\0';
+  *serr2 = '\0';
+  for (ig = 0; ig < ngeo; ig++) {
+    retflag[ig] = ERR;
+    for (i = 0; i < 8; i++)
+      dret[8 * ig + i] = 0;
+  }
+  if (strlen(ObjectName) >= AS_MAXCH) {
+    if (serr != NULL)
+      strcpy(serr, "object name too long");
+    return ERR;
+  }
+  strcpy(star, ObjectName);
+  tolower_string_star(star);
+  ipl = DeterObject(star);
+  if (ipl == SE_SUN) {
+    if (serr != NULL) {
+      strcpy(serr, "it makes no sense to call swe_vis_limit_mag() for the Sun");
+    }
+    return ERR;
+  }
+  use_moon = !(strncmp(star, "moon", 4) == 0 ||
+      (helflag & SE_HELFLAG_VISLIM_DARK) ||
+      (helflag & SE_HELFLAG_VISLIM_NOMOON));
+  /* per epoch */
+  swi_set_tid_acc(tjdut, helflag, 0, serr2);
+  sunra = SunRA(tjdut, helflag, serr2);
+  bna = BnZenith(tjdut);
+  epheflag = helflag & (SEFLG_JPLEPH|SEFLG_SWIEPH|SEFLG_MOSEPH);
+  iflag = SEFLG_EQUATORIAL | epheflag;
+  if (!exact)
+    iflag |= SEFLG_NONUT | SEFLG_TRUEPOS;
+  tjd_tt = tjdut + swe_deltat_ex(tjdut, epheflag, serr2);
+  sidt = swe_sidtime(tjdut);
+  if (!exact) {
+    if (vis_grid_equ(tjd_tt, ipl, star, iflag, xo, serr2) == ERR
+        || (use_sun && swe_calc(tjd_tt, SE_SUN, iflag, xs, serr2) == ERR)
+        || (use_moon && swe_calc(tjd_tt, SE_MOON, iflag, xm, serr2) == ERR))
+      goto epoch_error;
+    /* geocentric magnitude, scaled to the observer's distance below */
+    if (ipl != -1 && ipl != SE_MOON) {
+      if (swe_pheno_ut(tjdut, ipl, iflag, x, serr2) == ERR)
+        goto epoch_error;
+      dmag = x[4];
+    } else if (ipl == -1) {
+      if (call_swe_fixstar_mag(star, &dmag, serr2) == ERR)
+        goto epoch_error;
+    }
+  }
+  for (ig = 0; ig < ngeo; ig += VISGRID_LANES) {
+    /* geometry: horizontal coordinates of object, Sun and Moon */
+    n = 0;
+    for (i = ig; i < ngeo && i < ig + VISGRID_LANES; i++) {
+      dg = dgeo + 3 * i;
+      dr = dret + 8 * i;
+      armc = swe_degnorm(sidt * 15 + dg[0]);
+      if (exact) {
+        swe_set_topo(dg[0], dg[1], dg[2]);
+        if (vis_grid_equ(tjd_tt, ipl, star, iflag | SEFLG_TOPOCTR, xo, serr2) == ERR)
+          goto location_error;
+      }
+      vis_grid_azalt(xo, armc, dg, !exact, &azio[n], &alto[n], &dist);
+      if (alto[n] < 0) {
+        dr[0] = -100;
+        retflag[i] = -2;
+        continue;
+      }
+      if (use_sun) {
+        if (exact && swe_calc(tjd_tt, SE_SUN, iflag | SEFLG_TOPOCTR, xs, serr2) == ERR)
+          goto location_error;
+        vis_grid_azalt(xs, armc, dg, !exact, &azis[n], &alts[n], &x[0]);
+      } else {
+        alts[n] = -90;
+        azis[n] = 0;
+      }
+      if (use_moon) {
+        if (exact && swe_calc(tjd_tt, SE_MOON, iflag | SEFLG_TOPOCTR, xm, serr2) == ERR)
+          goto location_error;
+        vis_grid_azalt(xm, armc, dg, !exact, &azim[n], &altm[n], &x[0]);
+      } else {
+        altm[n] = -90;
+        azim[n] = 0;
+      }
+      /* the Moon's phase, and with it its magnitude, shifts with the
+       * observer too much for a distance correction */
+      if (exact || ipl == SE_MOON) {
+        if (Magnitude(tjdut, dg, star, helflag, &dr[7], serr2) == ERR)
+          goto location_error;
+      } else if (ipl != -1) {
+        dr[7] = dmag + 5 * log10(dist / xo[2]);
+      } else {
+        dr[7] = dmag;
+      }
+      for (l = 0; l < 4; l++)
+        ldatm[n][l] = datm[l];
+      for (l = 0; l < 6; l++)
+        ldobs[n][l] = dobs[l];
+      default_heliacal_parameters(ldatm[n], dg, ldobs[n], helflag);
+      lane_loc[n] = i;
+      n++;
+      continue;
+location_error:
+      if (retval == OK && serr != NULL)
+        strcpy(serr, serr2);
+      retval = ERR;
+    }
+    /* atmosphere at each location, given the Sun's altitude */
+    for (l = 0; l < n; l++) {
+      double h = dgeo[3 * lane_loc[l] + 2], lat = dgeo[3 * lane_loc[l] + 1];
+      prese[l] = PresEfromPresS(ldatm[l][1], ldatm[l][0], h);
+      tempe[l] = TempEfromTempS(ldatm[l][1], h, LapseSA);
+      kw[l] = kW(h, ldatm[l][1], ldatm[l][2]);
+      kr[l] = kR(alts[l], h);
+      koz[l] = kOZ_calc(alts[l], sunra, lat);
+      ka0[l] = ka_calc(alts[l], sunra, lat, h, ldatm[l][1], ldatm[l][2], ldatm[l][3], serr2);
+      if (ka0[l] < 0)
+        ka0[l] = 0;
+      ktot[l] = kw[l] + kr[l] + koz[l] + ka0[l];
+    }
+    /* extinction towards object, Sun and Moon */
+    for (l = 0; l < n; l++) {
+      appo[l] = AppAltfromTopoAlt(alto[l], tempe[l], prese[l], helflag);
+      dmo[l] = Deltam_calc(appo[l], ldatm[l][0], kr[l], ka0[l], koz[l], kw[l]);
+      dms[l] = 0;
+      if (alts[l] >= -3)
+        dms[l] = Deltam_calc(AppAltfromTopoAlt(alts[l], tempe[l], prese[l], helflag), ldatm[l][0], kr[l], ka0[l], koz[l], kw[l]);
+      moonlit[l] = altm[l] > -0.26 && !(alto[l] == altm[l] && azio[l] == azim[l]);
+      dmm[l] = 0;
+      if (moonlit[l])
+        dmm[l] = Deltam_calc(AppAltfromTopoAlt(altm[l], tempe[l], prese[l], helflag), ldatm[l][0], kr[l], ka0[l], koz[l], kw[l]);
+    }
+    /* sky brightness and limiting magnitude, as Bsky() and VisLimMagn() */
+    for (l = 0; l < n; l++) {
+      i = lane_loc[l];
+      dr = dret + 8 * i;
+      rs = DistanceAngle(alto[l] * DEGTORAD, azio[l] * DEGTORAD, alts[l] * DEGTORAD, azis[l] * DEGTORAD) / DEGTORAD;
+      if (alts[l] < -3)
+        b = Btwi_calc(alts[l], appo[l], rs, dmo[l], ktot[l]);
+      else if (alts[l] > 4)
+        b = Bday_calc(rs, dms[l], dmo[l]);
+      else
+        b = mymin(Bday_calc(rs, dms[l], dmo[l]), Btwi_calc(alts[l], appo[l], rs, dmo[l], ktot[l]));
+      if (b < 200000000.0 && moonlit[l])
+        b += mymax(Bm_calc(DistanceAngle(alto[l] * DEGTORAD, azio[l] * DEGTORAD, altm[l] * DEGTORAD, azim[l] * DEGTORAD) / DEGTORAD, dmm[l], dmo[l], MoonPhase(altm[l], azim[l], alts[l], azis[l])), 0) * erg2nL;
+      if (b < 5000)
+        b = b + Bn_calc(bna, appo[l], dmo[l]);
+      scotopic_flag = 0;
+      dr[0] = VisLimMagn_calc(ldobs[l], b, dmo[l], tjdut, helflag, &scotopic_flag);
+      dr[1] = alto[l];
+      dr[2] = azio[l];
+      dr[3] = alts[l];
+      dr[4] = azis[l];
+      dr[5] = altm[l];
+      dr[6] = azim[l];
+      retflag[i] = scotopic_flag;
+    }
+  }
+  return retval;
+epoch_error:
+  if (serr != NULL)
+    strcpy(serr, serr2);
+  return ERR;
+}
+
 /*###################################################################
 ' Magn [-]
 ' age [Year]
@@ -108,9 +108,13 @@ struct jpl_save {
   double buf[1500];
   double pc[18], vc[18], ac[18], jc[18];
   short do_km;
+  int np, nv, nac, njk;		/* interp(): coefficients computed for twot */
+  double twot;
+  int32 irecsz, nrl, ncoeffs;	/* state(): record size, last record read */
 };
 
-static TLS struct jpl_save *js;
+/* the state lives in the calculation context, see swed.jpl */
+#define js (swed.jpl)
 
 static int state (double et, int32 *list, int do_bary, 
 		  double *pv, double *pvsun, double *nut, char *serr);
@@ -473,10 +477,6 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
 		  int32 ncmin, int32 nain, int32 ifl, double *pv)
 {
   /* Initialized data */
-  static TLS int np, nv;
-  static TLS int nac;
-  static TLS int njk;
-  static TLS double twot = 0.;
   double *pc = js->pc;
   double *vc = js->vc;
   double *ac = js->ac;
@@ -509,21 +509,21 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
    *  contains the value of tc on the previous call.) 
    */
   if (tc != pc[1]) {
-    np = 2;
-    nv = 3;
-    nac = 4;
-    njk = 5;
+    js->np = 2;
+    js->nv = 3;
+    js->nac = 4;
+    js->njk = 5;
     pc[1] = tc;
-    twot = tc + tc;
+    js->twot = tc + tc;
   }
   /*
    *  be sure that at least 'ncf' polynomials have been evaluated 
    *  and are stored in the array 'pc'. 
    */
-  if (np < ncf) {
-    for (i = np; i < ncf; ++i) 
-      pc[i] = twot * pc[i - 1] - pc[i - 2];
-    np = ncf;
+  if (js->np < ncf) {
+    for (i = js->np; i < ncf; ++i) 
+      pc[i] = js->twot * pc[i - 1] - pc[i - 2];
+    js->np = ncf;
   }
   /*  interpolate to get position for each component */
   for (i = 0; i < ncm; ++i) {
@@ -538,11 +538,11 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
    *       derivative polynomials have been generated and stored. 
    */
   bma = (na + na) / intv;
-  vc[2] = twot + twot;
-  if (nv < ncf) {
-    for (i = nv; i < ncf; ++i) 
-      vc[i] = twot * vc[i - 1] + pc[i - 1] + pc[i - 1] - vc[i - 2];
-    nv = ncf;
+  vc[2] = js->twot + js->twot;
+  if (js->nv < ncf) {
+    for (i = js->nv; i < ncf; ++i) 
+      vc[i] = js->twot * vc[i - 1] + pc[i - 1] + pc[i - 1] - vc[i - 2];
+    js->nv = ncf;
   }
   /*       interpolate to get velocity for each component */
   for (i = 0; i < ncm; ++i) {
@@ -557,10 +557,10 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
   /*       re-do if necessary */
   bma2 = bma * bma;
   ac[3] = pc[1] * 24.;
-  if (nac < ncf) {
-    nac = ncf;
-    for (i = nac; i < ncf; ++i) 
-      ac[i] = twot * ac[i - 1] + vc[i - 1] * 4. - ac[i - 2];
+  if (js->nac < ncf) {
+    js->nac = ncf;
+    for (i = js->nac; i < ncf; ++i) 
+      ac[i] = js->twot * ac[i - 1] + vc[i - 1] * 4. - ac[i - 2];
   }
   /*       get acceleration for each component */
   for (i = 0; i < ncm; ++i) {
@@ -575,10 +575,10 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
   /*       re-do if necessary */
   bma3 = bma * bma2;
   jc[4] = pc[1] * 192.;
-  if (njk < ncf) {
-    njk = ncf;
-    for (i = njk; i < ncf; ++i) 
-      jc[i] = twot * jc[i - 1] + ac[i - 1] * 6. - jc[i - 2];
+  if (js->njk < ncf) {
+    js->njk = ncf;
+    for (i = js->njk; i < ncf; ++i) 
+      jc[i] = js->twot * jc[i - 1] + ac[i - 1] * 6. - jc[i - 2];
   }
   /*       get jerk for each component */
   for (i = 0; i < ncm; ++i) {
@@ -590,6 +590,30 @@ static int interp(double *buf, double t, double intv, int32 ncfin,
   return 0;
 }
 
+/* reads record nr into js->buf, for state() */
+static int read_record(int32 nr, double et, char *serr)
+{
+  int k;
+  double *buf = js->buf;
+  if (FSEEK(js->jplfptr, (off_t64) (nr * ((off_t64) js->irecsz)), 0) != 0) {
+    if (serr != NULL) 
+      sprintf(serr, "Read error in JPL eph. at %f\n", et);
+    return NOT_AVAILABLE;
+  }
+  for (k = 1; k <= js->ncoeffs; ++k) {
+    if ( fread((void *) &buf[k - 1], sizeof(double), 1, js->jplfptr) != 1) {
+      if (serr != NULL) 
+	sprintf(serr, "Read error in JPL eph. at %f\n", et);
+      return NOT_AVAILABLE;
+    }
+    if (js->do_reorder)
+      reorder((char *) &buf[k-1], sizeof(double), 1);
+  }
+  SWI_STAT_ADD(SE_STAT_SEG_LOADS, 1);
+  SWI_STAT_ADD(SE_STAT_SEG_BYTES, js->ncoeffs * sizeof(double));
+  return OK;
+}
+
 /*
  | ********** state ********************
  | this subroutine reads and interpolates the jpl planetary ephemeris file 
@@ -662,16 +686,15 @@ static int state(double et, int32 *list, int do_bary,
   double et_mn, et_fr;
   int32 *ipt = js->eh_ipt;
   char ch_ttl[252];
-  static TLS int32 irecsz;
-  static TLS int32 nrl, lpt[3], ncoeffs;
+  int32 lpt[3];
   size_t nrd; /* unused, removes compile warnings */
   if (js->jplfptr == NULL) {
     ksize = fsizer(serr); /* the number of single precision words in a record */
     nrecl = 4;
     if (ksize == NOT_AVAILABLE)
       return NOT_AVAILABLE;
-    irecsz = nrecl * ksize; 	/* record size in bytes */
-    ncoeffs = ksize / 2;	/* # of coefficients, doubles */
+    js->irecsz = nrecl * ksize; 	/* record size in bytes */
+    js->ncoeffs = ksize / 2;	/* # of coefficients, doubles */
     /* ttl = ephemeris title, e.g.
      * "JPL Planetary Ephemeris DE404/LE404
      *  Start Epoch: JED=   625296.5-3001 DEC 21 00:00:00
@@ -720,7 +743,7 @@ static int state(double et, int32 *list, int do_bary,
     if (js->do_reorder)
       reorder((char *) &lpt[0], sizeof(int32), 3);
     /* cval[]:  other constants in next record */
-    FSEEK(js->jplfptr, (off_t64) (1L * irecsz), 0);
+    FSEEK(js->jplfptr, (off_t64) (1L * js->irecsz), 0);
     nrd = fread((void *) &js->eh_cval[0], sizeof(double), 400, js->jplfptr);
     if (nrd != 400) return NOT_AVAILABLE;
     if (js->do_reorder)
@@ -728,7 +751,7 @@ static int state(double et, int32 *list, int do_bary,
     /* new 26-aug-2008: verify correct block size */
     for (i = 0; i < 3; ++i) 
       ipt[i + 36] = lpt[i];
-    nrl = 0;
+    js->nrl = 0;
     /* is file length correct? */
     /* file length */
     FSEEK(js->jplfptr, (off_t64) 0L, SEEK_END);
@@ -762,12 +785,12 @@ static int state(double et, int32 *list, int do_bary,
     }
     /* check if start and end dates in segments are the same as in 
      * file header */
-    FSEEK(js->jplfptr, (off_t64) (2L * irecsz), 0);
+    FSEEK(js->jplfptr, (off_t64) (2L * js->irecsz), 0);
     nrd = fread((void *) &ts[0], sizeof(double), 2, js->jplfptr);
     if (nrd != 2) return NOT_AVAILABLE;
     if (js->do_reorder)
       reorder((char *) &ts[0], sizeof(double), 2);
-    FSEEK(js->jplfptr, (off_t64) ((nseg + 2 - 1) * ((off_t64) irecsz)), 0);
+    FSEEK(js->jplfptr, (off_t64) ((nseg + 2 - 1) * ((off_t64) js->irecsz)), 0);
     nrd = fread((void *) &ts[2], sizeof(double), 2, js->jplfptr);
     if (nrd != 2) return NOT_AVAILABLE;
     if (js->do_reorder)
@@ -796,22 +819,11 @@ static int state(double et, int32 *list, int do_bary,
     --nr;	/* end point of ephemeris, use last record */
   t = (et_mn - ((nr - 2) * js->eh_ss[2] + js->eh_ss[0]) + et_fr) / js->eh_ss[2];
   /* read correct record if not in core */
-  if (nr != nrl) {
-    nrl = nr;
-    if (FSEEK(js->jplfptr, (off_t64) (nr * ((off_t64) irecsz)), 0) != 0) {
-      if (serr != NULL) 
-	sprintf(serr, "Read error in JPL eph. at %f\n", et);
-      return NOT_AVAILABLE;
-    }
-    for (k = 1; k <= ncoeffs; ++k) {
-      if ( fread((void *) &buf[k - 1], sizeof(double), 1, js->jplfptr) != 1) {
-	if (serr != NULL) 
-	  sprintf(serr, "Read error in JPL eph. at %f\n", et);
-	return NOT_AVAILABLE;
-      }
-      if (js->do_reorder)
-	reorder((char *) &buf[k-1], sizeof(double), 1);
-    }
+  if (nr != js->nrl) {
+    js->nrl = nr;
+    SWI_STAT_TIMED(SE_STAT_SEG_NS, k = read_record(nr, et, serr));
+    if (k != OK)
+      return k;
   }
   if (js->do_km) {
     intv = js->eh_ss[2] * 86400.;
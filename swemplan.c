@@ -73,7 +73,6 @@
 /* #define KGAUSS_GEO 0.00002999502129737  Earth + Moon */
 
 static void embofs_mosh(double J, double *xemb);
-static int check_t_terms(double t, char *sinp, double *doutp);
 
 static int read_elements_file(int32 ipl, double tjd, 
   double *tjd0, double *tequ, 
@@ -689,7 +688,285 @@ int swi_osc_el_plan(double tjd, double *xp, int ipl, int ipli, double *xearth, d
   return OK;
 }
 
-#if 1
+/* seorbel.txt is parsed once per file and shared by all threads. The 
+ * elements may be polynomials in T (Julian centuries from the epoch), 
+ * e.g. "252.8987988 + 707550.7341 * T"; they are kept as a list of 
+ * operations that repeats the arithmetic of the former text parser 
+ * step by step, so that the results do not change. */
+#define FOP_TERM	0	/* next term with sign x */
+#define FOP_END		1
+#define FOP_MUL		2	/* factor x */
+#define FOP_MUL_T	3	/* factor T^it */
+
+#define FICT_JDATE	1	/* equinox of date */
+
+struct fict_op {
+  int kind;		/* FOP_... */
+  AS_BOOL add;		/* FOP_TERM, FOP_END: add up the previous term */
+  int it;
+  double x;
+};
+
+struct fict_expr {
+  int retc;		/* 1 if there are t terms, 0 if not, ERR if invalid */
+  int32 iop, nop;	/* in fict_table.ops */
+};
+
+struct fict_elem {
+  int32 iline;		/* line in file, for error messages */
+  int epoch;		/* OK, or ERR if invalid */
+  double tjd0;
+  int equinox;		/* OK, FICT_JDATE, or ERR if invalid */
+  double tequ;
+  struct fict_expr el[6];	/* mano, sema, ecce, parg, node, incl */
+  AS_BOOL is_geo;
+  char name[AS_MAXCH];
+};
+
+struct fict_table {
+  int32 nelem;
+  struct fict_elem *elem;
+  int32 nops, nalloc_ops;
+  struct fict_op *ops;
+  int32 last_line;	/* last line with elements */
+  int32 bad_line;	/* line with less than nine elements, 0 if none; 
+			 * bodies from nelem on are not accessible */
+};
+
+static struct fict_table fict_none;	/* no file, built-in elements */
+
+static void free_fict_table(void *p)
+{
+  struct fict_table *tab = (struct fict_table *) p;
+  if (tab == NULL)
+    return;
+  if (tab->elem != NULL)
+    free(tab->elem);
+  if (tab->ops != NULL)
+    free(tab->ops);
+  free(tab);
+}
+
+/* called by swe_set_ephe_path() and swe_close() */
+void swi_release_fict_table(void)
+{
+  if (swed.fict != NULL && swed.fict != &fict_none)
+    swi_shared_release(swed.fict, free_fict_table);
+  swed.fict = NULL;
+}
+
+static int add_fict_op(struct fict_table *tab, int kind, AS_BOOL add, int it, double x)
+{
+  struct fict_op *op;
+  if (tab->nops >= tab->nalloc_ops) {
+    tab->nalloc_ops += tab->nalloc_ops / 2 + 64;
+    if ((op = (struct fict_op *) realloc(tab->ops, tab->nalloc_ops * sizeof(struct fict_op))) == NULL)
+      return ERR;
+    tab->ops = op;
+  }
+  op = &tab->ops[tab->nops++];
+  op->kind = kind;
+  op->add = add;
+  op->it = it;
+  op->x = x;
+  return OK;
+}
+
+/* translates an element with t terms into a list of operations,
+ * see eval_t_terms(); returns ERR only if out of memory */
+static int compile_t_terms(struct fict_table *tab, char *sinp, struct fict_expr *ex)
+{
+  int i, z, retc = OK;
+  char *sp, *sp0;
+  ex->retc = 0;
+  if (strpbrk(sinp, "+-") != NULL)
+    ex->retc = 1; /* with additional terms */
+  ex->iop = tab->nops;
+  sp = sinp;
+  z = 0;
+  while (retc == OK) {
+    while(*sp != '\0' && strchr(" \t", *sp) != NULL)
+      sp++;
+    sp0 = sp;
+    if (*sp == '\0') {
+      retc = add_fict_op(tab, FOP_END, z > 0, 0, 0);
+      break;
+    }
+    if (*sp == '+' || *sp == '-') {
+      retc = add_fict_op(tab, FOP_TERM, z > 0, 0, (*sp == '-') ? -1 : 1);
+      sp++;
+    } else {
+      while(*sp != '\0' && strchr("* \t", *sp) != NULL)
+        sp++;
+      if (*sp != '\0' && strchr("tT", *sp) != NULL) {
+	/* a T */
+        sp++;
+        if (*sp != '\0' && strchr("+-", *sp))
+	  retc = add_fict_op(tab, FOP_MUL_T, FALSE, 0, 0);
+	else if ((i = atoi(sp)) <= 4 && i >= 0)
+	  retc = add_fict_op(tab, FOP_MUL_T, FALSE, i, 0);
+      } else {
+        /* a number */
+        if (atof(sp) != 0 || *sp == '0')
+	  retc = add_fict_op(tab, FOP_MUL, FALSE, 0, atof(sp));
+      }
+      while (*sp != '\0' && strchr("0123456789.", *sp))
+	sp++;
+      /* a character that is neither a number nor a T */
+      if (sp == sp0) {
+	ex->retc = ERR;
+	break;
+      }
+    }
+    z++;
+  }
+  ex->nop = tab->nops - ex->iop;
+  return retc;
+}
+
+/* tt[] holds the powers of T, see read_elements_file() */
+static int eval_t_terms(const struct fict_table *tab, const struct fict_expr *ex, const double *tt, double *doutp)
+{
+  const struct fict_op *op = tab->ops + ex->iop;
+  const struct fict_op *opend = op + ex->nop;
+  double fac = 1;
+  *doutp = 0;
+  if (ex->retc == ERR)
+    return ERR;
+  for (; op < opend; op++) {
+    switch (op->kind) {
+      case FOP_TERM:
+	if (op->add)
+	  *doutp += fac;
+	fac = op->x;
+	break;
+      case FOP_END:
+	if (op->add)
+	  *doutp += fac;
+	return ex->retc;
+      case FOP_MUL_T:
+	fac *= tt[op->it];
+	break;
+      default:
+	fac *= op->x;
+	break;
+    }
+  }
+  return ex->retc;
+}
+
+static int parse_fict_date(char *sp, double *tjd)
+{
+  int i;
+  for (i = 0; i < 5 && sp[i] != '\0'; i++)
+    sp[i] = tolower(sp[i]);
+  if (strncmp(sp, "j2000", 5) == OK)
+    *tjd = J2000;
+  else if (strncmp(sp, "b1950", 5) == OK)
+    *tjd = B1950;
+  else if (strncmp(sp, "j1900", 5) == OK)
+    *tjd = J1900;
+  else if (strncmp(sp, "jdate", 5) == OK)
+    return FICT_JDATE;
+  else if (*sp == 'j' || *sp == 'b')
+    return ERR;
+  else
+    *tjd = atof(sp);
+  return OK;
+}
+
+static struct fict_table *read_fict_table(FILE *fp)
+{
+  struct fict_table *tab;
+  struct fict_elem *fe;
+  int i, iline = 0, ncpos, nalloc = 0;
+  char s[AS_MAXCH], *sp;
+  char *cpos[20];
+  void *p;
+  if ((tab = (struct fict_table *) calloc(1, sizeof(struct fict_table))) == NULL)
+    return NULL;
+  while (fgets(s, AS_MAXCH, fp) != NULL) {
+    iline++;
+    sp = s;
+    while(*sp == ' ' || *sp == '\t')
+      sp++;
+    swi_strcpy(s, sp);
+    if (*s == '#' || *s == '\r' || *s == '\n' || *s == '\0')
+      continue;
+    if ((sp = strchr(s, '#')) != NULL)
+      *sp = '\0';
+    ncpos = swi_cutstr(s, ",", cpos, 20);
+    tab->last_line = iline;
+    if (ncpos < 9) {
+      tab->bad_line = iline;
+      break;
+    }
+    if (tab->nelem >= nalloc) {
+      nalloc += nalloc / 2 + 64;
+      if ((p = realloc(tab->elem, nalloc * sizeof(struct fict_elem))) == NULL)
+	goto return_err;
+      tab->elem = (struct fict_elem *) p;
+    }
+    fe = &tab->elem[tab->nelem++];
+    memset(fe, 0, sizeof(struct fict_elem));
+    fe->iline = iline;
+    /* epoch of elements */
+    fe->epoch = parse_fict_date(cpos[0], &fe->tjd0);
+    if (fe->epoch == FICT_JDATE)
+      fe->epoch = ERR;
+    /* equinox */
+    sp = cpos[1];
+    while(*sp == ' ' || *sp == '\t')
+      sp++;
+    fe->equinox = parse_fict_date(sp, &fe->tequ);
+    /* mean anomaly, semi-axis, eccentricity, perihelion argument, 
+     * node, inclination */
+    for (i = 0; i < 6; i++) {
+      if (compile_t_terms(tab, cpos[i + 2], &fe->el[i]) == ERR)
+	goto return_err;
+    }
+    /* planet name */
+    sp = cpos[8];
+    while(*sp == ' ' || *sp == '\t')
+      sp++;
+    swi_right_trim(sp);
+    strcpy(fe->name, sp);
+    /* geocentric */
+    if (ncpos > 9) {
+      for (sp = cpos[9]; *sp != '\0'; sp++)
+        *sp = tolower(*sp);
+      if (strstr(cpos[9], "geo") != NULL)
+	fe->is_geo = TRUE;
+    }
+  }
+  return tab;
+return_err:
+  free_fict_table(tab);
+  return NULL;
+}
+
+/* elements of the thread's ephemeris path, &fict_none if there is
+ * no seorbel.txt */
+static struct fict_table *get_fict_table(void)
+{
+  struct fict_table *tab = NULL;
+  FILE *fp;
+  char hkey[2 * AS_MAXCH];
+  if (swed.fict != NULL)
+    return swed.fict;
+  swed.fict = &fict_none;
+  if ((fp = swi_fopen(-1, SE_FICTFILE, swed.ephepath, NULL)) == NULL)
+    return swed.fict;
+  swi_shared_file_key(fp, SE_FICTFILE, swed.ephepath, hkey);
+  if ((tab = (struct fict_table *) swi_shared_get(SWI_SHARED_FICTELEM, hkey)) == NULL
+      && (tab = read_fict_table(fp)) != NULL)
+    tab = (struct fict_table *) swi_shared_put(SWI_SHARED_FICTELEM, hkey, tab, free_fict_table);
+  fclose(fp);
+  if (tab != NULL)
+    swed.fict = tab;
+  return swed.fict;
+}
+
 /* note: input parameter tjd is required for T terms in elements */
 static int read_elements_file(int32 ipl, double tjd, 
   double *tjd0, double *tequ, 
@@ -697,14 +974,12 @@ static int read_elements_file(int32 ipl, double tjd,
   double *parg, double *node, double *incl,
   char *pname, int32 *fict_ifl, char *serr)
 {
-  int i, iline, iplan, retc, ncpos;
-  FILE *fp = NULL;
-  char s[AS_MAXCH], *sp;
-  char *cpos[20], serri[AS_MAXCH];
-  AS_BOOL elem_found = FALSE;
-  double tt = 0;
-  /* -1, because file information is not saved, file is always closed */
-  if ((fp = swi_fopen(-1, SE_FICTFILE, swed.ephepath, serr)) == NULL) {
+  int retc;
+  char serri[AS_MAXCH];
+  struct fict_table *tab = get_fict_table();
+  struct fict_elem *fe;
+  double tt[5];
+  if (tab == &fict_none) {
     /* file does not exist, use built-in bodies */
     if (ipl >= SE_NFICT_ELEM) {
       if (serr != NULL)
@@ -732,236 +1007,117 @@ static int read_elements_file(int32 ipl, double tjd,
     return OK;
   }
   /* 
-   * find elements in file 
+   * find elements in table
    */
-  iline = 0;
-  iplan = -1;
-  while (fgets(s, AS_MAXCH, fp) != NULL) {
-    iline++;
-    sp = s;
-    while(*sp == ' ' || *sp == '\t')
-      sp++;
-    swi_strcpy(s, sp);
-    if (*s == '#')
-      continue;
-    if (*s == '\r')
-      continue;
-    if (*s == '\n')
-      continue;
-    if (*s == '\0')
-      continue;
-    if ((sp = strchr(s, '#')) != NULL)
-      *sp = '\0';
-    ncpos = swi_cutstr(s, ",", cpos, 20);
-    sprintf(serri, "error in file %s, line %7.0f:", SE_FICTFILE, (double) iline);
-    if (ncpos < 9) {
-      if (serr != NULL) {
-        sprintf(serr, "%s nine elements required", serri);
-      }
-      goto return_err;
-    }
-    iplan++;
-    if (iplan != ipl)
-      continue;
-    elem_found = TRUE;
-    /* epoch of elements */
-    if (tjd0 != NULL) {
-      sp = cpos[0];
-	  for (i = 0; i < 5; i++)
-       sp[i] = tolower(sp[i]);
-      if (strncmp(sp, "j2000", 5) == OK)
-        *tjd0 = J2000;
-      else if (strncmp(sp, "b1950", 5) == OK)
-        *tjd0 = B1950;
-      else if (strncmp(sp, "j1900", 5) == OK)
-        *tjd0 = J1900;
-      else if (*sp == 'j' || *sp == 'b') {
-        if (serr != NULL) {
-          sprintf(serr, "%s invalid epoch", serri);
-	}
-        goto return_err;
-      } else
-        *tjd0 = atof(sp);
-      tt = tjd - *tjd0;
-    }
-    /* equinox */
-    if (tequ != NULL) {
-      sp = cpos[1];
-      while(*sp == ' ' || *sp == '\t')
-        sp++;
-	  for (i = 0; i < 5; i++)
-       sp[i] = tolower(sp[i]);
-      if (strncmp(sp, "j2000", 5) == OK)
-        *tequ = J2000;
-      else if (strncmp(sp, "b1950", 5) == OK)
-        *tequ = B1950;
-      else if (strncmp(sp, "j1900", 5) == OK)
-        *tequ = J1900;
-      else if (strncmp(sp, "jdate", 5) == OK)
-        *tequ = tjd;
-      else if (*sp == 'j' || *sp == 'b') {
-        if (serr != NULL) {
-          sprintf(serr, "%s invalid equinox", serri);
-	}
-        goto return_err;
-      } else
-        *tequ = atof(sp);
+  if (ipl < 0 || ipl >= tab->nelem) {
+    if (serr != NULL) {
+      if (tab->bad_line > 0)
+	sprintf(serr, "error in file %s, line %7.0f: nine elements required", SE_FICTFILE, (double) tab->bad_line);
+      else
+	sprintf(serr, "error in file %s, line %7.0f: elements for planet %7.0f not found", SE_FICTFILE, (double) tab->last_line, (double) ipl);
     }
-    /* mean anomaly t0 */
-    if (mano != NULL) {
-      retc = check_t_terms(tt, cpos[2], mano);
-	  *mano = swe_degnorm(*mano);
-      if (retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s mean anomaly value invalid", serri);
-	}
-        goto return_err;
-      }
-      /* if mean anomaly has t terms (which happens with fictitious 
-       * planet Vulcan), we set
-       * epoch = tjd, so that no motion will be added anymore 
-       * equinox = tjd */
-      if (retc == 1) {
-	*tjd0 = tjd;
-      }
-      *mano *= DEGTORAD;
+    return ERR;
+  }
+  fe = &tab->elem[ipl];
+  sprintf(serri, "error in file %s, line %7.0f:", SE_FICTFILE, (double) fe->iline);
+  tt[0] = 0;
+  /* epoch of elements */
+  if (tjd0 != NULL) {
+    if (fe->epoch == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s invalid epoch", serri);
+      return ERR;
     }
-    /* semi-axis */
-    if (sema != NULL) {
-      retc = check_t_terms(tt, cpos[3], sema);
-      if (*sema <= 0 || retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s semi-axis value invalid", serri);
-	}
-        goto return_err;
-      }
+    *tjd0 = fe->tjd0;
+    tt[0] = (tjd - *tjd0) / 36525;
+  }
+  tt[1] = tt[0];
+  tt[2] = tt[1] * tt[1];
+  tt[3] = tt[2] * tt[1];
+  tt[4] = tt[3] * tt[1];
+  /* equinox */
+  if (tequ != NULL) {
+    if (fe->equinox == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s invalid equinox", serri);
+      return ERR;
     }
-    /* eccentricity */
-    if (ecce != NULL) {
-      retc = check_t_terms(tt, cpos[4], ecce);
-      if (*ecce >= 1 || *ecce < 0 || retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s eccentricity invalid (no parabolic or hyperbolic orbits allowed)", serri);
-	}
-        goto return_err;
-      }
+    *tequ = (fe->equinox == FICT_JDATE) ? tjd : fe->tequ;
+  }
+  /* mean anomaly t0 */
+  if (mano != NULL) {
+    retc = eval_t_terms(tab, &fe->el[0], tt, mano);
+    *mano = swe_degnorm(*mano);
+    if (retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s mean anomaly value invalid", serri);
+      return ERR;
     }
-    /* perihelion argument */
-    if (parg != NULL) {
-      retc = check_t_terms(tt, cpos[5], parg);
-	  *parg = swe_degnorm(*parg);
-      if (retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s perihelion argument value invalid", serri);
-	}
-        goto return_err;
-      }
-      *parg *= DEGTORAD;
+    /* if mean anomaly has t terms (which happens with fictitious 
+     * planet Vulcan), we set
+     * epoch = tjd, so that no motion will be added anymore 
+     * equinox = tjd */
+    if (retc == 1) {
+      *tjd0 = tjd;
     }
-    /* node */
-    if (node != NULL) {
-      retc = check_t_terms(tt, cpos[6], node);
-	  *node = swe_degnorm(*node);
-      if (retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s node value invalid", serri);
-	}
-        goto return_err;
-      }
-      *node *= DEGTORAD;
+    *mano *= DEGTORAD;
+  }
+  /* semi-axis */
+  if (sema != NULL) {
+    retc = eval_t_terms(tab, &fe->el[1], tt, sema);
+    if (*sema <= 0 || retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s semi-axis value invalid", serri);
+      return ERR;
     }
-    /* inclination */
-    if (incl != NULL) {
-      retc = check_t_terms(tt, cpos[7], incl);
-	  *incl = swe_degnorm(*incl);
-      if (retc == ERR) {
-        if (serr != NULL) {
-          sprintf(serr, "%s inclination value invalid", serri);
-	}
-        goto return_err;
-      }
-      *incl *= DEGTORAD;
+  }
+  /* eccentricity */
+  if (ecce != NULL) {
+    retc = eval_t_terms(tab, &fe->el[2], tt, ecce);
+    if (*ecce >= 1 || *ecce < 0 || retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s eccentricity invalid (no parabolic or hyperbolic orbits allowed)", serri);
+      return ERR;
     }
-    /* planet name */
-    if (pname != NULL) {
-      sp = cpos[8];
-      while(*sp == ' ' || *sp == '\t')
-        sp++;
-      swi_right_trim(sp);
-      strcpy(pname, sp);
+  }
+  /* perihelion argument */
+  if (parg != NULL) {
+    retc = eval_t_terms(tab, &fe->el[3], tt, parg);
+    *parg = swe_degnorm(*parg);
+    if (retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s perihelion argument value invalid", serri);
+      return ERR;
     }
-    /* geocentric */
-    if (fict_ifl != NULL && ncpos > 9) {
-      for (sp = cpos[9]; *sp != '\0'; sp++)
-        *sp = tolower(*sp);
-      if (strstr(cpos[9], "geo") != NULL)
-        *fict_ifl |= FICT_GEO;
+    *parg *= DEGTORAD;
+  }
+  /* node */
+  if (node != NULL) {
+    retc = eval_t_terms(tab, &fe->el[4], tt, node);
+    *node = swe_degnorm(*node);
+    if (retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s node value invalid", serri);
+      return ERR;
     }
-    break;
+    *node *= DEGTORAD;
   }
-  if (!elem_found) {
-    if (serr != NULL) {
-      sprintf(serr, "%s elements for planet %7.0f not found", serri, (double) ipl);
+  /* inclination */
+  if (incl != NULL) {
+    retc = eval_t_terms(tab, &fe->el[5], tt, incl);
+    *incl = swe_degnorm(*incl);
+    if (retc == ERR) {
+      if (serr != NULL)
+	sprintf(serr, "%s inclination value invalid", serri);
+      return ERR;
     }
-    goto return_err;
+    *incl *= DEGTORAD;
   }
-  fclose(fp);
+  /* planet name */
+  if (pname != NULL)
+    strcpy(pname, fe->name);
+  /* geocentric */
+  if (fict_ifl != NULL && fe->is_geo)
+    *fict_ifl |= FICT_GEO;
   return OK;
-return_err:
-  fclose(fp);
-  return ERR;
-}
-#endif
-
-static int check_t_terms(double t, char *sinp, double *doutp)
-{
-  int i, isgn = 1, z;
-  int retc = 0;
-  char *sp;
-  double tt[5], fac;
-  tt[0] = t / 36525;
-  tt[1] = tt[0];
-  tt[2] = tt[1] * tt[1];
-  tt[3] = tt[2] * tt[1];
-  tt[4] = tt[3] * tt[1];
-  if ((sp = strpbrk(sinp, "+-")) != NULL)
-    retc = 1; /* with additional terms */
-  sp = sinp;
-  *doutp = 0;
-  fac = 1;
-  z = 0;
-  while (1) {
-    while(*sp != '\0' && strchr(" \t", *sp) != NULL)
-      sp++;
-    if (strchr("+-", *sp) || *sp == '\0') {
-	  if (z > 0)
-		*doutp += fac;
-	  isgn = 1;
-	  if (*sp == '-')
-	    isgn = -1;
-	  fac = 1 * isgn;
-	  if (*sp == '\0')
-		return retc;
-	  sp++;
-	} else {
-      while(*sp != '\0' && strchr("* \t", *sp) != NULL)
-        sp++;
-      if (*sp != '\0' && strchr("tT", *sp) != NULL) {
-		/* a T */
-        sp++;
-        if (*sp != '\0' && strchr("+-", *sp))
-		  fac *= tt[0];
-	    else if ((i = atoi(sp)) <= 4 && i >= 0)
-          fac *= tt[i];
-	  } else {
-        /* a number */
-        if (atof(sp) != 0 || *sp == '0')
-          fac *= atof(sp);
-	  }
-      while (*sp != '\0' && strchr("0123456789.", *sp))
-	    sp++;
-	}
-	z++;
-  }
-  return retc;	/* there have been additional terms */
 }
@@ -64,6 +64,7 @@
 /* Number of terms in the luni-solar nutation model */
 #define NLS 678
 #define NLS_2000B 77
+#define NLS_FAST 13   /* SEFLG_FAST: dropped terms sum up to < 0.1" */
 /* Number of terms in the planetary nutation model */
 #define NPL 687
 /* Luni-Solar argument multipliers
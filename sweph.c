@@ -62,6 +62,7 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <stddef.h>
 #if MSDOS
 #include <tchar.h>
 #include <windows.h>
@@ -93,7 +94,7 @@ struct meff_ele {double r,m;};
 /****************
  * global stuff *
  ****************/
-TLS struct swe_data swed = {FALSE,	/* ephe_path_is_set = FALSE */
+TLS struct swe_data swi_swed_tls = {FALSE,	/* ephe_path_is_set = FALSE */
                             FALSE,	/* jpl_file_is_open = FALSE */
                             NULL,	/* fixfp, fixed stars file pointer */
 			    "",		/* ephepath, ephemeris path */
@@ -114,14 +115,16 @@ TLS struct swe_data swed = {FALSE,	/* ephe_path_is_set = FALSE */
 			    0.0,	/* ast_G */
 			    0.0,	/* ast_H */
 			    0.0,	/* ast_diam */
-			    "",		/* astelem[] */
+			    NULL,	/* astelem */
 			    0, 		/* i_saved_planet_name */
 			    "",		/* saved_planet_name[] */
 			    NULL,	/* dpsi */
 			    NULL,	/* deps */
+			    NULL,	/* eop */
 			    0,		/* timeout */
 			    {0,0,0,0,0,0,0,0,}, /* astro_models */
 			    };
+TLS struct swe_data *swi_swed_cur = NULL;	/* bound context, NULL = swi_swed_tls */
 
 /*************
  * constants *
@@ -223,6 +226,9 @@ static int app_pos_rest(struct plan_data *pdp, int32 iflag,
     double *xx, double *x2000, struct epsilon *oe, char *serr);
 static int open_jpl_file(double *ss, char *fname, char *fpath, char *serr);
 static void free_planets(void);
+static void free_fixstar_catalog(void *p);
+static void release_text_tables(void);
+static void check_fast_flag(int32 iflag);
 
 #ifdef TRACE
 static void trace_swe_calc(int param, double tjd, int ipl, int32 iflag, double *xx, char *serr);
@@ -399,6 +405,7 @@ int32 CALL_CONV swe_calc(double tjd, int ipl, int32 iflag,
       swed.last_epheflag = epheflag;
     }
   }
+  check_fast_flag(iflag);
   /* high precision speed prevails fast speed */
   if ((iflag & SEFLG_SPEED3) && (iflag & SEFLG_SPEED))
     iflag = iflag & ~SEFLG_SPEED3;
@@ -454,9 +461,12 @@ int32 CALL_CONV swe_calc(double tjd, int ipl, int32 iflag,
    * save area.
    */ 
   if (sd->tsave == tjd && tjd != 0 && ipl == sd->ipl && iplmoon == 0) {
-    if ((sd->iflgsave & ~SEFLG_COORDSYS) == (iflag & ~SEFLG_COORDSYS)) 
+    if ((sd->iflgsave & ~SEFLG_COORDSYS) == (iflag & ~SEFLG_COORDSYS)) {
+      SWI_STAT_SAVE(TRUE, sd - swed.savedat);
       goto end_swe_calc;
+    }
   }
+  SWI_STAT_SAVE(FALSE, sd - swed.savedat);
   /* 
    * otherwise, new position must be computed 
    */
@@ -575,6 +585,13 @@ int32 CALL_CONV swe_calc_ut(double tjd_ut, int32 ipl, int32 iflag,
     iflag |= SEFLG_SWIEPH;
   }
   deltat = swe_deltat_ex(tjd_ut, iflag, serr);
+  /* precomputed table, see swe_set_table() */
+  if (swed.ptab != NULL 
+    && (retval = swi_tab_calc(swed.ptab, swed.tab_maxerr, tjd_ut + deltat, ipl, iflag, xx)) != NOT_AVAILABLE) {
+    if (!(iflag & SEFLG_SPEED))
+      xx[3] = xx[4] = xx[5] = 0;
+    return retval;
+  }
   retval = swe_calc(tjd_ut + deltat, ipl, iflag, xx, serr);
   /* if ephe required is not ephe returned, adjust delta t: */
   if ((retval & SEFLG_EPHMASK) != epheflag) {
@@ -724,7 +741,8 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
 	break;
     } 
     /* heliocentric, lighttime etc. */
-    if ((retc = app_pos_etc_moon(iflag, serr)) != OK)
+    SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_moon(iflag, serr));
+    if (retc != OK)
       goto return_error; /* retc may be wrong with sidereal calculation */
   /********************************************** 
    * barycentric sun                            * 
@@ -801,7 +819,8 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
 	break;
     }
     /* flags */
-    if ((retc = app_pos_etc_sbar(iflag, serr)) != OK)
+    SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_sbar(iflag, serr));
+    if (retc != OK)
       goto return_error; 
     /* iflag has possibly changed */
     iflag = pedp->xflgs;
@@ -878,7 +897,8 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
     ndp->teval = tjd;
     ndp->xflgs = -1; 	
     /* lighttime etc. */
-    if ((retc = app_pos_etc_mean(SEI_MEAN_NODE, iflag, serr)) != OK)
+    SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_mean(SEI_MEAN_NODE, iflag, serr));
+    if (retc != OK)
       goto return_error;
     /* to avoid infinitesimal deviations from latitude = 0 
      * that result from conversions */
@@ -918,7 +938,8 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
     ndp->teval = tjd;
     ndp->xflgs = -1; 	
     /* lighttime etc. */
-    if ((retc = app_pos_etc_mean(SEI_MEAN_APOG, iflag, serr)) != OK)
+    SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_mean(SEI_MEAN_APOG, iflag, serr));
+    if (retc != OK)
       goto return_error;
     /* to avoid infinitesimal deviations from r-speed = 0 
      * that result from conversions */
@@ -1077,7 +1098,7 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
     retc = sweph(tjd, ipli_ast, ifno, iflag, psdp->x, DO_SAVE, NULL, serr);
     if (retc == ERR || retc == NOT_AVAILABLE) 
       goto return_error;
-    retc = app_pos_etc_plan(ipli_ast, 0, iflag, serr);
+    SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_plan(ipli_ast, 0, iflag, serr));
     if (retc == ERR)
       goto return_error;
     /* app_pos_etc_plan() might have failed, if t(light-time)
@@ -1158,16 +1179,12 @@ static int32 swecalc(double tjd, int ipl, int32 iplmoon, int32 iflag, double *x,
 static void free_planets(void)
 {
   int i;
-  /* free planets data space */
+  /* free planets data space; segp is in the arena, 
+   * refep belongs to the shared file header */
   for (i = 0; i < SEI_NPLANETS; i++) {
-    if (swed.pldat[i].segp != NULL) {
-      free((void *) swed.pldat[i].segp);
-    }
-    if (swed.pldat[i].refep != NULL) {
-      free((void *) swed.pldat[i].refep);
-    }
     memset((void *) &swed.pldat[i], 0, sizeof(struct plan_data));
   }
+  swi_arena_reset(&swed.arena);
   for (i = 0; i <= SE_NPLANETS; i++) /* "<=" is correct! see decl. */
     memset((void *) &swed.savedat[i], 0, sizeof(struct save_positions));
   /* clear node data space */
@@ -1176,6 +1193,26 @@ static void free_planets(void)
   }
 }
 
+/* if SEFLG_FAST differs from the last call, the save areas are cleared:
+ * with SEFLG_FAST, positions are computed from truncated Chebyshev 
+ * series and with reduced nutation, and these must not be returned 
+ * to a call without SEFLG_FAST, nor vice versa. */
+static void check_fast_flag(int32 iflag)
+{
+  int i;
+  if ((iflag & SEFLG_FAST) == swed.last_fastflag)
+    return;
+  for (i = 0; i < SEI_NPLANETS; i++)
+    swed.pldat[i].teval = 0;
+  for (i = 0; i < SEI_NNODE_ETC; i++)
+    swed.nddat[i].teval = 0;
+  swed.nut.tnut = 0;
+  swed.nut2000.tnut = 0;
+  swed.nutv.tnut = 0;
+  swi_force_app_pos_etc();
+  swed.last_fastflag = iflag & SEFLG_FAST;
+}
+
 /* Function initialises swed structure. 
  * Returns 1 if initialisation is done, otherwise 0 */
 int32 swi_init_swed_if_start(void)
@@ -1265,16 +1302,23 @@ void CALL_CONV swe_close(void)
   memset((void *) &swed.sidd, 0, sizeof(struct sid_data));
   swed.timeout = 0;
   swed.last_epheflag = 0;
-  if (swed.dpsi != NULL) {
-    free(swed.dpsi);
+  swe_set_table(NULL, 0);
+  /* a thread's own context gives its buffers back, an explicit one
+   * keeps them for the next request, see swectx.c */
+  if (&swed == &swi_swed_tls)
+    swi_arena_release(&swed.arena);
+  /* the tables are shared with other threads */
+  if (swed.eop != NULL) {
+    swi_shared_release(swed.eop, free);
+    swed.eop = NULL;
     swed.dpsi = NULL;
-  }
-  if (swed.deps != NULL) {
-    free(swed.deps);
     swed.deps = NULL;
+    swed.eop_dpsi_loaded = 0;
   }
-  if (swed.n_fixstars_records > 0) {
-    free(swed.fixed_stars);
+  release_text_tables();
+  if (swed.fixstar_cat != NULL) {
+    swi_shared_release(swed.fixstar_cat, free_fixstar_catalog);
+    swed.fixstar_cat = NULL;
     swed.fixed_stars = NULL;
     swed.n_fixstars_real = 0;
     swed.n_fixstars_named = 0;
@@ -1321,6 +1365,7 @@ void CALL_CONV swe_set_ephe_path(const char *path)
   /* close all open files and delete all planetary data */
   swi_close_keep_topo_etc();
   swi_init_swed_if_start();
+  release_text_tables();
   swed.ephe_path_is_set = TRUE;
   /* environment variable SE_EPHE_PATH has priority */
   if ((sp = getenv("SE_EPHE_PATH")) != NULL 
@@ -1376,6 +1421,33 @@ void CALL_CONV swe_set_ephe_path(const char *path)
 #endif
 }
 
+/* copies the ephemeris path of the calling thread, as set by
+ * swe_set_ephe_path() (with a trailing directory separator), into path
+ * (AS_MAXCH bytes); empty if it has not been set */
+char *CALL_CONV swe_get_ephe_path(char *path)
+{
+  if (swed.ephe_path_is_set)
+    strcpy(path, swed.ephepath);
+  else
+    *path = '\0';
+  return path;
+}
+
+/* attaches the thread to a shared table of dpsi, deps */
+static void use_dpsi_deps(struct eop_data *eop)
+{
+  swed.eop = eop;
+  swed.dpsi = eop->dpsi;
+  swed.deps = eop->deps;
+  swed.eop_tjd_beg = eop->tjd_beg;
+  swed.eop_tjd_beg_horizons = eop->tjd_beg_horizons;
+  swed.eop_tjd_end = eop->tjd_end;
+  swed.eop_dpsi_loaded = eop->loaded;
+}
+
+/* The table is read by the first thread and shared by the others,
+ * see sweshare.c. Only a complete table is shared; after an error
+ * each thread tries once. */
 void load_dpsi_deps(void)
 {
   FILE *fp;
@@ -1383,22 +1455,25 @@ void load_dpsi_deps(void)
   char *cpos[20];
   int n = 0, iyear, mjd = 0, mjdsv = 0;
   double dpsi, deps, TJDOFS = 2400000.5;
-  if (swed.eop_dpsi_loaded > 0) 
+  AS_BOOL is_full = FALSE;
+  struct eop_data *eop;
+  if (swed.eop != NULL || swed.eop_dpsi_loaded > 0) 
     return;
-  fp = swi_fopen(-1, DPSI_DEPS_IAU1980_FILE_EOPC04, swed.ephepath, NULL);
-  if (fp == NULL) {
-    swed.eop_dpsi_loaded = ERR;
+  if ((eop = (struct eop_data *) swi_shared_get(SWI_SHARED_EOP, swed.ephepath)) != NULL) {
+    use_dpsi_deps(eop);
     return;
   }
-  if ((swed.dpsi = (double *) calloc((size_t) SWE_DATA_DPSI_DEPS, sizeof(double))) == NULL) {
+  fp = swi_fopen(-1, DPSI_DEPS_IAU1980_FILE_EOPC04, swed.ephepath, NULL);
+  if (fp == NULL) {
     swed.eop_dpsi_loaded = ERR;
     return;
   }
-  if ((swed.deps = (double *) calloc((size_t) SWE_DATA_DPSI_DEPS, sizeof(double))) == NULL) {
+  if ((eop = (struct eop_data *) calloc(1, sizeof(struct eop_data))) == NULL) {
     swed.eop_dpsi_loaded = ERR;
+    fclose(fp);
     return;
   }
-  swed.eop_tjd_beg_horizons = DPSI_DEPS_IAU1980_TJD0_HORIZONS;
+  eop->tjd_beg_horizons = DPSI_DEPS_IAU1980_TJD0_HORIZONS;
   while (fgets(s, AS_MAXCH, fp) != NULL) {
     swi_cutstr(s, " ", cpos, 16);
     if ((iyear = atoi(cpos[0])) == 0) 
@@ -1409,37 +1484,37 @@ void load_dpsi_deps(void)
       /* we cannot return error but we note it as follows: */
       swed.eop_dpsi_loaded = -2;
       fclose(fp);
+      free(eop);
       return;
     }
     if (n == 0)
-      swed.eop_tjd_beg = mjd + TJDOFS;
-    swed.dpsi[n] = atof(cpos[8]);
-    swed.deps[n] = atof(cpos[9]);
-/*    fprintf(stderr, "n=%d, tjd=%f, dpsi=%f, deps=%f\n", n, mjd + 2400000.5, swed.dpsi[n] * 1000, swed.deps[n] * 1000);exit(0);*/
+      eop->tjd_beg = mjd + TJDOFS;
+    eop->dpsi[n] = atof(cpos[8]);
+    eop->deps[n] = atof(cpos[9]);
     n++;
     mjdsv = mjd;
   }
-  swed.eop_tjd_end = mjd + TJDOFS;
-  swed.eop_dpsi_loaded = 1;
+  eop->tjd_end = mjd + TJDOFS;
+  eop->loaded = 1;
   fclose(fp);
   /* file finals.all may have some more data, and especially estimations 
    * for the near future */
   fp = swi_fopen(-1, DPSI_DEPS_IAU1980_FILE_FINALS, swed.ephepath, NULL);
-  if (fp == NULL) 
-    return; /* return without error as existence of file is not mandatory */
-  while (fgets(s, AS_MAXCH, fp) != NULL) {
+  /* existence of file is not mandatory */
+  while (fp != NULL && fgets(s, AS_MAXCH, fp) != NULL) {
     mjd = atoi(s + 7);
-    if (mjd + TJDOFS <= swed.eop_tjd_end)
+    if (mjd + TJDOFS <= eop->tjd_end)
       continue;
-    if (n >= SWE_DATA_DPSI_DEPS)
-      return;
+    if (n >= SWE_DATA_DPSI_DEPS) {
+      is_full = TRUE;
+      break;
+    }
     /* are data in one-day steps? */
     if (mjdsv > 0 && mjd - mjdsv != 1) {
       /* no error, as we do have data; however, if this file is usefull,
-       * then swed.eop_dpsi_loaded will be set to 2 */
-      swed.eop_dpsi_loaded = -3;
-      fclose(fp);
-      return;
+       * then eop_dpsi_loaded will be set to 2 */
+      eop->loaded = -3;
+      break;
     }
     /* dpsi, deps Bulletin B */
     dpsi = atof(s + 168);
@@ -1450,20 +1525,21 @@ void load_dpsi_deps(void)
       deps = atof(s + 118);
     }
     if (dpsi == 0) {
-      swed.eop_dpsi_loaded = 2;
-      /*printf("dpsi from %f to %f \n", swed.eop_tjd_beg, swed.eop_tjd_end);*/
-      fclose(fp);
-      return;
+      eop->loaded = 2;
+      break;
     }
-    swed.eop_tjd_end = mjd + TJDOFS;
-    swed.dpsi[n] = dpsi / 1000.0;
-    swed.deps[n] = deps / 1000.0;
-    /*fprintf(stderr, "tjd=%f, dpsi=%f, deps=%f\n", mjd + 2400000.5, swed.dpsi[n] * 1000, swed.deps[n] * 1000);*/
+    eop->tjd_end = mjd + TJDOFS;
+    eop->dpsi[n] = dpsi / 1000.0;
+    eop->deps[n] = deps / 1000.0;
     n++;
     mjdsv = mjd;
   }
-  swed.eop_dpsi_loaded = 2;
-  fclose(fp);
+  if (fp != NULL) {
+    if (eop->loaded == 1 && !is_full)
+      eop->loaded = 2;
+    fclose(fp);
+  }
+  use_dpsi_deps((struct eop_data *) swi_shared_put(SWI_SHARED_EOP, swed.ephepath, eop, free));
 }
 
 /* sets jpl file name.
@@ -1594,9 +1670,9 @@ static int main_planet(double tjd, int ipli, int iplmoon, int32 epheflag, int32
       }
       /* geocentric, lighttime etc. */
       if (ipli == SEI_SUN) {
-	retc = app_pos_etc_sun(iflag, serr)/**/;
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_sun(iflag, serr));
       } else {
-	retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr);
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr));
       }
       if (retc == ERR)
 	return ERR;
@@ -1634,9 +1710,9 @@ static int main_planet(double tjd, int ipli, int iplmoon, int32 epheflag, int32
       }
       /* geocentric, lighttime etc. */
       if (ipli == SEI_SUN) {
-	retc = app_pos_etc_sun(iflag, serr)/**/;
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_sun(iflag, serr));
       } else {
-	retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr);
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr));
       }
       if (retc == ERR)
 	return ERR;
@@ -1658,9 +1734,9 @@ static int main_planet(double tjd, int ipli, int iplmoon, int32 epheflag, int32
 	return ERR;
       /* geocentric, lighttime etc. */
       if (ipli == SEI_SUN) {
-	retc = app_pos_etc_sun(iflag, serr)/**/;
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_sun(iflag, serr));
       } else {
-	retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr);
+	SWI_STAT_TIMED(SE_STAT_APP_NS, retc = app_pos_etc_plan(ipli, iplmoon, iflag, serr));
       }
       if (retc == ERR)
 	return ERR;
@@ -2104,6 +2180,30 @@ static int jplplan(double tjd, int ipli, int32 iflag, AS_BOOL do_save,
   return (OK);
 }
 
+/* number of Chebyshev coefficients evaluated with SEFLG_FAST.
+ * as |T_n(x)| <= 1, the sum of the dropped coefficients bounds the
+ * error of the truncated series. the earth-moon barycenter gets the
+ * tolerance of the asteroids, because its error enters the geocentric
+ * positions of near-earth objects undiminished. */
+static int fast_neval(struct plan_data *pdp, int ipl)
+{
+  int n;
+  double tol, sum = 0;
+  double *cx = pdp->segp, *cy = cx + pdp->ncoe, *cz = cy + pdp->ncoe;
+  if (ipl == SEI_MOON)
+    tol = FAST_CHEB_TOL_MOON;
+  else if (ipl > SEI_EMB && ipl <= SEI_SUNBARY)
+    tol = FAST_CHEB_TOL_PLAN;
+  else
+    tol = FAST_CHEB_TOL_AST;
+  for (n = pdp->neval; n > 1; n--) {
+    sum += fabs(cx[n-1]) + fabs(cy[n-1]) + fabs(cz[n-1]);
+    if (sum >= tol)
+      break;
+  }
+  return n;
+}
+
 /* 
  * this function looks for an ephemeris file, 
  * opens it, if not yet open,
@@ -2123,7 +2223,7 @@ static int jplplan(double tjd, int ipli, int32 iflag, AS_BOOL do_save,
  */
 static int sweph(double tjd, int ipli, int ifno, int32 iflag, double *xsunb, AS_BOOL do_save, double *xpret, char *serr)
 {
-  int i, ipl, retc, subdirlen;
+  int i, ipl, retc, subdirlen, neval;
   char s[2 * AS_MAXCH], subdirnam[AS_MAXCH], fname[AS_MAXCH], *sp;
   double t, tsv;       
   double xemb[6], xx[6], *xp;
@@ -2167,11 +2267,7 @@ static int sweph(double tjd, int ipli, int ifno, int32 iflag, double *xsunb, AS_
       || (ipl == SEI_ANYBODY && ipli != pdp->ibdy)) { 	
       fclose(fdp->fptr);
       fdp->fptr = NULL;
-      if (pdp->refep != NULL) 
-	free((void *) pdp->refep);
       pdp->refep = NULL;
-      if (pdp->segp != NULL)
-	free((void *) pdp->segp);
       pdp->segp = NULL;
     }
   }
@@ -2270,7 +2366,7 @@ again:
    ******************************/
   /* get new segment, if necessary */
   if (pdp->segp == NULL || tjd < pdp->tseg0 || tjd > pdp->tseg1) {
-    retc = get_new_segment(tjd, ipl, ifno, serr);
+    SWI_STAT_TIMED(SE_STAT_SEG_NS, retc = get_new_segment(tjd, ipl, ifno, serr));
     if (retc != OK)
       return(retc);
     /* rotate cheby coeffs back to equatorial system.
@@ -2280,6 +2376,7 @@ again:
     } else {
       pdp->neval = pdp->ncoe;
     }
+    pdp->nevfast = fast_neval(pdp, ipl);
   }
   /* evaluate chebyshew polynomial for tjd */
   t = (tjd - pdp->tseg0) / pdp->dseg;
@@ -2291,10 +2388,11 @@ again:
    * 2. the speed flag has been specified.
    */
   need_speed = (do_save || (iflag & SEFLG_SPEED));
+  neval = (iflag & SEFLG_FAST) ? pdp->nevfast : pdp->neval;
   for (i = 0; i <= 2; i++) {
-    xp[i]  = swi_echeb (t, pdp->segp+(i*pdp->ncoe), pdp->neval);
+    xp[i]  = swi_echeb (t, pdp->segp+(i*pdp->ncoe), neval);
     if (need_speed) {
-      xp[i+3] = swi_edcheb(t, pdp->segp+(i*pdp->ncoe), pdp->neval) / pdp->dseg * 2;
+      xp[i+3] = swi_edcheb(t, pdp->segp+(i*pdp->ncoe), neval) / pdp->dseg * 2;
     } else {
       xp[i+3] = 0;	/* von Alois als billiger fix, evtl. illegal */
     }
@@ -2392,10 +2490,13 @@ FILE *swi_fopen(int ifno, char *fname, char *ephepath, char *serr)
       return NULL;
     }
     strcpy(fnamp, s);
-    fp = fopen(fnamp, BFILE_R_ACCESS);
-    if (fp != NULL) 
+    SWI_STAT_TIMED(SE_STAT_FILE_NS, fp = fopen(fnamp, BFILE_R_ACCESS));
+    if (fp != NULL) {
+      SWI_STAT_ADD(SE_STAT_FILE_OPENS, 1);
       return fp;
+    }
   }
+  SWI_STAT_ADD(SE_STAT_FILE_FAILS, 1);
   sprintf(s, "SwissEph file '%s' not found in PATH '%s'", fname, ephepath);
   s[AS_MAXCH-1] = '\0';		/* s must not be longer then AS_MAXCH */
   if (serr != NULL)
@@ -2453,6 +2554,31 @@ static int calc_center_body(int32 ipli, int32 iflag, double *xx, double *xcom, c
   return OK;
 }
 
+/* SEFLG_FAST: barycentric position and speed at t - dt from those at t,
+ * by a Taylor step of second order with the sun's attraction; this
+ * replaces the second evaluation of the ephemeris in the light-time
+ * correction. the neglected terms are < 0.001" even for Mercury.
+ * x		barycentric position and speed at t
+ * dt		light-time
+ * xret		position and speed at t - dt, may be x
+ */
+static void fast_light_time(double *x, double dt, double *xret)
+{
+  int i;
+  double xh[3], r, acc[3];
+  double *xsun = swed.pldat[SEI_SUNBARY].x;
+  double gm = HELGRAVCONST * 86400.0 * 86400.0 / AUNIT / AUNIT / AUNIT;
+  for (i = 0; i <= 2; i++)
+    xh[i] = x[i] - xsun[i];
+  r = sqrt(square_sum(xh));
+  for (i = 0; i <= 2; i++)
+    acc[i] = -gm * xh[i] / (r * r * r);
+  for (i = 0; i <= 2; i++) {
+    xret[i] = x[i] - dt * x[i+3] + 0.5 * dt * dt * acc[i];
+    xret[i+3] = x[i+3] - dt * acc[i];
+  }
+}
+
 /* converts planets from barycentric to geocentric,
  * apparent positions
  * precession and nutation
@@ -2465,6 +2591,7 @@ static int app_pos_etc_plan(int ipli, int iplmoon, int32 iflag, char *serr)
 {
   int i, j, niter, retc = OK;
   int ipl, ifno, ibody;
+  AS_BOOL fast_lt;
   int32 flg1, flg2;
   double xx[6], xx0[6], dx[3], dt, t, dtsave_for_defl;
   double xobs[6], xobs2[6];
@@ -2548,6 +2675,10 @@ static int app_pos_etc_plan(int ipli, int iplmoon, int32 iflag, char *serr)
     } else { 	/* SEFLG_MOSEPH or planet from osculating elements */
       niter = 0;
     }
+    /* with SEFLG_FAST, the ephemeris is not evaluated again for t - dt,
+     * see fast_light_time() */
+    fast_lt = (iflag & SEFLG_FAST) && !(iflag & SEFLG_CENTER_BODY)
+	&& niter > 0;
     if (iflag & SEFLG_SPEED) {
       /* 
        * Apparent speed is influenced by the fact that dt changes with
@@ -2578,6 +2709,7 @@ static int app_pos_etc_plan(int ipli, int iplmoon, int32 iflag, char *serr)
 	xxsp[i] = xxsv[i] - xxsp[i];
     }
     /* dt and t(apparent) */
+    SWI_STAT_ADD(SE_STAT_LT_ITER, niter + 1);
     for (j = 0; j <= niter; j++) {
       for (i = 0; i <= 2; i++) {
 	dx[i] = xx[i];
@@ -2609,7 +2741,11 @@ static int app_pos_etc_plan(int ipli, int iplmoon, int32 iflag, char *serr)
       if (retc == ERR || retc == NOT_AVAILABLE)
 	return ERR;
     }
-    switch(epheflag) {
+    if (fast_lt) {
+      fast_light_time(xx0, dt, xx);
+      if (iflag & SEFLG_SPEED)
+	fast_light_time(pedp->x, dt, xearth);
+    } else switch(epheflag) {
       case SEFLG_JPLEPH:
 	if (ibody >= IS_ANY_BODY)
 	  ipl = -1; /* will not be used */ /*pnoint2jpl[SEI_ANYBODY];*/
@@ -3452,6 +3588,7 @@ static int app_pos_etc_plan_osc(int ipl, int ipli, int32 iflag, char *serr)
 	xxsp[i] = xxsv[i] - xxsp[i];
     }
     /* dt and t(apparent) */
+    SWI_STAT_ADD(SE_STAT_LT_ITER, niter + 1);
     for (j = 0; j <= niter; j++) {
       for (i = 0; i <= 2; i++) {
 	dx[i] = xx[i];
@@ -3901,6 +4038,7 @@ void swi_deflect_light(double *xx, double dt, int32 iflag)
 static int app_pos_etc_sun(int32 iflag, char *serr)
 {
   int i, j, niter, retc = OK;
+  AS_BOOL fast_lt;
   int32 flg1, flg2;
   double xx[6], xxsv[6], dx[3], dt, t = 0;
   double xearth[6], xsun[6], xobs[6];
@@ -3974,6 +4112,9 @@ static int app_pos_etc_sun(int32 iflag, char *serr)
 	  xsun[i] = psdp->x[i];
       }
       niter = 1;	/* # of iterations */
+      /* with SEFLG_FAST, no new ephemeris evaluation for t' */
+      fast_lt = (iflag & SEFLG_FAST) && pedp->iephe != SEFLG_MOSEPH;
+      SWI_STAT_ADD(SE_STAT_LT_ITER, niter + 1);
       for (j = 0; j <= niter; j++) {
 	/* distance earth-sun */
 	for (i = 0; i <= 2; i++) {
@@ -3985,7 +4126,15 @@ static int app_pos_etc_sun(int32 iflag, char *serr)
 	dt = sqrt(square_sum(dx)) * AUNIT / CLIGHT / 86400.0;     
 	t = pedp->teval - dt;
 	/* new position */
-	switch(pedp->iephe) {
+	if (fast_lt) {
+	  if ((iflag & SEFLG_HELCTR) || (iflag & SEFLG_BARYCTR)) {
+	    fast_light_time(xobs, dt, xearth);
+	  } else {
+	    /* acceleration of barycentric sun is negligible */
+	    for (i = 0; i <= 2; i++)
+	      xsun[i] = psdp->x[i] - dt * psdp->x[i+3];
+	  }
+	} else switch(pedp->iephe) {
 	  /* if geocentric sun, new sun at t' 
 	   * if heliocentric or barycentric earth, new earth at t' */
 	  case SEFLG_JPLEPH:
@@ -4391,8 +4540,16 @@ static int get_new_segment(double tjd, int ipli, int ifno, char *serr)
     goto return_error_gns;
   fseek(fp, fpos, SEEK_SET);
   /* clear space of chebyshew coefficients */
-  if (pdp->segp == NULL)
-    pdp->segp = (double *) malloc((size_t) pdp->ncoe * 3 * 8);
+  /* the space of an earlier file is reused if large enough */
+  if (pdp->nsegbuf < pdp->ncoe * 3) {
+    pdp->segbuf = (double *) swi_arena_alloc(&swed.arena, (size_t) pdp->ncoe * 3 * 8);
+    pdp->nsegbuf = (pdp->segbuf != NULL) ? pdp->ncoe * 3 : 0;
+  }
+  if ((pdp->segp = pdp->segbuf) == NULL) {
+    if (serr != NULL)
+      strcpy(serr, "error in get_new_segment(): out of memory for ephemeris segment");
+    return ERR;
+  }
   memset((void *) pdp->segp, 0, (size_t) pdp->ncoe * 3 * 8);
   /* read coefficients for 3 coordinates */
   for (icoord = 0; icoord < 3; icoord++) {
@@ -4431,7 +4588,6 @@ static int get_new_segment(double tjd, int ipli, int ifno, char *serr)
 	  sprintf(serr, "error in ephemeris file %s: %d coefficients instead of %d. ", fdp->fnam, nco, pdp->ncoe);
 	}
       }
-      free(pdp->segp);
       pdp->segp = NULL;
       return (ERR);
     }
@@ -4492,6 +4648,8 @@ static int get_new_segment(double tjd, int ipli, int ifno, char *serr)
       }
     }
   }
+  SWI_STAT_ADD(SE_STAT_SEG_LOADS, 1);
+  SWI_STAT_ADD(SE_STAT_SEG_BYTES, ftell(fp) - fpos + 3);
   return(OK);
 return_error_gns:
   fclose(fdp->fptr);
@@ -4501,15 +4659,104 @@ return_error_gns:
   return ERR;
 }
 
+/* save area of a body on ephemeris file */
+static struct plan_data *file_plan_data(int ipli)
+{
+  if (ipli >= SE_AST_OFFSET)
+    return &swed.pldat[SEI_ANYBODY];
+  if (ipli >= SE_PLMOON_OFFSET)
+    return &swed.pldat[SEI_ANYBODY];
+  return &swed.pldat[ipli];
+}
+
+/* takes over the constants of an ephemeris file read by read_const(),
+ * possibly in another thread */
+static void use_file_header(int ifno, struct file_header *fh)
+{
+  int kpl;
+  struct plan_data *pdp;
+  struct file_data *fdp = &swed.fidat[ifno];
+  FILE *fptr = fdp->fptr;
+  *fdp = fh->fd;
+  fdp->fptr = fptr;
+  swed.gcdat = fh->gcdat;
+  if (ifno == SEI_FILE_ANY_AST) {
+    swed.astelem = fh->astelem;
+    swed.ast_G = fh->ast_G;
+    swed.ast_H = fh->ast_H;
+    swed.ast_diam = fh->ast_diam;
+  }
+  for (kpl = 0; kpl < fdp->npl; kpl++) {
+    pdp = file_plan_data(fdp->ipl[kpl]);
+    /* if switch to other eph. file, see read_const() */
+    if ((fh->pd[kpl].iflg & SEI_FLG_ELLIPSE) && pdp->refep != NULL)
+      pdp->segp = NULL;
+    memcpy((void *) pdp, (void *) &fh->pd[kpl], offsetof(struct plan_data, tseg0));
+  }
+}
+
+/* registers the constants just read by read_const(), so that other
+ * threads need not read them; the reference ellipses belong to the 
+ * registered header from now on. Returns ERR if there is no memory for
+ * the header; the caller then frees the reference ellipses. */
+static int share_file_header(int ifno, char *hkey, long fsize, char *sastelem, char *serr)
+{
+  int kpl;
+  struct plan_data *pdp;
+  struct file_data *fdp = &swed.fidat[ifno];
+  struct file_header *fh, *fhreg;
+  size_t size = sizeof(struct file_header) + (fdp->npl - 1) * sizeof(struct plan_data);
+  if ((fh = (struct file_header *) calloc(1, size)) == NULL) {
+    if (serr != NULL)
+      strcpy(serr, "could not allocate memory for ephemeris file header");
+    return ERR;
+  }
+  fh->flen = fsize;
+  fh->fd = *fdp;
+  fh->fd.fptr = NULL;
+  fh->gcdat = swed.gcdat;
+  if (ifno == SEI_FILE_ANY_AST) {
+    strcpy(fh->astelem, sastelem);
+    fh->ast_G = swed.ast_G;
+    fh->ast_H = swed.ast_H;
+    fh->ast_diam = swed.ast_diam;
+  }
+  for (kpl = 0; kpl < fdp->npl; kpl++) {
+    pdp = file_plan_data(fdp->ipl[kpl]);
+    memcpy((void *) &fh->pd[kpl], (void *) pdp, offsetof(struct plan_data, tseg0));
+  }
+  fhreg = (struct file_header *) swi_shared_put(SWI_SHARED_FILEHDR, hkey, fh, NULL);
+  if (fhreg != fh) {
+    /* another thread was faster */
+    for (kpl = 0; kpl < fdp->npl; kpl++) {
+      pdp = file_plan_data(fdp->ipl[kpl]);
+      if (fh->pd[kpl].refep != NULL)
+	free((void *) fh->pd[kpl].refep);
+      pdp->refep = fhreg->pd[kpl].refep;
+    }
+    free(fh);
+  }
+  if (ifno == SEI_FILE_ANY_AST)
+    swed.astelem = fhreg->astelem;
+  return OK;
+}
+
 /* SWISSEPH
  * reads constants on ephemeris file
  * ifno         file #
  * serr         error string
+ * The constants of a file are read once per process and then taken
+ * from the shared header, see sweshare.c.
  */
 static int read_const(int ifno, char *serr) 
 { 
   char *c, c2, *sp;
   char s[AS_MAXCH*2], s2[AS_MAXCH];
+  char sastelem[AS_MAXCH*2];
+  char hkey[AS_MAXCH + 20];
+  long fsize;
+  double *refep_new[SEI_FILE_NMAXPLAN];
+  struct file_header *fh;
   char sastnam[41];
   int i, ipli, kpl;
   int retc;
@@ -4528,6 +4775,19 @@ static int read_const(int ifno, char *serr)
   char *smsg = "";
   int nbytes_ipl = 2;
   fp = fdp->fptr;
+  memset((void *) refep_new, 0, sizeof(refep_new));
+  /************************************* 
+   * read by this or another thread?   *
+   *************************************/
+  if (fseek(fp, 0L, SEEK_END) != 0)
+    goto file_damage;
+  fsize = ftell(fp);
+  sprintf(hkey, "%s|%ld", fdp->fnam, fsize);
+  if ((fh = (struct file_header *) swi_shared_get(SWI_SHARED_FILEHDR, hkey)) != NULL) {
+    use_file_header(ifno, fh);
+    return OK;
+  }
+  rewind(fp);
   /************************************* 
    * version number of file            *
    *************************************/
@@ -4605,7 +4865,7 @@ static int read_const(int ifno, char *serr)
     strncpy(sastnam, s, lastnam+i);	// fixed 19-nov-19
     *(sastnam+lastnam+i) = '\0';
     /* save elements, they are required for swe_plan_pheno() */
-    strcpy(swed.astelem, s);
+    strcpy(sastelem, s);
     /* required for magnitude */
     swed.ast_H = atof(s + 35 + i);
     swed.ast_G = atof(s + 42 + i);
@@ -4797,13 +5057,7 @@ fendian, ifno, serr);
   for (kpl = 0; kpl < fdp->npl; kpl++) {
     /* get SEI_ planet number */
     ipli = fdp->ipl[kpl];
-    if (ipli >= SE_AST_OFFSET) {
-      pdp = &swed.pldat[SEI_ANYBODY];
-    } else if (ipli >= SE_PLMOON_OFFSET) {
-      pdp = &swed.pldat[SEI_ANYBODY];
-    } else {
-      pdp = &swed.pldat[ipli];
-    }
+    pdp = file_plan_data(ipli);
     pdp->ibdy = ipli;
     /* file position of planet's index */
     retc = do_fread((void *) &pdp->lndx0, 4, 1, 4, fp, SEI_CURR_FPOS,
@@ -4853,23 +5107,21 @@ fendian, ifno, serr);
     /* if reference ellipse is used, read its coefficients */
     if (pdp->iflg & SEI_FLG_ELLIPSE) {
       if (pdp->refep != NULL) { /* if switch to other eph. file */
-        free((void *) pdp->refep);
-	pdp->refep = NULL;    /* 2015-may-5 */  
-        if (pdp->segp != NULL) {        
-          free((void *) pdp->segp);     /* array of coefficients of */
-          pdp->segp = NULL;     /* ephemeris segment        */  
-        }
+	pdp->refep = NULL;    /* 2015-may-5; belongs to shared header */  
+        pdp->segp = NULL;     /* array of coefficients of ephemeris segment */
       }
       pdp->refep = (double *) malloc((size_t) pdp->ncoe * 2 * 8); 
+      refep_new[kpl] = pdp->refep;
       retc = do_fread((void *) pdp->refep, 8, 2*pdp->ncoe, 8, fp,
 SEI_CURR_FPOS, freord, fendian, ifno, serr); 
       if (retc != OK) {
-	free(pdp->refep);  /* 2015-may-5 */
 	pdp->refep = NULL;  /* 2015-may-5 */
 	goto return_error;
       }
     }/**/
   }
+  if (share_file_header(ifno, hkey, fsize, sastelem, serr) == ERR)
+    goto return_error;
   return(OK);
 file_damage:
   if (serr != NULL) {
@@ -4882,6 +5134,10 @@ return_error:
   fclose(fdp->fptr);
   // free(fdp->fptr);  is not from malloc(), must not be freed by us
   fdp->fptr = NULL;
+  for (i = 0; i < SEI_FILE_NMAXPLAN; i++) {
+    if (refep_new[i] != NULL)	/* 2015-may-5 */
+      free((void *) refep_new[i]);
+  }
   free_planets();
   return(ERR);
 }
@@ -5308,13 +5564,15 @@ static int lunar_osc_elem(double tjd, int ipl, int32 iflag, char *serr)
         } else  {
 	  t = tjd;
 	}
-	retc = swemoon(t, iflag | SEFLG_SPEED, NO_SAVE, xpos[i], serr);/**/
+	/* the osculating apogee depends on the lunar speed, which the
+	 * truncated series of SEFLG_FAST do not give precisely enough */
+	retc = swemoon(t, (iflag | SEFLG_SPEED) & ~SEFLG_FAST, NO_SAVE, xpos[i], serr);/**/
 	if (retc == ERR)
 	  return(ERR);
 	/* light-time-corrected moon for apparent node (~ 0.006") */
 	if ((iflag & SEFLG_TRUEPOS) == 0 && retc >= OK) { 
 	  dt = sqrt(square_sum(xpos[i])) * AUNIT / CLIGHT / 86400.0;     
-	  retc = swemoon(t-dt, iflag | SEFLG_SPEED, NO_SAVE, xpos[i], serr);/**/
+	  retc = swemoon(t-dt, (iflag | SEFLG_SPEED) & ~SEFLG_FAST, NO_SAVE, xpos[i], serr);/**/
 	  if (retc == ERR)
 	    return(ERR);
         }
@@ -6032,9 +6290,8 @@ void swi_check_ecliptic(double tjd, int32 iflag)
 void swi_check_nutation(double tjd, int32 iflag)
 {
   int32 speedf1, speedf2;
-  static TLS int32 nutflag = 0;
   double t;
-  speedf1 = nutflag & SEFLG_SPEED;
+  speedf1 = swed.nutflag & SEFLG_SPEED;
   speedf2 = iflag & SEFLG_SPEED;
   if (!(iflag & SEFLG_NONUT)
 	&& (tjd != swed.nut.tnut || tjd == 0
@@ -6043,7 +6300,7 @@ void swi_check_nutation(double tjd, int32 iflag)
     swed.nut.tnut = tjd;
     swed.nut.snut = sin(swed.nut.nutlo[1]);
     swed.nut.cnut = cos(swed.nut.nutlo[1]);
-    nutflag = iflag;
+    swed.nutflag = iflag;
     nut_matrix(&swed.nut, &swed.oec);
     if (iflag & SEFLG_SPEED) {
       /* once more for 'speed' of nutation, which is needed for 
@@ -6055,6 +6312,8 @@ void swi_check_nutation(double tjd, int32 iflag)
       swed.nutv.cnut = cos(swed.nutv.nutlo[1]);
       nut_matrix(&swed.nutv, &swed.oec);
     } 
+  } else if (!(iflag & SEFLG_NONUT)) {
+    SWI_STAT_ADD(SE_STAT_NUT_HITS, 1);
   } 
 } 
 
@@ -6106,6 +6365,9 @@ static int32 plaus_iflag(int32 iflag, int32 ipl, double tjd, char *serr)
   if (epheflag == 0)
     epheflag = SEFLG_DEFAULTEPH;
   iflag = (iflag & ~SEFLG_EPHMASK) | epheflag;
+  /* SEFLG_FAST does not reproduce JPL Horizons */
+  if (iflag & SEFLG_FAST)
+    iflag = iflag & ~(SEFLG_JPLHOR | SEFLG_JPLHOR_APPROX);
   /* SEFLG_JPLHOR only with JPL and Swiss Ephemeeris */
   if (!(epheflag & SEFLG_JPLEPH)) 
     iflag = iflag & ~(SEFLG_JPLHOR | SEFLG_JPLHOR_APPROX);
@@ -6174,16 +6436,22 @@ static int32 fixstar_format_search_name(char *star, char *sstar, char *serr)
 
 /* function saves a fixstar in fixed stars list
  */
-static int32 save_star_in_struct(int nrecs, struct fixed_star *fstp, char *serr)
+static int32 save_star_in_struct(struct fixstar_catalog *cat, int nrecs, struct fixed_star *fstp, char *serr)
 {
   int sizestru = sizeof(struct fixed_star);
-  struct fixed_star *ftarget;
+  struct fixed_star *ftarget, *stars;
   char *serr_alloc = "error in function load_all_fixed_stars(): could not resize fixed stars array";
-  if ((swed.fixed_stars = (struct fixed_star *) realloc(swed.fixed_stars, nrecs * sizestru)) == NULL) {
-    if (serr != NULL) strcpy(serr, serr_alloc);
-    return ERR;
+  /* the array grows by half its size, not by one record */
+  if (nrecs > cat->n_alloc) {
+    int n_alloc = cat->n_alloc + cat->n_alloc / 2 + 256;
+    if ((stars = (struct fixed_star *) realloc(cat->stars, n_alloc * sizestru)) == NULL) {
+      if (serr != NULL) strcpy(serr, serr_alloc);
+      return ERR;
+    }
+    cat->stars = stars;
+    cat->n_alloc = n_alloc;
   }
-  ftarget = swed.fixed_stars + (nrecs - 1);
+  ftarget = cat->stars + (nrecs - 1);
   memcpy((void *) ftarget, (void *) fstp, sizestru);
   return OK;
 }
@@ -6303,9 +6571,28 @@ int32 fixstar_cut_string(char *srecord, char *star, struct fixed_star *stardata,
   return OK;
 }
 
+static void free_fixstar_catalog(void *p)
+{
+  struct fixstar_catalog *cat = (struct fixstar_catalog *) p;
+  free(cat->stars);
+  free(cat);
+}
+
+/* attaches the thread to a shared star catalogue */
+static void use_fixstar_catalog(struct fixstar_catalog *cat)
+{
+  swed.fixstar_cat = cat;
+  swed.fixed_stars = cat->stars;
+  swed.n_fixstars_real = cat->n_real;
+  swed.n_fixstars_named = cat->n_named;
+  swed.n_fixstars_records = cat->n_records;
+}
+
 /* function loads all fixed stars from file sefstars.txt,
  * into swed.fixed_stars, which is a pointer to an array
  * of struct fixed_stars.
+ * The array is read by the first thread and shared by the others,
+ * see sweshare.c.
  * Every star has a record with its Bayer/Flamsteed designation 
  * as its search key.
  * Every star also has a record with its sequential number in
@@ -6326,6 +6613,8 @@ static int32 load_all_fixed_stars(char *serr)
   char s[AS_MAXCH], *sp;
   char srecord[AS_MAXCH];
   struct fixed_star fstdata;
+  struct fixstar_catalog *cat;
+  char *fnam = swed.fidat[SEI_FILE_FIXSTAR].fnam;
   char last_starbayer[SWI_STAR_LENGTH + 1];
   *last_starbayer = '\0';
   if (swed.n_fixstars_records > 0) {
@@ -6341,8 +6630,15 @@ static int32 load_all_fixed_stars(char *serr)
       }
     }
   }
+  if ((cat = (struct fixstar_catalog *) swi_shared_get(SWI_SHARED_FIXSTARS, fnam)) != NULL) {
+    use_fixstar_catalog(cat);
+    return OK;
+  }
+  if ((cat = (struct fixstar_catalog *) calloc(1, sizeof(struct fixstar_catalog))) == NULL) {
+    if (serr != NULL) strcpy(serr, "error in function load_all_fixed_stars(): could not allocate fixed stars list");
+    return ERR;
+  }
   rewind(swed.fixfp);
-  swed.fixed_stars = NULL;
   while (fgets(s, AS_MAXCH, swed.fixfp) != NULL) {
     // skip comment lines
     if (*s == '#') continue;
@@ -6351,7 +6647,7 @@ static int32 load_all_fixed_stars(char *serr)
     if (*s == '\0') continue;
     strcpy(srecord, s);
     retc = fixstar_cut_string(srecord, NULL, &fstdata, serr);
-    if (retc == ERR) return ERR;
+    if (retc == ERR) goto return_err;
     // if star has a traditional name, save it with that name as its search key
     if (*fstdata.starname != '\0') {
       nrecs++;
@@ -6363,7 +6659,7 @@ static int32 load_all_fixed_stars(char *serr)
       // star name to lowercase and compare with search string
       for (sp = fstdata.skey; *sp != '\0'; sp++) 
 	*sp = tolower((int) *sp);
-      if ((retc = save_star_in_struct(nrecs, &fstdata, serr)) == ERR) return ERR;
+      if ((retc = save_star_in_struct(cat, nrecs, &fstdata, serr)) == ERR) goto return_err;
     }
     // also save it with Bayer designation as search key;
     // only if it has not been saved already
@@ -6377,19 +6673,24 @@ static int32 load_all_fixed_stars(char *serr)
     while ((sp = strchr(fstdata.skey, ' ')) != NULL)
       swi_strcpy(sp, sp+1);
     strcpy(last_starbayer, fstdata.starbayer);
-    if ((retc = save_star_in_struct(nrecs, &fstdata, serr)) == ERR) return ERR;
+    if ((retc = save_star_in_struct(cat, nrecs, &fstdata, serr)) == ERR) goto return_err;
     // also save it with sequential star number as search key (NO!!!!)
     // nrecs++;
     // sprintf(fstdata.skey, "%07d", nstars);
     // if ((retc = save_star_in_struct(nrecs, &fstdata, serr)) == ERR) return ERR;
   }
-  swed.n_fixstars_real = nstars;
-  swed.n_fixstars_named = nnamed;
-  swed.n_fixstars_records = nrecs;
+  cat->n_real = nstars;
+  cat->n_named = nnamed;
+  cat->n_records = nrecs;
   // fprintf(stderr, "nstars=%d, nrecords=%d\n", nstars, nrecs);	
-  (void) qsort ((void *) swed.fixed_stars, (size_t) nrecs, sizeof (struct fixed_star),
+  (void) qsort ((void *) cat->stars, (size_t) nrecs, sizeof (struct fixed_star),
                     (int (CMP_CALL_CONV *)(const void *,const void *))(fixedstar_name_compare));
+  use_fixstar_catalog((struct fixstar_catalog *) swi_shared_put(SWI_SHARED_FIXSTARS, fnam, cat, free_fixstar_catalog));
+  SWI_STAT_ADD(SE_STAT_FIXSTAR_LOADS, 1);
   return retc;
+return_err:
+  free_fixstar_catalog(cat);
+  return ERR;
 }
 
 /* function calculates a fixstar from a star data struct 
@@ -6437,6 +6738,7 @@ static int32 fixstar_calc_from_struct(struct fixed_star *stardata, double tjd, i
     }
     swed.last_epheflag = epheflag;
   }
+  check_fast_flag(iflag);
   /* high precision speed prevails fast speed */
   /* JPL Horizons is only reproduced with SEFLG_JPLEPH */
   if (iflag & SEFLG_SIDEREAL && !swed.ayana_is_set)
@@ -6819,9 +7121,7 @@ int32 CALL_CONV swe_fixstar2(char *star, double tjd, int32 iflag,
   int i;
   AS_BOOL is_builtin_star = FALSE;
   char sstar[SWI_STAR_LENGTH + 1];
-  //static TLS char slast_stardata[AS_MAXCH];
-  static TLS char slast_starname[AS_MAXCH];
-  static TLS struct fixed_star last_stardata;
+  struct star_cache *last = &swed.last_fixstar2;
   char srecord[AS_MAXCH + 20];	/* 20 byte for SE_STARFILE */
   int retc;
   struct fixed_star stardata;
@@ -6831,14 +7131,14 @@ int32 CALL_CONV swe_fixstar2(char *star, double tjd, int32 iflag,
   swi_open_trace(serr);
   trace_swe_fixstar(1, star, tjd, iflag, xx, serr);
 #endif /* TRACE */
-  load_all_fixed_stars(serr); // loads stars unless loaded with an earlier call of function
+  SWI_STAT_TIMED(SE_STAT_FIXSTAR_NS, load_all_fixed_stars(serr)); // loads stars unless loaded with an earlier call of function
   retc = fixstar_format_search_name(star, sstar, serr);
   if (retc == ERR)
     goto return_err;
   /* star elements from last call: */
-  if (swed.n_fixstars_records > 0 && strcmp(slast_starname, sstar) == 0) {
+  if (swed.n_fixstars_records > 0 && strcmp(last->sname, sstar) == 0) {
  //   strcpy(srecord, slast_stardata);
-    stardata = last_stardata;
+    stardata = last->stardata;
     goto found;
   }
   if (get_builtin_star(star, sstar, srecord)) {
@@ -6856,8 +7156,8 @@ int32 CALL_CONV swe_fixstar2(char *star, double tjd, int32 iflag,
   /******************************************************/
   found:
   //strcpy(slast_stardata, srecord);
-  last_stardata = stardata;
-  strcpy(slast_starname, sstar);
+  last->stardata = stardata;
+  strcpy(last->sname, sstar);
   if ((retc = fixstar_calc_from_struct(&stardata, tjd, iflag, star, xx, serr)) == ERR)
     goto return_err;
 #ifdef TRACE
@@ -6909,21 +7209,19 @@ int32 CALL_CONV swe_fixstar2_ut(char *star, double tjd_ut, int32 iflag,
 int32 CALL_CONV swe_fixstar2_mag(char *star, double *mag, char *serr)
 {
   char sstar[SWI_STAR_LENGTH + 1];
-  //static TLS char slast_stardata[AS_MAXCH];
-  static TLS char slast_starname[AS_MAXCH];
-  static TLS struct fixed_star last_stardata;
+  struct star_cache *last = &swed.last_fixstar2_mag;
   int retc;
   struct fixed_star stardata;
   if (serr != NULL)
     *serr = '\0';
-  load_all_fixed_stars(serr); // loads stars unless loaded with an earlier call of function
+  SWI_STAT_TIMED(SE_STAT_FIXSTAR_NS, load_all_fixed_stars(serr)); // loads stars unless loaded with an earlier call of function
   retc = fixstar_format_search_name(star, sstar, serr);
   if (retc == ERR)
     goto return_err;
   /* star elements from last call: */
-  if (swed.n_fixstars_records > 0 && strcmp(slast_starname, sstar) == 0) {
+  if (swed.n_fixstars_records > 0 && strcmp(last->sname, sstar) == 0) {
  //   strcpy(srecord, slast_stardata);
-    stardata = last_stardata;
+    stardata = last->stardata;
     goto found;
   }
   retc = search_star_in_list(sstar, &stardata, serr);
@@ -6931,8 +7229,8 @@ int32 CALL_CONV swe_fixstar2_mag(char *star, double *mag, char *serr)
     goto return_err;
   /******************************************************/
   found:
-  last_stardata = stardata;
-  strcpy(slast_starname, sstar);
+  last->stardata = stardata;
+  strcpy(last->sname, sstar);
   *mag = stardata.mag;
   sprintf(star, "%s,%s", stardata.starname, stardata.starbayer);
   return OK;
@@ -6941,6 +7239,139 @@ int32 CALL_CONV swe_fixstar2_mag(char *star, double *mag, char *serr)
   return retc;
 }
 
+/* seasnam.txt is read once into a table sorted by catalogue number and
+ * shared by all threads. If a number appears more than once, the first
+ * line counts, as it did when the file was searched for every call. */
+static struct astnam_table astnam_none = {0, NULL, NULL};
+
+static void free_astnam_table(void *p)
+{
+  struct astnam_table *tab = (struct astnam_table *) p;
+  if (tab == NULL)
+    return;
+  if (tab->entries != NULL)
+    free(tab->entries);
+  if (tab->names != NULL)
+    free(tab->names);
+  free(tab);
+}
+
+static int astnam_compare(const void *a, const void *b)
+{
+  const struct astnam_entry *e1 = (const struct astnam_entry *) a;
+  const struct astnam_entry *e2 = (const struct astnam_entry *) b;
+  if (e1->ast_no != e2->ast_no)
+    return e1->ast_no < e2->ast_no ? -1 : 1;
+  return e1->iseq < e2->iseq ? -1 : (e1->iseq > e2->iseq);
+}
+
+static struct astnam_table *read_astnam_table(FILE *fp)
+{
+  struct astnam_table *tab;
+  struct astnam_entry *ep;
+  int32 nalloc = 0, lnames = 0, nnames = 0, len, iseq = 0, i, n;
+  char s[AS_MAXCH], *sp, *sp2;
+  void *p;
+  if ((tab = (struct astnam_table *) calloc(1, sizeof(struct astnam_table))) == NULL)
+    return NULL;
+  while ((sp = fgets(s, AS_MAXCH, fp)) != NULL) {
+    while (*sp == ' ' || *sp == '\t' 
+	   || *sp == '(' || *sp == '[' || *sp == '{')
+      sp++;
+    if (*sp == '#' || *sp == '\r' || *sp == '\n' || *sp == '\0')
+      continue;
+    if (tab->n >= nalloc) {
+      nalloc += nalloc / 2 + 1024;
+      if ((p = realloc(tab->entries, nalloc * sizeof(struct astnam_entry))) == NULL)
+	goto return_err;
+      tab->entries = (struct astnam_entry *) p;
+    }
+    ep = &tab->entries[tab->n++];
+    /* catalog number of body of current line */
+    ep->ast_no = atoi(sp);
+    ep->iname = -1;
+    ep->iseq = iseq++;
+    /* set pointer after catalog number */
+    if ((sp = strpbrk(sp, " \t")) == NULL)
+      continue; /* there is no name */
+    while (*sp == ' ' || *sp == '\t')
+      sp++;
+    if ((sp2 = strpbrk(sp, "#\r\n")) != NULL)
+      *sp2 = '\0'; 
+    if (*sp == '\0')
+      continue;
+    swi_right_trim(sp);
+    len = (int32) strlen(sp) + 1;
+    if (nnames + len > lnames) {
+      lnames += lnames / 2 + 16 * AS_MAXCH;
+      if ((p = realloc(tab->names, lnames)) == NULL)
+	goto return_err;
+      tab->names = (char *) p;
+    }
+    strcpy(tab->names + nnames, sp);
+    ep->iname = nnames;
+    nnames += len;
+  }
+  qsort(tab->entries, tab->n, sizeof(struct astnam_entry), astnam_compare);
+  for (i = 0, n = 0; i < tab->n; i++) {
+    if (n > 0 && tab->entries[i].ast_no == tab->entries[n - 1].ast_no)
+      continue;
+    tab->entries[n++] = tab->entries[i];
+  }
+  tab->n = n;
+  return tab;
+return_err:
+  free_astnam_table(tab);
+  return NULL;
+}
+
+/* name of asteroid ast_no in seasnam.txt, NULL if there is none */
+static const char *get_asteroid_name(int32 ast_no)
+{
+  struct astnam_table *tab = NULL;
+  FILE *fp;
+  char hkey[2 * AS_MAXCH];
+  int32 lo, hi, i;
+  if (swed.astnam == NULL) {
+    swed.astnam = &astnam_none;
+    if ((fp = swi_fopen(-1, SE_ASTNAMFILE, swed.ephepath, NULL)) != NULL) {
+      swi_shared_file_key(fp, SE_ASTNAMFILE, swed.ephepath, hkey);
+      if ((tab = (struct astnam_table *) swi_shared_get(SWI_SHARED_ASTNAMES, hkey)) == NULL
+	  && (tab = read_astnam_table(fp)) != NULL)
+	tab = (struct astnam_table *) swi_shared_put(SWI_SHARED_ASTNAMES, hkey, tab, free_astnam_table);
+      fclose(fp);
+      if (tab != NULL)
+	swed.astnam = tab;
+    }
+  }
+  tab = swed.astnam;
+  lo = 0;
+  hi = tab->n - 1;
+  while (lo <= hi) {
+    i = (lo + hi) / 2;
+    if (tab->entries[i].ast_no < ast_no) {
+      lo = i + 1;
+    } else if (tab->entries[i].ast_no > ast_no) {
+      hi = i - 1;
+    } else {
+      if (tab->entries[i].iname < 0)
+	return NULL;
+      return tab->names + tab->entries[i].iname;
+    }
+  }
+  return NULL;
+}
+
+/* drops the name and element tables, so that swe_set_ephe_path() 
+ * makes the files be read again */
+static void release_text_tables(void)
+{
+  if (swed.astnam != NULL && swed.astnam != &astnam_none)
+    swi_shared_release(swed.astnam, free_astnam_table);
+  swed.astnam = NULL;
+  swi_release_fict_table();
+}
+
 char *CALL_CONV swe_get_planet_name(int ipl, char *s) 
 {
   int i;
@@ -7061,7 +7492,7 @@ char *CALL_CONV swe_get_planet_name(int ipl, char *s)
 	}
         /* If there is a provisional designation only in ephemeris file,
          * we look for a name in seasnam.txt, which can be updated by
-         * the user.
+         * the user. The file is read again after swe_set_ephe_path().
          * Some old ephemeris files return a '?' in the first position.
          * There are still a couple of unnamed bodies that got their
          * provisional designation before 1925, when the current method
@@ -7074,36 +7505,9 @@ char *CALL_CONV swe_get_planet_name(int ipl, char *s)
          * The asteroid number may or may not be in brackets
          */
         if (ipl > SE_AST_OFFSET && (s[0] == '?' || isdigit((int) s[1]))) {
-          int ipli = (int) (ipl - SE_AST_OFFSET), iplf = 0;
-          FILE *fp;
-          char si[AS_MAXCH], *sp, *sp2;
-          if ((fp = swi_fopen(-1, SE_ASTNAMFILE, swed.ephepath, NULL)) != NULL) {
-            while(ipli != iplf && (sp = fgets(si, AS_MAXCH, fp)) != NULL) {
-              while (*sp == ' ' || *sp == '\t' 
-                     || *sp == '(' || *sp == '[' || *sp == '{')
-                sp++;
-              if (*sp == '#' || *sp == '\r' || *sp == '\n' || *sp == '\0')
-                continue;
-              /* catalog number of body of current line */
-              iplf = atoi(sp);
-              if (ipli != iplf)
-                continue;
-              /* set pointer after catalog number */
-              sp = strpbrk(sp, " \t");
-              if (sp == NULL)
-                continue; /* there is no name */
-              while (*sp == ' ' || *sp == '\t')
-                sp++;
-              sp2 = strpbrk(sp, "#\r\n");
-              if (sp2 != NULL)
-                *sp2 = '\0'; 
-              if (*sp == '\0')
-                continue;
-              swi_right_trim(sp);
-              strcpy(s, sp);
-            }
-            fclose(fp);
-          }
+          const char *sname = get_asteroid_name((int32) (ipl - SE_AST_OFFSET));
+          if (sname != NULL)
+            strcpy(s, sname);
         }
       } else  {
 	i = ipl;
@@ -7645,6 +8049,7 @@ static int32 swi_fixstar_calc_from_record(char *srecord, double tjd, int32 iflag
     }
     swed.last_epheflag = epheflag;
   }
+  check_fast_flag(iflag);
   /* high precision speed prevails fast speed */
   /* JPL Horizons is only reproduced with SEFLG_JPLEPH */
   if (iflag & SEFLG_SIDEREAL && !swed.ayana_is_set)
@@ -7896,8 +8301,7 @@ int32 CALL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
 {
   int i;
   char sstar[SWI_STAR_LENGTH + 1];
-  static TLS char slast_stardata[AS_MAXCH];
-  static TLS char slast_starname[AS_MAXCH];
+  struct star_cache *last = &swed.last_fixstar;
   char srecord[AS_MAXCH + 20], *sp;	/* 20 byte for SE_STARFILE */
   int retc;
   if (serr != NULL)
@@ -7918,8 +8322,8 @@ int32 CALL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
       *sp = '\0';
   }
   /* star elements from last call: */
-  if (*slast_stardata != '\0' && strcmp(slast_starname, sstar) == 0) {
-    strcpy(srecord, slast_stardata);
+  if (*last->srecord != '\0' && strcmp(last->sname, sstar) == 0) {
+    strcpy(srecord, last->srecord);
     goto found;
   }
   if (get_builtin_star(star, sstar, srecord)) {
@@ -7935,8 +8339,8 @@ int32 CALL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
   if ((retc = swi_fixstar_load_record(star, srecord, NULL, NULL, NULL, serr)) != OK)
     goto return_err;
   found:
-  strcpy(slast_stardata, srecord);
-  strcpy(slast_starname, sstar);
+  strcpy(last->srecord, srecord);
+  strcpy(last->sname, sstar);
   if ((retc = swi_fixstar_calc_from_record(srecord, tjd, iflag, star, xx, serr)) == ERR)
     goto return_err;
 #ifdef TRACE
@@ -7988,8 +8392,7 @@ int32 CALL_CONV swe_fixstar_ut(char *star, double tjd_ut, int32 iflag,
 int32 CALL_CONV swe_fixstar_mag(char *star, double *mag, char *serr)
 {
   char sstar[SWI_STAR_LENGTH + 1];
-  static TLS char slast_stardata[AS_MAXCH];
-  static TLS char slast_starname[AS_MAXCH];
+  struct star_cache *last = &swed.last_fixstar_mag;
   char srecord[AS_MAXCH + 20], *sp;	/* 20 byte for SE_STARFILE */
   struct fixed_star stardata;
   int retc;
@@ -8008,8 +8411,8 @@ int32 CALL_CONV swe_fixstar_mag(char *star, double *mag, char *serr)
       *sp = '\0';
   }
   /* star elements from last call: */
-  if (*slast_stardata != '\0' && strcmp(slast_starname, sstar) == 0) {
-    strcpy(srecord, slast_stardata);
+  if (*last->srecord != '\0' && strcmp(last->sname, sstar) == 0) {
+    strcpy(srecord, last->srecord);
     retc = fixstar_cut_string(srecord, star, &stardata, serr);
     if (retc == ERR) goto return_err;
     // magnitude V
@@ -8026,8 +8429,8 @@ int32 CALL_CONV swe_fixstar_mag(char *star, double *mag, char *serr)
   if ((retc = swi_fixstar_load_record(star, srecord, NULL, NULL, dparams, serr)) != OK)
     goto return_err;
   found:
-  strcpy(slast_stardata, srecord);
-  strcpy(slast_starname, sstar);
+  strcpy(last->srecord, srecord);
+  strcpy(last->sname, sstar);
   *mag = dparams[7];
   return OK;
   return_err:
@@ -8101,6 +8504,7 @@ int32 CALL_CONV swe_calc_pctr(double tjd, int32 ipl, int32 iplctr, int32 iflag,
         xxsp[i] = xxsv[i] - xxsp[i];
     }
     /* dt and t(apparent) */
+    SWI_STAT_ADD(SE_STAT_LT_ITER, niter + 1);
     for (j = 0; j <= niter; j++) {
       for (i = 0; i <= 2; i++) {
         dx[i] = xx[i];
@@ -8611,3 +9015,410 @@ int32 CALL_CONV swe_helio_cross_ut(int ipl, double x2cross, double jd_ut, int if
   *jd_cross = jd;
   return OK;
 }
+
+/*************************************************
+ * Batch versions of the crossing functions above.
+ *
+ * Element i of a batch is the crossing the scalar function would find
+ * for x2cross[i] and jd_et[i] (or jd_ut[i]), to within CROSS_PRECISION,
+ * with one exception: backward heliocentric searches (dir < 0). For
+ * these, swe_helio_cross() seeds Newton's method from the speed at the
+ * start time, and for an eccentric orbit it can converge on a crossing
+ * one period too early (Mercury, x2cross 250, jd 2453654: 2453478.92
+ * instead of 2453566.89). The batch always returns the nearest crossing
+ * in the direction of search: after Newton's method has converged, the
+ * time elapsed since the start is compared with the mean motion of the
+ * body (swe_get_orbital_elements()), and a crossing whole revolutions
+ * away is moved back to the nearest one.
+ * The elements are worked off in order of their start times. The
+ * ephemeris evaluations of each Newton iteration are kept in a small
+ * cache; the longitude at the start time and the seed of the next
+ * iteration are predicted from the nearest cached evaluation instead of
+ * calling swe_calc() at the start time and starting from mean motion.
+ * Batches of neighbouring crossings (every degree of a year, a Moon
+ * ingress table, returns of many charts in the same year) then need
+ * about two ephemeris calls per crossing instead of five or more.
+ * Where a prediction is not safe, the scalar function is called.
+ *
+ * Failed elements get jd_cross[i] = jd_et[i] - 1, as the scalar functions
+ * return, or 0 for swe_helio_cross_multi(). The functions return OK, or
+ * ERR if any element failed; serr then holds the first error.
+ *************************************************/
+#define CROSS_NSAMPLE	16	/* cached evaluations */
+#define CROSS_MAXITER	30
+#define CROSS_PRED_ERR	0.5	/* degrees, max. error of a predicted position */
+#define CROSS_NODE_HALF	13.6061	/* mean interval of node crossings, days */
+#define CROSS_NODE_MIN	12.5	/* shortest interval of node crossings */
+
+struct cross_cache {
+  double jd[CROSS_NSAMPLE], x[CROSS_NSAMPLE], v[CROSS_NSAMPLE];
+  int32 n, inext;
+};
+
+struct cross_order {
+  double jd;
+  int32 i;
+};
+
+static void cross_cache_add(struct cross_cache *pc, double jd, double x, double v)
+{
+  pc->jd[pc->inext] = jd;
+  pc->x[pc->inext] = x;
+  pc->v[pc->inext] = v;
+  pc->inext = (pc->inext + 1) % CROSS_NSAMPLE;
+  if (pc->n < CROSS_NSAMPLE)
+    pc->n++;
+}
+
+static int32 cross_cache_nearest(struct cross_cache *pc, double jd)
+{
+  int32 i, k = -1;
+  for (i = 0; i < pc->n; i++) {
+    if (k < 0 || fabs(pc->jd[i] - jd) < fabs(pc->jd[k] - jd))
+      k = i;
+  }
+  return k;
+}
+
+static int cross_order_compare(const void *a, const void *b)
+{
+  const struct cross_order *p1 = (const struct cross_order *) a;
+  const struct cross_order *p2 = (const struct cross_order *) b;
+  if (p1->jd != p2->jd)
+    return p1->jd < p2->jd ? -1 : 1;
+  return p1->i - p2->i;
+}
+
+/* indices of the elements in order of their start times */
+static struct cross_order *cross_sort(double *jd, int32 n, char *serr)
+{
+  struct cross_order *po;
+  int32 i;
+  if ((po = (struct cross_order *) malloc((n > 0 ? n : 1) * sizeof(struct cross_order))) == NULL) {
+    if (serr != NULL) strcpy(serr, "could not allocate memory for crossing batch");
+    return NULL;
+  }
+  for (i = 0; i < n; i++) {
+    po[i].jd = jd[i];
+    po[i].i = i;
+  }
+  qsort((void *) po, (size_t) n, sizeof(struct cross_order), cross_order_compare);
+  return po;
+}
+
+static int32 cross_calc(double jd, int32 ipl, int32 flag, AS_BOOL is_ut, double *x, char *serr)
+{
+  if (is_ut)
+    return swe_calc_ut(jd, ipl, flag, x, serr);
+  return swe_calc(jd, ipl, flag, x, serr);
+}
+
+/* 
+ * Max. acceleration in longitude (deg/day^2), used to bound the error of
+ * a linear prediction; negative if positions must not be predicted.
+ */
+static double cross_max_accel(int32 ipl, AS_BOOL helio)
+{
+  if (!helio) 
+    return (ipl == SE_MOON) ? 0.5 : 0.001;
+  if (ipl == SE_MERCURY)
+    return 0.2;
+  if (ipl == SE_EARTH || (ipl >= SE_VENUS && ipl <= SE_PLUTO) || ipl == SE_CHIRON)
+    return 0.02;
+  return -1;
+}
+
+/* one element of a longitude crossing batch; dir < 0 searches backward */
+/* hperiod is the mean sidereal period of a heliocentric body, 0 if unknown */
+static int32 cross_lon_one(int32 ipl, double x2cross, double t0, int32 flag, int32 dir, AS_BOOL is_ut, double hperiod, struct cross_cache *pc, double *jd_cross, char *serr)
+{
+  double x[6], x0 = 0, v0 = 0, err = 0, dist, dt, vseed, tc, d, m;
+  double amax, period = 0;
+  AS_BOOL helio = (flag & SEFLG_HELCTR) != 0 && ipl != SE_SUN;
+  AS_BOOL have = FALSE;
+  int32 k, iter, irev;
+  amax = cross_max_accel(ipl, helio);
+  if (!helio)
+    period = (ipl == SE_MOON) ? 27.32 : 365.24;
+  /* longitude at start time, exact or predicted */
+  if ((k = cross_cache_nearest(pc, t0)) >= 0) {
+    dt = t0 - pc->jd[k];
+    if (dt == 0) {
+      have = TRUE;
+    } else if (amax >= 0 && (err = 0.5 * amax * dt * dt) < CROSS_PRED_ERR) {
+      have = TRUE;
+    }
+    x0 = swe_degnorm(pc->x[k] + pc->v[k] * dt);
+    v0 = pc->v[k];
+  }
+  if (have) {
+    dist = (dir >= 0) ? swe_degnorm(x2cross - x0) : swe_degnorm(x0 - x2cross);
+    /* too close to tell whether the crossing is before or after t0 */
+    if (err > 0 && (dist < 2 * err || dist > 360 - 2 * err))
+      have = FALSE;
+  }
+  if (!have) {
+    if (cross_calc(t0, ipl, flag, is_ut, x, serr) < 0)
+      return ERR;
+    cross_cache_add(pc, t0, x[0], x[3]);
+    x0 = x[0];
+    v0 = x[3];
+  }
+  dist = (dir >= 0) ? swe_degnorm(x2cross - x0) : swe_degnorm(x0 - x2cross);
+  /* seed as the scalar functions do, then improve it from the cached
+   * evaluation nearest to it */
+  if (ipl == SE_MOON)
+    vseed = 360.0 / 27.32;
+  else if (!helio)
+    vseed = 360.0 / 365.24;
+  else if (ipl == SE_CHIRON)
+    vseed = 0.01971;
+  else
+    vseed = v0;
+  tc = t0 + (dir >= 0 ? dist : -dist) / vseed;
+  if (amax >= 0 && (k = cross_cache_nearest(pc, tc)) >= 0) {
+    dt = tc - pc->jd[k];
+    if (0.5 * amax * dt * dt < CROSS_PRED_ERR && pc->v[k] != 0)
+      tc = pc->jd[k] + swe_difdeg2n(x2cross, pc->x[k]) / pc->v[k];
+  }
+  for (irev = 0; ; irev++) {
+    for (iter = 0; ; iter++) {
+      if (iter == CROSS_MAXITER)
+	return 1;
+      if (cross_calc(tc, ipl, flag, is_ut, x, serr) < 0)
+	return ERR;
+      cross_cache_add(pc, tc, x[0], x[3]);
+      d = swe_difdeg2n(x2cross, x[0]);
+      tc += d / x[3];
+      if (fabs(d) < CROSS_PRECISION) break;
+    }
+    if (!helio || hperiod <= 0)
+      break;
+    /* whole revolutions between the crossing found and the nearest one:
+     * the time to cover dist differs from its mean by less than half
+     * a period unless the orbit is extremely eccentric */
+    m = floor(((dir >= 0 ? tc - t0 : t0 - tc) - dist / 360.0 * hperiod) / hperiod + 0.5);
+    if (m == 0)
+      break;
+    if (irev == 2)
+      return 1;
+    tc += (dir >= 0 ? -m : m) * hperiod;
+  }
+  /* wrong side of t0, or possibly a later crossing: let the scalar
+   * function decide */
+  if ((dir >= 0 && tc < t0) || (dir < 0 && tc > t0))
+    return 1;
+  if (period > 0 && fabs(tc - t0) > 0.9 * period)
+    return 1;
+  *jd_cross = tc;
+  return OK;
+}
+
+static int32 cross_lon_multi(int32 ipl, double *x2cross, double *jd_et, int32 n, int32 flag, int32 dir, AS_BOOL is_ut, double *jd_cross, char *serr)
+{
+  struct cross_cache cache;
+  struct cross_order *po;
+  int32 j, i, retc = OK, rc;
+  double dret[50], hperiod = 0;
+  char serr2[AS_MAXCH];
+  if (serr != NULL)
+    *serr = '\0';
+  if ((po = cross_sort(jd_et, n, serr)) == NULL)
+    return ERR;
+  memset((void *) &cache, 0, sizeof(struct cross_cache));
+  /* the mean motion hardly changes over a batch; without it, crossings
+   * are not moved (bodies without orbital elements) */
+  if ((flag & SEFLG_HELCTR) && ipl != SE_SUN && n > 0
+    && swe_get_orbital_elements(jd_et[po[0].i], ipl, flag & SEFLG_EPHMASK, dret, NULL) == OK
+    && dret[11] > 0)
+    hperiod = 360.0 / dret[11];
+  for (j = 0; j < n; j++) {
+    i = po[j].i;
+    *serr2 = '\0';
+    rc = cross_lon_one(ipl, x2cross[i], jd_et[i], flag, dir, is_ut, hperiod, &cache, &jd_cross[i], serr2);
+    if (rc == 1) {
+      /* fall back to the scalar function */
+      if ((flag & SEFLG_HELCTR) && ipl != SE_SUN) {
+	if (is_ut)
+	  rc = swe_helio_cross_ut(ipl, x2cross[i], jd_et[i], flag, dir, &jd_cross[i], serr2);
+	else
+	  rc = swe_helio_cross(ipl, x2cross[i], jd_et[i], flag, dir, &jd_cross[i], serr2);
+      } else {
+	if (ipl == SE_MOON)
+	  jd_cross[i] = is_ut ? swe_mooncross_ut(x2cross[i], jd_et[i], flag, serr2) : swe_mooncross(x2cross[i], jd_et[i], flag, serr2);
+	else
+	  jd_cross[i] = is_ut ? swe_solcross_ut(x2cross[i], jd_et[i], flag, serr2) : swe_solcross(x2cross[i], jd_et[i], flag, serr2);
+	rc = (jd_cross[i] < jd_et[i]) ? ERR : OK;
+      }
+    }
+    if (rc == ERR) {
+      jd_cross[i] = ((flag & SEFLG_HELCTR) && ipl != SE_SUN) ? 0 : jd_et[i] - 1;
+      if (retc != ERR && serr != NULL)
+	strcpy(serr, serr2);
+      retc = ERR;
+    }
+  }
+  free(po);
+  return retc;
+}
+
+/* Sun's crossings over x2cross[i] after jd_et[i], see swe_solcross() */
+int32 CALL_CONV swe_solcross_multi(double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr)
+{
+  return cross_lon_multi(SE_SUN, x2cross, jd_et, n, flag | SEFLG_SPEED, 1, FALSE, jd_cross, serr);
+}
+
+int32 CALL_CONV swe_solcross_multi_ut(double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr)
+{
+  return cross_lon_multi(SE_SUN, x2cross, jd_ut, n, flag | SEFLG_SPEED, 1, TRUE, jd_cross, serr);
+}
+
+/* Moon's crossings over x2cross[i] after jd_et[i], see swe_mooncross() */
+int32 CALL_CONV swe_mooncross_multi(double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr)
+{
+  return cross_lon_multi(SE_MOON, x2cross, jd_et, n, flag | SEFLG_SPEED, 1, FALSE, jd_cross, serr);
+}
+
+int32 CALL_CONV swe_mooncross_multi_ut(double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr)
+{
+  return cross_lon_multi(SE_MOON, x2cross, jd_ut, n, flag | SEFLG_SPEED, 1, TRUE, jd_cross, serr);
+}
+
+/* heliocentric crossings of planet ipl, see swe_helio_cross() */
+int32 CALL_CONV swe_helio_cross_multi(int32 ipl, double *x2cross, double *jd_et, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr)
+{
+  if (ipl == SE_SUN 
+    || ipl == SE_MOON 
+    || (ipl >= SE_MEAN_NODE && ipl <= SE_OSCU_APOG)
+    || (ipl >= SE_INTP_APOG && ipl < SE_NPLANETS)
+  ) {
+    char snam[AS_MAXCH];
+    swe_get_planet_name(ipl, snam);
+    if (serr != NULL) sprintf(serr, "swe_helio_cross: not possible for object %d = %s", ipl, snam);
+    return ERR;
+  }
+  return cross_lon_multi(ipl, x2cross, jd_et, n, iflag | SEFLG_SPEED | SEFLG_HELCTR, dir, FALSE, jd_cross, serr);
+}
+
+int32 CALL_CONV swe_helio_cross_multi_ut(int32 ipl, double *x2cross, double *jd_ut, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr)
+{
+  if (ipl == SE_SUN 
+    || ipl == SE_MOON 
+    || (ipl >= SE_MEAN_NODE && ipl <= SE_OSCU_APOG)
+    || (ipl >= SE_INTP_APOG && ipl < SE_NPLANETS)
+  ) {
+    char snam[AS_MAXCH];
+    swe_get_planet_name(ipl, snam);
+    if (serr != NULL) sprintf(serr, "swe_helio_cross: not possible for object %d = %s", ipl, snam);
+    return ERR;
+  }
+  return cross_lon_multi(ipl, x2cross, jd_ut, n, iflag | SEFLG_SPEED | SEFLG_HELCTR, dir, TRUE, jd_cross, serr);
+}
+
+/* Newton iteration on the Moon's latitude from seed tc, as in
+ * swe_mooncross_node() */
+static int32 cross_node_newton(double tc, int32 flag, AS_BOOL is_ut, double *jd_cross, double *x, char *serr)
+{
+  int32 iter;
+  if (cross_calc(tc, SE_MOON, flag, is_ut, x, serr) < 0)
+    return ERR;
+  for (iter = 0; fabs(x[1]) >= CROSS_PRECISION; iter++) {
+    if (iter == CROSS_MAXITER || x[4] == 0)
+      return 1;
+    tc -= x[1] / x[4];
+    if (cross_calc(tc, SE_MOON, flag, is_ut, x, serr) < 0)
+      return ERR;
+  }
+  *jd_cross = tc;
+  return OK;
+}
+
+/* one element of a node crossing batch; *tprev and *cprev are the start
+ * and result of the previous element */
+static int32 cross_node_one(double t0, int32 flag, AS_BOOL is_ut, double *tprev, double *cprev, double *xprev, double *jd_cross, double *xlon, double *xlat, char *serr)
+{
+  double x[6], tc, T, F;
+  int32 k, rc;
+  /* the previous crossing is also the first one after t0 */
+  if (*cprev != 0 && *tprev <= t0 && t0 < *cprev) {
+    *jd_cross = *cprev;
+    *xlon = xprev[0];
+    *xlat = xprev[1];
+    return OK;
+  }
+  /* seed: a node crossing soon after the previous one, or else from the
+   * mean argument of latitude (Meeus, Astronomical Algorithms, ch. 47) */
+  if (*cprev != 0 && t0 >= *cprev && (k = (int32) ((t0 - *cprev) / CROSS_NODE_HALF) + 1) <= 3) {
+    tc = *cprev + k * CROSS_NODE_HALF;
+  } else {
+    T = (t0 - J2000) / 36525.0;
+    F = swe_degnorm(93.2720950 + 483202.0175233 * T);
+    tc = t0 + (180.0 - fmod(F, 180.0)) / 13.22935;
+  }
+  if ((rc = cross_node_newton(tc, flag, is_ut, jd_cross, x, serr)) != OK)
+    return rc;
+  if (*jd_cross <= t0) {
+    if ((rc = cross_node_newton(*jd_cross + CROSS_NODE_HALF, flag, is_ut, jd_cross, x, serr)) != OK)
+      return rc;
+  }
+  /* only within the shortest interval of node crossings it is sure that
+   * no earlier crossing was skipped */
+  if (*jd_cross <= t0 || *jd_cross > t0 + CROSS_NODE_MIN)
+    return 1;
+  *tprev = t0;
+  *cprev = *jd_cross;
+  xprev[0] = *xlon = x[0];
+  xprev[1] = *xlat = x[1];
+  return OK;
+}
+
+static int32 cross_node_multi(double *jd_et, int32 n, int32 flag, AS_BOOL is_ut, double *jd_cross, double *xlon, double *xlat, char *serr)
+{
+  struct cross_order *po;
+  double tprev = 0, cprev = 0, xprev[2] = {0, 0};
+  int32 j, i, retc = OK, rc;
+  char serr2[AS_MAXCH];
+  if (serr != NULL)
+    *serr = '\0';
+  if ((po = cross_sort(jd_et, n, serr)) == NULL)
+    return ERR;
+  for (j = 0; j < n; j++) {
+    i = po[j].i;
+    *serr2 = '\0';
+    rc = cross_node_one(jd_et[i], flag, is_ut, &tprev, &cprev, xprev, &jd_cross[i], &xlon[i], &xlat[i], serr2);
+    if (rc == 1) {
+      if (is_ut)
+	jd_cross[i] = swe_mooncross_node_ut(jd_et[i], flag, &xlon[i], &xlat[i], serr2);
+      else
+	jd_cross[i] = swe_mooncross_node(jd_et[i], flag, &xlon[i], &xlat[i], serr2);
+      if (jd_cross[i] < jd_et[i]) {
+	rc = ERR;
+      } else {
+	rc = OK;
+	tprev = jd_et[i];
+	cprev = jd_cross[i];
+	xprev[0] = xlon[i];
+	xprev[1] = xlat[i];
+      }
+    }
+    if (rc == ERR) {
+      jd_cross[i] = jd_et[i] - 1;
+      if (retc != ERR && serr != NULL)
+	strcpy(serr, serr2);
+      retc = ERR;
+    }
+  }
+  free(po);
+  return retc;
+}
+
+/* Moon's node crossings after jd_et[i], see swe_mooncross_node() */
+int32 CALL_CONV swe_mooncross_node_multi(double *jd_et, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr)
+{
+  return cross_node_multi(jd_et, n, flag | SEFLG_SPEED, FALSE, jd_cross, xlon, xlat, serr);
+}
+
+int32 CALL_CONV swe_mooncross_node_multi_ut(double *jd_ut, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr)
+{
+  return cross_node_multi(jd_ut, n, flag | SEFLG_SPEED, TRUE, jd_cross, xlon, xlat, serr);
+}
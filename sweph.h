@@ -303,6 +303,13 @@
 #define NUT_SPEED_INTV   0.0001
 #define DEFL_SPEED_INTV  0.0000005
 
+/* SEFLG_FAST: the Chebyshev terms dropped from a segment sum up to less
+ * than this (AU), i.e. about 0.01" at the least distance from the earth
+ * of the Moon, the planets and near-earth asteroids */
+#define FAST_CHEB_TOL_MOON  1e-10
+#define FAST_CHEB_TOL_PLAN  1e-8
+#define FAST_CHEB_TOL_AST   2e-9
+
 #define SE_LAPSE_RATE        0.0065  /* deg K / m, for refraction */
 
 #define square_sum(x)   (x[0]*x[0]+x[1]*x[1]+x[2]*x[2])
@@ -640,8 +647,12 @@ struct plan_data {
   double tseg0, tseg1;	/* start and end jd of current segment */
   double *segp;         /* pointer to unpacked cheby coeffs of segment;
 			 * the size is 3 x ncoe */
+  double *segbuf;	/* space for segp in swed.arena, kept when the */
+  int nsegbuf;		/* file is switched; size in doubles */
   int neval;		/* how many coefficients to evaluate. this may
 			 * be less than ncoe */
+  int nevfast;		/* how many coefficients to evaluate with
+			 * SEFLG_FAST, see FAST_CHEB_TOL */
   /* result of most recent data evaluation for this body: */
   double teval;		/* time for which previous computation was made */
   int32 iephe;            /* which ephemeris was used */
@@ -673,6 +684,7 @@ extern int swi_intp_apsides(double J, double *pol, int ipli);
 extern int swi_moshplan(double tjd, int ipli, AS_BOOL do_save, double *xpret, double *xeret, char *serr);
 extern int swi_moshplan2(double J, int iplm, double *pobj);
 extern int swi_osc_el_plan(double tjd, double *xp, int ipl, int ipli, double *xearth, double *xsun, char *serr);
+extern void swi_release_fict_table(void);
 extern FILE *swi_fopen(int ifno, char *fname, char *ephepath, char *serr);
 extern int32 swi_init_swed_if_start(void);
 extern int32 swi_set_tid_acc(double tjd_ut, int32 iflag, int32 denum, char *serr);
@@ -778,9 +790,139 @@ struct fixed_star {
   double epoch, ra, de, ramot, demot, radvel, parall, mag;
 };
 
+/* star of the last call of a fixed star function */
+struct star_cache {
+  char sname[AS_MAXCH];		/* search name */
+  char srecord[AS_MAXCH];	/* catalogue record, swe_fixstar() */
+  struct fixed_star stardata;	/* parsed record, swe_fixstar2() */
+};
+
+struct jpl_save;		/* JPL reader state, see swejpl.c */
+
 /* dpsi and deps loaded for 100 years after 1962 */
 #define SWE_DATA_DPSI_DEPS  36525   
 
+/* The following are read from files once per process and shared
+ * read-only by all threads, see sweshare.c */
+#define SWI_SHARED_EOP		1	/* struct eop_data, key ephepath */
+#define SWI_SHARED_FIXSTARS	2	/* struct fixstar_catalog, key file name */
+#define SWI_SHARED_FILEHDR	3	/* struct file_header, key file name and length */
+#define SWI_SHARED_ASTNAMES	4	/* struct astnam_table, see swi_shared_file_key() */
+#define SWI_SHARED_FICTELEM	5	/* struct fict_table (swemplan.c), same key */
+
+/* IERS corrections to IAU 1980 nutation, see load_dpsi_deps() */
+struct eop_data {
+  int loaded;			/* eop_dpsi_loaded */
+  double tjd_beg, tjd_beg_horizons, tjd_end;
+  double dpsi[SWE_DATA_DPSI_DEPS];
+  double deps[SWE_DATA_DPSI_DEPS];
+};
+
+/* fixed star catalogue, see load_all_fixed_stars() */
+struct fixstar_catalog {
+  int n_real;			/* number of stars */
+  int n_named;			/* number of stars with a traditional name */
+  int n_records;		/* n_real + n_named */
+  int n_alloc;			/* size of stars */
+  struct fixed_star *stars;	/* sorted by search key */
+};
+
+/* what read_const() reads from an ephemeris file */
+struct file_header {
+  long flen;
+  struct file_data fd;		/* fptr is not used */
+  struct gen_const gcdat;
+  char astelem[AS_MAXCH * 2];	/* if asteroid file */
+  double ast_G, ast_H, ast_diam;
+  struct plan_data pd[1];	/* fd.npl planets, up to member tseg0 */
+};
+
+/* asteroid names from seasnam.txt, see swe_get_planet_name() */
+struct astnam_entry {
+  int32 ast_no;			/* catalogue number */
+  int32 iname;			/* offset in names, -1 if the line has no name */
+  int32 iseq;			/* line, the first one of a number counts */
+};
+struct astnam_table {
+  int32 n;
+  struct astnam_entry *entries;	/* sorted by ast_no */
+  char *names;
+};
+
+struct fict_table;		/* seorbel.txt, see swemplan.c */
+
+void *swi_shared_get(int kind, const char *key);
+void *swi_shared_put(int kind, const char *key, void *data, void (*free_data)(void *));
+void swi_shared_release(void *data, void (*free_data)(void *));
+char *swi_shared_file_key(FILE *fp, const char *fname, const char *ephepath, char *key);
+
+/* Hot-path counters, see swestat.c. Every thread counts into a block of
+ * its own; only the owner writes it, so a relaxed load and store suffice
+ * and swe_stats_snapshot() may read it at any time. With STATSOFF the
+ * macros expand to nothing (SWI_STAT_TIMED to the statement). */
+struct swi_stats {
+  unsigned long long v[SE_STAT_NSTATS];
+  unsigned long long body_hits[SE_STAT_NBODIES];
+  unsigned long long body_misses[SE_STAT_NBODIES];
+  struct swi_stats *next;
+};
+
+#ifdef STATSOFF
+# define SWI_STAT_ADD(i, n)
+# define SWI_STAT_SAVE(hit, ibody)
+# define SWI_STAT_TIMED(i, stmt)	do { stmt; } while (0)
+#else
+extern TLS struct swi_stats *swi_stats_tls;
+extern void (*volatile swi_stats_hook)(int32 istat, double t0, double t1);
+struct swi_stats *swi_stats_attach(void);
+unsigned long long swi_stats_clock(void);
+# if defined(__GNUC__) || defined(__clang__)
+#  define SWI_STAT_INC(p, n) \
+     __atomic_store_n((p), __atomic_load_n((p), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#  define SWI_STAT_HOOK()	__atomic_load_n(&swi_stats_hook, __ATOMIC_RELAXED)
+# else
+#  define SWI_STAT_INC(p, n) \
+     (*(volatile unsigned long long *) (p) = *(volatile unsigned long long *) (p) + (n))
+#  define SWI_STAT_HOOK()	(swi_stats_hook)
+# endif
+# define SWI_STAT_BLOCK()	(swi_stats_tls != NULL ? swi_stats_tls : swi_stats_attach())
+# define SWI_STAT_ADD(i, n) do { \
+     struct swi_stats *st_ = SWI_STAT_BLOCK(); \
+     if (st_ != NULL) SWI_STAT_INC(&st_->v[i], (unsigned long long) (n)); \
+   } while (0)
+# define SWI_STAT_SAVE(hit, ibody) do { \
+     struct swi_stats *st_ = SWI_STAT_BLOCK(); \
+     if (st_ != NULL) SWI_STAT_INC((hit) ? &st_->body_hits[ibody] : &st_->body_misses[ibody], 1); \
+   } while (0)
+# define SWI_STAT_TIMED(i, stmt) do { \
+     unsigned long long t0_ = swi_stats_clock(), t1_; \
+     void (*hook_)(int32, double, double); \
+     stmt; \
+     t1_ = swi_stats_clock(); \
+     SWI_STAT_ADD(i, t1_ - t0_); \
+     /* loaded once: another thread may remove the hook meanwhile */ \
+     hook_ = SWI_STAT_HOOK(); \
+     if (hook_ != NULL) hook_((i), (double) t0_, (double) t1_); \
+   } while (0)
+#endif
+
+/* Ephemeris buffers of a context are carved out of a few large blocks.
+ * swi_arena_reset() makes the space available again without freeing
+ * the blocks, see swectx.c */
+struct swi_arena_block;
+struct swi_arena {
+  struct swi_arena_block *blocks;
+  int32 nalloc;			/* buffers handed out */
+  int32 nreset;
+  int32 nmalloc;		/* blocks obtained with malloc() */
+  int32 nfree;			/* blocks returned with free() */
+  size_t used, reserved, peak;	/* bytes */
+};
+
+void *swi_arena_alloc(struct swi_arena *a, size_t size);
+void swi_arena_reset(struct swi_arena *a);
+void swi_arena_release(struct swi_arena *a);
+
 struct interpol {
   double tjd_nut0, tjd_nut2;
   double nut_dpsi0, nut_dpsi1, nut_dpsi2;
@@ -813,13 +955,14 @@ struct swe_data {
   double ast_G;
   double ast_H;
   double ast_diam;
-  char astelem[AS_MAXCH * 10];
+  const char *astelem;	/* elements of asteroid, in shared file header */
   int i_saved_planet_name;
   char saved_planet_name[80];
   //double dpsi[36525];  /* works for 100 years after 1962 */
   //double deps[36525];
-  double *dpsi;
+  double *dpsi;		/* in eop, shared */
   double *deps;
+  struct eop_data *eop;
   int32 timeout;
   int32 astro_models[SEI_NMODELS];
   AS_BOOL do_interpolate_nut;
@@ -843,7 +986,26 @@ struct swe_data {
   AS_BOOL n_fixstars_real;   // real number of fixed stars in sefstars.txt
   AS_BOOL n_fixstars_named;  // number of fixed stars with tradtional name
   AS_BOOL n_fixstars_records;// number of fixed stars records in fixed_stars
-  struct fixed_star *fixed_stars;
+  struct fixed_star *fixed_stars;	/* in fixstar_cat, shared */
+  struct fixstar_catalog *fixstar_cat;
+  struct swe_table *ptab;     /* table for swe_calc_ut(), see swetab.c */
+  double tab_maxerr;
+  int32 last_fastflag;        /* SEFLG_FAST bit of last call */
+  struct jpl_save *jpl;       /* open JPL file, NULL if none */
+  int32 nutflag;              /* flags of last swi_check_nutation() */
+  struct star_cache last_fixstar2, last_fixstar2_mag;
+  struct star_cache last_fixstar, last_fixstar_mag;
+  struct swi_arena arena;     /* segp of pldat[] */
+  struct astnam_table *astnam; /* seasnam.txt, shared, until swe_set_ephe_path() */
+  struct fict_table *fict;    /* seorbel.txt, shared, until swe_set_ephe_path() */
 };
 
-extern TLS struct swe_data swed;
+/* All state of the library lives in a struct swe_data. Every thread has
+ * its own default one; swe_ctx_bind() (swectx.c) redirects the thread to
+ * an explicit context, so that a computation can move between threads
+ * together with its files and saved positions. */
+extern TLS struct swe_data swi_swed_tls;
+extern TLS struct swe_data *swi_swed_cur;
+#define swed (*(swi_swed_cur != NULL ? swi_swed_cur : &swi_swed_tls))
+
+int32 swi_tab_calc(struct swe_table *ptab, double maxerr, double tjd, int32 ipl, int32 iflag, double *xx);
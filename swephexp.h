@@ -216,6 +216,11 @@ extern "C" {
 #define SEFLG_CENTER_BODY	(1024*1024)  /* calculate position of center of body (COB)
                                                 of planet, not barycenter of its system */
 #define SEFLG_TEST_PLMOON	(2*1024*1024 | SEFLG_J2000 | SEFLG_ICRS | SEFLG_HELCTR | SEFLG_TRUEPOS)  /* test raw data in files sepm9* */
+#define SEFLG_FAST	(4*1024*1024)  /* fast apparent positions, error < 1 arcsec:
+                                * single-pass light-time, reduced nutation
+                                * series (leading terms of IAU 2000B),
+                                * no frame bias, Chebyshev series truncated
+                                * per segment. Not with JPL Horizons modes. */
 
 
 #define SE_SIDBITS		256
@@ -676,6 +681,8 @@ extern HANDLE dllhandle;        // set by swedllst::DllMain,
 ext_def(int32) swe_heliacal_ut(double tjdstart_ut, double *geopos, double *datm, double *dobs, char *ObjectName, int32 TypeEvent, int32 iflag, double *dret, char *serr);
 ext_def(int32) swe_heliacal_pheno_ut(double tjd_ut, double *geopos, double *datm, double *dobs, char *ObjectName, int32 TypeEvent, int32 helflag, double *darr, char *serr);
 ext_def(int32) swe_vis_limit_mag(double tjdut, double *geopos, double *datm, double *dobs, char *ObjectName, int32 helflag, double *dret, char *serr);
+/* swe_vis_limit_mag() for ngeo locations at one epoch: geopos[3*ngeo], dret[8*ngeo], retflag[ngeo] */
+ext_def(int32) swe_vis_limit_mag_grid(double tjdut, double *geopos, int32 ngeo, double *datm, double *dobs, char *ObjectName, int32 helflag, double *dret, int32 *retflag, char *serr);
 
 /* the following are secret, for Victor Reijs' */
 ext_def(int32) swe_heliacal_angle(double tjdut, double *dgeo, double *datm, double *dobs, int32 helflag, double mag, double azi_obj, double azi_sun, double azi_moon, double alt_moon, double *dret, char *serr);
@@ -713,6 +720,97 @@ ext_def(double) swe_mooncross_node_ut(double jd_ut, int32 flag, double *xlon, do
 ext_def(int32) swe_helio_cross(int32 ipl, double x2cross, double jd_et, int32 iflag, int32 dir, double *jd_cross, char *serr);
 ext_def(int32) swe_helio_cross_ut(int32 ipl, double x2cross, double jd_ut, int32 iflag, int32 dir, double *jd_cross, char *serr);
 
+/* batches of crossings, sharing ephemeris evaluations between neighbours */
+ext_def(int32) swe_solcross_multi(double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr);
+ext_def(int32) swe_solcross_multi_ut(double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr);
+ext_def(int32) swe_mooncross_multi(double *x2cross, double *jd_et, int32 n, int32 flag, double *jd_cross, char *serr);
+ext_def(int32) swe_mooncross_multi_ut(double *x2cross, double *jd_ut, int32 n, int32 flag, double *jd_cross, char *serr);
+ext_def(int32) swe_mooncross_node_multi(double *jd_et, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr);
+ext_def(int32) swe_mooncross_node_multi_ut(double *jd_ut, int32 n, int32 flag, double *jd_cross, double *xlon, double *xlat, char *serr);
+ext_def(int32) swe_helio_cross_multi(int32 ipl, double *x2cross, double *jd_et, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr);
+ext_def(int32) swe_helio_cross_multi_ut(int32 ipl, double *x2cross, double *jd_ut, int32 n, int32 iflag, int32 dir, double *jd_cross, char *serr);
+
+/* dense precomputed ephemeris tables (swetab.c) */
+struct swe_table;
+ext_def(double) swe_tab_default_step(int32 ipl);
+ext_def(int32) swe_tab_grid(double tjd0, double tjde, double tstep, double *tfirst, int32 *npt);
+ext_def(int32) swe_tab_sample(int32 ipl, int32 iflag, double tfirst, double tstep, int32 i0, int32 n, double *x, char *serr);
+ext_def(int32) swe_tab_error(int32 ipl, int32 iflag, double tfirst, double tstep, int32 npt, double *x, int32 i0, int32 i1, double prec, char *bad, double *maxerr, char *serr);
+ext_def(int32) swe_tab_save(char *fname, double tjd0, double tjde, int32 nbody, int32 *ipl, int32 *retflag, double *tstep, double **x, double prec, char **bad, double *maxerr, char *serr);
+ext_def(int32) swe_tab_create(char *fname, int32 iflag, double tjd0, double tjde, int32 nbody, int32 *ipl, double *tstep, double prec, char *serr);
+ext_def(struct swe_table *) swe_tab_open(char *fname, char *serr);
+ext_def(void) swe_tab_close(struct swe_table *ptab);
+ext_def(double) swe_tab_maxerr(struct swe_table *ptab, int32 ipl, double *maxerr);
+ext_def(int32) swe_tab_calc(struct swe_table *ptab, double tjd, int32 ipl, int32 iflag, double *xx, char *serr);
+ext_def(void) swe_set_table(struct swe_table *ptab, double maxerr);
+
+/* explicit calculation contexts instead of the thread's own state (swectx.c);
+ * a context must not be used by two threads at the same time */
+typedef struct swe_ctx swe_ctx;
+ext_def(swe_ctx *) swe_ctx_new(void);
+ext_def(void) swe_ctx_free(swe_ctx *ctx);
+ext_def(swe_ctx *) swe_ctx_bind(swe_ctx *ctx);
+ext_def(void) swe_ctx_set_ephe_path(swe_ctx *ctx, const char *path);
+ext_def(void) swe_ctx_set_jpl_file(swe_ctx *ctx, const char *fname);
+ext_def(void) swe_ctx_set_topo(swe_ctx *ctx, double geolon, double geolat, double geoalt);
+ext_def(void) swe_ctx_set_sid_mode(swe_ctx *ctx, int32 sid_mode, double t0, double ayan_t0);
+ext_def(void) swe_ctx_close(swe_ctx *ctx);
+#define SE_ARENA_NALLOC		0	/* buffers handed out */
+#define SE_ARENA_NRESET		1	/* resets by swe_close() etc. */
+#define SE_ARENA_NMALLOC	2	/* blocks obtained with malloc() */
+#define SE_ARENA_NFREE		3	/* blocks returned with free() */
+#define SE_ARENA_USED		4	/* bytes in use */
+#define SE_ARENA_RESERVED	5	/* bytes in blocks */
+#define SE_ARENA_PEAK		6	/* most bytes in use at a time */
+#define SE_ARENA_NSTATS		7
+ext_def(void) swe_ctx_arena_stats(swe_ctx *ctx, double *stats);
+ext_def(int32) swe_ctx_calc(swe_ctx *ctx, double tjd, int ipl, int32 iflag, double *xx, char *serr);
+ext_def(int32) swe_ctx_calc_ut(swe_ctx *ctx, double tjd_ut, int32 ipl, int32 iflag, double *xx, char *serr);
+ext_def(int32) swe_ctx_fixstar2(swe_ctx *ctx, char *star, double tjd, int32 iflag, double *xx, char *serr);
+ext_def(int32) swe_ctx_fixstar2_ut(swe_ctx *ctx, char *star, double tjd_ut, int32 iflag, double *xx, char *serr);
+ext_def(int) swe_ctx_houses(swe_ctx *ctx, double tjd_ut, double geolat, double geolon, int hsys, double *cusps, double *ascmc);
+ext_def(int) swe_ctx_houses_ex2(swe_ctx *ctx, double tjd_ut, int32 iflag, double geolat, double geolon, int hsys, double *cusps, double *ascmc, double *cusp_speed, double *ascmc_speed, char *serr);
+ext_def(int32) swe_ctx_sol_eclipse_when_loc(swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr);
+ext_def(int32) swe_ctx_sol_eclipse_when_glob(swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr);
+ext_def(int32) swe_ctx_sol_eclipse_how(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
+ext_def(int32) swe_ctx_sol_eclipse_where(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
+ext_def(int32) swe_ctx_lun_eclipse_when(swe_ctx *ctx, double tjd_start, int32 ifl, int32 ifltype, double *tret, int32 backward, char *serr);
+ext_def(int32) swe_ctx_lun_eclipse_when_loc(swe_ctx *ctx, double tjd_start, int32 ifl, double *geopos, double *tret, double *attr, int32 backward, char *serr);
+ext_def(int32) swe_ctx_lun_eclipse_how(swe_ctx *ctx, double tjd_ut, int32 ifl, double *geopos, double *attr, char *serr);
+
+/* hot-path counters of all threads (swestat.c); see SE_STAT_... for the
+ * index of each in stats[SE_STAT_NSTATS]. body_hits and body_misses
+ * count positions served from and missed in the save area of swe_calc(),
+ * per body up to SE_NPLANETS - 1, all other bodies at SE_NPLANETS.
+ * Built with STATSOFF, the counters are always 0. */
+#define SE_STAT_SEG_LOADS	0	/* ephemeris segments and JPL records read */
+#define SE_STAT_SEG_BYTES	1	/* bytes read for them */
+#define SE_STAT_SEG_NS		2	/* time spent reading them, ns */
+#define SE_STAT_FILE_OPENS	3	/* files opened by swi_fopen() */
+#define SE_STAT_FILE_FAILS	4	/* files not found in the ephemeris path */
+#define SE_STAT_FILE_NS		5	/* time spent in fopen(), ns */
+#define SE_STAT_SAVE_HITS	6	/* sum of body_hits */
+#define SE_STAT_SAVE_MISSES	7	/* sum of body_misses */
+#define SE_STAT_NUT_EVALS	8	/* nutation series evaluated */
+#define SE_STAT_NUT_HITS	9	/* nutation of the last call reused */
+#define SE_STAT_NUT_NS		10	/* time spent in nutation, ns */
+#define SE_STAT_PREC_EVALS	11	/* precession matrices computed */
+#define SE_STAT_LT_ITER		12	/* light-time iterations */
+#define SE_STAT_DELTAT_EVALS	13	/* delta t computed */
+#define SE_STAT_FIXSTAR_LOADS	14	/* star catalogues parsed from a file */
+#define SE_STAT_FIXSTAR_NS	15	/* time spent loading star catalogues, ns */
+#define SE_STAT_DELTAT_NS	16	/* time spent in swe_deltat_ex(), ns */
+#define SE_STAT_APP_NS		17	/* time spent on apparent positions, ns */
+#define SE_STAT_NSTATS		18
+#define SE_STAT_NBODIES		(SE_NPLANETS + 1)
+ext_def(int32) swe_stats_enabled(void);
+ext_def(void) swe_stats_snapshot(double *stats, double *body_hits, double *body_misses);
+ext_def(void) swe_stats_reset(void);
+/* hook(istat, t0, t1) is called after every timed section (SE_STAT_..._NS)
+ * by the thread that ran it, with start and end in ns of the monotonic
+ * clock (CLOCK_MONOTONIC, QueryPerformanceCounter); NULL removes it */
+ext_def(void) swe_stats_set_hook(void (*hook)(int32 istat, double t0, double t1));
+
 /* fixed stars */
 ext_def( int32 ) swe_fixstar(
         char *star, double tjd, int32 iflag, 
@@ -740,6 +838,9 @@ ext_def( void ) swe_close(void);
 /* set directory path of ephemeris files */
 ext_def( void ) swe_set_ephe_path(const char *path);
 
+/* get the directory path of ephemeris files of the calling thread */
+ext_def( char * ) swe_get_ephe_path(char *path);
+
 /* set file name of JPL file */
 ext_def( void ) swe_set_jpl_file(const char *fname);
 
@@ -884,6 +985,11 @@ ext_def (int32) swe_pheno(double tjd, int32 ipl, int32 iflag, double *attr, char
  
 ext_def(int32) swe_pheno_ut(double tjd_ut, int32 ipl, int32 iflag, double *attr, char *serr);
 
+/* phenomena of several bodies at one time, sharing the sun */
+ext_def (int32) swe_pheno_multi(double tjd, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr);
+
+ext_def (int32) swe_pheno_multi_ut(double tjd_ut, int32 *ipl, int32 nipl, int32 iflag, double *attr, int32 *retflag, char *serr);
+
 ext_def (double) swe_refrac(double inalt, double atpress, double attemp, int32 calc_flag);
 
 ext_def (double) swe_refrac_extended(double inalt, double geoalt, double atpress, double attemp, double lapse_rate, int32 calc_flag, double *dret);
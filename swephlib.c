@@ -1377,6 +1377,7 @@ int swi_precess(double *R, double J, int32 iflag, int direction )
   int prec_model_short = swed.astro_models[SE_MODEL_PREC_SHORTTERM];
   int jplhora_model = swed.astro_models[SE_MODEL_JPLHORA_MODE];
   AS_BOOL is_jplhor = FALSE;
+  SWI_STAT_ADD(SE_STAT_PREC_EVALS, 1);
   if (prec_model == 0) prec_model = SEMOD_PREC_DEFAULT;
   if (prec_model_short == 0) prec_model_short = SEMOD_PREC_DEFAULT_SHORT;
   if (jplhora_model == 0) jplhora_model = SEMOD_JPLHORA_DEFAULT;
@@ -1810,7 +1811,7 @@ static int calc_nutation_iau1980(double J, double *nutlo)
  */
 
 #include "swenut2000a.h"
-static int calc_nutation_iau2000ab(double J, double *nutlo) 
+static int calc_nutation_iau2000ab(double J, int32 iflag, double *nutlo) 
 {
   int i, j, k, inls;
   double M, SM, F, D, OM;
@@ -1854,7 +1855,9 @@ static int calc_nutation_iau2000ab(double J, double *nutlo)
 	      T*(          0.007702 +
 	      T*(        - 0.00005939 ))))) / 3600.0) * DEGTORAD;
   /* luni-solar nutation series, in reverse order, starting with small terms */
-  if (nut_model == SEMOD_NUT_IAU_2000B)
+  if (iflag & SEFLG_FAST)
+    inls = NLS_FAST;	/* leading terms only, no planetary nutation */
+  else if (nut_model == SEMOD_NUT_IAU_2000B)
     inls = NLS_2000B;
   else
     inls = NLS;
@@ -1873,7 +1876,7 @@ static int calc_nutation_iau2000ab(double J, double *nutlo)
   }
   nutlo[0] = dpsi * O1MAS2DEG;
   nutlo[1] = deps * O1MAS2DEG;
-  if (nut_model == SEMOD_NUT_IAU_2000A) {
+  if (nut_model == SEMOD_NUT_IAU_2000A && !(iflag & SEFLG_FAST)) {
     /* planetary nutation 
      * note: The MHB2000 code computes the luni-solar and planetary nutation
      * in different routines, using slightly different Delaunay
@@ -2073,6 +2076,7 @@ static int calc_nutation(double J, int32 iflag, double *nutlo)
   int nut_model = swed.astro_models[SE_MODEL_NUT];
   int jplhora_model = swed.astro_models[SE_MODEL_JPLHORA_MODE];
   AS_BOOL is_jplhor = FALSE;
+  SWI_STAT_ADD(SE_STAT_NUT_EVALS, 1);
   if (nut_model == 0) nut_model = SEMOD_NUT_DEFAULT;
   if (jplhora_model == 0) jplhora_model = SEMOD_JPLHORA_DEFAULT;
   if (iflag & SEFLG_JPLHOR)
@@ -2102,7 +2106,7 @@ static int calc_nutation(double J, int32 iflag, double *nutlo)
   } else if (nut_model == SEMOD_NUT_IAU_1980 || nut_model == SEMOD_NUT_IAU_CORR_1987) {
     calc_nutation_iau1980(J, nutlo);
   } else if (nut_model == SEMOD_NUT_IAU_2000A || nut_model == SEMOD_NUT_IAU_2000B) {
-    calc_nutation_iau2000ab(J, nutlo);
+    calc_nutation_iau2000ab(J, iflag, nutlo);
     if ((iflag & SEFLG_JPLHOR_APPROX) && jplhora_model == SEMOD_JPLHORA_2) {
       nutlo[0] += -41.7750 / 3600.0 / 1000.0 * DEGTORAD;
       nutlo[1] += -6.8192 / 3600.0 / 1000.0 * DEGTORAD;
@@ -2123,7 +2127,7 @@ static double quadratic_intp(double ym, double y0, double yp, double x)
   return y;
 }
 
-int swi_nutation(double tjd, int32 iflag, double *nutlo)
+static int nutation(double tjd, int32 iflag, double *nutlo)
 {
   int retc = OK;
   double dnut[2], dx;
@@ -2157,6 +2161,14 @@ int swi_nutation(double tjd, int32 iflag, double *nutlo)
   return retc;
 }
 
+/* nutation, from the series or interpolated, see swe_set_interpolate_nut() */
+int swi_nutation(double tjd, int32 iflag, double *nutlo)
+{
+  int retc;
+  SWI_STAT_TIMED(SE_STAT_NUT_NS, retc = nutation(tjd, iflag, nutlo));
+  return retc;
+}
+
 #define OFFSET_JPLHORIZONS (-52.3) 
 #define DCOR_RA_JPL_TJD0  2437846.5
 #define NDCOR_RA_JPL  51
@@ -2219,6 +2231,9 @@ void swi_bias(double *x, double tjd, int32 iflag, AS_BOOL backward)
   if (jplhora_model == 0) jplhora_model = SEMOD_JPLHORA_DEFAULT;
   if (bias_model == SEMOD_BIAS_NONE)
     return;
+  /* frame bias is < 0.03", below the precision of SEFLG_FAST */
+  if (iflag & SEFLG_FAST)
+    return;
   if (iflag & SEFLG_JPLHOR_APPROX) {
     if (jplhora_model == SEMOD_JPLHORA_2)
       return;
@@ -2553,6 +2568,7 @@ static int32 calc_deltat(double tjd, int32 iflag, double *deltat, char *serr)
   int32 denum, denumret;
   int32 epheflag, otherflag;
 //fprintf(stderr, "dmod=%f, %.f\n", (double) deltat_model, (double) SEMOD_DELTAT_DEFAULT);
+  SWI_STAT_ADD(SE_STAT_DELTAT_EVALS, 1);
   if (deltat_model == 0) deltat_model = SEMOD_DELTAT_DEFAULT;
   epheflag = iflag & SEFLG_EPHMASK;
   otherflag = iflag & ~SEFLG_EPHMASK;
@@ -2705,7 +2721,7 @@ double CALL_CONV swe_deltat_ex(double tjd, int32 iflag, char *serr)
     return swed.delta_t_userdef;
   if (serr != NULL)
     *serr = '\0';
-  calc_deltat(tjd, iflag, &deltat, serr);
+  SWI_STAT_TIMED(SE_STAT_DELTAT_NS, calc_deltat(tjd, iflag, &deltat, serr));
   return deltat;
 }
 
@@ -0,0 +1,209 @@
+/* SWISSEPH
+ * 
+ * sweshare.c: data shared read-only by all threads of the process.
+ *
+ * Every thread (and every swe_ctx) has a struct swe_data of its own.
+ * Most of what it holds is small mutable state, but some of it is large
+ * and never changes once read from a file:
+ *
+ *   the IERS nutation corrections (eop_dc.txt, finals.all), 570 KB
+ *   the fixed star catalogue (sefstars.txt), about 1 MB
+ *   the header of each ephemeris file: constants, planet descriptions
+ *   and the reference ellipses read by read_const()
+ *
+ * These are loaded by the first thread that needs them and registered
+ * here under the name of the file or path they were read from; other
+ * threads find them and only keep a pointer. Nothing registered may be
+ * written to.
+ *
+ * EOP tables and star catalogues are reference counted and freed when
+ * the last thread releases them with swe_close(). File headers are a
+ * few KB each and are kept until the process ends, so that the
+ * reference ellipses can be used without a reference count.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#if MSDOS
+# include <windows.h>
+#else
+# include <pthread.h>
+#endif
+
+struct shared_entry {
+  int kind;			/* SWI_SHARED_... */
+  char *key;			/* file or path the data were read from */
+  void *data;
+  void (*free_data)(void *);	/* NULL: kept until the process ends */
+  int32 nref;
+  struct shared_entry *next;
+};
+
+static struct shared_entry *shared_list = NULL;
+
+#if MSDOS
+static SRWLOCK shared_lock = SRWLOCK_INIT;
+# define LOCK()		AcquireSRWLockExclusive(&shared_lock)
+# define UNLOCK()	ReleaseSRWLockExclusive(&shared_lock)
+#else
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK()		pthread_mutex_lock(&shared_lock)
+# define UNLOCK()	pthread_mutex_unlock(&shared_lock)
+#endif
+
+static struct shared_entry *find_entry(int kind, const char *key)
+{
+  struct shared_entry *e;
+  for (e = shared_list; e != NULL; e = e->next) {
+    if (e->kind == kind && strcmp(e->key, key) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+/* Returns the data registered under kind and key, NULL if there are
+ * none. The caller holds a reference until swi_shared_release(). */
+void *swi_shared_get(int kind, const char *key)
+{
+  struct shared_entry *e;
+  void *data = NULL;
+  LOCK();
+  if ((e = find_entry(kind, key)) != NULL) {
+    e->nref++;
+    data = e->data;
+  }
+  UNLOCK();
+  return data;
+}
+
+/* Registers data read by the calling thread, which holds the first
+ * reference. If another thread has registered the same kind and key in
+ * the meantime, data are freed and the other thread's data returned.
+ * If the registry cannot grow, data are returned unshared; such data 
+ * are freed by swi_shared_release() as well.
+ * free_data frees the data when the last reference is released; with 
+ * NULL they are kept until the process ends. */
+void *swi_shared_put(int kind, const char *key, void *data, void (*free_data)(void *))
+{
+  struct shared_entry *e;
+  LOCK();
+  if ((e = find_entry(kind, key)) != NULL) {
+    e->nref++;
+    UNLOCK();
+    if (free_data != NULL)
+      free_data(data);
+    return e->data;
+  }
+  if ((e = (struct shared_entry *) calloc(1, sizeof(struct shared_entry))) != NULL
+    && (e->key = (char *) malloc(strlen(key) + 1)) == NULL) {
+    free(e);
+    e = NULL;
+  }
+  if (e != NULL) {
+    e->kind = kind;
+    strcpy(e->key, key);
+    e->data = data;
+    e->free_data = free_data;
+    e->nref = 1;
+    e->next = shared_list;
+    shared_list = e;
+  }
+  UNLOCK();
+  return data;
+}
+
+/* Gives up a reference obtained from swi_shared_get() or swi_shared_put() */
+void swi_shared_release(void *data, void (*free_data)(void *))
+{
+  struct shared_entry *e, **pe;
+  if (data == NULL)
+    return;
+  LOCK();
+  for (pe = &shared_list; (e = *pe) != NULL; pe = &e->next) {
+    if (e->data != data)
+      continue;
+    if (--e->nref > 0 || e->free_data == NULL) {
+      UNLOCK();
+      return;
+    }
+    *pe = e->next;
+    UNLOCK();
+    e->free_data(e->data);
+    free(e->key);
+    free(e);
+    return;
+  }
+  UNLOCK();
+  /* not registered, see swi_shared_put() */
+  if (free_data != NULL)
+    free_data(data);
+}
+
+/* Builds the key for a text file found with swi_fopen(-1, fname, ephepath),
+ * which does not tell the full file name. The length comes first, so
+ * that a file replaced by a different one is read again. key must hold
+ * 2 * AS_MAXCH; fp is rewound. */
+char *swi_shared_file_key(FILE *fp, const char *fname, const char *ephepath, char *key)
+{
+  long flen;
+  fseek(fp, 0L, SEEK_END);
+  flen = ftell(fp);
+  rewind(fp);
+  sprintf(key, "%ld|%s|%.*s", flen, fname, AS_MAXCH, ephepath);
+  return key;
+}
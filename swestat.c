@@ -0,0 +1,287 @@
+/* SWISSEPH
+ * 
+ * swestat.c: hot-path counters.
+ *
+ * Segment loads, file opens, reuse of saved positions and of nutation,
+ * evaluations of nutation, precession and delta t, light-time iterations
+ * and fixed star catalogue loads are counted at the places where they
+ * happen, see SE_STAT_... in swephexp.h. The slow ones are also timed.
+ *
+ * Each thread counts into a block of its own, which it obtains with its
+ * first count and registers here. A count is a relaxed load and store
+ * to a cache line no other thread writes, so the counters can stay on
+ * in production. swe_stats_snapshot() adds up the blocks of all threads.
+ * When a thread ends, its counts are added to those of ended threads and
+ * its block is reused by the next new thread, so that a pool started for
+ * every batch does not make the list grow.
+ *
+ * Counts belong to the thread, not to the swe_ctx it works with.
+ * swe_stats_reset() does not touch the blocks; it takes the current sums
+ * as the zero of later snapshots.
+ *
+ * swe_stats_set_hook() passes every timed section to a caller's function
+ * as well, e.g. to draw segment reads into a trace of its own.
+ *
+ * Compiled with STATSOFF, no counting code is left in the library.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#ifndef STATSOFF
+# if MSDOS
+#  include <windows.h>
+# else
+#  include <pthread.h>
+#  include <time.h>
+# endif
+#endif
+
+#ifndef STATSOFF
+
+TLS struct swi_stats *swi_stats_tls = NULL;
+void (*volatile swi_stats_hook)(int32 istat, double t0, double t1) = NULL;
+
+static struct swi_stats *stats_active = NULL;	/* blocks of living threads */
+static struct swi_stats *stats_unused = NULL;	/* blocks of ended threads */
+static struct swi_stats stats_ended;		/* counts of ended threads */
+static struct swi_stats stats_zero;		/* sums at swe_stats_reset() */
+
+#if MSDOS
+static SRWLOCK stats_lock = SRWLOCK_INIT;
+# define LOCK()		AcquireSRWLockExclusive(&stats_lock)
+# define UNLOCK()	ReleaseSRWLockExclusive(&stats_lock)
+#else
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static int stats_key_ok = 0;
+# define LOCK()		pthread_mutex_lock(&stats_lock)
+# define UNLOCK()	pthread_mutex_unlock(&stats_lock)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define LOAD(p)	__atomic_load_n((p), __ATOMIC_RELAXED)
+#else
+# define LOAD(p)	(*(volatile unsigned long long *) (p))
+#endif
+
+/* adds the counts of block b to sum; the caller holds the lock */
+static void stats_add(struct swi_stats *sum, struct swi_stats *b)
+{
+  int i;
+  for (i = 0; i < SE_STAT_NSTATS; i++)
+    sum->v[i] += LOAD(&b->v[i]);
+  for (i = 0; i < SE_STAT_NBODIES; i++) {
+    sum->body_hits[i] += LOAD(&b->body_hits[i]);
+    sum->body_misses[i] += LOAD(&b->body_misses[i]);
+  }
+}
+
+/* sums of all threads since the start; the caller holds the lock */
+static void stats_sum(struct swi_stats *sum)
+{
+  struct swi_stats *b;
+  *sum = stats_ended;
+  for (b = stats_active; b != NULL; b = b->next)
+    stats_add(sum, b);
+}
+
+#if !MSDOS
+/* the thread ends: its counts go to stats_ended, its block to stats_unused */
+static void stats_detach(void *p)
+{
+  struct swi_stats *st = (struct swi_stats *) p, **pb;
+  LOCK();
+  stats_add(&stats_ended, st);
+  for (pb = &stats_active; *pb != NULL; pb = &(*pb)->next) {
+    if (*pb == st) {
+      *pb = st->next;
+      break;
+    }
+  }
+  st->next = stats_unused;
+  stats_unused = st;
+  UNLOCK();
+  /* a count by a later destructor of this thread attaches a new block */
+  swi_stats_tls = NULL;
+}
+
+static void stats_key_create(void)
+{
+  stats_key_ok = (pthread_key_create(&stats_key, stats_detach) == 0);
+}
+#endif
+
+/* Gives the calling thread its counter block on its first count.
+ * Returns NULL if out of memory; the count is then lost. */
+struct swi_stats *swi_stats_attach(void)
+{
+  struct swi_stats *st;
+#if !MSDOS
+  pthread_once(&stats_once, stats_key_create);
+#endif
+  LOCK();
+  if ((st = stats_unused) != NULL) {
+    stats_unused = st->next;
+    memset((void *) st, 0, sizeof(struct swi_stats));
+  } else {
+    st = (struct swi_stats *) calloc(1, sizeof(struct swi_stats));
+  }
+  if (st != NULL) {
+    st->next = stats_active;
+    stats_active = st;
+  }
+  UNLOCK();
+  if (st == NULL)
+    return NULL;
+#if !MSDOS
+  /* without the key, the block stays registered after the thread ends */
+  if (stats_key_ok)
+    pthread_setspecific(stats_key, st);
+#endif
+  swi_stats_tls = st;
+  return st;
+}
+
+/* monotonic clock in ns, for SWI_STAT_TIMED() */
+unsigned long long swi_stats_clock(void)
+{
+#if MSDOS
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (unsigned long long) ((double) t.QuadPart * 1e9 / (double) freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+#endif
+}
+
+#endif /* STATSOFF */
+
+/* FALSE if the library was compiled with STATSOFF */
+int32 CALL_CONV swe_stats_enabled(void)
+{
+#ifdef STATSOFF
+  return FALSE;
+#else
+  return TRUE;
+#endif
+}
+
+/* Counts of all threads since the last swe_stats_reset(): stats has
+ * SE_STAT_NSTATS elements, body_hits and body_misses SE_STAT_NBODIES;
+ * either of the latter may be NULL. Counts of threads working at the 
+ * same time may be a few calls behind. */
+void CALL_CONV swe_stats_snapshot(double *stats, double *body_hits, double *body_misses)
+{
+  int i;
+#ifdef STATSOFF
+  for (i = 0; i < SE_STAT_NSTATS; i++)
+    stats[i] = 0;
+  for (i = 0; i < SE_STAT_NBODIES; i++) {
+    if (body_hits != NULL) body_hits[i] = 0;
+    if (body_misses != NULL) body_misses[i] = 0;
+  }
+#else
+  struct swi_stats sum;
+  LOCK();
+  stats_sum(&sum);
+  for (i = 0; i < SE_STAT_NSTATS; i++)
+    sum.v[i] -= stats_zero.v[i];
+  for (i = 0; i < SE_STAT_NBODIES; i++) {
+    sum.body_hits[i] -= stats_zero.body_hits[i];
+    sum.body_misses[i] -= stats_zero.body_misses[i];
+  }
+  UNLOCK();
+  sum.v[SE_STAT_SAVE_HITS] = sum.v[SE_STAT_SAVE_MISSES] = 0;
+  for (i = 0; i < SE_STAT_NBODIES; i++) {
+    sum.v[SE_STAT_SAVE_HITS] += sum.body_hits[i];
+    sum.v[SE_STAT_SAVE_MISSES] += sum.body_misses[i];
+    if (body_hits != NULL) body_hits[i] = (double) sum.body_hits[i];
+    if (body_misses != NULL) body_misses[i] = (double) sum.body_misses[i];
+  }
+  for (i = 0; i < SE_STAT_NSTATS; i++)
+    stats[i] = (double) sum.v[i];
+#endif
+}
+
+/* Later snapshots count from here on, for all threads */
+void CALL_CONV swe_stats_reset(void)
+{
+#ifndef STATSOFF
+  LOCK();
+  stats_sum(&stats_zero);
+  UNLOCK();
+#endif
+}
+
+/* see swephexp.h; ignored with STATSOFF */
+void CALL_CONV swe_stats_set_hook(void (*hook)(int32 istat, double t0, double t1))
+{
+#ifndef STATSOFF
+# if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(&swi_stats_hook, hook, __ATOMIC_RELAXED);
+# else
+  swi_stats_hook = hook;
+# endif
+#endif
+}
@@ -0,0 +1,764 @@
+/* SWISSEPH
+ * 
+ * swetab.c: dense precomputed ephemeris tables.
+ *
+ * A table holds, for each of its bodies, the positions returned by
+ * swe_calc() (longitude, latitude, distance, or right ascension,
+ * declination, distance with SEFLG_EQUATORIAL) at equidistant times in
+ * TT. Positions in between, and speeds, are interpolated with the
+ * fifth-order polynomial through the six nearest points, which is the
+ * Everett interpolation of the ep4 tables of sweephe4.c written in
+ * Lagrange form. Unlike ep4, a table is built from swe_calc() with any
+ * ephemeris and coordinate flags, keeps full double precision, has a step
+ * width per body, and is mapped into memory rather than read.
+ *
+ * The file consists of a header, a directory with one entry per body,
+ * and for each body in directory order its positions and a bitmap of
+ * intervals that are not interpolated:
+ *
+ *   struct tab_header
+ *   struct tab_dir dir[nbody]
+ *   double x[npt][3]; uint32 bad[nbadw]    of body 0, body 1, ...
+ *
+ * The generator compares the interpolated with the directly computed
+ * position and speed at SWETAB_NSAMPLE equidistant times in every
+ * interval (the interpolation error of a smooth function peaks at the
+ * midpoint, that of the true node and apogee and of apparent positions
+ * not quite; four samples per interval missed peaks by up to a factor
+ * of two), and takes SWETAB_SAFETY times the largest difference as the
+ * error of the interval.
+ * Apparent positions are not smooth everywhere: light deflection changes
+ * by up to 1.7" within hours when a planet passes behind the Sun. An
+ * interval whose error exceeds the precision asked for, and the two
+ * intervals on either side, are marked in the bitmap; positions in them
+ * are computed with swe_calc(). For every body, the directory holds the
+ * largest error found in the other intervals; this is the error bound
+ * reported by swe_tab_maxerr() and used by swe_set_table(). It is a
+ * measured bound, not a proven one; in 100000 random queries per body
+ * over 1950 - 1980 no error exceeded it.
+ *
+ * With the Swiss Ephemeris over 1900 - 1950, the step widths of
+ * swe_tab_default_step() and a precision of 0.01", the measured bounds
+ * (before the safety factor) and marked intervals are:
+ *
+ *   Sun, Moon            0.002", none marked; speed 0.003", 0.3"/day
+ *   Mercury - Mars       0.01", 0.05 - 0.3 % marked; speed 0.1"/day
+ *   Jupiter - Neptune    0.01", 1.5 - 2.7 % marked; speed 0.03"/day
+ *   Pluto, Chiron        0.01", 0.2 - 0.5 % marked
+ *   mean node, apogee    0.0001", none marked
+ *   true node            0.01", 0.5 % marked; speed 1"/day
+ *   osc. apogee          0.01", 1.6 % marked; speed 100"/day
+ *
+ * The bound depends on range, flags and ephemeris, so it is always
+ * measured and stored in the table.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#if MSDOS
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#define SWETAB_MAGIC	"SWETAB\r\n"	/* \r\n catches text mode transfers */
+#define SWETAB_VERSION	1
+#define SWETAB_MARGIN	2	/* intervals marked on either side of a bad one */
+#define SWETAB_NSAMPLE	16	/* error samples per interval */
+#define SWETAB_SAFETY	1.1	/* error bound / largest error sampled */
+#define SWETAB_NIDX	SE_NPLANETS	/* bodies found by direct index */
+#define SWETAB_UNSUPP	(SEFLG_XYZ | SEFLG_RADIANS | SEFLG_TOPOCTR | SEFLG_SIDEREAL)
+
+struct tab_header {
+  char magic[8];
+  int32 version;
+  int32 hdrlen;          /* sizeof(struct tab_header) */
+  int32 dirlen;          /* sizeof(struct tab_dir) */
+  int32 nbody;
+  double tjd0;           /* period covered (TT) */
+  double tjde;
+};
+
+struct tab_dir {
+  int32 ipl;
+  int32 iflag;           /* flags returned by swe_calc(), without SEFLG_SPEED */
+  int32 npt;             /* number of points */
+  int32 nbad;            /* number of intervals marked in the bitmap */
+  double prec;           /* precision asked for, arc seconds; 0 = none */
+  double tfirst;         /* time of first point (TT) */
+  double tstep;
+  double maxerr[6];      /* lon/ra ", lat/dec ", dist AU; speeds per day */
+};
+
+struct swe_table {
+  char fname[AS_MAXCH];
+  char *buf;
+  size_t len;
+  AS_BOOL mapped;
+  struct tab_header *h;
+  struct tab_dir *dir;
+  double **x;            /* positions of each body */
+  uint32 **bad;          /* bitmaps of intervals computed with swe_calc() */
+  int32 idx[SWETAB_NIDX];/* directory entry of body ipl, or -1 */
+  int32 nattach;         /* threads that have it attached, see swe_set_table() */
+  AS_BOOL closed;        /* swe_tab_close() called, freed at last detach */
+};
+
+/* guards nattach and closed of all tables */
+#if MSDOS
+static SRWLOCK tab_lock = SRWLOCK_INIT;
+# define LOCK()		AcquireSRWLockExclusive(&tab_lock)
+# define UNLOCK()	ReleaseSRWLockExclusive(&tab_lock)
+#else
+static pthread_mutex_t tab_lock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK()		pthread_mutex_lock(&tab_lock)
+# define UNLOCK()	pthread_mutex_unlock(&tab_lock)
+#endif
+
+/* number of bitmap words after the positions, even to keep 8-byte alignment */
+static size_t tab_nbadw(int32 npt)
+{
+  return (((size_t) npt + 63) / 64) * 2;
+}
+
+/* 
+ * Step width in days used by swe_tab_create() when none is given.
+ */
+double CALL_CONV swe_tab_default_step(int32 ipl)
+{
+  switch (ipl) {
+  case SE_MOON:
+    return 0.25;
+  case SE_MERCURY:
+    return 0.5;
+  case SE_TRUE_NODE:
+  case SE_OSCU_APOG:
+    return 0.125;
+  case SE_JUPITER:
+  case SE_SATURN:
+  case SE_URANUS:
+  case SE_NEPTUNE:
+  case SE_PLUTO:
+    return 2;
+  default:
+    return 1;
+  }
+}
+
+/*
+ * Points of a table of step width tstep covering tjd0 .. tjde: the first
+ * is at *tfirst, point i at *tfirst + i * tstep. Two extra points before
+ * tjd0 and three after tjde complete the interpolation stencil.
+ */
+int32 CALL_CONV swe_tab_grid(double tjd0, double tjde, double tstep, double *tfirst, int32 *npt)
+{
+  double n;
+  if (tstep <= 0 || tjde < tjd0)
+    return ERR;
+  n = ceil((tjde - tjd0) / tstep) + 6;
+  if (n > 0x7fffffff / 3)
+    return ERR;
+  *tfirst = tjd0 - 2 * tstep;
+  *npt = (int32) n;
+  return OK;
+}
+
+/* fifth-order interpolation at p (0 <= p <= 1) between y[2] and y[3],
+ * with derivative in units of the step width */
+static void tab_inpol(double p, double *y, double *f, double *df)
+{
+  static const double den[6] = {-120, 24, -12, 12, -24, 120};
+  double a[6], w, dw;
+  int j, k;
+  for (j = 0; j < 6; j++)
+    a[j] = p - (j - 2);
+  *f = *df = 0;
+  for (k = 0; k < 6; k++) {
+    w = 1;
+    dw = 0;
+    for (j = 0; j < 6; j++) {
+      if (j == k) continue;
+      /* product rule: derivative of w * a[j] */
+      dw = dw * a[j] + w;
+      w *= a[j];
+    }
+    *f += y[k] * w / den[k];
+    *df += y[k] * dw / den[k];
+  }
+}
+
+/* interpolates the positions x (npt points from tfirst) at tjd;
+ * xx[0..5] as from swe_calc() with SEFLG_SPEED */
+static int32 tab_interpolate(double *x, int32 npt, double tfirst, double tstep, double tjd, double *xx)
+{
+  double u, p, y[6];
+  int32 i, j, k;
+  u = (tjd - tfirst) / tstep;
+  i = (int32) floor(u);
+  if (i < 2) i = 2;
+  if (i > npt - 4) i = npt - 4;
+  p = u - i;
+  for (k = 0; k < 3; k++) {
+    for (j = 0; j < 6; j++) 
+      y[j] = x[3 * (i - 2 + j) + k];
+    /* longitudes are continued across 0/360 */
+    if (k == 0) {
+      for (j = 0; j < 6; j++) {
+	if (j != 2)
+	  y[j] = y[2] + swe_difdeg2n(y[j], y[2]);
+      }
+    }
+    tab_inpol(p, y, &xx[k], &xx[k + 3]);
+    xx[k + 3] /= tstep;
+  }
+  xx[0] = swe_degnorm(xx[0]);
+  return i;
+}
+
+/*
+ * Computes points i0 .. i0 + n - 1 of body ipl into x[3 * i], for a table
+ * whose first point is at tfirst (see swe_tab_grid()).
+ * Returns the flags returned by swe_calc(), or ERR.
+ */
+int32 CALL_CONV swe_tab_sample(int32 ipl, int32 iflag, double tfirst, double tstep, int32 i0, int32 n, double *x, char *serr)
+{
+  double xx[6];
+  int32 i, retflag = ERR;
+  iflag &= ~(SEFLG_SPEED | SEFLG_SPEED3);
+  if (iflag & SWETAB_UNSUPP) {
+    if (serr != NULL) strcpy(serr, "ephemeris tables support neither XYZ, radians, topocentric nor sidereal positions");
+    return ERR;
+  }
+  for (i = i0; i < i0 + n; i++) {
+    if ((retflag = swe_calc(tfirst + i * tstep, ipl, iflag, xx, serr)) == ERR)
+      return ERR;
+    x[3 * i] = xx[0];
+    x[3 * i + 1] = xx[1];
+    x[3 * i + 2] = xx[2];
+  }
+  return retflag;
+}
+
+/*
+ * Interpolation error bounds of body ipl over the intervals i0 .. i1 - 1
+ * of a table (npt points x from tfirst), see the top of this file.
+ * If prec > 0, bad[i] is set for each interval i whose error in longitude
+ * or latitude exceeds prec arc seconds, and that interval is left out of
+ * maxerr. maxerr[0..5] are raised where the errors found are larger.
+ */
+int32 CALL_CONV swe_tab_error(int32 ipl, int32 iflag, double tfirst, double tstep, int32 npt, double *x, int32 i0, int32 i1, double prec, char *bad, double *maxerr, char *serr)
+{
+  double xx[6], xi[6], t, d, e[6];
+  int32 i, k, m;
+  iflag = (iflag & ~SEFLG_SPEED3) | SEFLG_SPEED;
+  if (i0 < 2) i0 = 2;
+  if (i1 > npt - 3) i1 = npt - 3;
+  for (i = i0; i < i1; i++) {
+    for (k = 0; k < 6; k++)
+      e[k] = 0;
+    for (m = 0; m < SWETAB_NSAMPLE; m++) {
+      t = tfirst + (i + (double) m / SWETAB_NSAMPLE) * tstep;
+      if (swe_calc(t, ipl, iflag, xx, serr) == ERR)
+	return ERR;
+      tab_interpolate(x, npt, tfirst, tstep, t, xi);
+      for (k = 0; k < 6; k++) {
+	if (m == 0 && k < 3)
+	  continue;
+	d = (k == 0) ? swe_difdeg2n(xi[0], xx[0]) : xi[k] - xx[k];
+	d = fabs(d);
+	if (k != 2 && k != 5)
+	  d *= 3600;
+	if (d > e[k])
+	  e[k] = d;
+      }
+    }
+    for (k = 0; k < 6; k++)
+      e[k] *= SWETAB_SAFETY;
+    if (prec > 0 && (e[0] > prec || e[1] > prec)) {
+      bad[i] = 1;
+      continue;
+    }
+    for (k = 0; k < 6; k++) {
+      if (e[k] > maxerr[k])
+	maxerr[k] = e[k];
+    }
+  }
+  return OK;
+}
+
+/*
+ * Writes a table: nbody bodies ipl[b] with step widths tstep[b], points
+ * x[b] (see swe_tab_grid()), flags retflag[b] as returned by
+ * swe_tab_sample(), and intervals bad[b] and errors maxerr[6 * b] as from
+ * swe_tab_error() with precision prec. bad may be NULL.
+ */
+int32 CALL_CONV swe_tab_save(char *fname, double tjd0, double tjde, int32 nbody, int32 *ipl, int32 *retflag, double *tstep, double **x, double prec, char **bad, double *maxerr, char *serr)
+{
+  struct tab_header h;
+  struct tab_dir d;
+  char ftmp[AS_MAXCH + 8];
+  FILE *fp;
+  uint32 *bits = NULL;
+  size_t nw;
+  int32 b, i, j, n = 0;
+  if (strlen(fname) >= AS_MAXCH) {
+    if (serr != NULL) sprintf(serr, "file name too long: %.160s", fname);
+    return ERR;
+  }
+  memset((void *) &h, 0, sizeof(h));
+  memcpy(h.magic, SWETAB_MAGIC, 8);
+  h.version = SWETAB_VERSION;
+  h.hdrlen = (int32) sizeof(struct tab_header);
+  h.dirlen = (int32) sizeof(struct tab_dir);
+  h.nbody = nbody;
+  h.tjd0 = tjd0;
+  h.tjde = tjde;
+  sprintf(ftmp, "%s.tmp", fname);
+  if ((fp = fopen(ftmp, BFILE_W_CREATE)) == NULL) {
+    if (serr != NULL) sprintf(serr, "could not open file %.160s", ftmp);
+    return ERR;
+  }
+  n += fwrite((void *) &h, sizeof(h), 1, fp) != 1;
+  for (b = 0; b < nbody && n == 0; b++) {
+    memset((void *) &d, 0, sizeof(d));
+    d.ipl = ipl[b];
+    d.iflag = retflag[b] & ~(SEFLG_SPEED | SEFLG_SPEED3);
+    d.tstep = tstep[b];
+    d.prec = prec > 0 ? prec : 0;
+    swe_tab_grid(tjd0, tjde, tstep[b], &d.tfirst, &d.npt);
+    if (bad != NULL) {
+      for (i = 0; i < d.npt; i++) {
+	for (j = i - SWETAB_MARGIN; j <= i + SWETAB_MARGIN; j++) {
+	  if (j >= 0 && j < d.npt && bad[b][j] == 1) {
+	    d.nbad++;
+	    break;
+	  }
+	}
+      }
+    }
+    memcpy((void *) d.maxerr, (void *) (maxerr + 6 * b), 6 * sizeof(double));
+    n += fwrite((void *) &d, sizeof(d), 1, fp) != 1;
+  }
+  for (b = 0; b < nbody && n == 0; b++) {
+    double tfirst = 0;
+    int32 npt = 0;
+    swe_tab_grid(tjd0, tjde, tstep[b], &tfirst, &npt);
+    n += fwrite((void *) x[b], 3 * sizeof(double), npt, fp) != (size_t) npt;
+    nw = tab_nbadw(npt);
+    if ((bits = (uint32 *) calloc(nw, sizeof(uint32))) == NULL) {
+      n++;
+      break;
+    }
+    if (bad != NULL) {
+      for (i = 0; i < npt; i++) {
+	for (j = i - SWETAB_MARGIN; j <= i + SWETAB_MARGIN; j++) {
+	  if (j >= 0 && j < npt && bad[b][j] == 1) {
+	    bits[i / 32] |= (uint32) 1 << (i % 32);
+	    break;
+	  }
+	}
+      }
+    }
+    n += fwrite((void *) bits, sizeof(uint32), nw, fp) != nw;
+    free(bits);
+  }
+  if (fclose(fp) != 0 || n != 0) {
+    if (serr != NULL) sprintf(serr, "error while trying to write %.160s", ftmp);
+    remove(ftmp);
+    return ERR;
+  }
+#if MSDOS
+  remove(fname);
+#endif
+  if (rename(ftmp, fname) != 0) {
+    if (serr != NULL) sprintf(serr, "could not rename %.100s to %.100s", ftmp, fname);
+    remove(ftmp);
+    return ERR;
+  }
+  return OK;
+}
+
+/*
+ * Builds the table fname for bodies ipl[0 .. nbody - 1] over tjd0 .. tjde
+ * (TT) with swe_calc() flags iflag. tstep[b] is the step width of body
+ * ipl[b]; tstep may be NULL for swe_tab_default_step(). Intervals whose
+ * interpolation error exceeds prec arc seconds are computed with
+ * swe_calc() (prec <= 0: none). Runs in the calling thread; see
+ * parabola_table.h for a parallel generator.
+ */
+int32 CALL_CONV swe_tab_create(char *fname, int32 iflag, double tjd0, double tjde, int32 nbody, int32 *ipl, double *tstep, double prec, char *serr)
+{
+  double **x, *step, *maxerr, tfirst;
+  char **bad;
+  int32 *retflag, b, npt, retc = ERR;
+  x = (double **) calloc(nbody > 0 ? nbody : 1, sizeof(double *));
+  bad = (char **) calloc(nbody > 0 ? nbody : 1, sizeof(char *));
+  step = (double *) calloc(nbody > 0 ? nbody : 1, sizeof(double));
+  maxerr = (double *) calloc(nbody > 0 ? 6 * nbody : 1, sizeof(double));
+  retflag = (int32 *) calloc(nbody > 0 ? nbody : 1, sizeof(int32));
+  if (x == NULL || bad == NULL || step == NULL || maxerr == NULL || retflag == NULL) {
+    if (serr != NULL) strcpy(serr, "could not allocate ephemeris table");
+    goto create_end;
+  }
+  for (b = 0; b < nbody; b++) {
+    step[b] = (tstep != NULL) ? tstep[b] : swe_tab_default_step(ipl[b]);
+    if (swe_tab_grid(tjd0, tjde, step[b], &tfirst, &npt) == ERR) {
+      if (serr != NULL) sprintf(serr, "invalid range or step width for body %d", ipl[b]);
+      goto create_end;
+    }
+    x[b] = (double *) malloc(3 * sizeof(double) * npt);
+    bad[b] = (char *) calloc(npt, sizeof(char));
+    if (x[b] == NULL || bad[b] == NULL) {
+      if (serr != NULL) strcpy(serr, "could not allocate ephemeris table");
+      goto create_end;
+    }
+    if ((retflag[b] = swe_tab_sample(ipl[b], iflag, tfirst, step[b], 0, npt, x[b], serr)) == ERR)
+      goto create_end;
+    if (swe_tab_error(ipl[b], iflag, tfirst, step[b], npt, x[b], 0, npt, prec, bad[b], maxerr + 6 * b, serr) == ERR)
+      goto create_end;
+  }
+  retc = swe_tab_save(fname, tjd0, tjde, nbody, ipl, retflag, step, x, prec, bad, maxerr, serr);
+create_end:
+  for (b = 0; b < nbody; b++) {
+    if (x != NULL) free(x[b]);
+    if (bad != NULL) free(bad[b]);
+  }
+  free(x);
+  free(bad);
+  free(step);
+  free(maxerr);
+  free(retflag);
+  return retc;
+}
+
+static int32 tab_check(char *buf, size_t len, char *fname, char *serr)
+{
+  struct tab_header *h = (struct tab_header *) buf;
+  struct tab_dir *d;
+  size_t flen;
+  int32 b;
+  if (len < sizeof(struct tab_header) || memcmp(h->magic, SWETAB_MAGIC, 8) != 0) {
+    if (serr != NULL) sprintf(serr, "%.160s is not an ephemeris table", fname);
+    return ERR;
+  }
+  if (h->version != SWETAB_VERSION || h->hdrlen != (int32) sizeof(struct tab_header) || h->dirlen != (int32) sizeof(struct tab_dir)) {
+    if (serr != NULL) sprintf(serr, "%.160s: version %d not supported, or written on another platform", fname, h->version);
+    return ERR;
+  }
+  flen = sizeof(struct tab_header) + h->nbody * sizeof(struct tab_dir);
+  if (h->nbody < 0 || flen > len) {
+    if (serr != NULL) sprintf(serr, "%.160s is damaged", fname);
+    return ERR;
+  }
+  d = (struct tab_dir *) (buf + sizeof(struct tab_header));
+  for (b = 0; b < h->nbody; b++) {
+    if (d[b].npt < 6 || !(d[b].tstep > 0)) {
+      if (serr != NULL) sprintf(serr, "%.160s is damaged", fname);
+      return ERR;
+    }
+    flen += (size_t) d[b].npt * 3 * sizeof(double) + tab_nbadw(d[b].npt) * sizeof(uint32);
+  }
+  if (flen != len) {
+    if (serr != NULL) sprintf(serr, "%.160s is damaged", fname);
+    return ERR;
+  }
+  return OK;
+}
+
+#if MSDOS
+/* reads the whole file where files cannot be mapped */
+static char *tab_read_file(char *fname, size_t *len, char *serr)
+{
+  FILE *fp;
+  char *buf;
+  long n;
+  if ((fp = fopen(fname, BFILE_R_ACCESS)) == NULL) {
+    if (serr != NULL) sprintf(serr, "could not open file %.160s", fname);
+    return NULL;
+  }
+  if (fseek(fp, 0L, SEEK_END) != 0 || (n = ftell(fp)) < 0 || fseek(fp, 0L, SEEK_SET) != 0) {
+    if (serr != NULL) sprintf(serr, "fseek failed: %.160s", fname);
+    fclose(fp);
+    return NULL;
+  }
+  if ((buf = (char *) malloc(n > 0 ? (size_t) n : 1)) == NULL) {
+    if (serr != NULL) strcpy(serr, "could not allocate buffer for ephemeris table");
+    fclose(fp);
+    return NULL;
+  }
+  if (fread(buf, 1, (size_t) n, fp) != (size_t) n) {
+    if (serr != NULL) sprintf(serr, "error while trying to read %.160s", fname);
+    free(buf);
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+  *len = (size_t) n;
+  return buf;
+}
+#endif
+
+/* Opens the ephemeris table fname. The handle is read-only and may be
+ * shared by any number of threads. swe_tab_close() detaches it from the
+ * calling thread; the memory is freed when no other thread has it
+ * attached any more, i.e. when the last one calls swe_set_table() with
+ * another table or NULL, or swe_close(). A thread that ends with the
+ * table attached keeps it allocated. */
+struct swe_table *CALL_CONV swe_tab_open(char *fname, char *serr)
+{
+  struct swe_table *ptab;
+  char *p;
+  int32 b;
+  if (strlen(fname) >= AS_MAXCH) {
+    if (serr != NULL) sprintf(serr, "file name too long: %.160s", fname);
+    return NULL;
+  }
+  if ((ptab = (struct swe_table *) calloc(1, sizeof(struct swe_table))) == NULL) {
+    if (serr != NULL) strcpy(serr, "could not allocate ephemeris table handle");
+    return NULL;
+  }
+  strcpy(ptab->fname, fname);
+#if MSDOS
+  ptab->buf = tab_read_file(fname, &ptab->len, serr);
+#else
+  {
+    struct stat sb;
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+      if (serr != NULL) sprintf(serr, "could not open file %.160s", fname);
+    } else if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+      if (serr != NULL) sprintf(serr, "%.160s is not an ephemeris table", fname);
+    } else {
+      ptab->len = (size_t) sb.st_size;
+      ptab->buf = (char *) mmap(NULL, ptab->len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptab->buf == (char *) MAP_FAILED) {
+	if (serr != NULL) sprintf(serr, "could not map file %.160s", fname);
+	ptab->buf = NULL;
+      } else {
+	ptab->mapped = TRUE;
+      }
+    }
+    if (fd >= 0)
+      close(fd);
+  }
+#endif
+  if (ptab->buf == NULL || tab_check(ptab->buf, ptab->len, fname, serr) == ERR) {
+    swe_tab_close(ptab);
+    return NULL;
+  }
+  ptab->h = (struct tab_header *) ptab->buf;
+  ptab->dir = (struct tab_dir *) (ptab->buf + sizeof(struct tab_header));
+  ptab->x = (double **) calloc(ptab->h->nbody > 0 ? ptab->h->nbody : 1, sizeof(double *));
+  ptab->bad = (uint32 **) calloc(ptab->h->nbody > 0 ? ptab->h->nbody : 1, sizeof(uint32 *));
+  if (ptab->x == NULL || ptab->bad == NULL) {
+    if (serr != NULL) strcpy(serr, "could not allocate ephemeris table handle");
+    swe_tab_close(ptab);
+    return NULL;
+  }
+  for (b = 0; b < SWETAB_NIDX; b++)
+    ptab->idx[b] = -1;
+  p = (char *) (ptab->dir + ptab->h->nbody);
+  for (b = 0; b < ptab->h->nbody; b++) {
+    ptab->x[b] = (double *) p;
+    p += (size_t) ptab->dir[b].npt * 3 * sizeof(double);
+    ptab->bad[b] = (uint32 *) p;
+    p += tab_nbadw(ptab->dir[b].npt) * sizeof(uint32);
+    if (ptab->dir[b].ipl >= 0 && ptab->dir[b].ipl < SWETAB_NIDX && ptab->idx[ptab->dir[b].ipl] < 0)
+      ptab->idx[ptab->dir[b].ipl] = b;
+  }
+  return ptab;
+}
+
+static void tab_free(struct swe_table *ptab)
+{
+#if !MSDOS
+  if (ptab->mapped)
+    munmap(ptab->buf, ptab->len);
+  else
+#endif
+    free(ptab->buf);
+  free(ptab->x);
+  free(ptab->bad);
+  free(ptab);
+}
+
+void CALL_CONV swe_tab_close(struct swe_table *ptab)
+{
+  AS_BOOL unused;
+  if (ptab == NULL)
+    return;
+  if (swed.ptab == ptab)
+    swe_set_table(NULL, 0);
+  LOCK();
+  ptab->closed = TRUE;
+  unused = (ptab->nattach == 0);
+  UNLOCK();
+  if (unused)
+    tab_free(ptab);
+}
+
+static int32 tab_find(struct swe_table *ptab, int32 ipl)
+{
+  int32 b;
+  if (ipl >= 0 && ipl < SWETAB_NIDX)
+    return ptab->idx[ipl];
+  for (b = 0; b < ptab->h->nbody; b++) {
+    if (ptab->dir[b].ipl == ipl)
+      return b;
+  }
+  return -1;
+}
+
+/*
+ * Error bounds of body ipl, see the top of this file: maxerr[0..2] for
+ * longitude (or right ascension) and latitude (or declination) in arc
+ * seconds and distance in AU, maxerr[3..5] for their speeds per day.
+ * Positions in marked intervals come from swe_calc() and have no error.
+ * Returns the number of days between points, or ERR if ipl is not in the
+ * table.
+ */
+double CALL_CONV swe_tab_maxerr(struct swe_table *ptab, int32 ipl, double *maxerr)
+{
+  int32 b;
+  if ((b = tab_find(ptab, ipl)) < 0)
+    return ERR;
+  memcpy((void *) maxerr, (void *) ptab->dir[b].maxerr, 6 * sizeof(double));
+  return ptab->dir[b].tstep;
+}
+
+/* 
+ * Position of body ipl at tjd from the table, if it has the body and
+ * date, was built with flags iflag (SEFLG_SPEED aside) and the date is
+ * not in a marked interval. The speed is always computed. Returns
+ * NOT_AVAILABLE otherwise; maxerr < 0 accepts any error bound, else the
+ * bound of the body must not exceed maxerr.
+ */
+int32 swi_tab_calc(struct swe_table *ptab, double maxerr, double tjd, int32 ipl, int32 iflag, double *xx)
+{
+  struct tab_dir *d;
+  double xi[6];
+  int32 b, i;
+  if ((b = tab_find(ptab, ipl)) < 0)
+    return NOT_AVAILABLE;
+  d = &ptab->dir[b];
+  if ((iflag & ~(SEFLG_SPEED | SEFLG_SPEED3)) != d->iflag)
+    return NOT_AVAILABLE;
+  if (tjd < ptab->h->tjd0 || tjd > ptab->h->tjde)
+    return NOT_AVAILABLE;
+  if (maxerr >= 0 && (d->maxerr[0] > maxerr || d->maxerr[1] > maxerr))
+    return NOT_AVAILABLE;
+  i = tab_interpolate(ptab->x[b], d->npt, d->tfirst, d->tstep, tjd, xi);
+  if (ptab->bad[b][i / 32] & ((uint32) 1 << (i % 32)))
+    return NOT_AVAILABLE;
+  memcpy((void *) xx, (void *) xi, 6 * sizeof(double));
+  return d->iflag | (iflag & SEFLG_SPEED);
+}
+
+/*
+ * Like swe_calc() from the table, for the flags the table was built
+ * with; in marked intervals, swe_calc() is called. Returns the flags as
+ * swe_calc() would, or ERR if the body, date or flags are not in the
+ * table.
+ */
+int32 CALL_CONV swe_tab_calc(struct swe_table *ptab, double tjd, int32 ipl, int32 iflag, double *xx, char *serr)
+{
+  int32 retc, b, k;
+  double x[6];
+  if ((retc = swi_tab_calc(ptab, -1, tjd, ipl, iflag, x)) == NOT_AVAILABLE) {
+    b = tab_find(ptab, ipl);
+    if (b >= 0 && (iflag & ~(SEFLG_SPEED | SEFLG_SPEED3)) == ptab->dir[b].iflag
+      && tjd >= ptab->h->tjd0 && tjd <= ptab->h->tjde)
+      return swe_calc(tjd, ipl, iflag, xx, serr);
+    if (serr != NULL) sprintf(serr, "body %d with flags %d at jd %f not in ephemeris table %.160s", ipl, iflag, tjd, ptab->fname);
+    for (k = 0; k < 6; k++)
+      xx[k] = 0;
+    return ERR;
+  }
+  for (k = 0; k < 6; k++)
+    xx[k] = (k < 3 || (iflag & SEFLG_SPEED)) ? x[k] : 0;
+  return retc;
+}
+
+/*
+ * From now on, swe_calc_ut() in the calling thread takes positions from
+ * ptab wherever the table has them and their error bound (longitude and
+ * latitude) is at most maxerr arc seconds. NULL turns this off.
+ * The table previously attached is detached, and freed if it has been
+ * closed and this thread was the last one using it.
+ */
+void CALL_CONV swe_set_table(struct swe_table *ptab, double maxerr)
+{
+  struct swe_table *pold = swed.ptab;
+  AS_BOOL unused = FALSE;
+  swed.tab_maxerr = maxerr;
+  if (ptab == pold)
+    return;
+  LOCK();
+  if (ptab != NULL)
+    ptab->nattach++;
+  if (pold != NULL)
+    unused = (--pold->nattach == 0 && pold->closed);
+  UNLOCK();
+  swed.ptab = ptab;
+  if (unused)
+    tab_free(pold);
+}
@@ -0,0 +1,624 @@
+/* SWISSEPH
+ * 
+ * swevdb.c: indexed store of mundane aspects (sweasp.dat).
+ *
+ * The file consists of a fixed header, the aspect records in time order,
+ * a day index and the aspect phases that are still open at its end:
+ *
+ *   struct evdb_header
+ *   EVDBREC rec[nrec]
+ *   int32   dayidx[nday + 1]  records of day k: post[dayidx[k]] ..
+ *   int32   post[npost]       .. post[dayidx[k + 1] - 1]
+ *   struct evdb_open open[nopen]
+ *
+ * Every record is posted on each day its phase is within orb, so the
+ * aspects active at a date are found with one index lookup, whatever
+ * the size of the file. Readers map the file into memory. A later
+ * period can be appended: the writer resumes the open phases where the
+ * previous run left them and rewrites the file.
+ *
+ * IMPORTANT NOTICE: like swevents.c, this is not a supported part of
+ * Swiss Ephemeris.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#include "swevents.h"
+#if !MSDOS
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#define SWEVDB_MAGIC	"SWEVDB\r\n"	/* \r\n catches text mode transfers */
+#define SWEVDB_VERSION	1
+
+struct evdb_header {
+  char magic[8];
+  int32 version;
+  int32 hdrlen;          /* sizeof(struct evdb_header) */
+  int32 reclen;          /* sizeof(EVDBREC) */
+  int32 iflag;           /* flags of the event search */
+  double tstep;          /* step width of the event search */
+  double tjd0;           /* begin of period covered (TT) */
+  double tjde;           /* end of period covered: end of last search step */
+  int32 nrec;
+  int32 day0;            /* first day of index, see evdb_day() */
+  int32 nday;
+  int32 npost;
+  int32 nopen;
+  int32 spare;
+  char splan[SWEVDB_SPLAN_LEN];
+  char sasp[NASPMAX + 2];
+};
+
+/* state of the aspect phase of a body pair, like struct aspdat */
+struct evdb_open {
+  double tjd;            /* last exactness of the phase, 0 if none yet */
+  double tjd_pre;        /* crossing of pre-orb, 0 if not seen */
+  double tbeg;           /* begin of the phase */
+  int32 bpind;
+  int32 iasp;
+  int32 irec0;           /* first and last record of the phase */
+  int32 irec;
+};
+
+struct evdb_writer {
+  char fname[AS_MAXCH];
+  struct evdb_header h;
+  double tfrom;          /* begin of the period being added */
+  EVDBREC *rec;
+  int32 nrecmax;
+  struct evdb_open pair[NMAXPL * NMAXPL];
+};
+
+struct evdb {
+  char fname[AS_MAXCH];
+  char *buf;
+  size_t len;
+  AS_BOOL mapped;
+  struct evdb_header *h;
+  EVDBREC *rec;
+  int32 *dayidx;
+  int32 *post;
+};
+
+/* days begin at 0h TT */
+static int32 evdb_day(double tjd)
+{
+  return (int32) floor(tjd + 0.5);
+}
+
+static size_t evdb_align8(size_t n)
+{
+  return (n + 7) & ~((size_t) 7);
+}
+
+/* file offsets of the sections following the header */
+static void evdb_layout(struct evdb_header *h, size_t *off_day, size_t *off_post, size_t *off_open, size_t *len)
+{
+  *off_day = sizeof(struct evdb_header) + (size_t) h->nrec * sizeof(EVDBREC);
+  *off_post = *off_day + (size_t) (h->nday + 1) * sizeof(int32);
+  *off_open = evdb_align8(*off_post + (size_t) h->npost * sizeof(int32));
+  *len = *off_open + (size_t) h->nopen * sizeof(struct evdb_open);
+}
+
+static int32 evdb_check(char *buf, size_t len, char *fname, char *serr)
+{
+  struct evdb_header *h = (struct evdb_header *) buf;
+  size_t off_day, off_post, off_open, flen;
+  if (len < sizeof(struct evdb_header) || memcmp(h->magic, SWEVDB_MAGIC, 8) != 0) {
+    sprintf(serr, "%.160s is not an aspect database", fname);
+    return ERR;
+  }
+  if (h->version != SWEVDB_VERSION || h->hdrlen != (int32) sizeof(struct evdb_header) || h->reclen != (int32) sizeof(EVDBREC)) {
+    sprintf(serr, "%.160s: version %d not supported, or written on another platform", fname, h->version);
+    return ERR;
+  }
+  evdb_layout(h, &off_day, &off_post, &off_open, &flen);
+  if (h->nrec < 0 || h->nday < 1 || h->npost < 0 || h->nopen < 0 || flen != len) {
+    sprintf(serr, "%.160s is damaged", fname);
+    return ERR;
+  }
+  return OK;
+}
+
+/* reads the whole file, for the writer and where files cannot be mapped */
+static char *evdb_read_file(char *fname, size_t *len, char *serr)
+{
+  FILE *fp;
+  char *buf;
+  long n;
+  if ((fp = fopen(fname, BFILE_R_ACCESS)) == NULL) {
+    sprintf(serr, "could not open file %.160s", fname);
+    return NULL;
+  }
+  if (fseek(fp, 0L, SEEK_END) != 0 || (n = ftell(fp)) < 0 || fseek(fp, 0L, SEEK_SET) != 0) {
+    sprintf(serr, "fseek failed: %.160s", fname);
+    fclose(fp);
+    return NULL;
+  }
+  if ((buf = (char *) malloc(n > 0 ? (size_t) n : 1)) == NULL) {
+    strcpy(serr, "could not allocate buffer for aspect database");
+    fclose(fp);
+    return NULL;
+  }
+  if (fread(buf, 1, (size_t) n, fp) != (size_t) n) {
+    sprintf(serr, "error while trying to read %.160s", fname);
+    free(buf);
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+  *len = (size_t) n;
+  return buf;
+}
+
+static int is_node_apsis(int32 ipl) 
+{
+  if (ipl == SE_MEAN_NODE || ipl == SE_TRUE_NODE 
+    || ipl == SE_MEAN_APOG || ipl == SE_OSCU_APOG
+    || ipl == SE_INTP_APOG || ipl == SE_INTP_PERG)
+    return 1;
+  return 0;
+}
+
+/*
+ * Starts a new aspect database fname. Events from an aspect search
+ * beginning at tjd0 with step width tstep are added with swev_db_add();
+ * swev_db_commit() writes the file. iflag, splan and sasp are the
+ * settings of the search, stored for later appends.
+ */
+EVDBW *swev_db_create(char *fname, int32 iflag, double tjd0, double tstep, char *splan, char *sasp, char *serr)
+{
+  EVDBW *pdw;
+  if (strlen(fname) >= AS_MAXCH - 4) {
+    sprintf(serr, "file name too long: %.160s", fname);
+    return NULL;
+  }
+  if (strlen(splan) >= SWEVDB_SPLAN_LEN || strlen(sasp) >= NASPMAX + 2) {
+    sprintf(serr, "body or aspect string too long for aspect database");
+    return NULL;
+  }
+  if (tstep <= 0) {
+    sprintf(serr, "invalid time step %f", tstep);
+    return NULL;
+  }
+  if ((pdw = (EVDBW *) calloc(1, sizeof(EVDBW))) == NULL) {
+    strcpy(serr, "could not allocate aspect database writer");
+    return NULL;
+  }
+  strcpy(pdw->fname, fname);
+  memcpy(pdw->h.magic, SWEVDB_MAGIC, 8);
+  pdw->h.version = SWEVDB_VERSION;
+  pdw->h.hdrlen = (int32) sizeof(struct evdb_header);
+  pdw->h.reclen = (int32) sizeof(EVDBREC);
+  pdw->h.iflag = iflag;
+  pdw->h.tstep = tstep;
+  pdw->h.tjd0 = tjd0;
+  pdw->h.tjde = tjd0;
+  strcpy(pdw->h.splan, splan);
+  strcpy(pdw->h.sasp, sasp);
+  pdw->tfrom = tjd0;
+  return pdw;
+}
+
+/*
+ * Reopens the aspect database fname for appending. The search must be
+ * continued with the stored settings, which are returned in iflag,
+ * tstep, splan (SWEVDB_SPLAN_LEN chars) and sasp (NASPMAX + 2 chars),
+ * from *tjd0 = end of the period covered so far.
+ */
+EVDBW *swev_db_append(char *fname, int32 *iflag, double *tjd0, double *tstep, char *splan, char *sasp, char *serr)
+{
+  EVDBW *pdw;
+  struct evdb_header *h;
+  struct evdb_open *po;
+  size_t len, off_day, off_post, off_open, flen;
+  char *buf;
+  int32 i;
+  if ((buf = evdb_read_file(fname, &len, serr)) == NULL)
+    return NULL;
+  if (evdb_check(buf, len, fname, serr) == ERR) {
+    free(buf);
+    return NULL;
+  }
+  h = (struct evdb_header *) buf;
+  if ((pdw = swev_db_create(fname, h->iflag, h->tjd0, h->tstep, h->splan, h->sasp, serr)) == NULL) {
+    free(buf);
+    return NULL;
+  }
+  pdw->h.tjde = pdw->tfrom = h->tjde;
+  pdw->h.nrec = pdw->nrecmax = h->nrec;
+  if (h->nrec > 0) {
+    if ((pdw->rec = (EVDBREC *) malloc(h->nrec * sizeof(EVDBREC))) == NULL) {
+      strcpy(serr, "could not allocate aspect records");
+      free(buf);
+      free(pdw);
+      return NULL;
+    }
+    memcpy(pdw->rec, buf + sizeof(struct evdb_header), h->nrec * sizeof(EVDBREC));
+  }
+  evdb_layout(h, &off_day, &off_post, &off_open, &flen);
+  po = (struct evdb_open *) (buf + off_open);
+  for (i = 0; i < h->nopen; i++) {
+    if (po[i].bpind < 0 || po[i].bpind >= NMAXPL * NMAXPL || po[i].irec >= h->nrec) {
+      sprintf(serr, "%.160s is damaged", fname);
+      free(buf);
+      swev_db_discard(pdw);
+      return NULL;
+    }
+    pdw->pair[po[i].bpind] = po[i];
+  }
+  *iflag = h->iflag;
+  *tjd0 = h->tjde;
+  *tstep = h->tstep;
+  strcpy(splan, h->splan);
+  strcpy(sasp, h->sasp);
+  free(buf);
+  return pdw;
+}
+
+/* the post-orb crossing ends the phase of body pair pp */
+static void close_phase(EVDBW *pdw, struct evdb_open *pp, double tend)
+{
+  int32 i;
+  for (i = pp->irec0; i <= pp->irec && i < pdw->h.nrec; i++) {
+    if (pdw->rec[i].bpind == pp->bpind && pdw->rec[i].tend == 0)
+      pdw->rec[i].tend = tend;
+  }
+}
+
+/* 
+ * Adds a mundane aspect event, as delivered by swev_iter_next(). Events
+ * must be added in time order.
+ */
+int32 swev_db_add(EVDBW *pdw, EVENT *pev, char *serr)
+{
+  struct evdb_open *pp;
+  EVDBREC *pr;
+  if (pev->bpind < 0 || pev->bpind >= NMAXPL * NMAXPL) {
+    sprintf(serr, "invalid body pair index %d", pev->bpind);
+    return ERR;
+  }
+  pp = &(pdw->pair[pev->bpind]);
+  pp->bpind = pev->bpind;
+  /* new aspect between body pair: init structure */
+  if (pp->tjd == 0 && pp->tjd_pre == 0) 
+    pp->iasp = -1;
+  if (pp->iasp != pev->iasp) {
+    /* the post-orb of the previous phase was missed: let the phase end
+     * at its last exactness */
+    if (pp->tjd != 0)
+      close_phase(pdw, pp, pp->tjd);
+    pp->tjd = 0;
+    pp->tjd_pre = 0;
+    pp->iasp = pev->iasp;
+  }
+  /* aspect is exact, or closest approach within orb */
+  if (pev->dasp == pev->dang) {
+    if (pdw->h.nrec == pdw->nrecmax) {
+      int32 n = pdw->nrecmax == 0 ? 1024 : 2 * pdw->nrecmax;
+      if ((pr = (EVDBREC *) realloc(pdw->rec, n * sizeof(EVDBREC))) == NULL) {
+	strcpy(serr, "could not allocate aspect records");
+	return ERR;
+      }
+      pdw->rec = pr;
+      pdw->nrecmax = n;
+    }
+    /* if there was another exactness before this one, we delete tjd_pre */
+    if (pp->tjd != 0) {
+      pp->tjd_pre = 0;
+    } else {
+      /* first exactness of the phase; without pre-orb, the aspect was
+       * within orb at the begin of the file already */
+      pp->tbeg = (pp->tjd_pre != 0) ? pp->tjd_pre : pdw->h.tjd0;
+      pp->irec0 = pdw->h.nrec;
+    }
+    pp->tjd = pev->tjd;
+    pp->irec = pdw->h.nrec;
+    pr = pdw->rec + pdw->h.nrec;
+    memset((void *) pr, 0, sizeof(EVDBREC));
+    pr->tjd = pev->tjd;
+    pr->tjd_pre = pp->tjd_pre;
+    pr->tbeg = pp->tbeg;
+    pr->dasp = pev->dasp;
+    pr->dorb = pev->dorb;
+    pr->ipla = pev->ipla;
+    pr->iplb = pev->iplb;
+    pr->iasp = pev->iasp;
+    pr->bpind = pev->bpind;
+    /* aspects between nodes and apsides have no orbs */
+    if (is_node_apsis(pev->ipla) && is_node_apsis(pev->iplb))
+      pr->tbeg = pr->tend = pev->tjd;
+    pdw->h.nrec++;
+  /* entering orb: save tjd_pre */
+  } else if (pp->tjd == 0) {
+    pp->tjd_pre = pev->tjd;
+  /* leaving orb */
+  } else {
+    pdw->rec[pp->irec].tjd_post = pev->tjd;
+    close_phase(pdw, pp, pev->tjd);
+    pp->iasp = -1;
+    pp->tjd = 0;
+    pp->tjd_pre = 0;
+  }
+  return OK;
+}
+
+void swev_db_discard(EVDBW *pdw)
+{
+  if (pdw == NULL)
+    return;
+  free(pdw->rec);
+  free(pdw);
+}
+
+/*
+ * Writes the database, now covering the period up to tjde, and frees
+ * the writer. The end is moved forward to the end of the last search
+ * step, so that an append continues on the same step grid.
+ */
+int32 swev_db_commit(EVDBW *pdw, double tjde, char *serr)
+{
+  struct evdb_header *h = &(pdw->h);
+  struct evdb_open *po;
+  int32 *dayidx = NULL, *post = NULL;
+  int32 i, d, d0, d1, n;
+  size_t off_day, off_post, off_open, len;
+  double t;
+  char ftmp[AS_MAXCH + 8], pad[8];
+  FILE *fp = NULL;
+  int32 retc = ERR;
+  for (t = pdw->tfrom; t < tjde; t += h->tstep)
+    ;
+  h->tjde = t;
+  /* day index: count, then fill the postings of each record's phase */
+  h->day0 = evdb_day(h->tjd0);
+  h->nday = evdb_day(h->tjde) - h->day0 + 1;
+  if ((dayidx = (int32 *) calloc(h->nday + 1, sizeof(int32))) == NULL) {
+    strcpy(serr, "could not allocate day index");
+    goto commit_end;
+  }
+  for (i = 0; i < h->nrec; i++) {
+    d0 = evdb_day(pdw->rec[i].tbeg) - h->day0;
+    d1 = (pdw->rec[i].tend == 0) ? h->nday - 1 : evdb_day(pdw->rec[i].tend) - h->day0;
+    if (d0 < 0) d0 = 0;
+    if (d1 > h->nday - 1) d1 = h->nday - 1;
+    for (d = d0; d <= d1; d++)
+      dayidx[d + 1]++;
+  }
+  for (d = 0; d < h->nday; d++)
+    dayidx[d + 1] += dayidx[d];
+  h->npost = dayidx[h->nday];
+  if ((post = (int32 *) malloc((h->npost + 1) * sizeof(int32))) == NULL) {
+    strcpy(serr, "could not allocate day index");
+    goto commit_end;
+  }
+  for (i = 0; i < h->nrec; i++) {
+    d0 = evdb_day(pdw->rec[i].tbeg) - h->day0;
+    d1 = (pdw->rec[i].tend == 0) ? h->nday - 1 : evdb_day(pdw->rec[i].tend) - h->day0;
+    if (d0 < 0) d0 = 0;
+    if (d1 > h->nday - 1) d1 = h->nday - 1;
+    for (d = d0; d <= d1; d++)
+      post[dayidx[d]++] = i;
+  }
+  /* dayidx[d] now points to the end of day d */
+  for (d = h->nday; d > 0; d--)
+    dayidx[d] = dayidx[d - 1];
+  dayidx[0] = 0;
+  h->nopen = 0;
+  for (i = 0; i < NMAXPL * NMAXPL; i++) {
+    po = &(pdw->pair[i]);
+    if (po->iasp >= 0 && (po->tjd != 0 || po->tjd_pre != 0))
+      h->nopen++;
+  }
+  evdb_layout(h, &off_day, &off_post, &off_open, &len);
+  /* write to a temporary file and replace the old one */
+  sprintf(ftmp, "%s.tmp", pdw->fname);
+  if ((fp = fopen(ftmp, BFILE_W_CREATE)) == NULL) {
+    sprintf(serr, "could not open file %.160s", ftmp);
+    goto commit_end;
+  }
+  memset(pad, 0, sizeof(pad));
+  n = 0;
+  n += fwrite((void *) h, sizeof(struct evdb_header), 1, fp) != 1;
+  if (h->nrec > 0)
+    n += fwrite((void *) pdw->rec, sizeof(EVDBREC), h->nrec, fp) != (size_t) h->nrec;
+  n += fwrite((void *) dayidx, sizeof(int32), h->nday + 1, fp) != (size_t) (h->nday + 1);
+  if (h->npost > 0)
+    n += fwrite((void *) post, sizeof(int32), h->npost, fp) != (size_t) h->npost;
+  if (off_open > off_post + h->npost * sizeof(int32))
+    n += fwrite(pad, off_open - off_post - h->npost * sizeof(int32), 1, fp) != 1;
+  for (i = 0; i < NMAXPL * NMAXPL; i++) {
+    po = &(pdw->pair[i]);
+    if (po->iasp >= 0 && (po->tjd != 0 || po->tjd_pre != 0))
+      n += fwrite((void *) po, sizeof(struct evdb_open), 1, fp) != 1;
+  }
+  if (fclose(fp) != 0 || n != 0) {
+    sprintf(serr, "error while trying to write %.160s", ftmp);
+    remove(ftmp);
+    goto commit_end;
+  }
+#if MSDOS
+  remove(pdw->fname);
+#endif
+  if (rename(ftmp, pdw->fname) != 0) {
+    sprintf(serr, "could not rename %.100s to %.100s", ftmp, pdw->fname);
+    remove(ftmp);
+    goto commit_end;
+  }
+  retc = OK;
+commit_end:
+  free(dayidx);
+  free(post);
+  swev_db_discard(pdw);
+  return retc;
+}
+
+/* Opens the aspect database fname for queries. */
+EVDB *swev_db_open(char *fname, char *serr)
+{
+  EVDB *pdb;
+  size_t off_day, off_post, off_open, len;
+  if (strlen(fname) >= AS_MAXCH) {
+    sprintf(serr, "file name too long: %.160s", fname);
+    return NULL;
+  }
+  if ((pdb = (EVDB *) calloc(1, sizeof(EVDB))) == NULL) {
+    strcpy(serr, "could not allocate aspect database handle");
+    return NULL;
+  }
+  strcpy(pdb->fname, fname);
+#if MSDOS
+  pdb->buf = evdb_read_file(fname, &pdb->len, serr);
+#else
+  {
+    struct stat sb;
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+      sprintf(serr, "could not open file %.160s", fname);
+    } else if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+      sprintf(serr, "%.160s is not an aspect database", fname);
+    } else {
+      pdb->len = (size_t) sb.st_size;
+      pdb->buf = (char *) mmap(NULL, pdb->len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (pdb->buf == (char *) MAP_FAILED) {
+	sprintf(serr, "could not map file %.160s", fname);
+	pdb->buf = NULL;
+      } else {
+	pdb->mapped = TRUE;
+      }
+    }
+    if (fd >= 0)
+      close(fd);
+  }
+#endif
+  if (pdb->buf == NULL || evdb_check(pdb->buf, pdb->len, fname, serr) == ERR) {
+    swev_db_close(pdb);
+    return NULL;
+  }
+  pdb->h = (struct evdb_header *) pdb->buf;
+  evdb_layout(pdb->h, &off_day, &off_post, &off_open, &len);
+  pdb->rec = (EVDBREC *) (pdb->buf + sizeof(struct evdb_header));
+  pdb->dayidx = (int32 *) (pdb->buf + off_day);
+  pdb->post = (int32 *) (pdb->buf + off_post);
+  return pdb;
+}
+
+/* All records in time order, and the period covered. */
+EVDBREC *swev_db_records(EVDB *pdb, int32 *nrec, double *tjd0, double *tjde)
+{
+  *nrec = pdb->h->nrec;
+  *tjd0 = pdb->h->tjd0;
+  *tjde = pdb->h->tjde;
+  return pdb->rec;
+}
+
+/*
+ * Numbers of the records whose phases are within orb at some time
+ * between tjd - dtol and tjd + dtol, at most nmax. Returns their count,
+ * or ERR if tjd is outside the file or more than nmax are found.
+ */
+int32 swev_db_active(EVDB *pdb, double tjd, double dtol, int32 *irec, int32 nmax, char *serr)
+{
+  struct evdb_header *h = pdb->h;
+  EVDBREC *pr;
+  int32 d, d0, d1, k, n = 0;
+  double tend;
+  if (tjd < h->tjd0 || tjd >= h->tjde) {
+    sprintf(serr, "date %f is beyond range of file %.160s (%.0f - %.0f)", tjd, pdb->fname, h->tjd0, h->tjde);
+    return ERR;
+  }
+  d0 = evdb_day(tjd - dtol) - h->day0;
+  d1 = evdb_day(tjd + dtol) - h->day0;
+  if (d0 < 0) d0 = 0;
+  if (d1 > h->nday - 1) d1 = h->nday - 1;
+  for (d = d0; d <= d1; d++) {
+    for (k = pdb->dayidx[d]; k < pdb->dayidx[d + 1]; k++) {
+      pr = pdb->rec + pdb->post[k];
+      /* posted on the previous day already */
+      if (d > d0 && evdb_day(pr->tbeg) - h->day0 < d)
+	continue;
+      tend = (pr->tend == 0) ? h->tjde : pr->tend;
+      if (pr->tbeg > tjd + dtol || tend < tjd - dtol)
+	continue;
+      if (n == nmax) {
+	sprintf(serr, "more than %d aspects active at %f", nmax, tjd);
+	return ERR;
+      }
+      irec[n++] = pdb->post[k];
+    }
+  }
+  return n;
+}
+
+void swev_db_close(EVDB *pdb)
+{
+  if (pdb == NULL)
+    return;
+#if !MSDOS
+  if (pdb->mapped)
+    munmap(pdb->buf, pdb->len);
+  else
+#endif
+    free(pdb->buf);
+  free(pdb);
+}
@@ -114,6 +114,10 @@ static char *info1 = "\n\
 	-doing45	crossings over 15 tau, Leo, Sco, Aqu\n\
 	-dolphase	report lunar phases (use with -p1)\n\
 	-doasp	report aspects between planets (-p option is ignored)\n\
+		and write them to the aspect database sweasp.dat\n\
+	-append	with -doasp: continue the existing sweasp.dat up to\n\
+		the end date, with the settings stored in it\n\
+	-getday	list the aspects in orb at the begin date, from sweasp.dat\n\
 	-dovoc	report Moon void of course periods (-p option is ignored)\n\
 	-noingr  no ingresses\n\
 	-motab  special format Moon ingres table\n\
@@ -274,6 +278,7 @@ AS_BOOL show_jd = FALSE;
 AS_BOOL print_cl = TRUE;
 AS_BOOL output_extra_prec = FALSE;
 AS_BOOL get_data_of_day = FALSE;
+AS_BOOL db_append = FALSE;
 AS_BOOL transits_to_stderr = FALSE;
 double	phase_mod = 90;
 char **znam = zod_nam;
@@ -304,7 +309,6 @@ static char *set_planet_name(int ipl);
 
 // from old swevents.c
 static char *hms(double x, int32 iflag);
-static int32 get_next_voc(double tet0, int32 iflag, int32 vocmethod, VOC *pvoc, char *serr);
 static int32 calc_all_crossings(
               int32 iflag,    /* swiss ephemeris flags */
               int32 itype,    /* type of calculation:
@@ -323,7 +327,6 @@ static int32 calc_all_crossings(
              );
 static int32 calc_all_voc(int32 iflag, double te, double tend, char *serr);
 static int32 extract_data_of_day(int32 do_flag, double te, double dtol, char *splan, char *sasp, EVENT *pev, char *serr);
-static int letter_to_ipl(int letter);
 
 
 
@@ -425,6 +428,8 @@ int main(int argc, char *argv[])
       iplfrom = SE_MOON;
     } else if (strcmp(argv[i], "-getday") == 0) {
       get_data_of_day = TRUE;
+    } else if (strcmp(argv[i], "-append") == 0) {
+      db_append = TRUE;
     } else if (strcmp(argv[i], "-et") == 0) {
       ephemeris_time = TRUE;
     } else if (strcmp(argv[i], "-jd") == 0) {
@@ -1801,251 +1806,6 @@ static int find_maximum(double y00, double y11, double y2, double dx,
 }
 
 // stuff from old swevents.c
-/* 
- * aspect codes
- * 1:   0
- * 2: 180
- * 3:  90
- * 4: 120
- * 5:  60
- * 6:  30
- * 7: 150
- * 8:  72
- * 9: 144
- * A:  45
- * B: 135
- * C:   0  parallel
- * D:   0  anti-parallel
- * input: 
- * sasp   aspects string, e.g. "1234567"
- * output:
- * dasp   aspect angles: 0, 180, 90, 270, 120, 240, 60, 300, 30, 330, 150, 210
- * saspi  aspects string that defines the angles: 123344556677
- */
-static int32 get_aspect_angles(char *sasp, char *saspi, double *dasp, char *serr)
-{
-  int nasp = 0;
-  char *sp;
-  *saspi = '\0';
-  for (sp = sasp; *sp != '\0'; sp++) {
-    switch (*sp) {
-    case '1': 
-      dasp[nasp] = 0;  
-      strcat(saspi, "1");
-      nasp++;
-      break;
-    case '2': 
-      dasp[nasp] = 180;  
-      strcat(saspi, "2");
-      nasp++;
-      break;
-    case '3': 
-      dasp[nasp] = 90;  
-      nasp++;
-      dasp[nasp] = 270;  
-      nasp++;
-      strcat(saspi, "33");
-      break;
-    case '4': 
-      dasp[nasp] = 120;  
-      nasp++;
-      dasp[nasp] = 240;  
-      nasp++;
-      strcat(saspi, "44");
-      break;
-    case '5': 
-      dasp[nasp] = 60;  
-      nasp++;
-      dasp[nasp] = 300;  
-      nasp++;
-      strcat(saspi, "55");
-      break;
-    case '6': 
-      dasp[nasp] = 30;  
-      nasp++;
-      dasp[nasp] = 330;  
-      nasp++;
-      strcat(saspi, "66");
-      break;
-    case '7': 
-      dasp[nasp] = 150;  
-      nasp++;
-      dasp[nasp] = 210;  
-      nasp++;
-      strcat(saspi, "77");
-      break;
-    case '8': 
-      dasp[nasp] = 72;  
-      nasp++;
-      dasp[nasp] = 288;  
-      nasp++;
-      strcat(saspi, "88");
-      break;
-    case '9': 
-      dasp[nasp] = 144;  
-      nasp++;
-      dasp[nasp] = 216;  
-      nasp++;
-      strcat(saspi, "99");
-      break;
-    case 'A': 
-      dasp[nasp] = 45;  
-      nasp++;
-      dasp[nasp] = 315;  
-      nasp++;
-      strcat(saspi, "AA");
-      break;
-    case 'B': 
-      dasp[nasp] = 135;  
-      nasp++;
-      dasp[nasp] = 225;  
-      nasp++;
-      strcat(saspi, "BB");
-      break;
-    default:
-      sprintf(serr, "aspects string %s is invalid", sasp);
-      return ERR;
-      break;
-    }
-  }
-  return nasp;
-}
-
-static int32 call_swe_calc(double tjd, int32 ipl, int32 iflag, char *star, double *x, char * serr)
-{
-  if (ipl == -2) 
-    fprintf(stderr, "hallo %d %s\n", ipl, star);
-  if (ipl == SE_FIXSTAR) {
-    return swe_fixstar(star, tjd, iflag, x, serr);
-  } else {
-    return swe_calc(tjd, ipl, iflag, x, serr);
-  }
-}
-
-/* 
- * Binary search of minimum orb with an almost-aspect 
- * and of exact aspects that happen twice within step width
- */
-static int get_crossing_bin_search(double dt, double tt0, double dang, double xta1,  double xta2,  double xtb1,  double xtb2, double *tret, int32 ipla, int32 iplb, char *stara, char *starb, int32 iflag, AS_BOOL is_transit, char *serr)
-{
-  double d12, d1, tt1, xa[6], xb[6];
-  /*swe_revjul(tt0, 1, &jyear, &jmon, &jday, &jut);
-  printf("%d%02d%02d %.2f: %c - %c %d\n", jyear, jmon, jday, jut, *spa, *spb, (int) dang);*/
-  d1 = swe_degnorm(xta1 - xtb1 - dang);
-  if (d1 > 180) d1 -= 360;
-  while(dt > HUNDTHOFSEC) {
-    dt /= 2.0;
-    tt1 = tt0 + dt;
-    if (call_swe_calc(tt1, ipla, iflag, stara, xa, serr) == ERR)
-      return ERR;
-    if (is_transit)
-      xb[0] = xtb1;
-    else
-      if (call_swe_calc(tt1, iplb, iflag, starb, xb, serr) == ERR)
-	return ERR;
-    d12 = swe_degnorm(xa[0] - xb[0] - dang);
-    if (d12 > 180) d12 -= 360;
-    if (d1 * d12 < 0) {
-      xta2 = xa[0];
-      xtb2 = xb[0];
-    } else {
-      xta1 = xa[0];
-      xtb1 = xb[0];
-      tt0 += dt;
-    }
-    d1 = swe_degnorm(xta1 - xtb1 - dang);
-    if (d1 > 180) d1 -= 360;
-  }
-  *tret = tt0;
-  return OK;
-}
-
-/* Binary search of exact aspect
- * This function finds aspects if exactness occurs only once within step
- * width */
-static int get_near_crossing_bin_search(double dt, double tt0, double dang, double xta1,  double xta2,  double xtb1,  double xtb2, double *tret, double *tret2, double *dorb, int32 ipla, int32 iplb, char *stara, char *starb, int32 iflag, char *serr)
-{
-  double d12, d1, d2, tt1, xa[6], xb[6];
-  *tret = 0;
-  *tret2 = 0;
-  *dorb = 0;
-  /*swe_revjul(tt0, 1, &jyear, &jmon, &jday, &jut);
-  printf("%d%02d%02d %.2f: %c - %c %d\n", jyear, jmon, jday, jut, *spa, *spb, (int) dang);*/
-  d1 = swe_degnorm(xta1 - xtb1 - dang);
-  if (d1 > 180) d1 -= 360;
-  d2 = swe_degnorm(xta2 - xtb2 - dang);
-  if (d2 > 180) d2 -= 360;
-  while(dt > HUNDTHOFSEC) {
-    dt /= 2.0;
-    tt1 = tt0 + dt;
-    if (call_swe_calc(tt1, ipla, iflag, stara, xa, serr) == ERR)
-      return ERR;
-    if (call_swe_calc(tt1, iplb, iflag, starb, xb, serr) == ERR)
-      return ERR;
-    d12 = swe_degnorm(xa[0] - xb[0] - dang);
-    if (d12 > 180) d12 -= 360;
-    if (d1 * d12 < 0 || d12 * d2 < 0) {
-      if (get_crossing_bin_search(dt, tt0, dang, xta1, xa[0], xtb1, xb[0], tret, ipla, iplb, stara, starb, iflag, FALSE, serr) == ERR)
-	return ERR;
-      if (get_crossing_bin_search(dt, tt1, dang, xa[0], xta2, xb[0], xtb2, tret2, ipla, iplb, stara, starb, iflag, FALSE, serr) == ERR)
-	return ERR;
-      *dorb = 0;
-      return OK;
-      /*sprintf(serr, "crossing missed near t=%f, ipl1=%d, ipl2=%d, dang=%.0f\n", tt1, ipla, iplb, dang);
-      return ERR;*/
-    } else if (fabs(d2) > fabs(d1)) {
-      xta2 = xa[0];
-      xtb2 = xb[0];
-    } else {
-      xta1 = xa[0];
-      xtb1 = xb[0];
-      tt0 += dt;
-    }
-    d1 = swe_degnorm(xta1 - xtb1 - dang);
-    if (d1 > 180) d1 -= 360;
-    d2 = swe_degnorm(xta2 - xtb2 - dang);
-    if (d2 > 180) d2 -= 360;
-  }
-  *tret = tt0;
-  *dorb = d1;
-  return OK;
-}
-
-static void fill_pev_day(EVENT *pevd, double tjd, int ipla, int iplb, char *stara, char *starb, int iasp, int bpind, double dasp, double dang, double dorb, char *strg) 
-{
-  int jyear, jmon, jday;
-  double jut;
-  char s[AS_MAXCH];
-  char spl1[30], spl2[30];
-  swe_get_planet_name(ipla, spl1);
-  swe_get_planet_name(iplb, spl2);
-  if (ipla == SE_FIXSTAR) 
-    strcpy(spl1, stara);
-  if (iplb == SE_FIXSTAR) 
-    strcpy(spl2, starb);
-  spl1[3] = '\0';
-  spl2[3] = '\0';
-  pevd->ipla = ipla;
-  pevd->iplb = iplb;
-  strcpy(pevd->stnama, spl1);
-  strcpy(pevd->stnamb, spl2);
-  pevd->tjd = tjd;
-  pevd->iasp = iasp;
-  pevd->bpind = bpind;
-  pevd->dasp = dasp;
-  pevd->dang = dang;
-  pevd->dorb = dorb;
-  tjd -= swe_deltat(tjd);  /* now we have UT */
-  swe_revjul(tjd, 1, &jyear, &jmon, &jday, &jut);
-  sprintf(s, "%d/%02d/%02d %s: %s - %s ang=%d", jyear, jmon, jday, hms(jut, BIT_LZEROES), spl1, spl2, (int) dang);
-  if (fabs(dorb) > 0)
-    sprintf(s + strlen(s), " orb=%.4f", dorb);
-  if (strg != NULL && *strg != '\0')
-    sprintf(s + strlen(s), " %s", strg);
-  strcat(s, "\n");
- /*  printf(s);*/
-}
-
 static void test_print_date(double tjd, int ipla, int iplb, char *stara, char *starb, double dang, double dorb, char *strg) 
 {
   int jyear, jmon, jday;
@@ -2071,115 +1831,34 @@ static void test_print_date(double tjd, int ipla, int iplb, char *stara, char *s
   printf("%s", s);
 }
 
-static char *forw_splan(char *sp)
-{
-  char *sp2;
-  /*fprintf(stderr, "vor=%s; ", sp);*/
-  if (*sp == ',') {
-    sp2 = strchr(sp, ']');
-    if (sp2 == NULL)
-      sp = sp + strlen(sp); /* end of string splan */
-    else
-      sp = sp2 + 1;
-  } else {
-    sp++;
-  }
-  /* fprintf(stderr, "nach=%s;\n", sp);*/
-  return sp;
-}
-
-/*
- * Function returns the ipl or name (if star) of the next object in 
- * the planets string.
- * The planets string is formed as follows:
- * "0123456789mtAFD,f[Gal],f[Ald],a[136199],a[433]"
- * The characters before the comma are planet codes as we use them
- * in other software.
- * Asteroids are coded as follows ",a[mpc_number]".
- * Fixed stars are coded as follows ",f[star_name]".
- */
-static int32 letter_to_ipl_or_star(char *s, char *stnam)
-{
-  char *sp, *sp2;
-  int ipl = letter_to_ipl((int) *s);
-  if (*s == ',') {
-    sp = s + 1;
-    /* fixed star */
-    if (*sp == 'f') {
-      sp += 2;
-      sp2 = strchr(sp, ']');
-      if (sp2 == NULL) { /* bracket at end of string missing */
-        strcpy(stnam, sp);
-      } else {
-        strncpy(stnam, sp, sp2 - sp);
-	stnam[sp2 - sp] = '\0';
-      }
-      ipl = SE_FIXSTAR;
-    } else if (*sp == 'a') {
-      sp += 2;
-      ipl = atoi(sp) + SE_AST_OFFSET;
-    }
-  }
-  return ipl;
-}
-
-static int pev_compare(const EVENT *a1, const EVENT *a2)
-{
-  if (a1->tjd > a2->tjd)
-    return 1;
-  if (a1->tjd < a2->tjd)
-    return -1;
-  return 0;
-}
-
-#define SWEV_ASPORB 1
 #define NSTARS_MAX 30
-#define NMAXPL 50
-#define NEAR_CROSSING_ORB 1
 #define FOUTNAM   "sweasp.dat"
 #define PATH_FOUTNAM   "."
 
 static int read_sweasp_dat(char *foutnam) 
 {
-  FILE *fpout;
+  EVDB *pdb;
+  EVDBREC *pr;
   char serr[AS_MAXCH];
-  int32 flen = 0, headerlen = 0;
-  int32 i, nrec = 0, ipla, iplb, iasp;
-  double tjd, dasp, tjd_pre, tjd_post;
+  int32 i, nrec = 0, ipla, iplb;
+  double tjd, dasp, tjd_pre, tjd_post, tjd0, tjde;
   int jyear, jmon, jday;
   double jut, dorb, dur;
-  char s[AS_MAXCH], *sp;
+  char s[AS_MAXCH];
   char spl1[30], spl2[30];
   /* open aspects file */
-  if ((fpout = fopen(foutnam, BFILE_R_ACCESS)) == NULL) {
-    sprintf(serr, "could not open file %s", foutnam);
-    return ERR;
-  }
-  while (fgets(s, AS_MAXCH, fpout) != NULL && (sp = strchr(s, '\n')) != NULL) {
-    headerlen += strlen(s);
-    if (strncmp(s, "####", 4) == 0) 
-      break;
-  }
-  if (fseek(fpout, 0L, SEEK_END) != 0) {
-    sprintf(serr, "fseek failed (SEEK_END): %s", foutnam);
+  if ((pdb = swev_db_open(foutnam, serr)) == NULL)
     return ERR;
-  }
-  flen = ftell(fpout) - headerlen;
-  nrec = flen / 52;
-  if (fseek(fpout, headerlen, SEEK_SET) != 0) {
-    sprintf(serr, "fseek failed (SEEK_SET): %s", foutnam);
-    return ERR;
-  }
+  pr = swev_db_records(pdb, &nrec, &tjd0, &tjde);
 dur = 0;
-  for (i = 0; i < nrec; i++) {
-    fread((void *) &tjd, sizeof(double), 1, fpout);
-    fread((void *) &ipla, sizeof(int32), 1, fpout);
-    fread((void *) &iplb, sizeof(int32), 1, fpout);
-    fread((void *) &iasp, sizeof(int32), 1, fpout);
-    fread((void *) &dasp, sizeof(double), 1, fpout);
-    fread((void *) &dorb, sizeof(double), 1, fpout);
-    fread((void *) &tjd_pre, sizeof(double), 1, fpout);
-    fread((void *) &tjd_post, sizeof(double), 1, fpout);
+  for (i = 0; i < nrec; i++, pr++) {
+    tjd = pr->tjd;
+    ipla = pr->ipla;
+    iplb = pr->iplb;
+    dasp = pr->dasp;
+    dorb = pr->dorb;
+    tjd_pre = pr->tjd_pre;
+    tjd_post = pr->tjd_post;
     if ((0)) { /* test output find longest possible aspect duration */
       if (ipla <= 9 && tjd_pre > 0 && tjd_post > 0 && tjd_post - tjd_pre > dur) {
 	dur = tjd_post - tjd_pre;
@@ -2202,7 +1881,7 @@ dur = 0;
     strcat(s, "\n");
     fprintf(stderr, "%s", s);
   }
-  fclose(fpout);
+  swev_db_close(pdb);
   return OK;
 }
 
@@ -2210,471 +1889,89 @@ dur = 0;
  * The algorithm finds
  * 1. exact aspects
  * 2. near aspects with orb < 3 before the planets separate again
+ * and writes them to the aspect database sweasp.dat. With -append, the
+ * existing database is continued up to tjde with its own settings.
  */
 int32 calc_mundane_aspects(int32 iflag, double tjd0, double tjde, double tstep, 
   char *splan, char *sasp, EVENT *pev, char *serr)
 {
-  int32 ipl, ipla, iplb, ipli, iplia, iplib, bpind;
-  char *sp, *spa, *spb;
-  char stnam[40], stnama[40], stnamb[40];
-  double t, tt0, tret, tret2, dang = 0, dorb = 0;
-  double x[6], x1[30], x2[30], x1d[30], x2d[30];
-  double xa[6], xa1[30], xa2[30], xa1d[30], xa2d[30];
-  double d1d, d2d;
-  double xta1, xta2, xtb1, xtb2, dt, d1, d2;
-  int32 retflag = 0;
-  int32 jyear, jmon, jday;
-  double jut;
-  char saspi[30];
-  double dasp[30];
-  int iaspi;
-  int nasp = get_aspect_angles(sasp, saspi, dasp, serr);
-  int nev;
-  EVENT events_day[500], *pevd = &(events_day[0]);
-  struct aspdat aspdat[NMAXPL * NMAXPL], *pasp;
+  int32 retc;
+  EVENT ev, *pevd = &ev;
+  EVITER *pit;
+  EVDBW *pdw;
   char foutnam[AS_MAXCH];
-  FILE *fpout = NULL;
-  UNUSED(xa1);
-  UNUSED(xa1d);
+  char splan_db[SWEVDB_SPLAN_LEN], sasp_db[NASPMAX + 2];
   sprintf(foutnam, "%s/%s", PATH_FOUTNAM, FOUTNAM);
-  if ((fpout = fopen(foutnam, BFILE_W_CREATE)) == NULL) {
-    sprintf(serr, "could not open file %s", foutnam);
+  if (db_append) {
+    if ((pdw = swev_db_append(foutnam, &iflag, &tjd0, &tstep, splan_db, sasp_db, serr)) == NULL)
+      return ERR;
+    splan = splan_db;
+    sasp = sasp_db;
+  } else if ((pdw = swev_db_create(foutnam, iflag, tjd0, tstep, splan, sasp, serr)) == NULL) {
     return ERR;
   }
-  fprintf(fpout, "%s, mundane aspects\ncreation date: %s\n%s\n", FOUTNAM, sdate, cmdline);
-  swe_revjul(tjd0, 1, &jyear, &jmon, &jday, &jut);
-  fprintf(fpout, "start date: %d/%02d/%02d, ", jyear, jmon, jday);
-  swe_revjul(tjde, 1, &jyear, &jmon, &jday, &jut);
-  fprintf(fpout, "end date:   %d/%02d/%02d\n", jyear, jmon, jday);
-  fprintf(fpout, "planets:    %s\n", splan);
-  fprintf(fpout, "aspects:    %s\n", sasp);
-  fprintf(fpout, "orb:        %.2f\n", (double) SWEV_ASPORB);
-  fprintf(fpout, "aspects 90 and 270 are distinguished; the coding of aspects is therefore as follows:\n");
-  fprintf(fpout, "aspcode:    0123456789...\n");
-  fprintf(fpout, "          = %s\n", saspi);
-  fprintf(fpout, "data structure:\ndouble time of exactness (TT)\nint32  number of planet a\nint32  number of planet b\nint32  number of aspect\ndouble aspect angle\ndouble precision of aspect; 0 if exact\ndouble time of crossing of pre-orb\ndouble time of crossing of post-orb\n");
-  fprintf(fpout, "Aspects between nodes and apsides have no pre-orb and post-orb.\nIf an aspect comes into orb but does not become exact, time of exactness is the moment of closest approach.\nIf an aspect has no preorb, there is another exactness before that. And if it has no postorb, there is another exactness after that.\n");
-  fprintf(fpout, "######################\n");
-  memset((void *) &(aspdat[0]), 0, NMAXPL * NMAXPL * sizeof(struct aspdat));
-  /* *stnam = '\0';*/
-  for (t = tjd0; t < tjde; t += tstep) {
-    nev = 0;
-    pevd = &(events_day[0]);
-    for (sp = splan, ipli = 0; *sp != '\0'; sp = forw_splan(sp), ipli++) {
-      ipl = letter_to_ipl_or_star(sp, stnam);
-      if (t == tjd0) {
-	if (call_swe_calc(t, ipl, iflag|SEFLG_SPEED, stnam, x, serr) == ERR)
-	  return ERR;
-	if (call_swe_calc(t, ipl, iflag|SEFLG_SPEED|SEFLG_EQUATORIAL, stnam, xa, serr) == ERR)
-	  return ERR;
-	x1[ipli] = x[0];
-	x1d[ipli] = x[0] + tstep / 10.0 * x[3];
-	/* declination */
-	xa1[ipli] = xa[1]; 
-	xa1d[ipli] = xa[1] + tstep / 10.0 * xa[4];
-      } else {
-        x1[ipli] = x2[ipli];
-	x1d[ipli] = x2d[ipli];
-	/* declination */
-        xa1[ipli] = xa2[ipli];
-	xa1d[ipli] = xa2d[ipli];
-      }
-      if (call_swe_calc(t + tstep, ipl, iflag|SEFLG_SPEED, stnam, x, serr) == ERR)
-	return ERR;
-      if (call_swe_calc(t + tstep, ipl, iflag|SEFLG_SPEED|SEFLG_EQUATORIAL, stnam, xa, serr) == ERR)
-	return ERR;
-      x2[ipli] = x[0];
-      x2d[ipli] = x[0] + tstep / 10.0 * x[3];
-      /* declination */
-      xa2[ipli] = xa[1];
-      xa2d[ipli] = xa[1] + tstep / 10.0 * xa[4];
-    }
-    /* for all planets a */
-    for (spa = splan, iplia = 0; *spa != '\0'; spa = forw_splan(spa), iplia++) {
-      ipla = letter_to_ipl_or_star(spa, stnama);
-      /* fixed stars are not considered to transit over other bodies */
-      if (ipla == SE_FIXSTAR) continue; /* ????? */
-      /* for all planets b */
-      for (spb = forw_splan(spa), iplib = iplia + 1; *spb != '\0'; spb = forw_splan(spb), iplib++) {
-	iplb = letter_to_ipl_or_star(spb, stnamb);
-	bpind = iplia * NMAXPL + iplib;
-	/* for all aspects */
-	for (iaspi = 0; iaspi < nasp; iaspi++) {
-	  int iorb, norb = 3;
-	  int orbfac;
-	  double dmaxorb;
-	  int iasp = (int) saspi[iaspi] - (int) '0';
-	  /* for pre-orb, exact, post-orb: */
-	  for (iorb = 0; iorb < norb; iorb++) {
-	    /* no pre- and post orbs for aspects between different kinds of
-	     * nodes and apsides */
-	    if (norb == 3 && iorb != 1) {
-	      if (strchr("mtABcg", *spa) != NULL && strchr("mtABcg", *spb) != NULL)
-	         continue;
-	    }
-	    orbfac = (iorb - 1);  /* is -1, 0, 1 */
-	    if (norb == 1)
-	      orbfac = 0;
-	    dmaxorb = SWEV_ASPORB * orbfac;
-	    dang = swe_degnorm(dasp[iaspi] + dmaxorb);
-	    xta1 = x1[iplia];
-	    xta2 = x2[iplia];
-	    xtb1 = x1[iplib];
-	    xtb2 = x2[iplib];
-	    tt0 = t;
-	    dt = tstep;
-	    d1 = swe_degnorm(xta1 - xtb1 - dang);
-	    if (d1 > 180) d1 -= 360;
-	    d2 = swe_degnorm(xta2 - xtb2 - dang);
-	    if (d2 > 180) d2 -= 360;
-	    if (ipla == SE_MOON || iplb == SE_MOON) {
-	      if (fabs(d1) >  20)
-		continue;
-	    } else if (fabs(d1) > NEAR_CROSSING_ORB + 3) {
-	      continue;
-	    }
-	    d1d = swe_degnorm(x1d[iplia] - x1d[iplib] - dang);
-	    if (d1d > 180) d1d -= 360;
-	    d2d = swe_degnorm(x2d[iplia] - x2d[iplib] - dang);
-	    if (d2d > 180) d2d -= 360;
-	    /* 
-	     * crossing found 
-	     * find t of exact aspect
-	     * if exactness happens twice within step width, the aspect is
-	     * lost
-	     */
-	    if (d1 * d2 < 0) {
-	      /*
-	       * step width 1 day:     1min20sec/100 yr (1 or 2 asp lost per cty)
-	       * step width 0.1 day:   1min55sec/100 years
-	       * step width 0.01 day:  9min32sec/100 years 
-	       * (calculations with SEFLG_NONUT)
-	       * Still, we use 1-day step width. The lost aspects will
-	       * be found in the "else".
-	       */
-	      if ((retflag = get_crossing_bin_search(dt, tt0, dang, xta1, xta2, xtb1, xtb2, &tret, ipla, iplb, stnama, stnamb, iflag, FALSE, serr)) == ERR)
-		return ERR;
-	      fill_pev_day(pevd + nev, tret, ipla, iplb, stnama, stnamb, iasp, bpind, dasp[iaspi], dang, 0, NULL);
-	      nev++;
-	    /* 
-	     * - near crossing occurs (t of smallest orb is found)
-	     * - or exact aspect occurs twice within step width
-	     *   (was lost by "if")
-	     */
-	    } else if (fabs(d1) < NEAR_CROSSING_ORB || fabs(d2) < NEAR_CROSSING_ORB) {
-	      /* printf("d1=%f, d1d=%f, d2=%f, d2d=%f\n", d1, d1d, d2, d2d);*/
-	      if (d1 > 0 && d2 > 0) {
-		if (d1 > d2 && d2 > d2d) continue;
-		if (d1 < d2 && d1 < d1d) continue;
-	      } else {
-		if (d1 > d2 && d1 > d1d) continue;
-		if (d1 < d2 && d2 < d2d) continue;
-	      }
-	      if ((retflag = get_near_crossing_bin_search(dt, tt0, dang, xta1, xta2, xtb1, xtb2, &tret, &tret2, &dorb, ipla, iplb, stnama, stnamb, iflag, serr)) == ERR)
-		return ERR;
-	      if (retflag == -2)
-		continue;
-	      if (fabs(dorb) > 0) {
-		if (orbfac == 0) {
-		  fill_pev_day(pevd + nev, tret, ipla, iplb, stnama, stnamb, iasp, bpind, dasp[iaspi], dang, dorb, "*");
-		  nev++;
-		}
-	      } else {
-		fill_pev_day(pevd + nev, tret, ipla, iplb, stnama, stnamb, iasp, bpind, dasp[iaspi], dang, dorb, "x");
-		nev++;
-		if (tret2 != 0) {
-		  fill_pev_day(pevd + nev, tret2, ipla, iplb, stnama, stnamb, iasp, bpind, dasp[iaspi], dang, dorb, "x");
-		  nev++;
-		}
-	      }
-	    }
-	  }
-	}
-      }
-    }
-    /* sort transits of current day (time step) */
-    qsort((void *) &(events_day[0]), (size_t) nev, sizeof(EVENT),
-          (int (*)(const void *, const void *))(pev_compare));
-    for (pevd = &(events_day[0]); pevd - &(events_day[0]) < nev; pevd++) {
-      test_print_date(pevd->tjd, pevd->ipla, pevd->iplb, pevd->stnama, pevd->stnamb, pevd->dang, pevd->dorb, "");
-      pasp = &(aspdat[pevd->bpind]);
-      /* new aspect between body pair: init structure */
-      if (pasp->tjd == 0 && pasp->tjd_pre == 0) 
-        pasp->iasp = -1;
-      if (pasp->iasp != pevd->iasp) {
-        pasp->tjd = 0;
-        pasp->tjd_pre = 0;
-	pasp->iasp = pevd->iasp;
-      }
-      /* aspect is exact */
-      if (pevd->dasp == pevd->dang) {
-	/* if there was another exactness before this one, we delete tjd_pre */
-        if (pasp->tjd != 0) 
-	  pasp->tjd_pre = 0;
-        pasp->tjd = pevd->tjd;
-        /* write database */
-	if (fseek(fpout, 0, SEEK_END) != 0) {
-	  strcpy(serr, "error in fseek (1)");
-	  return ERR;
-	}
-	fwrite((char *) &(pasp->tjd), sizeof(double), 1, fpout);
-	fwrite((char *) &(pevd->ipla), sizeof(int32), 1, fpout);
-	fwrite((char *) &(pevd->iplb), sizeof(int32), 1, fpout);
-	fwrite((char *) &(pevd->iasp), sizeof(int32), 1, fpout);
-	fwrite((char *) &(pevd->dasp), sizeof(double), 1, fpout);
-	fwrite((char *) &(pevd->dorb), sizeof(double), 1, fpout);
-	fwrite((char *) &(pasp->tjd_pre), sizeof(double), 1, fpout);
-	pasp->fpos_tjd_post = ftell(fpout);
-	fwrite((char *) &(pasp->tjd_post), sizeof(double), 1, fpout);
-        /*fprintf(stderr, "%f: %d - %d ang=%.0f tpre=%f\n", pasp->tjd, pevd->ipla, pevd->iplb, pevd->dasp, pasp->tjd_pre);*/
-      /* entering orb: save tjd_pre */
-      } else if (pasp->tjd == 0) {
-        pasp->tjd_pre = pevd->tjd;
-      /* leaving orb */
-      } else {
-        /* write database: tjd_post */
-	if (fseek(fpout, pasp->fpos_tjd_post, SEEK_SET) != 0) {
-	  strcpy(serr, "error in fseek (1)");
-	  return ERR;
-	}
-	fwrite((char *) &(pevd->tjd), sizeof(double), 1, fpout);
-	/* after writing database, init aspdat */
-	pasp->iasp = -1;
-        pasp->tjd = 0;
-        pasp->tjd_pre = 0;
-      }
-    }
-  }
-  fclose(fpout);
-  read_sweasp_dat(foutnam);
-	//if (get_crossings(iflag, t, tstep, ipl1, ipl2, x1, x2, sasp, pev, serr) == ERR)
-  return OK;
-}
-
-static int do_fread_double(FILE *fpout, char *foutnam, int32 fposbeg, double *tjdbeg, char *serr)
-{
-  if (fseek(fpout, fposbeg, SEEK_SET) != 0) {
-    sprintf(serr, "fseek failed (SEEK_SET): %s", foutnam);
-    return ERR;   
-  }
-  if (fread((void *) tjdbeg, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "error while trying to read %s (1)", foutnam);
-    return ERR;   
-  }
-  return OK;
-}
-
-static int do_fread_asp(FILE *fpout, int32 fpos1, double *tjd_ex, int *ipla, int *iplb, int *iasp, double *dasp, double *dorb, double *tjd_pre, double *tjd_post, char *serr)
-{
-  if (fseek(fpout, fpos1, SEEK_SET) != 0) {
-    sprintf(serr, "do_fread_asp(): fseek failed (SEEK_SET)");
-    return ERR;   
-  }
-  if (fread((void *) tjd_ex, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) ipla, sizeof(int), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) iplb, sizeof(int), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) iasp, sizeof(int), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) dasp, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) dorb, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
-  }
-  if (fread((void *) tjd_pre, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
+  if ((pit = swev_iter_open(iflag, CTYP_MASPECTS, tjd0, tjde, tstep, splan, sasp, 0, NULL, serr)) == NULL) {
+    swev_db_discard(pdw);
+    return ERR;
   }
-  if (fread((void *) tjd_post, sizeof(double), 1, fpout) <= 0) {
-    sprintf(serr, "do_fread_asp(): error while trying to read");
-    return ERR;   
+  /* events come in time order, sorted within each time step */
+  while ((retc = swev_iter_next(pit, pevd, serr)) == 1) {
+    test_print_date(pevd->tjd, pevd->ipla, pevd->iplb, pevd->stnama, pevd->stnamb, pevd->dang, pevd->dorb, "");
+    if (swev_db_add(pdw, pevd, serr) == ERR) {
+      retc = ERR;
+      break;
+    }
   }
-  return OK;
-}
-
-static int start_and_end_date_sweasp(FILE *fpout, char *foutnam, int32 fposbeg, int32 fposlast, double *tjdbeg, double *tjdend, char *serr)
-{
-  if (do_fread_double(fpout, foutnam, fposbeg, tjdbeg, serr) == ERR)
+  swev_iter_close(pit);
+  if (retc == ERR) {
+    swev_db_discard(pdw);
     return ERR;
-  if (do_fread_double(fpout, foutnam, fposlast, tjdend, serr) == ERR)
+  }
+  if (swev_db_commit(pdw, tjde, serr) == ERR)
     return ERR;
-  return OK;   
-}
-
-static int is_node_apsis(int ipl) 
-{
-  if (ipl == SE_MEAN_NODE || ipl == SE_TRUE_NODE 
-    || ipl == SE_MEAN_APOG || ipl == SE_OSCU_APOG
-    || ipl == SE_INTP_APOG || ipl == SE_INTP_PERG)
-    return 1;
-  return 0;
+  read_sweasp_dat(foutnam);
+  return OK;
 }
 
-#define SWEASP_DAT_RECLEN  (5*sizeof(double) + 3 *sizeof(int32))
-#define PERIOD_PRE_POST  365 /* days */
+#define NACTIVE_MAX 1000
 /* returns all aspects, that are within orb during the time (tjd +- dtol) */
 static int32 extract_data_of_day(int32 doflag, double tjd, double dtol, char *splan, char *sasp, EVENT *pev, char *serr)
 {
-  int32 flen = 0, headerlen = 0, fposfirst = 0, fposlast = 0, nrecdif;
-  int32 fpos0, fpos1, fpos2;
-  int32 retc, nrec = 0, ipla, iplb, iasp;
-  double dasp, dorb, dorb2, tjd_pre, tjd_post, tjd_ex, tjdstart;
-  double tjd0, tjd1, tjd2;
-  int ipla2, iplb2, iasp2;
-  double tjd_pre2, tjd_post2, tjd_ex2;
-  double tjdbeg, tjdend;
-  char s[AS_MAXCH], *sp;
-  FILE *fpout = NULL;
+  EVDB *pdb;
+  EVDBREC *prec, *pr, *pr2;
+  int32 irec[NACTIVE_MAX];
+  int32 i, j, n, nrec;
+  double tjd0, tjde;
   char foutnam[AS_MAXCH];
-  UNUSED(tjd2);
   /* open aspects file */
   sprintf(foutnam, "%s/%s", PATH_FOUTNAM, FOUTNAM);
-  if ((fpout = fopen(foutnam, BFILE_R_ACCESS)) == NULL) {
-    sprintf(serr, "could not open file %s", foutnam);
+  if ((pdb = swev_db_open(foutnam, serr)) == NULL)
     return ERR;
-  }
-  /* read file header */
-  while (fgets(s, AS_MAXCH, fpout) != NULL && (sp = strchr(s, '\n')) != NULL) {
-    headerlen += strlen(s);
-    if (strncmp(s, "####", 4) == 0) 
-      break;
-  }
-  /* start position of file */
-  fposfirst = headerlen;
-  /* end position of file */
-  if (fseek(fpout, 0L, SEEK_END) != 0) {
-    sprintf(serr, "fseek failed (SEEK_END): %s", foutnam);
+  prec = swev_db_records(pdb, &nrec, &tjd0, &tjde);
+  /* one index lookup gives all aspect phases overlapping with our date
+   * tjd +- dtol */
+  if ((n = swev_db_active(pdb, tjd, dtol, irec, NACTIVE_MAX, serr)) == ERR) {
+    swev_db_close(pdb);
     return ERR;
   }
-  fposlast = ftell(fpout); /* pointer to end of file */
-  flen = fposlast - headerlen;
-  /* number of records in file */
-  nrec = flen / SWEASP_DAT_RECLEN;
-  fposlast = fposfirst + (nrec - 1) * SWEASP_DAT_RECLEN; /* pointer to last record in file */
-  /* is search date in file range ? */
-  if ((retc = start_and_end_date_sweasp(fpout, foutnam, fposfirst, fposlast, &tjdbeg, &tjdend, serr)) == ERR) 
-    goto end_extract;
-  if (tjd <= tjdbeg || tjd >= tjdend) {
-    sprintf(serr, "date %f is beyond range of file %s (%.0f - %.0f)", tjd, foutnam, tjdbeg, tjdend);
-    return ERR;
-    goto end_extract;
-  }
-  /* binary search for date in file */
-  tjdstart = tjd - PERIOD_PRE_POST; /* we start our search a year before the date we want */
-  if (tjdstart < tjdbeg)
-    tjdstart = tjdbeg;
-  nrecdif = (fposlast - fposfirst) / SWEASP_DAT_RECLEN;
-  tjd0 = tjdbeg; tjd2 = tjdend; tjd1 = tjd0;
-  fpos0 = fposfirst; fpos2 = fposlast;
-  fpos1 = fpos0;  // silence compiler
-  while(fabs(tjdstart - tjd1) > 2) {
-    fpos1 = fpos0 + (nrecdif / 2) * SWEASP_DAT_RECLEN;
-    if ((retc = do_fread_double(fpout, foutnam, fpos1, &tjd1, serr)) == ERR) {
-      goto end_extract;
-    }
-    if (tjdstart >= tjd1) {
-      tjd0 = tjd1; 
-      fpos0 = fpos1;
-    } else {
-      tjd2 = tjd1; 
-      fpos2 = fpos1;
-    }
-    nrecdif = (fpos2 - fpos0) / SWEASP_DAT_RECLEN;
-  }
-  /*fprintf(stderr, "ts = %.0f, t0 = %.0f, t1 = %.0f, t2 = %.0f, d = %d\n", tjdstart, tjd0, tjd1, tjd2, nrecdif);*/
-  /* now, from this date we start searching for aspects whose period covers
-   * or overlaps with our date tjd +- dtol */
-  if ((retc = do_fread_asp(fpout, fpos1, &tjd_ex, &ipla, &iplb, &iasp, &dasp, &dorb, &tjd_pre, &tjd_post, serr)) == ERR)
-    goto end_extract;
-  while(tjd_ex < tjd + PERIOD_PRE_POST) {
-      /*if (ipla == 8 && iplb == 11) {
-        fprintf(stderr, "hallo\n");
-      }*/
-    if (ipla <= SE_CHIRON && iplb <= SE_CHIRON && ipla >= 0 && iplb >= 0 && iasp < 8) {
-      /* complete aspect with tjd_pre and tjd_post */
-      if (tjd_pre > 0 && tjd_post > 0) {
-	/* within time range */
-        if (tjd_post >= tjd - dtol && tjd_pre <= tjd + dtol) {
-	  fprintf(stderr, "tjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", tjd_ex, tjd_pre, tjd_post, ipla, iplb, dasp, iasp);
-        }
-      /* aspect between nodes and aspides (no tjd_pre and tjd_post) */
-      } else if (is_node_apsis(ipla) && is_node_apsis(iplb)) {
-	/* exactness is within time range */
-        if (tjd_ex >= tjd - dtol && tjd_ex <= tjd + dtol) {
-	  fprintf(stderr, "tjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", tjd_ex, tjd_pre, tjd_post, ipla, iplb, dasp, iasp);
-	}
-      /* aspect is in process already at the beginning of search period,
-       * too far away from the required date range */
-      } else if (tjd_pre == 0) {
-        ;
-      /* aspect begins after end of required date range */
-      } else if (tjd + dtol < tjd_pre) {
-        ;
-      /* aspect with unknown end, possibly covering our required date range.
-       * we search for its end */
-      } else {
-        AS_BOOL do_output = FALSE;
-	if (tjd_ex > tjd - dtol) {
-	  do_output = TRUE;
-	  fprintf(stderr, "xxtjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", tjd_ex, tjd_pre, tjd_post, ipla, iplb, dasp, iasp);
-	}
-	fpos2 = fpos1;
-	tjd_ex2 = tjd_ex;
-	while(tjd_ex2 < tjd + PERIOD_PRE_POST && fpos2 < fposlast) {
-	  fpos2 += SWEASP_DAT_RECLEN;
-	  if ((retc = do_fread_asp(fpout, fpos2, &tjd_ex2, &ipla2, &iplb2, &iasp2, &dasp, &dorb2, &tjd_pre2, &tjd_post2, serr)) == ERR)
-	    goto end_extract;
-	  if (ipla == ipla2 && iplb == iplb2 && iasp == iasp2) {
-	    fprintf(stderr, "yytjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f\n", tjd_ex2, tjd_pre2, tjd_post2, ipla2, iplb2, dasp);
-	    fprintf(stderr, "yytjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", tjd_ex2, tjd_pre2, tjd_post2, ipla2, iplb2, dasp, iasp);
-	    /* if previous phases had no exactness, but the current one has
-	     * or is exacter, take over its time of exactness */
-	    if (fabs(dorb2) < fabs(dorb)) {
-	      dorb = dorb2;
-	      tjd_ex = tjd_ex2;
-	    }
-	    /* if there are several exactnesses, select the one closest
-	     * to the required date */
-	    if (dorb2 == 0 && fabs(tjd_ex2 - tjd) < fabs(tjd_ex - tjd)) {
-	      tjd_ex = tjd_ex2;
-	      dorb = 0;
-	    }
-	    if (tjd_post2 > tjd - dtol) {
-	      do_output = TRUE;
-	      tjd_post = tjd_post2;
-	    }
-	    if (tjd_post2 > 0) /* there is no future exactness after that */
-	      break;
-	  }
-	}
-	if (do_output)
-	  fprintf(stderr, "xxtjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", tjd_ex, tjd_pre, tjd_post, ipla, iplb, dasp, iasp);
-      }
-
+  for (i = 0; i < n; i++) {
+    pr = prec + irec[i];
+    if (pr->ipla > SE_CHIRON || pr->iplb > SE_CHIRON || pr->ipla < 0 || pr->iplb < 0 || pr->iasp >= 8)
+      continue;
+    /* if the phase has several exactnesses, select the one closest
+     * to the required date */
+    for (j = 0; j < n; j++) {
+      pr2 = prec + irec[j];
+      if (j != i && pr2->bpind == pr->bpind && pr2->iasp == pr->iasp && pr2->tbeg == pr->tbeg
+	&& (fabs(pr2->tjd - tjd) < fabs(pr->tjd - tjd) || (fabs(pr2->tjd - tjd) == fabs(pr->tjd - tjd) && j < i)))
+	break;
     }
-    fpos1 += SWEASP_DAT_RECLEN;
-    if ((retc = do_fread_asp(fpout, fpos1, &tjd_ex, &ipla, &iplb, &iasp, &dasp, &dorb, &tjd_pre, &tjd_post, serr)) == ERR)
-      goto end_extract;
-  }
-end_extract:
-  fclose(fpout);
-  if (retc == ERR) {
-    fprintf(stderr, "%s", serr);
+    if (j < n)
+      continue;
+    fprintf(stderr, "tjd_ex=%.1f, tjd_pre=%.1f, tjd_post=%.1f, %d, %d, %.0f %d\n", pr->tjd, pr->tbeg, pr->tend, pr->ipla, pr->iplb, pr->dasp, pr->iasp);
   }
-  return retc;
+  swev_db_close(pdb);
+  return OK;
 }
 
 int32 calc_all_crossings(
@@ -2705,216 +2002,20 @@ int32 calc_all_crossings(
   return OK;
 }
 
-static char get_casp(double dasp) 
-{
-  if (dasp == 0) return ((char) 1); 
-  if (dasp == 180) return ((char) 2); 
-  if (dasp == 90) return ((char) 3); 
-  if (dasp == 270) return ((char) 3); 
-  if (dasp == 120) return ((char) 4); 
-  if (dasp == 240) return ((char) 4); 
-  if (dasp == 60) return ((char) 5); 
-  if (dasp == 300) return ((char) 5); 
-  return ((char) 0);
-}
-
-static int32 get_prev_lunasp(double t0, int32 ipl, int32 iflag, double *tret, double *dasp, int32 *isign, char *serr)
-{
-  double xx[6], xm[6], dang, dx, t, mspeed;
-  int nsign;
-  if (swe_calc(t0, SE_MOON, iflag, xm, serr) == ERR) 
-    return ERR;
-  if (swe_calc(t0, ipl, iflag, xx, serr) == ERR) 
-    return ERR;
-  nsign = 0;
-  dx = swe_degnorm(xm[0] - xx[0]);
-  nsign = (int) (dx / 30);
-  /* ignore semisextiles and inconjuncts */
-  if (nsign == 1 || nsign == 5 || nsign == 7 || nsign == 11)
-    nsign--;
-  dang = nsign * 30;
-  dx -= dang;
-  /* lunar speed roughly */
-  mspeed = xm[3] - xx[3];
-  if (iflag & SEFLG_TOPOCTR)
-    mspeed = 13 - xx[3];
-  t = t0 - dx / mspeed;
-  while (fabs(dx) > 1e-5) {
-    if (swe_calc(t, SE_MOON, iflag, xm, serr) == ERR) 
-      return ERR;
-    if (swe_calc(t, ipl, iflag, xx, serr) == ERR) 
-      return ERR;
-    dx = swe_degnorm(xm[0] - xx[0] - dang);
-    if (dx > 180)
-      dx -= 360;
-    t -= dx / mspeed;
-  }
-  *dasp = (double) ((int) (dang + 0.5));
-  *tret = t;
-  *isign = (int) (xm[0] / 30);
-  return OK;
-}
-
-static int32 get_sign_ingress_direct_body(double tet0, int32 ipl, int32 iflag, int32 backward, double *tret, int32 *isign, char *serr)
-{
-  double xx[6], xingr, dx, mspeed, t;
-  iflag |= SEFLG_SPEED;
-  if (swe_calc(tet0, ipl, iflag, xx, serr) == ERR)
-    return ERR;
-  *isign = (int) (xx[0] / 30); 
-/*  if (!backward) {*/
-    if (ipl != SE_MEAN_NODE) 
-      (*isign) ++;
-    if (*isign == 12)
-      *isign = 0;
-    if (*isign == -1)
-      * isign = 11;
-/*  }*/
-  xingr = *isign * 30;
-  dx = swe_difdeg2n(xingr, xx[0]);
-  t = tet0;
-  /* body's speed roughly */
-  mspeed = xx[3];
-  if (ipl == SE_MOON && (iflag & SEFLG_TOPOCTR))
-    mspeed = 13;
-  while(fabs(dx) > 1e-6) {
-    t += dx / mspeed;
-    if (swe_calc(t, ipl, iflag, xx, serr) == ERR)
-      return ERR;
-    dx = swe_difdeg2n(xingr, xx[0]);
-  }
-  *tret = t;
-  return OK;
-}
-
-/*
-Lunar void-of-course phases
-===========================
- 
-Definition:
-Last lunar aspect (COQTS) to a planet (0-9) before a lunar ingress.
- 
-Problem:
-It happens that a the moon does not form ANY aspects with planets while
-crossing a sign. 
-The Rosicrucian Ephemeris lists the following case for March 1965:
-Last aspect    Lunar ingress
-Day    h  m    Day    h  m
- 4     1:35     4    18:45
- 4     1:35     7     1:50
- 
-Method 1 (-v1):
-A VOC phase can start before the last sign ingress, and it can last longer
-than a sign transit. There are less VOC phases than ingresses. The output 
-contains a line per VOC phase, but not a line per ingress.
-For a given time t:
-- calculate the next lunar ingress (ti_next)
-- calculate the next lunar ingress after ti_next (ti_nextnext)
-- set tvoc_start = 0, tvoc_end = ti_nextnext
-- calculate the last aspect before tvoc_end (ta_last)
-  as soon as an aspect later than ti_next is found,
-  set tvoc_end = ti_next; break the search and repeat it
-- set tvoc_start = ta_last
- 
-Method 2 (-v2): 
-A VOC phase can start before the last sign ingress, and it can last longer
-than a sign transit. But a line is printed for each ingress, and two 
-ingresses can have the same start date for their VOC phases.
-(Output is as in Ros. Eph., e.g. for 4-mar-1965) 
-- calculate the next lunar ingress (ti_next)
-- set tvoc_start = 0, tvoc_end = ti_next
-- calculate the last aspect before tvoc_end (ta_last)
-- set tvoc_start = ta_last
- 
-Method 3 (-v3, default): 
-A VOC phase cannot start before the last sign ingress, i.e. a VOC phase
-can start at a sign ingress and end at the next sign ingress.
-the two VOC phases remain separate, a VOC phase may start at ingress
-- same procedure as solution 2
-but after that:
-- calculate previous lunar ingress (ti_prev)
-- if ta_last < ti_prev, then ta_last = ti_prev
-*/
-static int32 get_next_voc(double tet0, int32 iflag, int32 vocmethod, VOC *pvoc, char *serr) 
-{
-  int32 retc;
-  double tet_asp, daspi, tvoc_end, tingr_save;
-  double tret[2], dasp;
-  int32 ipl, ipllast;
-  int32 isign, isigni, isign_save;
-  int32 isign_ingr;
-  if (vocmethod == 0) vocmethod = 3;
-  /* next ingress */
-  if ((retc = get_sign_ingress_direct_body(tet0, SE_MOON, iflag, 0, &(tret[1]), &isign, serr)) == ERR)
-    return retc;
-  isign_save = isign;
-  tingr_save = tret[1];
-  tvoc_end = tret[1];
-  /* overnext ingress */
-  if (vocmethod == 1 && (retc = get_sign_ingress_direct_body(tret[1] + 1, SE_MOON, iflag, 0, &tvoc_end, &isign, serr)) == ERR)
-    return retc;
-  isign_ingr = isign;
-  /* find the last aspect with a planet within this time range */
-  tret[0] = 0;
-repeat_loop:
-  for (ipl = SE_SUN; ipl <= SE_PLUTO; ipl++) {
-    if (ipl == SE_MOON)
-      continue;
-    if ((retc = get_prev_lunasp(tvoc_end, ipl, iflag, &tet_asp, &daspi, &isigni, serr)) == ERR)
-      return retc;
-    if (vocmethod == 1 && tet_asp > tret[1]) {
-      tvoc_end = tret[1];
-      isign_ingr--;
-      if (isign_ingr < 0) isign_ingr = 11;
-      goto repeat_loop;
-    }
-    if (tet_asp > tret[0]) {
-      tret[0] = tet_asp;
-      dasp = daspi;
-      ipllast = ipl;
-      isign = isigni;
-    }
-  }
-  tret[1] = tvoc_end;
-  if (vocmethod == 3) {
-    double tingr_prev;
-    /* get previous lunar ingress */
-    if ((retc = get_sign_ingress_direct_body(tet0, SE_MOON, iflag, 1, &tingr_prev, &isign, serr)) == ERR)
-      return retc;
-    if (tret[0] < tingr_prev)
-      tret[0] = tingr_prev;
-  }
-  pvoc->tvoc = tret[0];
-  pvoc->tingr = tret[1];
-  pvoc->casp = get_casp(dasp);
-  pvoc->cpl = (char) ipllast;
-  pvoc->isign_voc = isign;
-  pvoc->isign_ingr = isign_ingr;
-  if (isign_save == isign_ingr) {
-    pvoc->tingr0 = 0;
-    pvoc->isign_ingr0 = 0;
-  } else {
-    pvoc->tingr0 = tingr_save;
-    pvoc->isign_ingr0 = isign_save;
-  }
-  return OK;
-}
-
 static int32 calc_all_voc(int32 iflag, double te, double tend, char *serr)
 {
-  double t, tnext;
   int jday, jmon, jyear, gregflag = SE_GREG_CAL;
   double jut;
 /*  int32 ctyp = CTYP_VOC; */
   int32 retc;
   VOC dvoc;
+  VOCITER *pit;
   /* moon void of course */
-  for (t = te; t < tend; t = tnext) {
-    retc = get_next_voc(t, SEFLG_SPEED, 1, &dvoc, serr);
-    if (retc == ERR) {
-      printf("%s\n", serr);
-      return ERR;
-    }
+  if ((pit = swev_voc_open(SEFLG_SPEED, 1, te, tend, serr)) == NULL) {
+    printf("%s\n", serr);
+    return ERR;
+  }
+  while ((retc = swev_voc_next(pit, &dvoc, serr)) == 1) {
     /* content of dvoc:
      * double tvoc;    : time of begin of voc phase 
      * double tingr;   : time of ingress that ends voc phase 
@@ -2934,39 +2035,13 @@ static int32 calc_all_voc(int32 iflag, double te, double tend, char *serr)
       swe_revjul(dvoc.tingr0, gregflag, &jyear, &jmon, &jday, &jut);
       printf("                  -> VOCEND0: %d.%d.%d, %f, %d \n", jday, jmon, jyear, jut, dvoc.isign_ingr0);
     }
-    tnext = dvoc.tingr + 0.1;
   }
-  return OK;
-}
-
-static int letter_to_ipl(int letter)
-{
-  if (letter >= '0' && letter <= '9')
-    return letter - '0' + SE_SUN;
-  if (letter >= 'A' && letter <= 'I')
-    return letter - 'A' + SE_MEAN_APOG;
-  if (letter >= 'J' && letter <= 'Z')
-    return letter - 'J' + SE_CUPIDO;
-  switch (letter) {
-  case 'm': return SE_MEAN_NODE;
-  case 'c': return SE_INTP_APOG;
-  case 'g': return SE_INTP_PERG;
-  case 'n': 
-  case 'o': return SE_ECL_NUT;
-  case 't': return SE_TRUE_NODE;
-  case 'f': return SE_FIXSTAR;
-  case 'w': return SE_WALDEMATH;
-  case 'e': /* swetest: a line of labels */
-  case 'q': /* swetest: delta t */
-  case 's': /* swetest: an asteroid, with number given in -xs[number] */
-  case 'z': /* swetest: a fictitious body, number given in -xz[number] */
-  case 'd': /* swetest: default (main) factors 0123456789mtABC */
-  case 'p': /* swetest: main factors ('d') plus main asteroids DEFGHI */
-  case 'h': /* swetest: fictitious factors JKLMNOPQRSTUVWXYZw */
-  case 'a': /* swetest: all factors, like 'p'+'h' */
-    return -1;
+  swev_voc_close(pit);
+  if (retc == ERR) {
+    printf("%s\n", serr);
+    return ERR;
   }
-  return -2;
+  return OK;
 }
 
 static char *hms(double x, int32 iflag)
@@ -86,6 +86,43 @@ struct aspdat {
 #define CTYP_INGRESSES	1
 #define CTYP_TRANSITS	2
 #define CTYP_VOC	3
+#define SWEV_PROXY	256	/* option bit for swev_iter_open(): Chebyshev-proxy search */
+#define SWEV_TSTEP	1.0	/* default time step of the stepping search, days */
+#define SWEV_PROXY_WINDOW 8.0	/* default window of the proxy search, days */
+
+#define SWEV_ASPORB 1          /* pre-orb and post-orb of aspects */
+#define NMAXPL 50              /* max. number of bodies in an event search */
+#define NEAR_CROSSING_ORB 1
+#define NASPMAX 30             /* max. number of aspect angles */
+
+/* Event iterator (swevlib.c): mundane aspects, transits and ingresses
+ * are handed out one at a time, in time order. All search state is in
+ * the handle; separate handles may be used in parallel threads. */
+#define EVITER struct event_iter
+EVITER;
+
+/* Aspect database (swevdb.c): mundane aspects with a day index. A record
+ * is written for every exactness, or closest approach within orb. */
+#define SWEVDB_SPLAN_LEN 512   /* max. length of body string, incl. 0 */
+#define EVDB struct evdb
+#define EVDBW struct evdb_writer
+#define EVDBREC struct evdb_rec
+EVDB;
+EVDBW;
+
+EVDBREC {
+  double tjd;       /* time of exactness, or closest approach (TT) */
+  double tjd_pre;   /* crossing of pre-orb, 0 if another exactness precedes */
+  double tjd_post;  /* crossing of post-orb, 0 if another exactness follows */
+  double tbeg;      /* begin of the aspect phase within orb */
+  double tend;      /* end of the phase, 0 while it is still open */
+  double dasp;      /* aspect angle */
+  double dorb;      /* distance from exactness, 0 if exact */
+  int32 ipla;
+  int32 iplb;
+  int32 iasp;       /* aspect code, see swev_get_aspect_angles() */
+  int32 bpind;      /* body pair index, as in EVENT */
+};
 
 #define SPLAN_INGRESS   "0123456789mtAFD"
 #define SPLAN_ASPECTS   "0123456789mtAFD,a[136199],f[Gal]"
@@ -107,6 +144,12 @@ VOC {
                     * during voc phase */
 };
 
+/* VOC iterator (swevvoc.c): void-of-course phases in time order. All
+ * search state is in the handle; separate handles may be used in
+ * parallel threads. */
+#define VOCITER struct voc_iter
+VOCITER;
+
 #define INGRESS	struct ingress
 
 INGRESS {
@@ -116,3 +159,20 @@ INGRESS {
   int direction;  /* direct/retrograde: 1 or -1 */
   int ino;	  /* number of transit over this sign boundary */
 };
+
+EVITER *swev_iter_open(int32 iflag, int32 itype, double tjd0, double tjde, double tstep, char *splan, char *sasp, int32 npos, double *dpos, char *serr);
+int32 swev_iter_next(EVITER *pit, EVENT *pev, char *serr);
+void swev_iter_close(EVITER *pit);
+int32 swev_get_aspect_angles(char *sasp, char *saspi, double *dasp, char *serr);
+EVDBW *swev_db_create(char *fname, int32 iflag, double tjd0, double tstep, char *splan, char *sasp, char *serr);
+EVDBW *swev_db_append(char *fname, int32 *iflag, double *tjd0, double *tstep, char *splan, char *sasp, char *serr);
+int32 swev_db_add(EVDBW *pdw, EVENT *pev, char *serr);
+int32 swev_db_commit(EVDBW *pdw, double tjde, char *serr);
+void swev_db_discard(EVDBW *pdw);
+EVDB *swev_db_open(char *fname, char *serr);
+EVDBREC *swev_db_records(EVDB *pdb, int32 *nrec, double *tjd0, double *tjde);
+int32 swev_db_active(EVDB *pdb, double tjd, double dtol, int32 *irec, int32 nmax, char *serr);
+void swev_db_close(EVDB *pdb);
+VOCITER *swev_voc_open(int32 iflag, int32 vocmethod, double tjd0, double tjde, char *serr);
+int32 swev_voc_next(VOCITER *pit, VOC *pvoc, char *serr);
+void swev_voc_close(VOCITER *pit);
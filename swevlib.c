@@ -0,0 +1,1104 @@
+/* SWISSEPH
+ * 
+ * swevlib.c: reentrant event finder for mundane aspects, transits and
+ * ingresses, factored out of swevents.c. All search state lives in an
+ * EVITER handle, so independent searches can run in parallel threads,
+ * and events are handed out one at a time instead of being printed or
+ * collected in a fixed-size array.
+ *
+ * IMPORTANT NOTICE: like swevents.c, this is not a supported part of
+ * Swiss Ephemeris.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#include "swevents.h"
+
+/* Chebyshev-proxy search, see proxy_step() */
+#define PROXY_NMAX	64            /* max. degree of body proxies */
+#define PROXY_NMIN	4
+#define PROXY_TOL	1e-4          /* degrees; roots are polished anyway */
+#define PROXY_TTOL	(1.0 / 864000.0) /* polishing tolerance, days */
+#define PROXY_NCRIT	(8 * PROXY_NMAX + 20) /* max. segment breakpoints */
+
+struct event_iter {
+  int32 iflag;
+  int32 itype;
+  double tjde, tstep;
+  double t;                     /* begin of next time step */
+  AS_BOOL first_step;
+  int32 nbody;
+  int32 ipl[NMAXPL];
+  char stnam[NMAXPL][40];       /* star name as given in splan */
+  char stcat[NMAXPL][40];       /* star name as found in catalogue */
+  char code[NMAXPL];            /* first character of body in splan */
+  double x1[NMAXPL], x2[NMAXPL], x1d[NMAXPL], x2d[NMAXPL];
+  int32 nasp;
+  double dasp[NASPMAX];
+  char saspi[NASPMAX + 1];
+  int32 npos;
+  double *dpos;
+  /* Chebyshev proxies of the current window (SWEV_PROXY) */
+  AS_BOOL proxy;
+  int32 pn[NMAXPL];                          /* degree */
+  double pc[NMAXPL][PROXY_NMAX + 1];         /* coefficients */
+  double praw[NMAXPL][PROXY_NMAX + 1];       /* longitudes at nodes */
+  double pu[NMAXPL][PROXY_NMAX + 1];         /* same, unwrapped */
+  double pcos[2 * PROXY_NMAX];
+  /* events of the current time step, sorted */
+  EVENT *pev;
+  int32 nev, iev, nevmax;
+};
+
+static int letter_to_ipl(int letter)
+{
+  if (letter >= '0' && letter <= '9')
+    return letter - '0' + SE_SUN;
+  if (letter >= 'A' && letter <= 'I')
+    return letter - 'A' + SE_MEAN_APOG;
+  if (letter >= 'J' && letter <= 'Z')
+    return letter - 'J' + SE_CUPIDO;
+  switch (letter) {
+  case 'm': return SE_MEAN_NODE;
+  case 'c': return SE_INTP_APOG;
+  case 'g': return SE_INTP_PERG;
+  case 'n': 
+  case 'o': return SE_ECL_NUT;
+  case 't': return SE_TRUE_NODE;
+  case 'f': return SE_FIXSTAR;
+  case 'w': return SE_WALDEMATH;
+  case 'e': /* swetest: a line of labels */
+  case 'q': /* swetest: delta t */
+  case 's': /* swetest: an asteroid, with number given in -xs[number] */
+  case 'z': /* swetest: a fictitious body, number given in -xz[number] */
+  case 'd': /* swetest: default (main) factors 0123456789mtABC */
+  case 'p': /* swetest: main factors ('d') plus main asteroids DEFGHI */
+  case 'h': /* swetest: fictitious factors JKLMNOPQRSTUVWXYZw */
+  case 'a': /* swetest: all factors, like 'p'+'h' */
+    return -1;
+  }
+  return -2;
+}
+
+/* 
+ * aspect codes
+ * 1:   0
+ * 2: 180
+ * 3:  90
+ * 4: 120
+ * 5:  60
+ * 6:  30
+ * 7: 150
+ * 8:  72
+ * 9: 144
+ * A:  45
+ * B: 135
+ * C:   0  parallel
+ * D:   0  anti-parallel
+ * input: 
+ * sasp   aspects string, e.g. "1234567"
+ * output:
+ * dasp   aspect angles: 0, 180, 90, 270, 120, 240, 60, 300, 30, 330, 150, 210
+ * saspi  aspects string that defines the angles: 123344556677
+ */
+int32 swev_get_aspect_angles(char *sasp, char *saspi, double *dasp, char *serr)
+{
+  int nasp = 0;
+  char *sp;
+  *saspi = '\0';
+  for (sp = sasp; *sp != '\0'; sp++) {
+    if (nasp + 2 > NASPMAX) {
+      sprintf(serr, "aspects string %s is too long", sasp);
+      return ERR;
+    }
+    switch (*sp) {
+    case '1': 
+      dasp[nasp] = 0;  
+      strcat(saspi, "1");
+      nasp++;
+      break;
+    case '2': 
+      dasp[nasp] = 180;  
+      strcat(saspi, "2");
+      nasp++;
+      break;
+    case '3': 
+      dasp[nasp] = 90;  
+      nasp++;
+      dasp[nasp] = 270;  
+      nasp++;
+      strcat(saspi, "33");
+      break;
+    case '4': 
+      dasp[nasp] = 120;  
+      nasp++;
+      dasp[nasp] = 240;  
+      nasp++;
+      strcat(saspi, "44");
+      break;
+    case '5': 
+      dasp[nasp] = 60;  
+      nasp++;
+      dasp[nasp] = 300;  
+      nasp++;
+      strcat(saspi, "55");
+      break;
+    case '6': 
+      dasp[nasp] = 30;  
+      nasp++;
+      dasp[nasp] = 330;  
+      nasp++;
+      strcat(saspi, "66");
+      break;
+    case '7': 
+      dasp[nasp] = 150;  
+      nasp++;
+      dasp[nasp] = 210;  
+      nasp++;
+      strcat(saspi, "77");
+      break;
+    case '8': 
+      dasp[nasp] = 72;  
+      nasp++;
+      dasp[nasp] = 288;  
+      nasp++;
+      strcat(saspi, "88");
+      break;
+    case '9': 
+      dasp[nasp] = 144;  
+      nasp++;
+      dasp[nasp] = 216;  
+      nasp++;
+      strcat(saspi, "99");
+      break;
+    case 'A': 
+      dasp[nasp] = 45;  
+      nasp++;
+      dasp[nasp] = 315;  
+      nasp++;
+      strcat(saspi, "AA");
+      break;
+    case 'B': 
+      dasp[nasp] = 135;  
+      nasp++;
+      dasp[nasp] = 225;  
+      nasp++;
+      strcat(saspi, "BB");
+      break;
+    default:
+      sprintf(serr, "aspects string %s is invalid", sasp);
+      return ERR;
+      break;
+    }
+  }
+  return nasp;
+}
+
+/* swe_fixstar() overwrites the star name; work on a copy */
+static int32 call_swe_calc(double tjd, int32 ipl, int32 iflag, char *star, double *x, char * serr)
+{
+  char star2[AS_MAXCH];
+  if (ipl == SE_FIXSTAR) {
+    strcpy(star2, star);
+    return swe_fixstar(star2, tjd, iflag, x, serr);
+  } else {
+    return swe_calc(tjd, ipl, iflag, x, serr);
+  }
+}
+
+/* 
+ * Binary search of minimum orb with an almost-aspect 
+ * and of exact aspects that happen twice within step width
+ */
+static int get_crossing_bin_search(double dt, double tt0, double dang, double xta1,  double xta2,  double xtb1,  double xtb2, double *tret, int32 ipla, int32 iplb, char *stara, char *starb, int32 iflag, AS_BOOL is_transit, char *serr)
+{
+  double d12, d1, tt1, xa[6], xb[6];
+  d1 = swe_degnorm(xta1 - xtb1 - dang);
+  if (d1 > 180) d1 -= 360;
+  while(dt > HUNDTHOFSEC) {
+    dt /= 2.0;
+    tt1 = tt0 + dt;
+    if (call_swe_calc(tt1, ipla, iflag, stara, xa, serr) == ERR)
+      return ERR;
+    if (is_transit)
+      xb[0] = xtb1;
+    else
+      if (call_swe_calc(tt1, iplb, iflag, starb, xb, serr) == ERR)
+	return ERR;
+    d12 = swe_degnorm(xa[0] - xb[0] - dang);
+    if (d12 > 180) d12 -= 360;
+    if (d1 * d12 < 0) {
+      xta2 = xa[0];
+      xtb2 = xb[0];
+    } else {
+      xta1 = xa[0];
+      xtb1 = xb[0];
+      tt0 += dt;
+    }
+    d1 = swe_degnorm(xta1 - xtb1 - dang);
+    if (d1 > 180) d1 -= 360;
+  }
+  *tret = tt0;
+  return OK;
+}
+
+/* Binary search of exact aspect
+ * This function finds aspects if exactness occurs only once within step
+ * width */
+static int get_near_crossing_bin_search(double dt, double tt0, double dang, double xta1,  double xta2,  double xtb1,  double xtb2, double *tret, double *tret2, double *dorb, int32 ipla, int32 iplb, char *stara, char *starb, int32 iflag, char *serr)
+{
+  double d12, d1, d2, tt1, xa[6], xb[6];
+  *tret = 0;
+  *tret2 = 0;
+  *dorb = 0;
+  d1 = swe_degnorm(xta1 - xtb1 - dang);
+  if (d1 > 180) d1 -= 360;
+  d2 = swe_degnorm(xta2 - xtb2 - dang);
+  if (d2 > 180) d2 -= 360;
+  while(dt > HUNDTHOFSEC) {
+    dt /= 2.0;
+    tt1 = tt0 + dt;
+    if (call_swe_calc(tt1, ipla, iflag, stara, xa, serr) == ERR)
+      return ERR;
+    if (call_swe_calc(tt1, iplb, iflag, starb, xb, serr) == ERR)
+      return ERR;
+    d12 = swe_degnorm(xa[0] - xb[0] - dang);
+    if (d12 > 180) d12 -= 360;
+    if (d1 * d12 < 0 || d12 * d2 < 0) {
+      if (get_crossing_bin_search(dt, tt0, dang, xta1, xa[0], xtb1, xb[0], tret, ipla, iplb, stara, starb, iflag, FALSE, serr) == ERR)
+	return ERR;
+      if (get_crossing_bin_search(dt, tt1, dang, xa[0], xta2, xb[0], xtb2, tret2, ipla, iplb, stara, starb, iflag, FALSE, serr) == ERR)
+	return ERR;
+      *dorb = 0;
+      return OK;
+    } else if (fabs(d2) > fabs(d1)) {
+      xta2 = xa[0];
+      xtb2 = xb[0];
+    } else {
+      xta1 = xa[0];
+      xtb1 = xb[0];
+      tt0 += dt;
+    }
+    d1 = swe_degnorm(xta1 - xtb1 - dang);
+    if (d1 > 180) d1 -= 360;
+    d2 = swe_degnorm(xta2 - xtb2 - dang);
+    if (d2 > 180) d2 -= 360;
+  }
+  *tret = tt0;
+  *dorb = d1;
+  return OK;
+}
+
+static char *forw_splan(char *sp)
+{
+  char *sp2;
+  if (*sp == ',') {
+    sp2 = strchr(sp, ']');
+    if (sp2 == NULL)
+      sp = sp + strlen(sp); /* end of string splan */
+    else
+      sp = sp2 + 1;
+  } else {
+    sp++;
+  }
+  return sp;
+}
+
+/*
+ * Function returns the ipl or name (if star) of the next object in 
+ * the planets string.
+ * The planets string is formed as follows:
+ * "0123456789mtAFD,f[Gal],f[Ald],a[136199],a[433]"
+ * The characters before the comma are planet codes as we use them
+ * in other software.
+ * Asteroids are coded as follows ",a[mpc_number]".
+ * Fixed stars are coded as follows ",f[star_name]".
+ */
+static int32 letter_to_ipl_or_star(char *s, char *stnam)
+{
+  char *sp, *sp2;
+  int ipl = letter_to_ipl((int) *s);
+  if (*s == ',') {
+    sp = s + 1;
+    /* fixed star */
+    if (*sp == 'f') {
+      sp += 2;
+      sp2 = strchr(sp, ']');
+      if (sp2 == NULL) { /* bracket at end of string missing */
+        strncpy(stnam, sp, 39);
+	stnam[39] = '\0';
+      } else {
+	if (sp2 - sp > 39)
+	  sp2 = sp + 39;
+        strncpy(stnam, sp, sp2 - sp);
+	stnam[sp2 - sp] = '\0';
+      }
+      ipl = SE_FIXSTAR;
+    } else if (*sp == 'a') {
+      sp += 2;
+      ipl = atoi(sp) + SE_AST_OFFSET;
+    }
+  }
+  return ipl;
+}
+
+static int pev_compare(const EVENT *a1, const EVENT *a2)
+{
+  if (a1->tjd > a2->tjd)
+    return 1;
+  if (a1->tjd < a2->tjd)
+    return -1;
+  return 0;
+}
+
+static int32 add_event(EVITER *pit, char *serr)
+{
+  EVENT *pev;
+  if (pit->nev == pit->nevmax) {
+    int32 n = pit->nevmax == 0 ? 64 : 2 * pit->nevmax;
+    if ((pev = (EVENT *) realloc(pit->pev, n * sizeof(EVENT))) == NULL) {
+      strcpy(serr, "could not allocate event buffer");
+      return ERR;
+    }
+    pit->pev = pev;
+    pit->nevmax = n;
+  }
+  pev = pit->pev + pit->nev;
+  memset((void *) pev, 0, sizeof(EVENT));
+  pev->evtype = pit->itype;
+  pit->nev++;
+  return OK;
+}
+
+static void fill_pev(EVENT *pev, EVITER *pit, double tjd, int ia, int ib, int iasp, int bpind, double dasp, double dang, double dorb)
+{
+  pev->tjd = tjd;
+  pev->ipla = pit->ipl[ia];
+  if (pev->ipla == SE_FIXSTAR)
+    strcpy(pev->stnama, pit->stcat[ia]);
+  else
+    swe_get_planet_name(pev->ipla, pev->stnama);
+  if (ib >= 0) {
+    pev->iplb = pit->ipl[ib];
+    if (pev->iplb == SE_FIXSTAR)
+      strcpy(pev->stnamb, pit->stcat[ib]);
+    else
+      swe_get_planet_name(pev->iplb, pev->stnamb);
+  } else {
+    pev->iplb = -1;
+  }
+  pev->iasp = iasp;
+  pev->bpind = bpind;
+  pev->dasp = dasp;
+  pev->dang = dang;
+  pev->dorb = dorb;
+}
+
+/* orb within which a crossing is looked for at the begin of a step */
+static double search_orb(int32 ipla, int32 iplb)
+{
+  if (ipla == SE_MOON || iplb == SE_MOON)
+    return 20;
+  return NEAR_CROSSING_ORB + 3;
+}
+
+/* Exact aspects, near aspects with orb < NEAR_CROSSING_ORB, and the
+ * crossings of the pre-orb and post-orb of +-SWEV_ASPORB between all body
+ * pairs, as calc_mundane_aspects() has always found them */
+static int32 step_aspects(EVITER *pit, double t, char *serr)
+{
+  int32 ia, ib, iaspi, ipla, iplb, bpind, retflag;
+  double tret, tret2, dang, dorb, d1, d2, d1d, d2d;
+  for (ia = 0; ia < pit->nbody; ia++) {
+    ipla = pit->ipl[ia];
+    /* fixed stars are not considered to transit over other bodies */
+    if (ipla == SE_FIXSTAR) continue;
+    for (ib = ia + 1; ib < pit->nbody; ib++) {
+      iplb = pit->ipl[ib];
+      bpind = ia * NMAXPL + ib;
+      for (iaspi = 0; iaspi < pit->nasp; iaspi++) {
+	int iorb, norb = 3;
+	int orbfac;
+	int iasp = (int) pit->saspi[iaspi] - (int) '0';
+	/* for pre-orb, exact, post-orb: */
+	for (iorb = 0; iorb < norb; iorb++) {
+	  /* no pre- and post orbs for aspects between different kinds of
+	   * nodes and apsides */
+	  if (iorb != 1) {
+	    if (strchr("mtABcg", pit->code[ia]) != NULL && strchr("mtABcg", pit->code[ib]) != NULL)
+	      continue;
+	  }
+	  orbfac = (iorb - 1);  /* is -1, 0, 1 */
+	  dang = swe_degnorm(pit->dasp[iaspi] + SWEV_ASPORB * orbfac);
+	  d1 = swe_degnorm(pit->x1[ia] - pit->x1[ib] - dang);
+	  if (d1 > 180) d1 -= 360;
+	  d2 = swe_degnorm(pit->x2[ia] - pit->x2[ib] - dang);
+	  if (d2 > 180) d2 -= 360;
+	  if (fabs(d1) > search_orb(ipla, iplb))
+	    continue;
+	  d1d = swe_degnorm(pit->x1d[ia] - pit->x1d[ib] - dang);
+	  if (d1d > 180) d1d -= 360;
+	  d2d = swe_degnorm(pit->x2d[ia] - pit->x2d[ib] - dang);
+	  if (d2d > 180) d2d -= 360;
+	  /* crossing found; if exactness happens twice within step width,
+	   * it is found by the near crossing search below */
+	  if (d1 * d2 < 0) {
+	    if (get_crossing_bin_search(pit->tstep, t, dang, pit->x1[ia], pit->x2[ia], pit->x1[ib], pit->x2[ib], &tret, ipla, iplb, pit->stnam[ia], pit->stnam[ib], pit->iflag, FALSE, serr) == ERR)
+	      return ERR;
+	    if (add_event(pit, serr) == ERR)
+	      return ERR;
+	    fill_pev(pit->pev + pit->nev - 1, pit, tret, ia, ib, iasp, bpind, pit->dasp[iaspi], dang, 0);
+	  /* 
+	   * - near crossing occurs (t of smallest orb is found)
+	   * - or exact aspect occurs twice within step width
+	   */
+	  } else if (fabs(d1) < NEAR_CROSSING_ORB || fabs(d2) < NEAR_CROSSING_ORB) {
+	    if (d1 > 0 && d2 > 0) {
+	      if (d1 > d2 && d2 > d2d) continue;
+	      if (d1 < d2 && d1 < d1d) continue;
+	    } else {
+	      if (d1 > d2 && d1 > d1d) continue;
+	      if (d1 < d2 && d2 < d2d) continue;
+	    }
+	    if ((retflag = get_near_crossing_bin_search(pit->tstep, t, dang, pit->x1[ia], pit->x2[ia], pit->x1[ib], pit->x2[ib], &tret, &tret2, &dorb, ipla, iplb, pit->stnam[ia], pit->stnam[ib], pit->iflag, serr)) == ERR)
+	      return ERR;
+	    if (retflag == -2)
+	      continue;
+	    if (fabs(dorb) > 0) {
+	      if (orbfac == 0) {
+		if (add_event(pit, serr) == ERR)
+		  return ERR;
+		fill_pev(pit->pev + pit->nev - 1, pit, tret, ia, ib, iasp, bpind, pit->dasp[iaspi], dang, dorb);
+	      }
+	    } else {
+	      if (add_event(pit, serr) == ERR)
+		return ERR;
+	      fill_pev(pit->pev + pit->nev - 1, pit, tret, ia, ib, iasp, bpind, pit->dasp[iaspi], dang, dorb);
+	      if (tret2 != 0) {
+		if (add_event(pit, serr) == ERR)
+		  return ERR;
+		fill_pev(pit->pev + pit->nev - 1, pit, tret2, ia, ib, iasp, bpind, pit->dasp[iaspi], dang, dorb);
+	      }
+	    }
+	  }
+	}
+      }
+    }
+  }
+  return OK;
+}
+
+/* Transits of the bodies over the positions dpos, in the aspects of sasp
+ * (CTYP_TRANSITS), or over the positions dpos, by default the sign
+ * boundaries (CTYP_INGRESSES). Only exact crossings are returned. */
+static int32 step_positions(EVITER *pit, double t, char *serr)
+{
+  int32 ia, ip, iaspi, ipla, nasp;
+  double tret, dang, d1, d2, pos;
+  EVENT *pev;
+  nasp = (pit->itype == CTYP_TRANSITS) ? pit->nasp : 1;
+  for (ia = 0; ia < pit->nbody; ia++) {
+    ipla = pit->ipl[ia];
+    for (ip = 0; ip < pit->npos; ip++) {
+      pos = pit->dpos[ip];
+      for (iaspi = 0; iaspi < nasp; iaspi++) {
+	dang = (pit->itype == CTYP_TRANSITS) ? pit->dasp[iaspi] : 0;
+	d1 = swe_degnorm(pit->x1[ia] - pos - dang);
+	if (d1 > 180) d1 -= 360;
+	d2 = swe_degnorm(pit->x2[ia] - pos - dang);
+	if (d2 > 180) d2 -= 360;
+	if (fabs(d1) > search_orb(ipla, -1) || d1 * d2 >= 0)
+	  continue;
+	if (get_crossing_bin_search(pit->tstep, t, dang, pit->x1[ia], pit->x2[ia], pos, pos, &tret, ipla, -1, pit->stnam[ia], NULL, pit->iflag, TRUE, serr) == ERR)
+	  return ERR;
+	if (add_event(pit, serr) == ERR)
+	  return ERR;
+	pev = pit->pev + pit->nev - 1;
+	if (pit->itype == CTYP_TRANSITS) {
+	  fill_pev(pev, pit, tret, ia, -1, (int) pit->saspi[iaspi] - (int) '0', ip, pit->dasp[iaspi], dang, 0);
+	} else {
+	  fill_pev(pev, pit, tret, ia, -1, 0, ip, 0, 0, 0);
+	  pev->backward = (d1 > 0);
+	  pev->isign = (int32) (swe_degnorm(pos + (pev->backward ? -TTINY : TTINY)) / 30);
+	}
+	pev->dret = pos;
+      }
+    }
+  }
+  return OK;
+}
+
+/* positions of all bodies at the end of the step beginning at t */
+static int32 step_positions_at(EVITER *pit, double t, char *serr)
+{
+  int32 i;
+  double x[6];
+  for (i = 0; i < pit->nbody; i++) {
+    if (pit->first_step) {
+      if (call_swe_calc(t, pit->ipl[i], pit->iflag|SEFLG_SPEED, pit->stnam[i], x, serr) == ERR)
+	return ERR;
+      pit->x1[i] = x[0];
+      pit->x1d[i] = x[0] + pit->tstep / 10.0 * x[3];
+    } else {
+      pit->x1[i] = pit->x2[i];
+      pit->x1d[i] = pit->x2d[i];
+    }
+    if (call_swe_calc(t + pit->tstep, pit->ipl[i], pit->iflag|SEFLG_SPEED, pit->stnam[i], x, serr) == ERR)
+      return ERR;
+    pit->x2[i] = x[0];
+    pit->x2d[i] = x[0] + pit->tstep / 10.0 * x[3];
+  }
+  pit->first_step = FALSE;
+  return OK;
+}
+
+/*
+ * Chebyshev-proxy search (SWEV_PROXY)
+ *
+ * For every window of pit->tstep days, the longitude of each body is
+ * fitted by a Chebyshev series through its values at the Chebyshev-Lobatto
+ * nodes. The degree is doubled (the nodes nest, so earlier evaluations are
+ * kept) until the last two coefficients are below PROXY_TOL.
+ * For a body pair, the difference series D(t) = La(t) - Lb(t) is split at
+ * the zeros of the relative speed D'(t) into monotone segments. Each
+ * segment crosses any given angle at most once, so the roots
+ * are bracketed without stepping, however fast or slow the pair moves.
+ * Roots are found on the series and then polished with swe_calc().
+ */
+static double cheb_eval(double x, double *c, int n)
+{
+  double b0 = 0, b1 = 0, b2;
+  int j;
+  for (j = n; j >= 1; j--) {
+    b2 = b1;
+    b1 = b0;
+    b0 = 2 * x * b1 - b2 + c[j];
+  }
+  return x * b0 - b1 + c[0];
+}
+
+/* coefficients d[0..n-1] of the derivative (by x) of series c[0..n] */
+static void cheb_deriv(double *c, int n, double *d)
+{
+  int j;
+  d[n] = 0;
+  if (n == 0)
+    return;
+  d[n - 1] = 2 * n * c[n];
+  for (j = n - 1; j >= 1; j--)
+    d[j - 1] = (j + 1 < n ? d[j + 1] : 0) + 2 * j * c[j];
+  d[0] /= 2;
+}
+
+/* root of series c - y in [xa, xb], where c(xa) - y and c(xb) - y
+ * differ in sign */
+static double cheb_root(double *c, int n, double y, double xa, double xb)
+{
+  double xm, fa = cheb_eval(xa, c, n) - y;
+  int i;
+  for (i = 0; i < 60 && xb - xa > 1e-15; i++) {
+    xm = (xa + xb) / 2;
+    if ((cheb_eval(xm, c, n) - y < 0) == (fa < 0)) {
+      xa = xm;
+    } else {
+      xb = xm;
+    }
+  }
+  return (xa + xb) / 2;
+}
+
+/* Fits the longitude of body i over the window [t0, t0 + 2 * hw].
+ * Node k of degree n is node k * PROXY_NMAX / n of the finest grid, at
+ * x = pcos[k]; node 0 is the end of the window, node PROXY_NMAX the
+ * beginning. raw[] holds the longitudes, u[] the same unwrapped in time
+ * order. */
+static int32 proxy_fit_body(EVITER *pit, int32 i, double t0, double hw, char *serr)
+{
+  double *raw = pit->praw[i], *u = pit->pu[i], *c = pit->pc[i];
+  double x[6], sum, tm = t0 + hw;
+  int32 n, k, j, s;
+  /* beginning of window is end of previous window */
+  if (pit->first_step) {
+    if (call_swe_calc(t0, pit->ipl[i], pit->iflag, pit->stnam[i], x, serr) == ERR)
+      return ERR;
+    raw[PROXY_NMAX] = x[0];
+  } else {
+    raw[PROXY_NMAX] = raw[0];
+  }
+  u[PROXY_NMAX] = raw[PROXY_NMAX];
+  n = PROXY_NMIN;
+  s = PROXY_NMAX / n;
+  for (k = PROXY_NMAX - s; k >= 0; k -= s) {
+    if (call_swe_calc(tm + hw * pit->pcos[k], pit->ipl[i], pit->iflag, pit->stnam[i], x, serr) == ERR)
+      return ERR;
+    raw[k] = x[0];
+    u[k] = u[k + s] + swe_difdeg2n(raw[k], raw[k + s]);
+  }
+  for (;;) {
+    /* Lobatto coefficients of degree n */
+    for (j = 0; j <= n; j++) {
+      sum = (u[0] + ((j & 1) ? -u[PROXY_NMAX] : u[PROXY_NMAX])) / 2;
+      for (k = 1; k < n; k++)
+	sum += u[k * s] * pit->pcos[(j * k * s) % (2 * PROXY_NMAX)];
+      c[j] = 2.0 / n * sum;
+    }
+    c[0] /= 2;
+    c[n] /= 2;
+    pit->pn[i] = n;
+    if (fabs(c[n]) + fabs(c[n - 1]) < PROXY_TOL || n == PROXY_NMAX)
+      return OK;
+    /* double the degree: new nodes lie between the old ones */
+    for (k = PROXY_NMAX - s / 2; k > 0; k -= s) {
+      if (call_swe_calc(tm + hw * pit->pcos[k], pit->ipl[i], pit->iflag, pit->stnam[i], x, serr) == ERR)
+	return ERR;
+      raw[k] = x[0];
+      u[k] = u[k + s / 2] + swe_difdeg2n(raw[k], raw[k + s / 2]);
+    }
+    n *= 2;
+    s /= 2;
+  }
+}
+
+/* Splits [-1, 1] at the zeros of the derivative of series c[0..n].
+ * xb[] receives -1, the zeros in ascending order, and 1; the number of
+ * breakpoints is returned. Pairs of zeros closer than the sampling grid
+ * are found from the zeros of the second derivative. */
+static int32 proxy_segments(double *c, int32 n, double *xb)
+{
+  double d1[PROXY_NMAX + 1], d2[PROXY_NMAX + 1];
+  double xa, xc, xm, fa, fc, fm, ga, gc;
+  int32 j, m = 4 * n + 8, nb = 0;
+  cheb_deriv(c, n, d1);
+  cheb_deriv(d1, n - 1, d2);
+  xb[nb++] = -1;
+  xa = -1;
+  fa = cheb_eval(xa, d1, n - 1);
+  ga = cheb_eval(xa, d2, n - 2);
+  for (j = 1; j <= m; j++) {
+    xc = -1 + 2.0 * j / m;
+    fc = cheb_eval(xc, d1, n - 1);
+    gc = cheb_eval(xc, d2, n - 2);
+    if ((fa < 0) != (fc < 0)) {
+      xb[nb++] = cheb_root(d1, n - 1, 0, xa, xc);
+    } else if ((ga < 0) != (gc < 0)) {
+      xm = cheb_root(d2, n - 2, 0, xa, xc);
+      fm = cheb_eval(xm, d1, n - 1);
+      if ((fm < 0) != (fa < 0)) {
+	xb[nb++] = cheb_root(d1, n - 1, 0, xa, xm);
+	xb[nb++] = cheb_root(d1, n - 1, 0, xm, xc);
+      }
+    }
+    xa = xc;
+    fa = fc;
+    ga = gc;
+  }
+  xb[nb++] = 1;
+  return nb;
+}
+
+/* difference series of a body pair over the current window, split into
+ * segments of monotone relative position */
+struct proxy_pair {
+  int32 ia, ib;                 /* ib < 0: body ia alone */
+  double t0, hw;
+  int32 n, nb;
+  double c[PROXY_NMAX + 1], d1[PROXY_NMAX + 1], d2[PROXY_NMAX + 1];
+  double xb[PROXY_NCRIT], yb[PROXY_NCRIT];
+  double ymin, ymax;
+};
+
+static void proxy_pair_init(EVITER *pit, int32 ia, int32 ib, double t0, double hw, struct proxy_pair *pp)
+{
+  int32 j, n;
+  pp->ia = ia;
+  pp->ib = ib;
+  pp->t0 = t0;
+  pp->hw = hw;
+  n = pit->pn[ia];
+  if (ib >= 0 && pit->pn[ib] > n)
+    n = pit->pn[ib];
+  for (j = 0; j <= n; j++) {
+    pp->c[j] = (j <= pit->pn[ia]) ? pit->pc[ia][j] : 0;
+    if (ib >= 0 && j <= pit->pn[ib])
+      pp->c[j] -= pit->pc[ib][j];
+  }
+  pp->n = n;
+  pp->nb = proxy_segments(pp->c, n, pp->xb);
+  cheb_deriv(pp->c, n, pp->d1);
+  cheb_deriv(pp->d1, n - 1, pp->d2);
+  /* the window ends use the sampled values, so that a crossing near a
+   * window boundary is found in exactly one window */
+  pp->yb[0] = pit->pu[ia][PROXY_NMAX] - (ib >= 0 ? pit->pu[ib][PROXY_NMAX] : 0);
+  pp->yb[pp->nb - 1] = pit->pu[ia][0] - (ib >= 0 ? pit->pu[ib][0] : 0);
+  pp->ymin = pp->ymax = pp->yb[0];
+  for (j = 1; j < pp->nb; j++) {
+    if (j < pp->nb - 1)
+      pp->yb[j] = cheb_eval(pp->xb[j], pp->c, n);
+    if (pp->yb[j] < pp->ymin) pp->ymin = pp->yb[j];
+    if (pp->yb[j] > pp->ymax) pp->ymax = pp->yb[j];
+  }
+}
+
+/* longitude of body i, or pos if i < 0. Positions are computed without
+ * SEFLG_SPEED throughout, because for some bodies (interpolated apsides)
+ * the position depends on that flag. */
+static int32 proxy_calc(EVITER *pit, int32 i, double pos, double t, double *x, char *serr)
+{
+  if (i < 0) {
+    x[0] = pos;
+    return OK;
+  }
+  return call_swe_calc(t, pit->ipl[i], pit->iflag, pit->stnam[i], x, serr);
+}
+
+/* Polishes a root found on the proxy with the full ephemeris: Newton
+ * steps on the true relative position, with the relative speed from the
+ * proxy. If they do not converge within the segment [ta, tb], falls back
+ * to bisection, which requires the crossing to be confirmed by swe_calc()
+ * at ta and tb.
+ * Returns OK, ERR, or -2 if the ephemeris does not confirm the root. */
+static int32 proxy_polish(EVITER *pit, struct proxy_pair *pp, double pos, double dang, double ta, double tb, double *tret, char *serr)
+{
+  double xa[6], xb[6], xa2[6], xb2[6], g, v, dt, t = *tret;
+  int32 i, ia = pp->ia, ib = pp->ib;
+  for (i = 0; i < 8; i++) {
+    if (proxy_calc(pit, ia, pos, t, xa, serr) == ERR || proxy_calc(pit, ib, pos, t, xb, serr) == ERR)
+      return ERR;
+    g = swe_degnorm(xa[0] - xb[0] - dang);
+    if (g > 180) g -= 360;
+    v = cheb_eval((t - pp->t0) / pp->hw - 1, pp->d1, pp->n - 1) / pp->hw;
+    if (v == 0)
+      break;
+    dt = -g / v;
+    t += dt;
+    if (fabs(dt) < PROXY_TTOL) {
+      *tret = t;
+      return OK;
+    }
+    if (t < ta || t > tb)
+      break;
+  }
+  if (proxy_calc(pit, ia, pos, ta, xa, serr) == ERR || proxy_calc(pit, ib, pos, ta, xb, serr) == ERR)
+    return ERR;
+  if (proxy_calc(pit, ia, pos, tb, xa2, serr) == ERR || proxy_calc(pit, ib, pos, tb, xb2, serr) == ERR)
+    return ERR;
+  g = swe_degnorm(xa[0] - xb[0] - dang);
+  if (g > 180) g -= 360;
+  v = swe_degnorm(xa2[0] - xb2[0] - dang);
+  if (v > 180) v -= 360;
+  if (g * v >= 0)
+    return -2;
+  return get_crossing_bin_search(tb - ta, ta, dang, xa[0], xa2[0], xb[0], xb2[0], tret, pit->ipl[ia], ib < 0 ? -1 : pit->ipl[ib], pit->stnam[ia], ib < 0 ? NULL : pit->stnam[ib], pit->iflag, ib < 0, serr);
+}
+
+/* All crossings of the pair with angle dang within the current window,
+ * or of the single body over pos + dang, and, if near is set, the closest
+ * approaches within NEAR_CROSSING_ORB that do not become exact. */
+static int32 proxy_crossings(EVITER *pit, struct proxy_pair *pp, double pos, double dang, AS_BOOL near, int32 iasp, int32 bpind, double dasp, char *serr)
+{
+  double y, tret, ta, tb, dorb, curv, xpa[6], xpb[6];
+  double t0 = pp->t0, hw = pp->hw, *xb = pp->xb, *yb = pp->yb;
+  int32 j, k, kmin, kmax, retc;
+  int32 ia = pp->ia, ib = pp->ib;
+  if (ib >= 0)
+    pos = 0;
+  kmin = (int32) floor((pp->ymin - pos - dang) / 360);
+  kmax = (int32) ceil((pp->ymax - pos - dang) / 360);
+  for (j = 0; j < pp->nb - 1; j++) {
+    for (k = kmin; k <= kmax; k++) {
+      y = pos + dang + 360.0 * k;
+      if ((yb[j] - y < 0) == (yb[j + 1] - y < 0))
+	continue;
+      ta = t0 + hw * (xb[j] + 1);
+      tb = t0 + hw * (xb[j + 1] + 1);
+      tret = t0 + hw * (cheb_root(pp->c, pp->n, y, xb[j], xb[j + 1]) + 1);
+      if ((retc = proxy_polish(pit, pp, pos, dang, ta, tb, &tret, serr)) == ERR)
+	return ERR;
+      if (retc == -2)
+	continue;
+      if (add_event(pit, serr) == ERR)
+	return ERR;
+      fill_pev(pit->pev + pit->nev - 1, pit, tret, ia, ib, iasp, bpind, dasp, dang, 0);
+      if (ib < 0)
+	pit->pev[pit->nev - 1].backward = (yb[j + 1] < yb[j]);
+    }
+  }
+  if (!near)
+    return OK;
+  for (j = 1; j < pp->nb - 1; j++) {
+    y = swe_degnorm(yb[j] - dang);
+    if (y > 180) y -= 360;
+    if (y == 0 || fabs(y) >= NEAR_CROSSING_ORB)
+      continue;
+    /* closest approach without crossing: minimum above the aspect angle
+     * or maximum below it */
+    curv = cheb_eval(xb[j], pp->d2, pp->n - 2) / (hw * hw);
+    if (y * curv <= 0)
+      continue;
+    /* the orb is taken from the ephemeris, the time from the proxy */
+    tret = t0 + hw * (xb[j] + 1);
+    if (proxy_calc(pit, ia, 0, tret, xpa, serr) == ERR || proxy_calc(pit, ib, 0, tret, xpb, serr) == ERR)
+      return ERR;
+    dorb = swe_degnorm(xpa[0] - xpb[0] - dang);
+    if (dorb > 180) dorb -= 360;
+    if (dorb == 0 || dorb * y < 0)
+      continue;
+    if (add_event(pit, serr) == ERR)
+      return ERR;
+    fill_pev(pit->pev + pit->nev - 1, pit, tret, ia, ib, iasp, bpind, dasp, dang, dorb);
+  }
+  return OK;
+}
+
+/* One window of the proxy search, beginning at t */
+static int32 proxy_step(EVITER *pit, double t, char *serr)
+{
+  int32 ia, ib, ip, iaspi, iorb, nasp;
+  double hw, dang, pos;
+  struct proxy_pair pp;
+  EVENT *pev;
+  hw = pit->tstep;
+  if (t + hw > pit->tjde)
+    hw = pit->tjde - t;
+  hw /= 2;
+  for (ia = 0; ia < pit->nbody; ia++) {
+    if (proxy_fit_body(pit, ia, t, hw, serr) == ERR)
+      return ERR;
+  }
+  pit->first_step = FALSE;
+  if (pit->itype == CTYP_MASPECTS) {
+    for (ia = 0; ia < pit->nbody; ia++) {
+      /* fixed stars are not considered to transit over other bodies */
+      if (pit->ipl[ia] == SE_FIXSTAR) continue;
+      for (ib = ia + 1; ib < pit->nbody; ib++) {
+	proxy_pair_init(pit, ia, ib, t, hw, &pp);
+	for (iaspi = 0; iaspi < pit->nasp; iaspi++) {
+	  for (iorb = 0; iorb < 3; iorb++) {
+	    /* no pre- and post orbs for aspects between different kinds of
+	     * nodes and apsides */
+	    if (iorb != 1) {
+	      if (strchr("mtABcg", pit->code[ia]) != NULL && strchr("mtABcg", pit->code[ib]) != NULL)
+		continue;
+	    }
+	    dang = swe_degnorm(pit->dasp[iaspi] + SWEV_ASPORB * (iorb - 1));
+	    if (proxy_crossings(pit, &pp, 0, dang, iorb == 1, (int32) pit->saspi[iaspi] - (int32) '0', ia * NMAXPL + ib, pit->dasp[iaspi], serr) == ERR)
+	      return ERR;
+	  }
+	}
+      }
+    }
+    return OK;
+  }
+  nasp = (pit->itype == CTYP_TRANSITS) ? pit->nasp : 1;
+  for (ia = 0; ia < pit->nbody; ia++) {
+    proxy_pair_init(pit, ia, -1, t, hw, &pp);
+    for (ip = 0; ip < pit->npos; ip++) {
+      pos = pit->dpos[ip];
+      for (iaspi = 0; iaspi < nasp; iaspi++) {
+	int32 nev0 = pit->nev;
+	if (pit->itype == CTYP_TRANSITS) {
+	  if (proxy_crossings(pit, &pp, pos, pit->dasp[iaspi], FALSE, (int32) pit->saspi[iaspi] - (int32) '0', ip, pit->dasp[iaspi], serr) == ERR)
+	    return ERR;
+	} else {
+	  if (proxy_crossings(pit, &pp, pos, 0, FALSE, 0, ip, 0, serr) == ERR)
+	    return ERR;
+	}
+	for (pev = pit->pev + nev0; pev < pit->pev + pit->nev; pev++) {
+	  pev->dret = pos;
+	  if (pit->itype == CTYP_INGRESSES)
+	    pev->isign = (int32) (swe_degnorm(pos + (pev->backward ? -TTINY : TTINY)) / 30);
+	}
+      }
+    }
+  }
+  return OK;
+}
+
+/*
+ * Opens an event search from tjd0 to tjde, stepping by tstep days
+ * (TT; default 1). Steps begin at tjd0 and before tjde; as in swevents,
+ * a step covers [t, t + tstep], so the last one can report events up to
+ * tjde + tstep. Proxy windows are cut at tjde.
+ * itype    CTYP_MASPECTS:  aspects sasp between all pairs of bodies splan
+ *          CTYP_TRANSITS:  bodies splan in aspects sasp to the npos
+ *                          fixed longitudes dpos
+ *          CTYP_INGRESSES: bodies splan crossing the npos longitudes
+ *                          dpos, or the sign boundaries if npos == 0
+ * itype | SWEV_PROXY: instead of stepping, fit Chebyshev proxies over
+ *          windows of tstep days (default 8) and solve for the events on
+ *          them; every event is then polished with swe_calc(). Needs far
+ *          fewer ephemeris calls. Near aspects are the closest approaches.
+ * splan and sasp are coded as for swevents (SPLAN_ASPECTS, SASP_ASPECTS).
+ * The handle owns all state of the search; use one handle per thread.
+ * Returns NULL on error.
+ */
+EVITER *swev_iter_open(int32 iflag, int32 itype, double tjd0, double tjde, double tstep, char *splan, char *sasp, int32 npos, double *dpos, char *serr)
+{
+  EVITER *pit;
+  char *sp;
+  int32 i;
+  AS_BOOL proxy = (itype & SWEV_PROXY) != 0;
+  itype &= ~SWEV_PROXY;
+  if (itype != CTYP_MASPECTS && itype != CTYP_TRANSITS && itype != CTYP_INGRESSES) {
+    sprintf(serr, "event type %d is not supported", itype);
+    return NULL;
+  }
+  if ((pit = (EVITER *) calloc(1, sizeof(EVITER))) == NULL) {
+    strcpy(serr, "could not allocate event iterator");
+    return NULL;
+  }
+  pit->iflag = iflag;
+  pit->itype = itype;
+  pit->t = tjd0;
+  pit->tjde = tjde;
+  pit->tstep = (tstep > 0) ? tstep : (proxy ? SWEV_PROXY_WINDOW : SWEV_TSTEP);
+  pit->first_step = TRUE;
+  pit->proxy = proxy;
+  for (i = 0; i < 2 * PROXY_NMAX; i++)
+    pit->pcos[i] = cos(i * PI / PROXY_NMAX);
+  for (sp = splan; *sp != '\0'; sp = forw_splan(sp)) {
+    if (pit->nbody == NMAXPL) {
+      sprintf(serr, "too many bodies in %s, max. %d", splan, NMAXPL);
+      goto open_error;
+    }
+    pit->code[pit->nbody] = *sp;
+    *pit->stnam[pit->nbody] = '\0';
+    pit->ipl[pit->nbody] = letter_to_ipl_or_star(sp, pit->stnam[pit->nbody]);
+    if (pit->ipl[pit->nbody] < 0 && pit->ipl[pit->nbody] != SE_FIXSTAR) {
+      sprintf(serr, "invalid body code %c in %s", *sp, splan);
+      goto open_error;
+    }
+    /* events carry the catalogue name; the search itself always uses
+     * the name as given, which may match a different catalogue entry
+     * than the catalogue name would */
+    if (pit->ipl[pit->nbody] == SE_FIXSTAR) {
+      char star[AS_MAXCH];
+      double x[6];
+      strcpy(star, pit->stnam[pit->nbody]);
+      if (swe_fixstar(star, tjd0, iflag, x, serr) == ERR)
+	goto open_error;
+      star[39] = '\0';
+      strcpy(pit->stcat[pit->nbody], star);
+    }
+    pit->nbody++;
+  }
+  if (itype != CTYP_INGRESSES) {
+    if ((pit->nasp = swev_get_aspect_angles(sasp, pit->saspi, pit->dasp, serr)) == ERR)
+      goto open_error;
+  }
+  if (itype == CTYP_INGRESSES && npos == 0) {
+    pit->npos = 12;
+    if ((pit->dpos = (double *) malloc(12 * sizeof(double))) == NULL)
+      goto alloc_error;
+    for (i = 0; i < 12; i++)
+      pit->dpos[i] = i * 30.0;
+  } else if (itype != CTYP_MASPECTS && npos > 0) {
+    pit->npos = npos;
+    if ((pit->dpos = (double *) malloc(npos * sizeof(double))) == NULL)
+      goto alloc_error;
+    for (i = 0; i < npos; i++)
+      pit->dpos[i] = swe_degnorm(dpos[i]);
+  }
+  return pit;
+alloc_error:
+  strcpy(serr, "could not allocate event iterator");
+open_error:
+  swev_iter_close(pit);
+  return NULL;
+}
+
+/*
+ * Delivers the next event in time order.
+ * Returns 1 if *pev holds an event, 0 at the end of the range, or ERR.
+ * Events are found one time step at a time, so memory does not grow with
+ * the length of the range.
+ */
+int32 swev_iter_next(EVITER *pit, EVENT *pev, char *serr)
+{
+  int32 retc;
+  while (pit->iev == pit->nev) {
+    if (pit->t >= pit->tjde)
+      return 0;
+    pit->nev = pit->iev = 0;
+    if (pit->proxy)
+      retc = proxy_step(pit, pit->t, serr);
+    else if (step_positions_at(pit, pit->t, serr) == ERR)
+      return ERR;
+    else if (pit->itype == CTYP_MASPECTS)
+      retc = step_aspects(pit, pit->t, serr);
+    else
+      retc = step_positions(pit, pit->t, serr);
+    if (retc == ERR)
+      return ERR;
+    /* sort events of current time step */
+    qsort((void *) pit->pev, (size_t) pit->nev, sizeof(EVENT),
+          (int (*)(const void *, const void *))(pev_compare));
+    pit->t += pit->tstep;
+  }
+  *pev = pit->pev[pit->iev++];
+  return 1;
+}
+
+void swev_iter_close(EVITER *pit)
+{
+  if (pit == NULL)
+    return;
+  free(pit->pev);
+  free(pit->dpos);
+  free(pit);
+}
@@ -0,0 +1,418 @@
+/* SWISSEPH
+ * 
+ * swevvoc.c: void-of-course Moon phases, factored out of swevents.c.
+ * All search state lives in a VOCITER handle, so calendars for different
+ * ranges can be computed in parallel threads. Within a handle, the lunar
+ * ingresses and the last lunar aspects found for one phase are kept and
+ * reused for the next one: the ingress that ends a phase is the first
+ * ingress searched for the next phase, and the last aspect to a planet
+ * before an ingress is often also the last before the following one.
+ *
+ * IMPORTANT NOTICE: like swevents.c, this is not a supported part of
+ * Swiss Ephemeris.
+
+**************************************************************/
+/* Copyright (C) 1997 - 2021 Astrodienst AG, Switzerland.  All rights reserved.
+
+  License conditions
+  ------------------
+
+  This file is part of Swiss Ephemeris.
+
+  Swiss Ephemeris is distributed with NO WARRANTY OF ANY KIND.  No author
+  or distributor accepts any responsibility for the consequences of using it,
+  or for whether it serves any particular purpose or works at all, unless he
+  or she says so in writing.  
+
+  Swiss Ephemeris is made available by its authors under a dual licensing
+  system. The software developer, who uses any part of Swiss Ephemeris
+  in his or her software, must choose between one of the two license models,
+  which are
+  a) GNU Affero General Public License (AGPL)
+  b) Swiss Ephemeris Professional License
+
+  The choice must be made before the software developer distributes software
+  containing parts of Swiss Ephemeris to others, and before any public
+  service using the developed software is activated.
+
+  If the developer choses the AGPL software license, he or she must fulfill
+  the conditions of that license, which includes the obligation to place his
+  or her whole software project under the AGPL or a compatible license.
+  See https://www.gnu.org/licenses/agpl-3.0.html
+
+  If the developer choses the Swiss Ephemeris Professional license,
+  he must follow the instructions as found in http://www.astro.com/swisseph/ 
+  and purchase the Swiss Ephemeris Professional Edition from Astrodienst
+  and sign the corresponding license contract.
+
+  The License grants you the right to use, copy, modify and redistribute
+  Swiss Ephemeris, but only under certain conditions described in the License.
+  Among other things, the License requires that the copyright notices and
+  this notice be preserved on all copies.
+
+  Authors of the Swiss Ephemeris: Dieter Koch and Alois Treindl
+
+  The authors of Swiss Ephemeris have no control or influence over any of
+  the derived works, i.e. over software or services created by other
+  programmers which use Swiss Ephemeris functions.
+
+  The names of the authors or of the copyright holder (Astrodienst) must not
+  be used for promoting any software, product or service which uses or contains
+  the Swiss Ephemeris. This copyright notice is the ONLY place where the
+  names of the authors can legally appear, except in cases where they have
+  given special permission in writing.
+
+  The trademarks 'Swiss Ephemeris' and 'Swiss Ephemeris inside' may be used
+  for promoting such software, products or services.
+*/
+
+#include "swephexp.h"
+#include "sweph.h"
+#include "swephlib.h"
+#include "swevents.h"
+
+#define VOC_NINGR	8	/* lunar ingresses kept */
+
+struct voc_iter {
+  int32 iflag;
+  int32 vocmethod;
+  double t, tjde;               /* begin of next search, end of range */
+  /* consecutive lunar ingresses; tingr[0] is the first after tfrom */
+  double tfrom;
+  int32 ningr;
+  double tingr[VOC_NINGR];
+  int32 isign[VOC_NINGR];
+  /* Moon at time tm */
+  double tm, xm[6];
+  /* last aspect of the Moon to a planet: for search ends in (tasp, tend],
+   * the last aspect is the one at tasp */
+  struct {
+    double tend, tasp, dasp;
+    int32 isign;
+  } asp[SE_PLUTO + 1];
+};
+
+/*
+Lunar void-of-course phases
+===========================
+ 
+Definition:
+Last lunar aspect (COQTS) to a planet (0-9) before a lunar ingress.
+ 
+Problem:
+It happens that a the moon does not form ANY aspects with planets while
+crossing a sign. 
+The Rosicrucian Ephemeris lists the following case for March 1965:
+Last aspect    Lunar ingress
+Day    h  m    Day    h  m
+ 4     1:35     4    18:45
+ 4     1:35     7     1:50
+ 
+Method 1 (-v1):
+A VOC phase can start before the last sign ingress, and it can last longer
+than a sign transit. There are less VOC phases than ingresses. The output 
+contains a line per VOC phase, but not a line per ingress.
+For a given time t:
+- calculate the next lunar ingress (ti_next)
+- calculate the next lunar ingress after ti_next (ti_nextnext)
+- set tvoc_start = 0, tvoc_end = ti_nextnext
+- calculate the last aspect before tvoc_end (ta_last)
+  as soon as an aspect later than ti_next is found,
+  set tvoc_end = ti_next; break the search and repeat it
+- set tvoc_start = ta_last
+ 
+Method 2 (-v2): 
+A VOC phase can start before the last sign ingress, and it can last longer
+than a sign transit. But a line is printed for each ingress, and two 
+ingresses can have the same start date for their VOC phases.
+(Output is as in Ros. Eph., e.g. for 4-mar-1965) 
+- calculate the next lunar ingress (ti_next)
+- set tvoc_start = 0, tvoc_end = ti_next
+- calculate the last aspect before tvoc_end (ta_last)
+- set tvoc_start = ta_last
+ 
+Method 3 (-v3, default): 
+A VOC phase cannot start before the last sign ingress, i.e. a VOC phase
+can start at a sign ingress and end at the next sign ingress.
+the two VOC phases remain separate, a VOC phase may start at ingress
+- same procedure as solution 2
+but after that:
+- calculate previous lunar ingress (ti_prev)
+- if ta_last < ti_prev, then ta_last = ti_prev
+*/
+
+static char get_casp(double dasp) 
+{
+  if (dasp == 0) return ((char) 1); 
+  if (dasp == 180) return ((char) 2); 
+  if (dasp == 90) return ((char) 3); 
+  if (dasp == 270) return ((char) 3); 
+  if (dasp == 120) return ((char) 4); 
+  if (dasp == 240) return ((char) 4); 
+  if (dasp == 60) return ((char) 5); 
+  if (dasp == 300) return ((char) 5); 
+  return ((char) 0);
+}
+
+static int32 moon_at(VOCITER *pit, double t, double *xm, char *serr)
+{
+  if (t != pit->tm) {
+    if (swe_calc(t, SE_MOON, pit->iflag, pit->xm, serr) == ERR) {
+      pit->tm = 0;
+      return ERR;
+    }
+    pit->tm = t;
+  }
+  memcpy((void *) xm, (void *) pit->xm, 6 * sizeof(double));
+  return OK;
+}
+
+/* lunar ingress into the next sign after tet0 (backward == 0), or into
+ * the current sign before tet0 (backward != 0) */
+static int32 get_moon_ingress(VOCITER *pit, double tet0, int32 backward, double *tret, int32 *isign, char *serr)
+{
+  double xx[6], xingr, dx, mspeed, t;
+  if (moon_at(pit, tet0, xx, serr) == ERR)
+    return ERR;
+  *isign = (int) (xx[0] / 30); 
+  if (!backward) {
+    (*isign) ++;
+    if (*isign == 12)
+      *isign = 0;
+  }
+  xingr = *isign * 30;
+  dx = swe_difdeg2n(xingr, xx[0]);
+  t = tet0;
+  /* body's speed roughly */
+  mspeed = xx[3];
+  if (pit->iflag & SEFLG_TOPOCTR)
+    mspeed = 13;
+  while(fabs(dx) > 1e-6) {
+    t += dx / mspeed;
+    if (swe_calc(t, SE_MOON, pit->iflag, xx, serr) == ERR)
+      return ERR;
+    dx = swe_difdeg2n(xingr, xx[0]);
+    if (!(pit->iflag & SEFLG_TOPOCTR))
+      mspeed = xx[3];
+  }
+  *tret = t;
+  return OK;
+}
+
+/* first lunar ingress after t; ingresses are taken from, or added to,
+ * the chain of consecutive ingresses in the handle */
+static int32 next_moon_ingress(VOCITER *pit, double t, double *tret, int32 *isign, char *serr)
+{
+  int32 k;
+  double tnext;
+  if (pit->ningr == 0 || t < pit->tfrom || t > pit->tingr[pit->ningr - 1] + 3) {
+    pit->tfrom = t;
+    pit->ningr = 0;
+    if (get_moon_ingress(pit, t, 0, &pit->tingr[0], &pit->isign[0], serr) == ERR)
+      return ERR;
+    pit->ningr = 1;
+  }
+  while (t >= pit->tingr[pit->ningr - 1]) {
+    if (pit->ningr == VOC_NINGR) {
+      pit->tfrom = pit->tingr[0];
+      memmove((void *) pit->tingr, (void *) (pit->tingr + 1), (VOC_NINGR - 1) * sizeof(double));
+      memmove((void *) pit->isign, (void *) (pit->isign + 1), (VOC_NINGR - 1) * sizeof(int32));
+      pit->ningr--;
+    }
+    /* just after the last ingress, the Moon is safely in the new sign */
+    if (get_moon_ingress(pit, pit->tingr[pit->ningr - 1] + 0.1, 0, &tnext, &pit->isign[pit->ningr], serr) == ERR)
+      return ERR;
+    pit->tingr[pit->ningr++] = tnext;
+  }
+  for (k = 0; t >= pit->tingr[k]; k++)
+    ;
+  *tret = pit->tingr[k];
+  *isign = pit->isign[k];
+  return OK;
+}
+
+/* last lunar ingress before t */
+static int32 prev_moon_ingress(VOCITER *pit, double t, double *tret, int32 *isign, char *serr)
+{
+  int32 k;
+  for (k = pit->ningr - 2; k >= 0; k--) {
+    if (pit->tingr[k] <= t && t < pit->tingr[k + 1]) {
+      *tret = pit->tingr[k];
+      *isign = pit->isign[k];
+      return OK;
+    }
+  }
+  return get_moon_ingress(pit, t, 1, tret, isign, serr);
+}
+
+/* last aspect (0, 60, 90, 120, 180 degrees, ...) of the Moon to planet
+ * ipl before t0 */
+static int32 get_prev_lunasp(VOCITER *pit, double t0, int32 ipl, double *tret, double *dasp, int32 *isign, char *serr)
+{
+  double xx[6], xm[6], dang, dx, t, mspeed;
+  int nsign;
+  if (pit->asp[ipl].tend != 0 && pit->asp[ipl].tasp < t0 && t0 <= pit->asp[ipl].tend) {
+    *tret = pit->asp[ipl].tasp;
+    *dasp = pit->asp[ipl].dasp;
+    *isign = pit->asp[ipl].isign;
+    return OK;
+  }
+  if (moon_at(pit, t0, xm, serr) == ERR) 
+    return ERR;
+  if (swe_calc(t0, ipl, pit->iflag, xx, serr) == ERR) 
+    return ERR;
+  nsign = 0;
+  dx = swe_degnorm(xm[0] - xx[0]);
+  nsign = (int) (dx / 30);
+  /* ignore semisextiles and inconjuncts */
+  if (nsign == 1 || nsign == 5 || nsign == 7 || nsign == 11)
+    nsign--;
+  dang = nsign * 30;
+  dx -= dang;
+  /* lunar speed roughly */
+  mspeed = xm[3] - xx[3];
+  if (pit->iflag & SEFLG_TOPOCTR)
+    mspeed = 13 - xx[3];
+  t = t0 - dx / mspeed;
+  while (fabs(dx) > 1e-5) {
+    if (swe_calc(t, SE_MOON, pit->iflag, xm, serr) == ERR) 
+      return ERR;
+    if (swe_calc(t, ipl, pit->iflag, xx, serr) == ERR) 
+      return ERR;
+    dx = swe_degnorm(xm[0] - xx[0] - dang);
+    if (dx > 180)
+      dx -= 360;
+    /* Newton steps with the current relative speed converge much faster
+     * than with the speed at t0 */
+    if (!(pit->iflag & SEFLG_TOPOCTR))
+      mspeed = xm[3] - xx[3];
+    t -= dx / mspeed;
+  }
+  *dasp = (double) ((int) (dang + 0.5));
+  *tret = t;
+  *isign = (int) (xm[0] / 30);
+  /* same aspect as before: the cached range grows */
+  if (pit->asp[ipl].tend != 0 && pit->asp[ipl].dasp == *dasp && fabs(pit->asp[ipl].tasp - t) < 0.01) {
+    if (t0 > pit->asp[ipl].tend)
+      pit->asp[ipl].tend = t0;
+    *tret = pit->asp[ipl].tasp;
+    *isign = pit->asp[ipl].isign;
+    return OK;
+  }
+  pit->asp[ipl].tend = t0;
+  pit->asp[ipl].tasp = t;
+  pit->asp[ipl].dasp = *dasp;
+  pit->asp[ipl].isign = *isign;
+  return OK;
+}
+
+static int32 get_next_voc(VOCITER *pit, double tet0, VOC *pvoc, char *serr) 
+{
+  double tet_asp, daspi, tvoc_end, tingr_save;
+  double tret[2], dasp = 0;
+  int32 ipl, ipllast = SE_SUN;
+  int32 isign = 0, isigni, isign_save;
+  int32 isign_ingr;
+  /* next ingress */
+  if (next_moon_ingress(pit, tet0, &(tret[1]), &isign, serr) == ERR)
+    return ERR;
+  isign_save = isign;
+  tingr_save = tret[1];
+  tvoc_end = tret[1];
+  /* overnext ingress */
+  if (pit->vocmethod == 1 && next_moon_ingress(pit, tret[1] + 1, &tvoc_end, &isign, serr) == ERR)
+    return ERR;
+  isign_ingr = isign;
+  /* find the last aspect with a planet within this time range */
+  tret[0] = 0;
+repeat_loop:
+  for (ipl = SE_SUN; ipl <= SE_PLUTO; ipl++) {
+    if (ipl == SE_MOON)
+      continue;
+    if (get_prev_lunasp(pit, tvoc_end, ipl, &tet_asp, &daspi, &isigni, serr) == ERR)
+      return ERR;
+    if (pit->vocmethod == 1 && tet_asp > tret[1]) {
+      tvoc_end = tret[1];
+      isign_ingr--;
+      if (isign_ingr < 0) isign_ingr = 11;
+      goto repeat_loop;
+    }
+    if (tet_asp > tret[0]) {
+      tret[0] = tet_asp;
+      dasp = daspi;
+      ipllast = ipl;
+      isign = isigni;
+    }
+  }
+  tret[1] = tvoc_end;
+  if (pit->vocmethod == 3) {
+    double tingr_prev;
+    int32 isign_prev;
+    if (prev_moon_ingress(pit, tet0, &tingr_prev, &isign_prev, serr) == ERR)
+      return ERR;
+    if (tret[0] < tingr_prev) {
+      tret[0] = tingr_prev;
+      isign = isign_prev;
+    }
+  }
+  pvoc->tvoc = tret[0];
+  pvoc->tingr = tret[1];
+  pvoc->casp = get_casp(dasp);
+  pvoc->cpl = (char) ipllast;
+  pvoc->isign_voc = isign;
+  pvoc->isign_ingr = isign_ingr;
+  if (isign_save == isign_ingr) {
+    pvoc->tingr0 = 0;
+    pvoc->isign_ingr0 = 0;
+  } else {
+    pvoc->tingr0 = tingr_save;
+    pvoc->isign_ingr0 = isign_save;
+  }
+  return OK;
+}
+
+/*
+ * Opens a search for void-of-course phases of the Moon, for the VOC
+ * method vocmethod (1, 2 or 3, 0 = 3, see above).
+ * The first phase is the one that ends with the first lunar ingress after
+ * tjd0 (method 1: with the first or second one); each further phase is
+ * searched from just after the end of the previous one, as long as that
+ * is before tjde. Times are TT. Returns NULL on error.
+ */
+VOCITER *swev_voc_open(int32 iflag, int32 vocmethod, double tjd0, double tjde, char *serr)
+{
+  VOCITER *pit;
+  if (vocmethod == 0) vocmethod = 3;
+  if (vocmethod < 1 || vocmethod > 3) {
+    sprintf(serr, "VOC method %d is not supported", vocmethod);
+    return NULL;
+  }
+  if ((pit = (VOCITER *) calloc(1, sizeof(VOCITER))) == NULL) {
+    strcpy(serr, "could not allocate VOC iterator");
+    return NULL;
+  }
+  pit->iflag = iflag | SEFLG_SPEED;
+  pit->vocmethod = vocmethod;
+  pit->t = tjd0;
+  pit->tjde = tjde;
+  return pit;
+}
+
+/*
+ * Delivers the next void-of-course phase.
+ * Returns 1 if *pvoc holds a phase, 0 at the end of the range, or ERR.
+ */
+int32 swev_voc_next(VOCITER *pit, VOC *pvoc, char *serr)
+{
+  if (pit->t >= pit->tjde)
+    return 0;
+  if (get_next_voc(pit, pit->t, pvoc, serr) == ERR)
+    return ERR;
+  pit->t = pvoc->tingr + 0.1;
+  return 1;
+}
+
+void swev_voc_close(VOCITER *pit)
+{
+  free(pit);
+}